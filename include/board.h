@@ -0,0 +1,131 @@
+#pragma once
+#include <stdint.h>
+#include <Filters.h>
+
+/* ===== Cấu hình board lúc biên dịch =====
+ * Mỗi board là một struct chỉ gồm hằng constexpr và typedef: chân, OLED, hiệu chuẩn ADC,
+ * bộ lọc, ngưỡng điều khiển và tính năng. Ngưỡng và hiệu chuẩn chỉ là giá trị mặc định của
+ * GardenConfig (garden.h), chỉnh được lúc chạy qua MQTT. Env PlatformIO chọn board bằng -DGARDEN_BOARD_<TÊN>
+ * (platformio.ini), mặc định GardenDevkit; mọi chỗ dùng qua typedef Board.
+ *
+ * Tính năng cần bỏ cả biến toàn cục (buffer HTTP, bảng sector lịch sử) là macro GARDEN_HTTP /
+ * GARDEN_HISTORY đặt theo board ở cuối file; phần còn lại là hằng constexpr, nhánh tắt bị
+ * compiler bỏ như #if.
+ */
+
+// Quy đổi ADC thô sang % trong khoảng hiệu chuẩn [minRaw, maxRaw]. Tính như các hàm *_percent() cũ
+// (float rồi cắt về int, giới hạn 0..100); raw() là chiều ngược lại, cho ngưỡng đánh thức ULP.
+// Chiều đảo là đấu dây nên cố định lúc biên dịch; khoảng đổi được lúc chạy (GardenConfig trong garden.h).
+template <bool Inverted>
+struct AdcRange {
+  uint16_t minRaw, maxRaw;
+
+  static constexpr bool INVERTED = Inverted;   // true: giá trị thô thấp = % cao (LDR sáng)
+
+  static constexpr int clamp(int percent) { return percent < 0 ? 0 : percent > 100 ? 100 : percent; }
+  constexpr int percent(int raw) const {
+    return clamp(Inverted ? (int)(100 - (float)(raw - minRaw) / (maxRaw - minRaw) * 100)
+                          : (int)((float)(raw - minRaw) / (maxRaw - minRaw) * 100));
+  }
+  // % chưa làm tròn, chưa đảo (độ ẩm đất cho bộ điều khiển tưới)
+  constexpr float level(int raw) const { return (raw - minRaw) * 100.0f / (maxRaw - minRaw); }
+  constexpr int raw(int percent) const {
+    return Inverted ? maxRaw - percent * (maxRaw - minRaw) / 100 : minRaw + percent * (maxRaw - minRaw) / 100;
+  }
+};
+
+// Hiệu chuẩn mặc định của board, dùng được trong biểu thức hằng
+template <int MinRaw, int MaxRaw, bool Inverted>
+struct AdcScale {
+  static_assert(MaxRaw > MinRaw, "AdcScale: MaxRaw must be above MinRaw");
+  typedef AdcRange<Inverted> Range;
+  static constexpr int MIN_RAW = MinRaw;
+  static constexpr int MAX_RAW = MaxRaw;
+  static constexpr bool INVERTED = Inverted;
+
+  static constexpr Range range() { return Range{ MinRaw, MaxRaw }; }
+  static constexpr int percent(int raw) { return range().percent(raw); }
+  static constexpr float level(int raw) { return range().level(raw); }
+  static constexpr int raw(int percent) { return range().raw(percent); }
+};
+
+// Wokwi diagram.json, firmware src/main.cpp: đủ cảm biến, OLED, vòng LED, van, còi
+struct GardenDevkit {
+  static constexpr uint8_t DHT_PIN = 12;
+  static constexpr uint8_t ALARM_LED_PIN = 33;    // LED báo quá nhiệt
+  static constexpr uint8_t BUZZER_PIN = 32;
+  static constexpr uint8_t BUZZER_CHANNEL = 5;    // kênh LEDC
+  static constexpr uint8_t LAMP_PIN = 26;         // đèn bật/tắt bằng lệnh switch_light
+  static constexpr uint8_t SERVO_PIN = 2;         // van tưới
+  static constexpr uint8_t RING_PIN = 4;          // vòng WS2812
+  static constexpr uint16_t RING_PIXELS = 16;
+  static constexpr uint8_t LDR_PIN = 34;          // ADC1
+  static constexpr uint8_t SOIL_PIN = 35;         // ADC1
+
+  static constexpr int16_t SCREEN_WIDTH = 128;
+  static constexpr int16_t SCREEN_HEIGHT = 64;
+  static constexpr uint8_t OLED_ADDRESS = 0x3C;
+
+  // ADC 12 bit cả thang: đất khô = raw thấp, LDR sáng = raw thấp
+  typedef AdcScale<0, 4095, true> Light;
+  typedef AdcScale<0, 4095, false> Soil;
+  // Theo nhịp lấy mẫu (đã decimate từ ADC DMA): trung vị 3 loại giá trị lẻ, EMA alpha 1/2,
+  // deadband 8 LSB để % hiển thị/gửi đi không nhấp nháy
+  typedef FilterChain<MedianFilter<int, 3>, EmaFilter<int, 1, 2>, Deadband<int, 8>> LightFilter;
+  typedef LightFilter SoilFilter;
+
+  static constexpr float OVERHEAT_C = 35.0f;       // còi + LED báo động
+  static constexpr int SOIL_DRY_PERCENT = 30;      // tưới tự động
+  static constexpr int SOIL_TARGET_PERCENT = 33;   // tưới dự báo: mỗi xung đưa về mức này
+  static constexpr int LIGHT_DIM_PERCENT = 40;     // auto light: <= mức này đèn xanh
+  static constexpr int LIGHT_BRIGHT_PERCENT = 80;  // > mức này đèn trắng, giữa hai mức vàng
+
+  // Telemetry: topic text từng kênh (flow Node-RED trong DashBoard.json) và/hoặc khung nhị phân
+  static constexpr bool TEXT_TOPICS = true;
+  static constexpr bool FRAME_TOPIC = false;
+  static constexpr uint8_t FRAME_BATCH = 4;        // số mẫu mỗi khung (tối đa TELEMETRY_MAX_BATCH)
+  static constexpr bool BATTERY = false;           // true: mặc định deep sleep (PowerConfig)
+};
+
+// Cùng mạch, chạy pin: deep sleep, chỉ gửi khung nhị phân, không HTTP/lịch sử flash
+struct BatteryNode : GardenDevkit {
+  static constexpr bool TEXT_TOPICS = false;
+  static constexpr bool FRAME_TOPIC = true;
+  static constexpr uint8_t FRAME_BATCH = 10;
+  static constexpr bool BATTERY = true;
+};
+
+// Mạch của test/main.cpp (ThingSpeak + NeoPixel): LDR hiệu chuẩn tới 3500, lọc mạnh hơn ở 20 Hz
+struct FarmRing {
+  static constexpr uint8_t DHT_PIN = 4;
+  static constexpr uint8_t LDR_PIN = 34;
+  static constexpr uint8_t SOIL_PIN = 35;
+  static constexpr uint8_t RING_PIN = 25;
+  static constexpr uint16_t RING_PIXELS = 16;
+  static constexpr uint8_t SERVO_PIN = 26;         // bơm
+
+  static constexpr int16_t SCREEN_WIDTH = 128;
+  static constexpr int16_t SCREEN_HEIGHT = 64;
+  static constexpr uint8_t OLED_ADDRESS = 0x3C;
+
+  typedef AdcScale<0, 3500, true> Light;
+  typedef AdcScale<0, 4095, false> Soil;
+  // trung vị 7 -> EMA alpha 3/20 (0.15) -> deadband, chạy trên mỗi giá trị DMA mới (20 Hz)
+  typedef FilterChain<MedianFilter<int, 7>, EmaFilter<int, 3, 20>, Deadband<int, 4>> LightFilter;
+  typedef FilterChain<MedianFilter<int, 7>, EmaFilter<int, 3, 20>, Deadband<int, 6>> SoilFilter;
+
+  static constexpr int LIGHT_ON_PERCENT = 40;      // auto: bật đèn dưới mức này, tắt trên LIGHT_OFF
+  static constexpr int LIGHT_OFF_PERCENT = 50;
+  static constexpr int SOIL_ON_PERCENT = 35;       // bơm giữ độ ẩm dự báo trên mức này
+  static constexpr int SOIL_TARGET_PERCENT = 40;   // ... và mỗi lần bơm đưa về mức này
+};
+
+#if defined(GARDEN_BOARD_BATTERY)
+typedef BatteryNode Board;
+#define GARDEN_HTTP 0
+#define GARDEN_HISTORY 0
+#else
+typedef GardenDevkit Board;
+#define GARDEN_HTTP 1       // máy chủ HTTP cục bộ (lib/HttpServer), ~6,5 KB RAM
+#define GARDEN_HISTORY 1    // lịch sử trên flash (lib/History), bảng sector ~6 KB RAM
+#endif
@@ -0,0 +1,87 @@
+#pragma once
+// Các thành phần của src/main.cpp dùng chung với chương trình host (src/native/)
+#include <ConnectionManager.h>
+#include <History.h>
+#include <HttpServer.h>
+#include <Metrics.h>
+#include <Ota.h>
+#include <RingBuffer.h>
+#include <Scheduler.h>
+#include <SpscQueue.h>
+#include <Telemetry.h>
+#include "board.h"
+
+// Bộ đệm mẫu khi mất MQTT: 720 mẫu = 1 giờ với chu kỳ lấy mẫu 5 s
+const size_t BACKLOG_CAPACITY = 720;
+typedef RingBuffer<SensorSample, BACKLOG_CAPACITY> SampleBacklog;
+
+// Lệnh MQTT chép từ callback (luồng mạng) sang luồng io; payload đủ cho một lệnh signal/config
+// đặt mọi trường (static_assert theo configFields trong main.cpp)
+struct CommandMsg {
+  char topic[32];
+  uint8_t payload[232];
+  uint8_t length;
+};
+
+// Chế độ năng lượng. ALWAYS_ON: WiFi và CPU luôn chạy, lấy mẫu mỗi 5 s (như trước).
+// Các chế độ ngủ: lấy mẫu mỗi sampleMs rồi ngủ tới task kế tiếp (WiFi tắt); cứ uploadEvery
+// mẫu (hoặc khi bị đánh thức bởi ngưỡng soil/LDR) bật WiFi, gửi mẫu mới + backlog, nghe lệnh
+// listenMs rồi tắt. Cửa sổ gửi không kéo dài quá maxAwakeMs dù chưa vào được mạng.
+// DEEP_SLEEP giữ trạng thái điều khiển và backlog trong RTC memory qua mỗi lần khởi động lại.
+enum PowerMode : uint8_t { POWER_ALWAYS_ON, POWER_LIGHT_SLEEP, POWER_DEEP_SLEEP };
+
+struct PowerConfig {
+  PowerMode mode;
+  uint32_t sampleMs;      // chu kỳ lấy mẫu khi ngủ
+  uint8_t uploadEvery;    // số mẫu giữa hai lần bật WiFi
+  uint32_t listenMs;      // giữ kết nối sau khi gửi xong để nhận lệnh
+  uint32_t maxAwakeMs;    // thời gian tối đa của một cửa sổ gửi
+  uint32_t minSleepMs;    // không ngủ nếu task kế tiếp gần hơn
+};
+
+// Tưới tự động. PREDICTIVE (mặc định): lib/Irrigation ước lượng tốc độ khô theo nhiệt độ/độ ẩm
+// không khí và tính thời gian mở van để về dải mục tiêu. THRESHOLD: như trước, mở van wateringPulse
+// mỗi lần lấy mẫu thấy đất dưới config.soilDryPercent (giữ lại để so sánh trong sim).
+enum IrrigationMode : uint8_t { IRRIGATION_PREDICTIVE, IRRIGATION_THRESHOLD };
+
+// Ngưỡng điều khiển và hiệu chuẩn ADC chỉnh được lúc chạy bằng lệnh signal/config (lib/ConfigStore),
+// lưu NVS dạng blob có version + CRC. Mặc định theo Board; chỉ luồng io đọc/ghi. Đổi bố cục thì
+// tăng GARDEN_CONFIG_VERSION: blob cũ bị bỏ, node chạy giá trị mặc định tới lệnh config kế tiếp.
+struct GardenConfig {
+  float overheatC;                 // còi + LED báo động
+  float soilTargetPercent;         // tưới dự báo: mỗi xung đưa độ ẩm về mức này
+  Board::Light::Range light;       // hiệu chuẩn ADC thô -> %
+  Board::Soil::Range soil;
+  uint8_t soilDryPercent;          // tưới khi (dự báo) dưới mức này
+  uint8_t lightDimPercent;         // auto light: <= mức này đèn xanh
+  uint8_t lightBrightPercent;      // > mức này đèn trắng, giữa hai mức vàng
+  uint8_t spare;                   // 0; blob NVS không có byte đệm
+};
+static_assert(sizeof(GardenConfig) == 20, "GardenConfig layout changed: bump GARDEN_CONFIG_VERSION");
+const uint16_t GARDEN_CONFIG_VERSION = 1;
+
+// Hàng đợi giữa hai luồng: mẫu io -> mạng, lệnh mạng -> io
+typedef SpscQueue<SensorSample, 16> SampleQueue;
+typedef SpscQueue<CommandMsg, 8> CommandQueue;
+
+extern Scheduler netScheduler;   // MQTT, gửi dữ liệu, gửi bù (core 0 trên ESP32)
+extern Scheduler ioScheduler;    // cảm biến, điều khiển, OLED, LED (loop(), core 1)
+extern SampleQueue sampleQueue;
+extern CommandQueue commandQueue;
+extern SampleBacklog backlog;
+extern MetricsRegistry metrics;   // JSON chẩn đoán trên topics[TOPIC_DIAG]
+extern ConnectionManager connection;   // WiFi + MQTT, chỉ luồng mạng gọi
+#if GARDEN_HISTORY
+extern HistoryLog history;        // lịch sử số đo trên flash, luồng io
+#endif
+#if GARDEN_HTTP
+extern HttpServer http;           // HTTP cục bộ cổng 80, luồng io
+#endif
+extern GardenConfig config;      // luồng io
+extern Counter configUpdates, configRejected;   // lệnh signal/config áp dụng / bị từ chối
+extern OtaPatcher ota;            // cập nhật firmware bằng delta, luồng mạng
+extern PowerConfig power;         // đặt trước setup()
+extern IrrigationMode irrigationMode;   // đặt trước setup()
+
+void setup();
+void loop();
@@ -0,0 +1,75 @@
+#ifdef ARDUINO
+#include "AdcDmaSampler.h"
+#include <driver/adc.h>
+
+static const uint32_t FRAME_BYTES = 512;          // byte mỗi lần ngắt DMA
+static const uint32_t STORE_BYTES = 4 * FRAME_BYTES;
+static const uint32_t READ_TIMEOUT_MS = 20;       // để task thấy yêu cầu dừng
+
+AdcDmaSampler::AdcDmaSampler(AnalogDecimator& out, uint32_t sampleHz) : out(out), sampleHz(sampleHz) {}
+
+bool AdcDmaSampler::begin(const uint8_t* pins, uint8_t count) {
+  if (running() || count == 0 || count > ADC1_CHANNELS) return false;
+
+  adc_digi_pattern_config_t pattern[ADC1_CHANNELS] = {};
+  uint32_t mask = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    int8_t ch = adc1Channel(pins[i]);
+    if (ch < 0) return false;
+    mask |= 1u << ch;
+    pattern[i].atten = ADC_ATTEN_DB_11;
+    pattern[i].channel = ch;
+    pattern[i].unit = 0;   // ADC1
+    pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+  }
+
+  adc_digi_init_config_t init = {};
+  init.max_store_buf_size = STORE_BYTES;
+  init.conv_num_each_intr = FRAME_BYTES;
+  init.adc1_chan_mask = mask;
+  if (adc_digi_initialize(&init) != ESP_OK) return false;
+
+  adc_digi_configuration_t config = {};
+  config.conv_limit_en = true;   // bắt buộc trên ESP32
+  config.conv_limit_num = 250;
+  config.pattern_num = count;
+  config.adc_pattern = pattern;
+  config.sample_freq_hz = sampleHz;
+  config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+  if (adc_digi_controller_configure(&config) != ESP_OK || adc_digi_start() != ESP_OK) {
+    adc_digi_deinitialize();
+    return false;
+  }
+
+  // core 0 cùng WiFi, loop() trên core 1 không bị chiếm
+  TaskHandle_t handle = nullptr;
+  xTaskCreatePinnedToCore(run, "adc_dma", 3072, this, 5, &handle, 0);
+  task = handle;
+  return running();
+}
+
+void AdcDmaSampler::end() {
+  if (!running()) return;
+  stopping = true;
+  while (task) vTaskDelay(1);   // task tự thoát sau lần đọc kế tiếp
+  adc_digi_stop();
+  adc_digi_deinitialize();
+  stopping = false;
+}
+
+void AdcDmaSampler::run(void* arg) {
+  AdcDmaSampler* self = (AdcDmaSampler*)arg;
+  static uint16_t frame[FRAME_BYTES / sizeof(uint16_t)];
+  while (!self->stopping) {
+    uint32_t length = 0;
+    esp_err_t err = adc_digi_read_bytes((uint8_t*)frame, FRAME_BYTES, &length, READ_TIMEOUT_MS);
+    if (err == ESP_ERR_INVALID_STATE) self->overruns++;   // vẫn có dữ liệu hợp lệ
+    else if (err != ESP_OK) continue;
+    self->out.push(frame, length / sizeof(uint16_t));
+    self->blocks++;
+  }
+  self->task = nullptr;
+  vTaskDelete(NULL);
+}
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+#ifdef ARDUINO
+// Lấy mẫu ADC1 liên tục bằng DMA (driver adc_digi của ESP-IDF). Một task FreeRTOS
+// chờ khối DMA đầy rồi đẩy thẳng vào AnalogDecimator, loop() không tốn thời gian
+// chờ nào; sau begin() không được gọi analogRead() trên các chân ADC1 nữa.
+#include <Arduino.h>
+#include "AnalogStream.h"
+
+class AdcDmaSampler {
+public:
+  // sampleHz: tổng tần số lấy mẫu cho mọi kênh (ESP32: 20 kHz .. 2 MHz)
+  explicit AdcDmaSampler(AnalogDecimator& out, uint32_t sampleHz = 20000);
+
+  // pins: các chân ADC1; false nếu chân không hợp lệ hoặc driver lỗi
+  bool begin(const uint8_t* pins, uint8_t count);
+  // Dừng DMA và giải phóng driver (vd. trước khi ULP dùng ADC1 lúc ngủ); begin() lại để chạy tiếp
+  void end();
+  bool running() const { return task != nullptr; }
+
+  uint32_t blocks = 0;     // số khối DMA đã xử lý
+  uint32_t overruns = 0;   // bộ đệm driver đầy, mất mẫu do task đọc không kịp
+
+private:
+  static void run(void* arg);
+
+  AnalogDecimator& out;
+  uint32_t sampleHz;
+  TaskHandle_t volatile task = nullptr;
+  volatile bool stopping = false;
+};
+#endif
@@ -0,0 +1,56 @@
+#include "AnalogStream.h"
+
+int8_t adc1Channel(uint8_t gpio) {
+  switch (gpio) {
+    case 36: return 0;
+    case 37: return 1;
+    case 38: return 2;
+    case 39: return 3;
+    case 32: return 4;
+    case 33: return 5;
+    case 34: return 6;
+    case 35: return 7;
+    default: return -1;
+  }
+}
+
+AnalogDecimator::AnalogDecimator(uint16_t factor) : windowSize(factor < 3 ? 3 : factor) {
+  for (uint8_t i = 0; i < ADC1_CHANNELS; i++) {
+    acc[i].sum = 0;
+    acc[i].n = 0;
+    acc[i].min = 0xFFFF;
+    acc[i].max = 0;
+    acc[i].value = 0;
+    acc[i].outputs = 0;
+  }
+}
+
+void AnalogDecimator::push(const uint16_t* words, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    uint8_t ch = words[i] >> 12;
+    uint16_t raw = words[i] & 0x0FFF;
+    if (ch >= ADC1_CHANNELS) {
+      foreign++;
+      continue;
+    }
+    Channel& c = acc[ch];
+    c.sum += raw;
+    if (raw < c.min) c.min = raw;
+    if (raw > c.max) c.max = raw;
+    if (++c.n < windowSize) continue;
+
+    c.value = (uint16_t)((c.sum - c.min - c.max + (c.n - 2) / 2) / (c.n - 2));
+    c.outputs = c.outputs + 1;
+    c.sum = 0;
+    c.n = 0;
+    c.min = 0xFFFF;
+    c.max = 0;
+  }
+  samples += count;
+}
+
+bool AnalogDecimator::latest(uint8_t channel, uint16_t& value) const {
+  if (channel >= ADC1_CHANNELS || acc[channel].outputs == 0) return false;
+  value = acc[channel].value;
+  return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* ===== AnalogStream =====
+ * Xử lý theo khối cho dữ liệu ADC lấy mẫu liên tục. Mỗi mẫu là một word 16 bit
+ * theo định dạng TYPE1 của bộ ADC DMA trên ESP32 (bit 0-11: giá trị, bit 12-15:
+ * kênh ADC1), nên khối DMA được xử lý tại chỗ, không cần chép lại.
+ * Mỗi kênh gom `factor` mẫu thô thành một giá trị (trung bình sau khi bỏ mẫu
+ * lớn nhất và nhỏ nhất để loại gai nhiễu).
+ */
+
+const uint8_t ADC1_CHANNELS = 8;
+
+static inline uint16_t adcWord(uint8_t channel, uint16_t raw) {
+  return (uint16_t)((channel & 0x0F) << 12 | (raw & 0x0FFF));
+}
+
+// GPIO -> kênh ADC1 (GPIO36..39, 32..35), -1 nếu chân không thuộc ADC1
+int8_t adc1Channel(uint8_t gpio);
+
+class AnalogDecimator {
+public:
+  explicit AnalogDecimator(uint16_t factor);
+
+  // Nạp một khối word TYPE1; an toàn khi gọi từ task lấy mẫu riêng
+  void push(const uint16_t* words, size_t count);
+  // Giá trị đã decimate gần nhất của kênh; false nếu chưa có
+  bool latest(uint8_t channel, uint16_t& value) const;
+  uint32_t outputs(uint8_t channel) const { return channel < ADC1_CHANNELS ? acc[channel].outputs : 0; }
+  uint16_t factor() const { return windowSize; }
+
+  uint32_t samples = 0;   // tổng số mẫu thô đã xử lý
+  uint32_t foreign = 0;   // mẫu của kênh ngoài ADC1 (bỏ qua)
+
+private:
+  struct Channel {
+    uint32_t sum;
+    uint16_t n, min, max;
+    volatile uint16_t value;   // ghi 16 bit là nguyên tử, bên đọc không cần khóa
+    volatile uint32_t outputs;
+  };
+
+  uint16_t windowSize;
+  Channel acc[ADC1_CHANNELS];
+};
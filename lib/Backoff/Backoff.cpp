@@ -0,0 +1,24 @@
+#include "Backoff.h"
+
+Backoff::Backoff(const BackoffPolicy& policy, uint32_t seed) : policy(policy), state(0), failures(0) {
+  this->seed(seed);
+}
+
+// xorshift32: đủ để rải lần thử lại, không dùng cho mật mã
+uint32_t Backoff::random() {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+uint32_t Backoff::next() {
+  uint32_t delay = policy.initialMs;
+  for (uint16_t i = 0; i < failures && delay < policy.maxMs; i++) delay *= 2;
+  if (delay > policy.maxMs) delay = policy.maxMs;
+  if (failures < UINT16_MAX) failures++;
+
+  uint32_t span = (uint64_t)delay * policy.jitterPercent / 100;
+  if (span) delay -= random() % (span + 1);
+  return delay ? delay : 1;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+
+/* ===== Backoff =====
+ * Khoảng chờ giữa các lần thử lại (kết nối MQTT, ...): lần thứ n chờ
+ * initialMs * 2^n, tối đa maxMs, rồi trừ ngẫu nhiên tới jitterPercent % để
+ * nhiều node mất kết nối cùng lúc không thử lại đồng loạt. reset() sau khi
+ * thành công. Không cấp phát, không phụ thuộc nền tảng (seed do nơi gọi cấp).
+ */
+
+struct BackoffPolicy {
+  uint32_t initialMs;      // lần chờ đầu tiên
+  uint32_t maxMs;          // trần
+  uint8_t jitterPercent;   // 0..100, phần bị trừ ngẫu nhiên khỏi mỗi lần chờ
+};
+
+class Backoff {
+public:
+  explicit Backoff(const BackoffPolicy& policy, uint32_t seed = 0x9E3779B9);
+
+  // Khoảng chờ trước lần thử kế tiếp (ms), tăng dần sau mỗi lần gọi
+  uint32_t next();
+  void reset() { failures = 0; }
+  void seed(uint32_t s) { state = s ? s : 0x9E3779B9; }
+
+  uint16_t attempts() const { return failures; }
+
+private:
+  uint32_t random();
+
+  const BackoffPolicy& policy;
+  uint32_t state;
+  uint16_t failures;
+};
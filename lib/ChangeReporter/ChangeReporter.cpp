@@ -0,0 +1,39 @@
+#include "ChangeReporter.h"
+#include <math.h>
+
+ChangeReporter::ChangeReporter(const ReportPolicy& policy)
+  : policy(policy), last(NAN), lastMs(0), hasLast(false) {}
+
+ReportReason ChangeReporter::update(float value, uint32_t nowMs) {
+  ReportReason reason = REPORT_NONE;
+  uint32_t elapsed = nowMs - lastMs;
+
+  if (!hasLast) {
+    reason = REPORT_FIRST;
+  } else if (isnan(value) != isnan(last)) {
+    reason = REPORT_CHANGE;
+  } else if (!isnan(value)) {
+    float band = policy.relDelta * fabsf(last);
+    if (policy.absDelta > band) band = policy.absDelta;
+    if (!isnan(policy.threshold) && (last > policy.threshold) != (value > policy.threshold)) {
+      reason = REPORT_THRESHOLD;
+    } else if (fabsf(value - last) > band) {
+      reason = REPORT_CHANGE;
+    }
+  }
+  if (reason == REPORT_NONE && policy.heartbeatMs && elapsed >= policy.heartbeatMs) reason = REPORT_HEARTBEAT;
+
+  if (reason == REPORT_NONE) {
+    suppressed++;
+    return REPORT_NONE;
+  }
+  if (reason != REPORT_FIRST && elapsed < policy.minIntervalMs) {
+    limited++;
+    return REPORT_NONE;
+  }
+  last = value;
+  lastMs = nowMs;
+  hasLast = true;
+  reports++;
+  return reason;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+
+/* ===== ChangeReporter =====
+ * Quyết định có gửi một kênh đo ở lần lấy mẫu này hay không (report-on-change):
+ *  - giá trị lệch so với lần gửi trước quá max(absDelta, relDelta * |giá trị trước|)
+ *  - hoặc vượt qua ngưỡng cảnh báo (threshold) theo một trong hai chiều
+ *  - hoặc đã im lặng quá heartbeatMs (để phía nhận biết node còn sống)
+ * nhưng không gửi dày hơn minIntervalMs. Giá trị bị chặn bởi minIntervalMs
+ * không mất: lần lấy mẫu sau vẫn so với giá trị đã gửi nên sẽ được gửi tiếp.
+ * Lần đầu và khi NaN <-> số luôn gửi. Không cấp phát, so sánh thời gian an
+ * toàn khi millis() tràn.
+ */
+
+struct ReportPolicy {
+  float absDelta;          // lệch tuyệt đối tối thiểu (đơn vị của kênh), 0 = bỏ qua
+  float relDelta;          // lệch tương đối tối thiểu (0.1 = 10 %), 0 = bỏ qua
+  uint32_t minIntervalMs;  // khoảng cách tối thiểu giữa hai lần gửi
+  uint32_t heartbeatMs;    // gửi lại dù không đổi sau chừng này, 0 = không
+  float threshold;         // ngưỡng cảnh báo, NAN = không có
+};
+
+enum ReportReason : uint8_t { REPORT_NONE, REPORT_FIRST, REPORT_CHANGE, REPORT_THRESHOLD, REPORT_HEARTBEAT };
+
+class ChangeReporter {
+public:
+  explicit ChangeReporter(const ReportPolicy& policy);
+
+  // Gọi mỗi lần có giá trị mới; khác REPORT_NONE nghĩa là gửi ngay, giá trị được ghi nhận là đã gửi
+  ReportReason update(float value, uint32_t nowMs);
+  // Gửi lại ở lần update() kế tiếp (vd. sau khi kết nối lại broker)
+  void invalidate() { hasLast = false; }
+
+  float lastValue() const { return last; }
+
+  uint32_t reports = 0;     // số lần được phép gửi
+  uint32_t suppressed = 0;  // số mẫu không cần gửi
+  uint32_t limited = 0;     // đã đổi nhưng bị minIntervalMs chặn
+
+private:
+  const ReportPolicy& policy;
+  float last;
+  uint32_t lastMs;
+  bool hasLast;
+};
@@ -0,0 +1,136 @@
+#include "ConfigStore.h"
+#include <stdio.h>
+#include <string.h>
+
+static inline bool isSeparator(uint8_t c) { return c == ' ' || c == ',' || c == ';' || c == '\t' || c == '\r' || c == '\n'; }
+
+static const ConfigField* findField(const ConfigField* fields, size_t count, const uint8_t* name, size_t length) {
+  for (size_t i = 0; i < count; i++)
+    if (payloadIs(name, length, fields[i].name)) return &fields[i];
+  return nullptr;
+}
+
+static float fieldValue(const ConfigField& f, const void* config) {
+  const uint8_t* p = (const uint8_t*)config + f.offset;
+  switch (f.type) {
+    case CONFIG_FLOAT: { float v; memcpy(&v, p, sizeof(v)); return v; }
+    case CONFIG_U8:    return *p;
+    case CONFIG_U16:   { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+  }
+  return 0;
+}
+
+// false nếu giá trị mới trùng giá trị cũ
+static bool setField(const ConfigField& f, void* config, float value) {
+  uint8_t* p = (uint8_t*)config + f.offset;
+  switch (f.type) {
+    case CONFIG_FLOAT: {
+      float old;
+      memcpy(&old, p, sizeof(old));
+      memcpy(p, &value, sizeof(value));
+      return old != value;
+    }
+    case CONFIG_U8: {
+      uint8_t v = (uint8_t)value, old = *p;
+      *p = v;
+      return old != v;
+    }
+    case CONFIG_U16: {
+      uint16_t v = (uint16_t)value, old;
+      memcpy(&old, p, sizeof(old));
+      memcpy(p, &v, sizeof(v));
+      return old != v;
+    }
+  }
+  return false;
+}
+
+ConfigResult configParse(const ConfigField* fields, size_t count, void* config, const uint8_t* payload, size_t length) {
+  ConfigResult r = { CONFIG_EMPTY, nullptr, 0 };
+  size_t i = 0;
+  while (i < length) {
+    while (i < length && isSeparator(payload[i])) i++;
+    if (i == length) break;
+    size_t start = i;
+    while (i < length && !isSeparator(payload[i])) i++;
+    const uint8_t* pair = payload + start;
+    size_t pairLength = i - start;
+
+    const uint8_t* eq = (const uint8_t*)memchr(pair, '=', pairLength);
+    if (!eq) return { CONFIG_BAD_VALUE, nullptr, 0 };
+    const ConfigField* f = findField(fields, count, pair, eq - pair);
+    if (!f) return { CONFIG_UNKNOWN_FIELD, nullptr, 0 };
+
+    float v;
+    if (!payloadFloat(eq + 1, pair + pairLength - (eq + 1), v)) return { CONFIG_BAD_VALUE, f, 0 };
+    if (v < f->min || v > f->max) return { CONFIG_OUT_OF_RANGE, f, 0 };
+    // trường nguyên không nhận phần lẻ; sau kiểm tra khoảng nên ép kiểu không tràn
+    if (f->type != CONFIG_FLOAT && v != (float)(long)v) return { CONFIG_BAD_VALUE, f, 0 };
+    if (setField(*f, config, v)) r.changed++;
+    r.status = CONFIG_OK;
+  }
+  return r;
+}
+
+size_t configFormat(const ConfigField* fields, size_t count, const void* config, char* out, size_t capacity) {
+  size_t n = 0;
+  if (capacity == 0) return 0;
+  out[0] = '\0';
+  for (size_t i = 0; i < count; i++) {
+    const ConfigField& f = fields[i];
+    int w = f.type == CONFIG_FLOAT
+              ? snprintf(out + n, capacity - n, "%s%s=%g", n ? " " : "", f.name, (double)fieldValue(f, config))
+              : snprintf(out + n, capacity - n, "%s%s=%u", n ? " " : "", f.name, (unsigned)fieldValue(f, config));
+    if (w < 0 || (size_t)w >= capacity - n) {
+      out[0] = '\0';
+      return 0;
+    }
+    n += w;
+  }
+  return n;
+}
+
+const char* configStatusText(ConfigStatus status) {
+  switch (status) {
+    case CONFIG_OK:            return "ok";
+    case CONFIG_EMPTY:         return "empty";
+    case CONFIG_UNKNOWN_FIELD: return "unknown field";
+    case CONFIG_BAD_VALUE:     return "bad value";
+    case CONFIG_OUT_OF_RANGE:  return "out of range";
+  }
+  return "?";
+}
+
+// --------------------- Blob lưu NVS -----------------
+// CRC-32 (IEEE, phản xạ), bảng 16 phần tử cho mỗi nửa byte: đủ nhanh cho vài chục byte
+uint32_t configCrc32(const void* data, size_t length, uint32_t crc) {
+  static const uint32_t table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+  };
+  const uint8_t* p = (const uint8_t*)data;
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc = table[(crc ^ p[i]) & 0x0F] ^ (crc >> 4);
+    crc = table[(crc ^ (p[i] >> 4)) & 0x0F] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+size_t configEncode(uint16_t version, const void* config, size_t size, uint8_t* out, size_t capacity) {
+  if (size > UINT16_MAX || capacity < CONFIG_BLOB_HEADER + size) return 0;
+  ConfigBlobHeader h = { CONFIG_MAGIC, version, (uint16_t)size, configCrc32(config, size) };
+  memcpy(out, &h, sizeof(h));
+  memcpy(out + CONFIG_BLOB_HEADER, config, size);
+  return CONFIG_BLOB_HEADER + size;
+}
+
+bool configDecode(uint16_t version, const uint8_t* blob, size_t length, void* config, size_t size) {
+  if (length != CONFIG_BLOB_HEADER + size) return false;
+  ConfigBlobHeader h;
+  memcpy(&h, blob, sizeof(h));
+  if (h.magic != CONFIG_MAGIC || h.version != version || h.length != size) return false;
+  if (configCrc32(blob + CONFIG_BLOB_HEADER, size) != h.crc) return false;
+  memcpy(config, blob + CONFIG_BLOB_HEADER, size);
+  return true;
+}
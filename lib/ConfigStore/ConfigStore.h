@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <Dispatcher.h>
+
+/* ===== ConfigStore =====
+ * Cấu hình chỉnh được lúc chạy cho một struct POD, mô tả bằng bảng trường (tên, offset,
+ * kiểu, khoảng hợp lệ):
+ *  - configParse() đọc payload "tên=giá trị tên=giá trị ..." (cách nhau bởi khoảng trắng,
+ *    ',' hoặc ';') vào struct. Nơi gọi truyền một bản sao: trường lạ, giá trị hỏng hoặc ngoài
+ *    khoảng làm hỏng cả lệnh, bản đang dùng không bị đổi một nửa.
+ *  - configFormat() in lại cùng dạng (log, trả lời lệnh).
+ *  - configEncode()/configDecode(): blob nhị phân [magic][version][length][CRC-32][struct]
+ *    để lưu NVS; khi khởi động chỉ kiểm tra header + CRC rồi chép, không parse lại. Blob của
+ *    version khác, độ dài khác hoặc sai CRC bị bỏ, nơi gọi dùng giá trị mặc định.
+ * Không cấp phát.
+ */
+
+enum ConfigType : uint8_t { CONFIG_FLOAT, CONFIG_U8, CONFIG_U16 };
+
+struct ConfigField {
+  const char* name;
+  uint16_t offset;
+  ConfigType type;
+  float min, max;          // khoảng hợp lệ, gồm cả hai đầu
+};
+
+// offsetof nhận cả trường lồng: CONFIG_FIELD(GardenConfig, light.minRaw, CONFIG_U16, 0, 4095)
+#define CONFIG_FIELD(Struct, member, type, min, max) { #member, offsetof(Struct, member), type, min, max }
+
+enum ConfigStatus : uint8_t { CONFIG_OK, CONFIG_EMPTY, CONFIG_UNKNOWN_FIELD, CONFIG_BAD_VALUE, CONFIG_OUT_OF_RANGE };
+
+struct ConfigResult {
+  ConfigStatus status;
+  const ConfigField* field;  // trường lỗi (BAD_VALUE, OUT_OF_RANGE), nullptr nếu không có
+  uint8_t changed;           // số trường có giá trị mới
+};
+
+// Độ dài lệnh đặt mọi trường một lần ("tên=giá trị " mỗi trường, giá trị tối đa CONFIG_VALUE_CHARS
+// ký tự), để nơi gọi static_assert buffer lệnh đủ chỗ. Bảng trường phải là constexpr.
+const size_t CONFIG_VALUE_CHARS = 10;
+constexpr size_t configNameChars(const char* name) { return *name ? 1 + configNameChars(name + 1) : 0; }
+constexpr size_t configCommandChars(const ConfigField* fields, size_t count) {
+  return count ? configNameChars(fields->name) + 2 + CONFIG_VALUE_CHARS + configCommandChars(fields + 1, count - 1) : 0;
+}
+
+ConfigResult configParse(const ConfigField* fields, size_t count, void* config, const uint8_t* payload, size_t length);
+// Số ký tự đã ghi (không tính '\0'), 0 nếu không đủ chỗ
+size_t configFormat(const ConfigField* fields, size_t count, const void* config, char* out, size_t capacity);
+const char* configStatusText(ConfigStatus status);
+
+const uint32_t CONFIG_MAGIC = 0x47434647;   // "GCFG"
+struct ConfigBlobHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t length;         // sizeof struct cấu hình
+  uint32_t crc;            // CRC-32 của phần struct
+};
+const size_t CONFIG_BLOB_HEADER = sizeof(ConfigBlobHeader);
+
+uint32_t configCrc32(const void* data, size_t length, uint32_t crc = 0);
+// Số byte blob, 0 nếu capacity < CONFIG_BLOB_HEADER + size
+size_t configEncode(uint16_t version, const void* config, size_t size, uint8_t* out, size_t capacity);
+bool configDecode(uint16_t version, const uint8_t* blob, size_t length, void* config, size_t size);
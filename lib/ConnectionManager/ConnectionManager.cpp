@@ -0,0 +1,63 @@
+#include "ConnectionManager.h"
+
+ConnectionManager::ConnectionManager(TransportHal& transport, const BackoffPolicy& backoff, uint32_t linkPollMs)
+  : transport(transport), backoff(backoff), linkPollMs(linkPollMs) {}
+
+void ConnectionManager::configure(const char* ssid, const char* password, const char* clientId, const char* filter,
+                                  const char* groupFilter) {
+  this->ssid = ssid;
+  this->password = password;
+  this->clientId = clientId;
+  this->filter = filter;
+  this->groupFilter = groupFilter;
+}
+
+void ConnectionManager::start() {
+  transport.beginLink(ssid, password);
+  state = STATE_LINK;
+  startMs = halMillis();
+  backoff.seed(halMicros() ^ startMs);
+  backoff.reset();
+}
+
+void ConnectionManager::stop() {
+  transport.endLink();
+  state = STATE_OFF;
+}
+
+void ConnectionManager::lost() {
+  if (state != STATE_ONLINE) return;
+  state = STATE_LINK;
+  startMs = halMillis();
+  backoff.reset();
+}
+
+uint32_t ConnectionManager::service() {
+  if (state == STATE_OFF) return linkPollMs;
+  if (state == STATE_ONLINE) {
+    if (transport.connected()) return 0;
+    lost();   // mất kết nối: thử lại ngay, không chờ
+  }
+  if (state == STATE_LINK) transport.serviceLink();
+  if (!transport.linkUp()) {
+    state = STATE_LINK;
+    return linkPollMs;   // chờ WiFi không tính là một lần thử
+  }
+  if (state == STATE_LINK) {
+    counters.lastLinkMs = halMillis() - startMs;
+    state = STATE_MQTT;
+  }
+
+  counters.attempts++;
+  if (!transport.connect(clientId) || (filter && !transport.subscribe(filter)) ||
+      (groupFilter && !transport.subscribe(groupFilter))) {
+    counters.failures++;
+    return backoff.next();
+  }
+  state = STATE_ONLINE;
+  backoff.reset();
+  counters.onlines++;
+  counters.lastOnlineMs = halMillis() - startMs;
+  if (counters.lastOnlineMs > counters.maxOnlineMs) counters.maxOnlineMs = counters.lastOnlineMs;
+  return 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <Hal.h>
+#include <Backoff.h>
+
+/* ===== ConnectionManager =====
+ * Đưa node lên mạng mà không chặn: start() bật WiFi (backend dùng lại kênh/BSSID/IP
+ * đã nhớ), service() được gọi lại theo khoảng chờ nó trả về — chờ WiFi vào mạng
+ * mỗi linkPollMs (gọi transport.serviceLink(), chỉ trên luồng mạng), rồi thử MQTT
+ * với Backoff (lũy thừa 2 + jitter). Kết nối được thì đăng ký topic filter (wildcard)
+ * của node và, nếu có, của nhóm thay cho từng topic lệnh.
+ * Đo thời gian từ start()/lost() tới khi online (time-to-online) và thời gian vào WiFi.
+ */
+
+struct ConnectStats {
+  uint32_t attempts;       // số lần connect() MQTT
+  uint32_t failures;
+  uint32_t onlines;        // số lần lên mạng thành công
+  uint32_t lastLinkMs;     // start()/lost() -> WiFi vào mạng, lần gần nhất
+  uint32_t lastOnlineMs;   // start()/lost() -> MQTT kết nối và đã subscribe
+  uint32_t maxOnlineMs;
+};
+
+class ConnectionManager {
+public:
+  ConnectionManager(TransportHal& transport, const BackoffPolicy& backoff, uint32_t linkPollMs);
+
+  // groupFilter: filter thứ hai cho lệnh gửi chung nhiều node, nullptr = không dùng
+  void configure(const char* ssid, const char* password, const char* clientId, const char* filter,
+                 const char* groupFilter = nullptr);
+
+  void start();     // bật WiFi và bắt đầu đo
+  void stop();      // tắt WiFi (trước khi ngủ)
+  void lost();      // phát hiện mất MQTT/WiFi khi đang online: đo lại, thử ngay
+  // Một bước kết nối; trả về ms tới lần gọi kế tiếp, 0 khi đã online
+  uint32_t service();
+
+  bool online() const { return state == STATE_ONLINE; }
+  const ConnectStats& stats() const { return counters; }
+
+private:
+  enum State : uint8_t { STATE_OFF, STATE_LINK, STATE_MQTT, STATE_ONLINE };
+
+  TransportHal& transport;
+  Backoff backoff;
+  uint32_t linkPollMs;
+  const char* ssid = "";
+  const char* password = "";
+  const char* clientId = "";
+  const char* filter = nullptr;
+  const char* groupFilter = nullptr;
+  State state = STATE_OFF;
+  uint32_t startMs = 0;
+  ConnectStats counters = {};
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <Hal.h>
+
+/* ===== CycleStats =====
+ * Thống kê thời gian chạy của một đoạn mã theo chu kỳ CPU (halCycles()):
+ * số lần, min/max và tổng. Đặt CycleScope ở đầu đoạn cần đo, khi ra khỏi
+ * phạm vi thời gian được cộng vào CycleStats. Chi phí đo: hai lần đọc CCOUNT.
+ */
+
+struct CycleStats {
+  const char* name;
+  uint32_t count;
+  uint32_t minCycles;
+  uint32_t maxCycles;
+  uint64_t totalCycles;
+
+  explicit CycleStats(const char* name) : name(name) { reset(); }
+
+  void add(uint32_t cycles) {
+    count++;
+    totalCycles += cycles;
+    if (cycles < minCycles) minCycles = cycles;
+    if (cycles > maxCycles) maxCycles = cycles;
+  }
+
+  void reset() {
+    count = 0;
+    minCycles = UINT32_MAX;
+    maxCycles = 0;
+    totalCycles = 0;
+  }
+
+  uint32_t meanCycles() const { return count ? (uint32_t)(totalCycles / count) : 0; }
+  // Đổi sang ns theo tần số CPU hiện tại
+  static uint32_t toNs(uint32_t cycles) { return (uint32_t)((uint64_t)cycles * 1000 / halCpuMhz()); }
+};
+
+class CycleScope {
+public:
+  explicit CycleScope(CycleStats& stats) : stats(stats), start(halCycles()) {}
+  ~CycleScope() { stats.add(halCycles() - start); }
+
+private:
+  CycleStats& stats;
+  uint32_t start;
+};
@@ -0,0 +1,150 @@
+#include "Dht22.h"
+#include <math.h>
+
+// Mỗi bit: mức thấp ~50 µs rồi mức cao 26-28 µs (bit 0) hoặc 70 µs (bit 1),
+// nên khoảng cách giữa hai cạnh xuống liên tiếp là ~78 µs hoặc ~120 µs.
+static const uint32_t BIT_MIN_US = 50;
+static const uint32_t BIT_ONE_US = 100;
+static const uint32_t BIT_MAX_US = 200;
+
+Dht22Status dht22Decode(const uint32_t* fallUs, uint8_t count, float& temperature, float& humidity) {
+  temperature = humidity = NAN;
+  if (count < DHT22_EDGES) return DHT22_TIMEOUT;
+
+  const uint32_t* e = fallUs + (count - DHT22_EDGES);
+  uint8_t data[5] = {};
+  for (uint8_t i = 0; i < 40; i++) {
+    uint32_t width = e[i + 1] - e[i];
+    if (width < BIT_MIN_US || width > BIT_MAX_US) return DHT22_FRAME;
+    data[i / 8] = (data[i / 8] << 1) | (width > BIT_ONE_US ? 1 : 0);
+  }
+  if ((uint8_t)(data[0] + data[1] + data[2] + data[3]) != data[4]) return DHT22_CHECKSUM;
+
+  humidity = ((data[0] << 8) | data[1]) * 0.1f;
+  temperature = (((data[2] & 0x7F) << 8) | data[3]) * 0.1f;
+  if (data[2] & 0x80) temperature = -temperature;
+  return DHT22_OK;
+}
+
+float heatIndexC(float temperature, float humidity) {
+  float t = temperature * 1.8f + 32.0f;
+  float h = humidity;
+  float hi = 0.5f * (t + 61.0f + ((t - 68.0f) * 1.2f) + (h * 0.094f));
+  if (hi > 79.0f) {
+    hi = -42.379f + 2.04901523f * t + 10.14333127f * h - 0.22475541f * t * h -
+         0.00683783f * t * t - 0.05481717f * h * h + 0.00122874f * t * t * h +
+         0.00085282f * t * h * h - 0.00000199f * t * t * h * h;
+    if (h < 13.0f && t >= 80.0f && t <= 112.0f)
+      hi -= ((13.0f - h) * 0.25f) * sqrtf((17.0f - fabsf(t - 95.0f)) * 0.05882f);
+    else if (h > 85.0f && t >= 80.0f && t <= 87.0f)
+      hi += ((h - 85.0f) * 0.1f) * ((87.0f - t) * 0.2f);
+  }
+  return (hi - 32.0f) * 0.55555f;
+}
+
+#ifdef ARDUINO
+static const uint32_t START_LOW_US = 1100;   // host giữ mức thấp >= 1 ms
+static const uint32_t CAPTURE_US = 6000;     // phản hồi 160 µs + 40 bit x tối đa 120 µs
+
+Dht22::Dht22(uint8_t pin, uint32_t minIntervalMs) : pin(pin), minIntervalMs(minIntervalMs) {}
+
+void Dht22::begin() {
+  pinMode(pin, INPUT_PULLUP);
+  esp_timer_create_args_t args = {};
+  args.callback = &Dht22::onTimer;
+  args.arg = this;
+  args.name = "dht22";
+  esp_timer_create(&args, &timer);
+}
+
+bool Dht22::start() {
+  uint32_t now = millis();
+  if (state != IDLE || (everStarted && now - startedMs < minIntervalMs)) {
+    portENTER_CRITICAL(&mux);
+    counters.deferred++;
+    portEXIT_CRITICAL(&mux);
+    return false;
+  }
+  everStarted = true;
+  startedMs = now;
+  portENTER_CRITICAL(&mux);
+  counters.started++;
+  portEXIT_CRITICAL(&mux);
+  state = START_LOW;
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+  esp_timer_start_once(timer, START_LOW_US);
+  return true;
+}
+
+void Dht22::onTimer(void* arg) {
+  Dht22* self = (Dht22*)arg;
+  if (self->state == START_LOW) {
+    self->edgeCount = 0;
+    pinMode(self->pin, INPUT_PULLUP);   // nhả đường truyền, cảm biến bắt đầu trả lời
+    attachInterruptArg(self->pin, &Dht22::onEdge, self, FALLING);
+    self->state = CAPTURE;
+    esp_timer_start_once(self->timer, CAPTURE_US);
+  } else if (self->state == CAPTURE) {
+    self->finish();
+  }
+}
+
+void IRAM_ATTR Dht22::onEdge(void* arg) {
+  Dht22* self = (Dht22*)arg;
+  uint8_t n = self->edgeCount;
+  if (n < sizeof(self->edges) / sizeof(self->edges[0])) {
+    self->edges[n] = micros();
+    self->edgeCount = n + 1;
+  }
+}
+
+void Dht22::finish() {
+  detachInterrupt(pin);
+  uint32_t captured[sizeof(edges) / sizeof(edges[0])];
+  uint8_t count = edgeCount;
+  for (uint8_t i = 0; i < count; i++) captured[i] = edges[i];
+
+  float t, h;
+  Dht22Status result = dht22Decode(captured, count, t, h);
+
+  portENTER_CRITICAL(&mux);
+  switch (result) {
+    case DHT22_OK:
+      counters.ok++;
+      temperature = t;
+      humidity = h;
+      goodMs = millis();
+      seq = seq + 1;
+      break;
+    case DHT22_TIMEOUT:  counters.timeouts++; break;
+    case DHT22_FRAME:    counters.frameErrors++; break;
+    case DHT22_CHECKSUM: counters.checksumErrors++; break;
+  }
+  status = result;
+  portEXIT_CRITICAL(&mux);
+  state = IDLE;
+}
+
+bool Dht22::read(float& t, float& h, uint32_t maxAgeMs) const {
+  portENTER_CRITICAL(&mux);
+  t = temperature;
+  h = humidity;
+  uint32_t at = goodMs;
+  bool have = seq > 0;
+  portEXIT_CRITICAL(&mux);
+
+  if (!have || (maxAgeMs && millis() - at > maxAgeMs)) {
+    t = h = NAN;
+    return false;
+  }
+  return true;
+}
+
+Dht22Stats Dht22::stats() const {
+  portENTER_CRITICAL(&mux);
+  Dht22Stats s = counters;
+  portEXIT_CRITICAL(&mux);
+  return s;
+}
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+
+/* ===== Dht22 =====
+ * Đọc DHT22 không chặn. start() kéo chân data xuống rồi trả về ngay; phần còn
+ * lại chạy nền: esp_timer nhả chân sau 1.1 ms, ngắt GPIO ghi thời điểm các cạnh
+ * xuống, và một esp_timer thứ hai giải mã 40 bit khi khung truyền đã xong.
+ * Kết quả hợp lệ gần nhất được giữ lại cho read(); khoảng cách tối thiểu 2 s
+ * giữa hai lần đo do chính driver đảm bảo.
+ */
+
+enum Dht22Status : uint8_t {
+  DHT22_OK = 0,
+  DHT22_TIMEOUT,   // không đủ cạnh xung (cảm biến không trả lời / đứt dây)
+  DHT22_FRAME,     // độ rộng bit nằm ngoài khoảng hợp lệ
+  DHT22_CHECKSUM,
+};
+
+// Số cạnh xuống cần cho 40 bit: cạnh đầu mỗi bit + cạnh kết thúc bit cuối
+const uint8_t DHT22_EDGES = 41;
+const uint32_t DHT22_MIN_INTERVAL_MS = 2000;
+
+// Giải mã từ thời điểm (µs) các cạnh xuống; dùng DHT22_EDGES cạnh cuối cùng nên
+// cạnh phản hồi đầu khung có bị bắt hay không cũng không ảnh hưởng.
+Dht22Status dht22Decode(const uint32_t* fallUs, uint8_t count, float& temperature, float& humidity);
+
+// Chỉ số nhiệt (°C), cùng công thức với DHT::computeHeatIndex()
+float heatIndexC(float temperature, float humidity);
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+
+struct Dht22Stats {
+  uint32_t started;    // start() đã phát xung kích; lớn hơn tổng kết quả khi đang đo
+  uint32_t ok;
+  uint32_t timeouts;
+  uint32_t frameErrors;
+  uint32_t checksumErrors;
+  uint32_t deferred;   // start() bị từ chối vì chưa đủ khoảng cách tối thiểu / đang đo
+};
+
+class Dht22 {
+public:
+  explicit Dht22(uint8_t pin, uint32_t minIntervalMs = DHT22_MIN_INTERVAL_MS);
+
+  void begin();
+  // Bắt đầu một lần đo; false nếu đang đo hoặc chưa đủ minIntervalMs
+  bool start();
+  bool busy() const { return state != IDLE; }
+
+  // Giá trị hợp lệ gần nhất; false nếu chưa có hoặc cũ hơn maxAgeMs (0 = không giới hạn)
+  bool read(float& temperature, float& humidity, uint32_t maxAgeMs = 0) const;
+  // Tăng mỗi khi có một kết quả hợp lệ mới
+  uint32_t sequence() const { return seq; }
+  Dht22Status lastStatus() const { return status; }
+  Dht22Stats stats() const;
+
+private:
+  enum State : uint8_t { IDLE, START_LOW, CAPTURE };
+
+  static void onTimer(void* arg);
+  static void IRAM_ATTR onEdge(void* arg);
+  void finish();
+
+  uint8_t pin;
+  uint32_t minIntervalMs;
+  esp_timer_handle_t timer = nullptr;
+  mutable portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+  volatile State state = IDLE;
+  volatile uint8_t edgeCount = 0;
+  volatile uint32_t edges[DHT22_EDGES + 4];
+
+  bool everStarted = false;
+  uint32_t startedMs = 0;
+  uint32_t goodMs = 0;
+  float temperature = NAN, humidity = NAN;
+  volatile uint32_t seq = 0;
+  volatile Dht22Status status = DHT22_TIMEOUT;
+  Dht22Stats counters = {};
+};
+#endif
@@ -0,0 +1,135 @@
+#include "Dispatcher.h"
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool CommandDispatcher::dispatch(const char* topic, const uint8_t* payload, size_t length) {
+  uint32_t h = 2166136261u;
+  for (const char* p = topic; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+
+  for (size_t i = 0; i < count; i++) {
+    if (routes[i].hash != h || strcmp(routes[i].topic, topic) != 0) continue;
+    routes[i].handler(payload, length);
+    handled++;
+    return true;
+  }
+  unmatched++;
+  return false;
+}
+
+bool topicMatches(const char* filter, const char* topic) {
+  while (*filter) {
+    if (*filter == '#') return true;
+    if (*filter == '/' && !*topic && filter[1] == '#' && !filter[2]) return true;   // mức cha của "/#"
+    if (*filter == '+') {
+      while (*topic && *topic != '/') topic++;
+      filter++;
+      continue;
+    }
+    if (*filter != *topic) return false;
+    filter++;
+    topic++;
+  }
+  return *topic == '\0';
+}
+
+bool topicLevel(const char* topic, uint8_t index, const char*& start, size_t& length) {
+  for (; index; index--) {
+    topic = strchr(topic, '/');
+    if (!topic) return false;
+    topic++;
+  }
+  const char* end = strchr(topic, '/');
+  start = topic;
+  length = end ? (size_t)(end - topic) : strlen(topic);
+  return true;
+}
+
+static inline bool isSpace(uint8_t c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+static inline uint8_t lower(uint8_t c) { return (c >= 'A' && c <= 'Z') ? c + 32 : c; }
+
+size_t payloadTrim(const uint8_t*& payload, size_t length) {
+  while (length && isSpace(payload[0])) { payload++; length--; }
+  while (length && isSpace(payload[length - 1])) length--;
+  return length;
+}
+
+bool payloadIs(const uint8_t* payload, size_t length, const char* word) {
+  size_t n = strlen(word);
+  return n == length && memcmp(payload, word, n) == 0;
+}
+
+bool payloadIsNoCase(const uint8_t* payload, size_t length, const char* word) {
+  size_t n = strlen(word);
+  if (n != length) return false;
+  for (size_t i = 0; i < n; i++)
+    if (lower(payload[i]) != lower((uint8_t)word[i])) return false;
+  return true;
+}
+
+bool payloadStartsWith(const uint8_t* payload, size_t length, const char* prefix) {
+  size_t n = strlen(prefix);
+  return n <= length && memcmp(payload, prefix, n) == 0;
+}
+
+int8_t payloadBool(const uint8_t* payload, size_t length) {
+  if (payloadIs(payload, length, "true")) return 1;
+  if (payloadIs(payload, length, "false")) return 0;
+  return -1;
+}
+
+bool payloadInt(const uint8_t* payload, size_t length, long& out) {
+  length = payloadTrim(payload, length);
+  if (length == 0) return false;
+  bool neg = payload[0] == '-';
+  size_t i = (neg || payload[0] == '+') ? 1 : 0;
+  if (i == length) return false;
+  // long 32 bit trên ESP32: giới hạn theo kiểu nhỏ hơn, tràn thì từ chối thay vì quấn vòng
+  const unsigned long limit = (unsigned long)LONG_MAX < UINT32_MAX ? (unsigned long)LONG_MAX : UINT32_MAX;
+  unsigned long v = 0;
+  for (; i < length; i++) {
+    if (payload[i] < '0' || payload[i] > '9') return false;
+    unsigned digit = payload[i] - '0';
+    if (v > (limit - digit) / 10) return false;
+    v = v * 10 + digit;
+  }
+  out = neg ? -(long)v : (long)v;
+  return true;
+}
+
+bool payloadFloat(const uint8_t* payload, size_t length, float& out) {
+  length = payloadTrim(payload, length);
+  char text[24];
+  if (length == 0 || length >= sizeof(text)) return false;
+  memcpy(text, payload, length);
+  text[length] = '\0';
+  char* end;
+  float v = strtof(text, &end);
+  if (end != text + length || !isfinite(v)) return false;
+  out = v;
+  return true;
+}
+
+bool payloadHexColor(const uint8_t* payload, size_t length, uint32_t& out) {
+  length = payloadTrim(payload, length);
+  if (length && payload[0] == '#') { payload++; length--; }
+  if (length != 6) return false;
+  uint32_t v = 0;
+  for (size_t i = 0; i < 6; i++) {
+    uint8_t c = lower(payload[i]);
+    if (c >= '0' && c <= '9') v = (v << 4) | (c - '0');
+    else if (c >= 'a' && c <= 'f') v = (v << 4) | (c - 'a' + 10);
+    else return false;
+  }
+  out = v;
+  return true;
+}
+
+size_t payloadCopy(const uint8_t* payload, size_t length, char* out, size_t capacity) {
+  if (capacity == 0) return 0;
+  if (length >= capacity) length = capacity - 1;
+  memcpy(out, payload, length);
+  out[length] = '\0';
+  return length;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* ===== Dispatcher =====
+ * Bảng topic -> handler cho callback MQTT. Hash FNV-1a của topic được tính một
+ * lần khi khởi tạo bảng (lúc biên dịch nếu bảng và topic đều constexpr); mỗi message chỉ hash topic nhận được, so hash rồi
+ * strcmp để xác nhận. Payload được đọc tại chỗ từ buffer của PubSubClient,
+ * không tạo String, không cấp phát heap.
+ */
+
+typedef void (*CommandHandler)(const uint8_t* payload, size_t length);
+
+struct CommandRoute {
+  const char* topic;
+  uint32_t hash;
+  CommandHandler handler;
+};
+
+constexpr uint32_t topicHash(const char* s, uint32_t h = 2166136261u) {
+  return *s ? topicHash(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+
+constexpr size_t topicLength(const char* s) { return *s ? 1 + topicLength(s + 1) : 0; }
+
+#define COMMAND_ROUTE(topic, handler) { topic, topicHash(topic), handler }
+
+class CommandDispatcher {
+public:
+  CommandDispatcher(const CommandRoute* routes, size_t count) : routes(routes), count(count) {}
+
+  // false nếu không có handler cho topic
+  bool dispatch(const char* topic, const uint8_t* payload, size_t length);
+
+  uint32_t handled = 0;
+  uint32_t unmatched = 0;
+
+private:
+  const CommandRoute* routes;
+  size_t count;
+};
+
+// --------------------- Topic -----------------
+// MQTT wildcard: '+' một cấp, '#' phần còn lại ("a/#" khớp cả "a", như broker thật)
+bool topicMatches(const char* filter, const char* topic);
+// Cấp thứ index (0 = cấp đầu) của topic, không chép; false nếu topic ít cấp hơn
+bool topicLevel(const char* topic, uint8_t index, const char*& start, size_t& length);
+
+// --------------------- Đọc payload tại chỗ -----------------
+// Bỏ khoảng trắng hai đầu, trả về độ dài mới
+size_t payloadTrim(const uint8_t*& payload, size_t length);
+bool payloadIs(const uint8_t* payload, size_t length, const char* word);
+bool payloadIsNoCase(const uint8_t* payload, size_t length, const char* word);
+bool payloadStartsWith(const uint8_t* payload, size_t length, const char* prefix);
+// "true"/"false" -> 1/0, còn lại -1
+int8_t payloadBool(const uint8_t* payload, size_t length);
+// Số nguyên thập phân có dấu; false nếu có ký tự thừa hoặc trị tuyệt đối quá UINT32_MAX / LONG_MAX
+bool payloadInt(const uint8_t* payload, size_t length, long& out);
+// Số thập phân ("36.5", "-2", "1e3"); false nếu có ký tự thừa, quá dài hoặc không hữu hạn
+bool payloadFloat(const uint8_t* payload, size_t length, float& out);
+// "#RRGGBB" hoặc "RRGGBB"
+bool payloadHexColor(const uint8_t* payload, size_t length, uint32_t& out);
+// Chép vào chuỗi C có giới hạn, trả về số ký tự đã chép
+size_t payloadCopy(const uint8_t* payload, size_t length, char* out, size_t capacity);
@@ -0,0 +1,213 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+/* ===== Filters =====
+ * Các tầng lọc dạng streaming, kích thước cố định, không cấp phát động; mọi
+ * tham số là tham số template nên được cố định lúc biên dịch:
+ *  - MedianFilter<T, N>:        trung vị trượt N mẫu, O(log N) mỗi mẫu
+ *  - EmaFilter<T, NUM, DEN>:    EMA với alpha = NUM/DEN
+ *  - Deadband<T, BAND>:         giữ nguyên đầu ra khi thay đổi <= BAND
+ *  - Hysteresis<T, LOW, HIGH>:  Schmitt trigger, true khi > HIGH, false khi < LOW
+ * Ghép bằng FilterChain<...>, ví dụ trung vị 7 -> EMA 0.15 -> deadband 4:
+ *   FilterChain<MedianFilter<int, 7>, EmaFilter<int, 3, 20>, Deadband<int, 4>> ldr;
+ *   int stable = ldr.update(raw);
+ */
+
+// Trung vị trượt bằng hai heap quanh phần tử giữa (heap[0]): heap max ở chỉ số
+// âm, heap min ở chỉ số dương. Mẫu mới thay thế đúng vị trí heap của mẫu cũ nhất
+// rồi được sift lên/xuống, nên không cần sắp xếp lại cả cửa sổ.
+template <typename T, size_t N>
+class MedianFilter {
+  static_assert(N >= 1 && N < 32768, "MedianFilter window out of range");
+
+public:
+  typedef T value_type;
+
+  MedianFilter() { reset(); }
+
+  void reset() {
+    idx = 0;
+    ct = 0;
+    for (size_t i = 0; i < N; i++) data[i] = T();
+    // thứ tự lấp đầy ban đầu: giữa, max, min, max, min...
+    for (int16_t i = N - 1; i >= 0; i--) {
+      pos[i] = ((i + 1) / 2) * ((i & 1) ? -1 : 1);
+      heap()[pos[i]] = i;
+    }
+  }
+
+  T update(T v) {
+    bool fresh = ct < (int16_t)N;
+    int16_t p = pos[idx];
+    T old = data[idx];
+    data[idx] = v;
+    idx = (idx + 1) % N;
+    ct += fresh;
+
+    if (p > 0) {
+      if (!fresh && old < v) minSortDown(p * 2);
+      else if (minSortUp(p)) maxSortDown(-1);
+    } else if (p < 0) {
+      if (!fresh && v < old) maxSortDown(p * 2);
+      else if (maxSortUp(p)) minSortDown(1);
+    } else {
+      if (maxCt()) maxSortDown(-1);
+      if (minCt()) minSortDown(1);
+    }
+    return median();
+  }
+
+  T median() const { return data[heapStore[N / 2]]; }
+  size_t size() const { return ct; }
+
+private:
+  int16_t* heap() { return heapStore + N / 2; }
+  int16_t minCt() const { return (ct - 1) / 2; }
+  int16_t maxCt() const { return ct / 2; }
+
+  bool less(int16_t i, int16_t j) { return data[heap()[i]] < data[heap()[j]]; }
+
+  void exchange(int16_t i, int16_t j) {
+    int16_t* h = heap();
+    int16_t t = h[i];
+    h[i] = h[j];
+    h[j] = t;
+    pos[h[i]] = i;
+    pos[h[j]] = j;
+  }
+
+  bool cmpExchange(int16_t i, int16_t j) {
+    if (!less(i, j)) return false;
+    exchange(i, j);
+    return true;
+  }
+
+  // i là con đầu tiên cần so với cha (1 / -1 = so với phần tử giữa)
+  void minSortDown(int16_t i) {
+    for (; i <= minCt(); i *= 2) {
+      if (i > 1 && i < minCt() && less(i + 1, i)) ++i;
+      if (!cmpExchange(i, i / 2)) break;
+    }
+  }
+
+  void maxSortDown(int16_t i) {
+    for (; i >= -maxCt(); i *= 2) {
+      if (i < -1 && i > -maxCt() && less(i, i - 1)) --i;
+      if (!cmpExchange(i / 2, i)) break;
+    }
+  }
+
+  // true nếu phần tử giữa (trung vị) thay đổi
+  bool minSortUp(int16_t i) {
+    while (i > 0 && cmpExchange(i, i / 2)) i /= 2;
+    return i == 0;
+  }
+
+  bool maxSortUp(int16_t i) {
+    while (i < 0 && cmpExchange(i / 2, i)) i /= 2;
+    return i == 0;
+  }
+
+  T data[N];
+  int16_t pos[N];                 // vị trí trong heap của từng mẫu
+  int16_t heapStore[N + 1];       // chỉ số -N/2 .. N/2
+  int16_t idx, ct;
+};
+
+// Làm tròn kết quả EMA về kiểu đầu ra (số nguyên làm tròn gần nhất, float giữ nguyên)
+template <typename T> struct FilterRound {
+  static T from(float v) { return (T)lroundf(v); }
+};
+template <> struct FilterRound<float> {
+  static float from(float v) { return v; }
+};
+
+template <typename T, int NUM, int DEN>
+class EmaFilter {
+  static_assert(NUM > 0 && NUM <= DEN, "EMA alpha must be in (0, 1]");
+
+public:
+  typedef T value_type;
+
+  void reset() { primed = false; }
+
+  T update(T x) {
+    const float alpha = (float)NUM / DEN;
+    state = primed ? alpha * x + (1.0f - alpha) * state : (float)x;
+    primed = true;
+    return FilterRound<T>::from(state);
+  }
+
+private:
+  float state = 0;
+  bool primed = false;
+};
+
+template <typename T, int BAND>
+class Deadband {
+public:
+  typedef T value_type;
+
+  void reset() { primed = false; }
+
+  T update(T x) {
+    T d = x > held ? x - held : held - x;
+    if (!primed || d > BAND) held = x;
+    primed = true;
+    return held;
+  }
+
+private:
+  T held = T();
+  bool primed = false;
+};
+
+template <typename T, int LOW, int HIGH>
+class Hysteresis {
+  static_assert(LOW <= HIGH, "Hysteresis LOW must not exceed HIGH");
+
+public:
+  typedef T value_type;
+
+  bool update(T x) {
+    if (x > HIGH) state = true;
+    else if (x < LOW) state = false;
+    return state;
+  }
+  // Đồng bộ với trạng thái bị đổi từ bên ngoài (vd. lệnh bật/tắt tay)
+  void set(bool on) { state = on; }
+  bool value() const { return state; }
+
+private:
+  bool state = false;
+};
+
+template <typename... Stages> class FilterChain;
+
+template <typename Last>
+class FilterChain<Last> {
+public:
+  typedef typename Last::value_type value_type;
+  value_type update(value_type x) { return last.update(x); }
+  void reset() { last.reset(); }
+
+private:
+  Last last;
+};
+
+template <typename First, typename... Rest>
+class FilterChain<First, Rest...> {
+public:
+  typedef typename First::value_type value_type;
+  value_type update(value_type x) { return rest.update(head.update(x)); }
+  void reset() {
+    head.reset();
+    rest.reset();
+  }
+
+private:
+  First head;
+  FilterChain<Rest...> rest;
+};
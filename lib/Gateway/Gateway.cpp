@@ -0,0 +1,251 @@
+#include "Gateway.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Dispatcher.h>
+
+// Kênh text như src/main.cpp đặt tên, theo thứ tự GatewayChannel
+static const char* const CHANNEL_TOPICS[GATEWAY_CHANNELS] = { "temperature", "humidity", "light", "soil_moisture" };
+static const char* const CHANNEL_KEYS[GATEWAY_CHANNELS] = { "t", "h", "l", "s" };
+static const char* const CHANNEL_FORMATS[GATEWAY_CHANNELS] = {
+  ",\"%s\":[%.2f,%.2f,%.2f]", ",\"%s\":[%.1f,%.1f,%.1f]", ",\"%s\":[%.0f,%.0f,%.0f]", ",\"%s\":[%.0f,%.0f,%.0f]",
+};
+
+static uint32_t fnv1a(const char* s, size_t length) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < length; i++) h = (h ^ (uint8_t)s[i]) * 16777619u;
+  return h;
+}
+
+// nodeId đi thẳng vào JSON nên chỉ nhận ký tự an toàn
+static bool validId(const char* s, size_t length) {
+  if (!length || length >= GATEWAY_ID_LEN) return false;
+  for (size_t i = 0; i < length; i++) {
+    char c = s[i];
+    bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+              c == '-' || c == '_' || c == '.';
+    if (!ok) return false;
+  }
+  return true;
+}
+
+static bool levelIs(const char* level, size_t length, const char* word) {
+  return strlen(word) == length && memcmp(level, word, length) == 0;
+}
+
+// Tách topic một lần thành tối đa max cấp; trả về số cấp (max + 1 nếu còn nhiều hơn)
+static uint8_t splitTopic(const char* topic, const char** levels, size_t* lengths, uint8_t max) {
+  uint8_t n = 0;
+  const char* start = topic;
+  for (const char* p = topic;; p++) {
+    if (*p != '/' && *p) continue;
+    if (n == max) return max + 1;
+    levels[n] = start;
+    lengths[n++] = p - start;
+    if (!*p) return n;
+    start = p + 1;
+  }
+}
+
+// "-12.34" như firmware gửi ("%.2f", "%d") không qua strtof; dạng khác (nan, mũ) thì strtof.
+// inf và số tràn float (1e39) bị từ chối: lọt vào tổng hợp thì JSON gửi đi có "inf", không hợp lệ
+static bool parseValue(const char* text, float& out) {
+  const char* p = text;
+  bool negative = *p == '-';
+  if (negative) p++;
+  int32_t whole = 0, frac = 0, scale = 1;
+  const char* digits = p;
+  while (*p >= '0' && *p <= '9' && p - digits < 7) whole = whole * 10 + (*p++ - '0');
+  bool simple = p > digits;
+  if (simple && *p == '.') {
+    p++;
+    while (*p >= '0' && *p <= '9' && scale < 100000) { frac = frac * 10 + (*p++ - '0'); scale *= 10; }
+  }
+  if (simple && !*p) {
+    out = (whole + (float)frac / scale) * (negative ? -1 : 1);
+    return true;
+  }
+  char* end;
+  out = strtof(text, &end);
+  return end != text && !*end && !isinf(out);
+}
+
+static void clearAggregates(NodeSlot& node) {
+  memset(node.ch, 0, sizeof(node.ch));
+  node.readings = 0;
+  node.pending = false;
+}
+
+Gateway::Gateway(NodeSlot* slots, uint16_t capacity, const char* root)
+    : slots(slots), slotCount(capacity), used(0), root(root), rootLength(strlen(root)),
+      cursor(0), flushing(false), closedMs(0), part(0) {
+  memset(slots, 0, sizeof(NodeSlot) * capacity);
+}
+
+NodeSlot* Gateway::lookup(const char* id, size_t length, bool create) {
+  if (!slotCount) return nullptr;
+  uint32_t h = fnv1a(id, length);
+  uint16_t k = h % slotCount;
+  for (uint16_t i = 0; i < slotCount; i++) {
+    NodeSlot& node = slots[k];
+    if (!node.id[0]) {
+      if (!create) return nullptr;
+      memcpy(node.id, id, length);
+      node.id[length] = '\0';
+      node.hash = h;
+      used++;
+      return &node;
+    }
+    if (node.hash == h && node.id[length] == '\0' && memcmp(node.id, id, length) == 0) return &node;
+    if (++k == slotCount) k = 0;
+  }
+  return nullptr;
+}
+
+const NodeSlot* Gateway::find(const char* id) const {
+  return const_cast<Gateway*>(this)->lookup(id, strlen(id), false);
+}
+
+void Gateway::add(NodeSlot& node, GatewayChannel ch, float value) {
+  if (isnan(value) || value <= -999.0f) return;   // lỗi cảm biến
+  ChannelAggregate& a = node.ch[ch];
+  if (a.count == UINT16_MAX) return;
+  if (!a.count || value < a.min) a.min = value;
+  if (!a.count || value > a.max) a.max = value;
+  a.sum += value;
+  a.count++;
+  node.readings++;
+  node.pending = true;
+  readings++;
+}
+
+bool Gateway::ingest(const char* topic, const uint8_t* payload, size_t length, uint32_t nowMs) {
+  messages++;
+  // <root>/<nodeId>/sensors/<kênh>
+  const char* levels[4];
+  size_t lengths[4];
+  if (splitTopic(topic, levels, lengths, 4) != 4 || lengths[0] != rootLength || memcmp(levels[0], root, rootLength) ||
+      !levelIs(levels[2], lengths[2], "sensors") || !validId(levels[1], lengths[1])) {
+    ignored++;
+    return false;
+  }
+  const char* id = levels[1];
+  size_t idLength = lengths[1];
+  const char* channel = levels[3];
+  size_t channelLength = lengths[3];
+  bool frame = levelIs(channel, channelLength, "frame");
+  int8_t ch = -1;
+  for (uint8_t i = 0; i < GATEWAY_CHANNELS && !frame && ch < 0; i++)
+    if (levelIs(channel, channelLength, CHANNEL_TOPICS[i])) ch = i;
+  if (!frame && ch < 0) {
+    ignored++;
+    return false;
+  }
+
+  NodeSlot* node = lookup(id, idLength, true);
+  if (!node) {
+    rejectedNodes++;
+    return false;
+  }
+  node->lastSeenMs = nowMs;
+  node->messages++;
+  bool ok = frame ? ingestFrame(*node, payload, length) : ingestText(*node, (GatewayChannel)ch, payload, length);
+  if (!ok) badPayloads++;
+  return ok;
+}
+
+bool Gateway::ingestText(NodeSlot& node, GatewayChannel ch, const uint8_t* payload, size_t length) {
+  length = payloadTrim(payload, length);
+  char text[16];
+  if (!length || length >= sizeof(text)) return false;
+  payloadCopy(payload, length, text, sizeof(text));
+  float value;
+  if (!parseValue(text, value)) return false;
+  add(node, ch, value);
+  return true;
+}
+
+bool Gateway::ingestFrame(NodeSlot& node, const uint8_t* payload, size_t length) {
+  TelemetryHeader header;
+  SensorSample samples[TELEMETRY_MAX_BATCH];
+  int count = decodeTelemetryFrame(payload, length, header, samples, TELEMETRY_MAX_BATCH);
+  if (count < 0) return false;
+  frames++;
+  // seq nhỏ hơn mong đợi: node khởi động lại, đếm lại từ khung này
+  if (node.nextSeq && header.seq > node.nextSeq) {
+    uint32_t lost = header.seq - node.nextSeq;
+    node.framesLost += lost;
+    framesLost += lost;
+  }
+  node.nextSeq = header.seq + 1;
+  for (int i = 0; i < count; i++) {
+    add(node, CH_TEMP, samples[i].temp);
+    add(node, CH_HUM, samples[i].hum);
+    add(node, CH_LIGHT, samples[i].light);
+    add(node, CH_SOIL, samples[i].soil);
+  }
+  return true;
+}
+
+uint16_t Gateway::closeInterval(uint32_t nowMs) {
+  uint16_t pending = 0;
+  for (uint16_t i = 0; i < slotCount; i++) pending += slots[i].pending;
+  intervals++;
+  closedMs = nowMs;
+  cursor = 0;
+  part = 0;
+  flushing = true;
+  return pending;
+}
+
+size_t Gateway::formatNode(const NodeSlot& node, char* out, size_t capacity) const {
+  int len = snprintf(out, capacity, "{\"id\":\"%s\",\"n\":%u", node.id, (unsigned)node.readings);
+  for (uint8_t c = 0; c < GATEWAY_CHANNELS && len >= 0 && (size_t)len < capacity; c++) {
+    const ChannelAggregate& a = node.ch[c];
+    if (a.count) len += snprintf(out + len, capacity - len, CHANNEL_FORMATS[c], CHANNEL_KEYS[c], a.sum / a.count, a.min, a.max);
+    else len += snprintf(out + len, capacity - len, ",\"%s\":null", CHANNEL_KEYS[c]);
+  }
+  if (len < 0 || (size_t)len + 1 >= capacity) return 0;
+  out[len++] = '}';
+  out[len] = '\0';
+  return len;
+}
+
+size_t Gateway::nextChunk(char* out, size_t capacity) {
+  if (!flushing) return 0;
+  int head = snprintf(out, capacity, "{\"t\":%lu,\"seq\":%lu,\"part\":%u,\"nodes\":[",
+                      (unsigned long)closedMs, (unsigned long)intervals, (unsigned)part);
+  if (head < 0 || (size_t)head + 3 > capacity) return 0;
+  size_t len = head;
+  uint16_t written = 0;
+  for (; cursor < slotCount; cursor++) {
+    NodeSlot& node = slots[cursor];
+    if (!node.pending) continue;
+    size_t sep = written ? 1 : 0;
+    // chừa "]}" và '\0' sau node
+    size_t n = capacity > len + sep + 2 ? formatNode(node, out + len + sep, capacity - len - sep - 2) : 0;
+    if (!n) {
+      if (written) break;        // message này đã đầy, node sang message sau
+      oversized++;               // một mình cũng không vừa
+      clearAggregates(node);
+      continue;
+    }
+    if (sep) out[len] = ',';
+    len += sep + n;
+    batchedReadings += node.readings;
+    clearAggregates(node);
+    written++;
+  }
+  if (!written) {
+    flushing = false;
+    return 0;
+  }
+  memcpy(out + len, "]}", 3);
+  len += 2;
+  part++;
+  chunks++;
+  chunkBytes += len;
+  if (len > maxChunkBytes) maxChunkBytes = len;
+  return len;
+}
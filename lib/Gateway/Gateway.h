@@ -0,0 +1,88 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <Telemetry.h>
+
+/* ===== Gateway =====
+ * Gom số đo của nhiều node thành batch theo chu kỳ. ingest() nhận message MQTT
+ * <root>/<nodeId>/sensors/<kênh> (text như src/main.cpp gửi) hoặc .../sensors/frame
+ * (khung nhị phân lib/Telemetry, backlog gửi bù) và cộng vào ô của node: số mẫu,
+ * trung bình/min/max từng kênh trong chu kỳ hiện tại, seq khung để đếm khung mất.
+ * Hết chu kỳ: closeInterval() rồi gọi nextChunk() tới khi trả về 0 — mỗi lần ghi
+ * các node có dữ liệu thành một message JSON không quá capacity byte và xóa ô đó
+ * (ingest() tiếp chỉ sau khi đã ghi hết). Ô node nằm trong bảng băm địa chỉ mở do
+ * người gọi cấp, không cấp phát; node mới khi bảng đầy bị bỏ (rejectedNodes).
+ *
+ *   {"t":<ms cuối chu kỳ>,"seq":<chu kỳ>,"part":<message thứ mấy>,"nodes":[
+ *     {"id":"esp32-a1b2c3","n":<số mẫu>,"t":[avg,min,max],"h":[...],"l":[...],"s":[...]}, ...]}
+ * Kênh không có mẫu trong chu kỳ ghi null.
+ */
+
+enum GatewayChannel : uint8_t { CH_TEMP, CH_HUM, CH_LIGHT, CH_SOIL, GATEWAY_CHANNELS };
+
+struct ChannelAggregate {
+  float sum, min, max;
+  uint16_t count;
+};
+
+const size_t GATEWAY_ID_LEN = 24;   // kể cả '\0'
+
+struct NodeSlot {
+  char id[GATEWAY_ID_LEN];     // "" = ô trống
+  uint32_t hash;
+  ChannelAggregate ch[GATEWAY_CHANNELS];
+  uint16_t readings;           // số mẫu (mọi kênh) trong chu kỳ
+  bool pending;                // có dữ liệu chưa ghi vào batch
+  uint32_t lastSeenMs;
+  uint32_t messages;           // tổng message nhận từ node
+  uint32_t nextSeq;            // seq khung mong đợi kế tiếp, 0 = chưa nhận khung nào
+  uint32_t framesLost;
+};
+
+class Gateway {
+public:
+  Gateway(NodeSlot* slots, uint16_t capacity, const char* root);
+
+  // false nếu không phải số đo của node (topic khác, payload sai, bảng node đầy)
+  bool ingest(const char* topic, const uint8_t* payload, size_t length, uint32_t nowMs);
+
+  // Kết thúc chu kỳ; trả về số node có dữ liệu (sẽ được nextChunk() ghi ra)
+  uint16_t closeInterval(uint32_t nowMs);
+  // Message batch kế tiếp của chu kỳ đã đóng vào out ('\0' ở cuối); 0 khi đã ghi hết
+  size_t nextChunk(char* out, size_t capacity);
+
+  uint16_t nodes() const { return used; }
+  const NodeSlot* find(const char* id) const;
+
+  uint32_t messages = 0;        // message đã nhận vào ingest()
+  uint32_t readings = 0;        // giá trị kênh đã cộng vào ô node
+  uint32_t frames = 0;
+  uint32_t framesLost = 0;      // khung bị nhảy seq (mọi node)
+  uint32_t badPayloads = 0;
+  uint32_t ignored = 0;         // topic không phải số đo
+  uint32_t rejectedNodes = 0;   // message của node mới khi bảng đầy
+  uint32_t intervals = 0;
+  uint32_t chunks = 0;          // message batch đã ghi
+  uint32_t chunkBytes = 0;
+  uint32_t maxChunkBytes = 0;
+  uint32_t batchedReadings = 0; // giá trị kênh đã ghi ra batch
+  uint32_t oversized = 0;       // node không vừa một message, bị bỏ
+
+private:
+  NodeSlot* lookup(const char* id, size_t length, bool create);
+  void add(NodeSlot& node, GatewayChannel ch, float value);
+  bool ingestText(NodeSlot& node, GatewayChannel ch, const uint8_t* payload, size_t length);
+  bool ingestFrame(NodeSlot& node, const uint8_t* payload, size_t length);
+  size_t formatNode(const NodeSlot& node, char* out, size_t capacity) const;
+
+  NodeSlot* slots;
+  uint16_t slotCount;
+  uint16_t used;
+  const char* root;
+  size_t rootLength;
+
+  uint16_t cursor;              // ô kế tiếp nextChunk() xét
+  bool flushing;
+  uint32_t closedMs;
+  uint16_t part;
+};
@@ -0,0 +1,218 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* ===== Hardware abstraction layer =====
+ * Firmware (src/main.cpp) chỉ làm việc qua các interface dưới đây, nên cùng một
+ * logic điều khiển chạy được trên ESP32 (src/hal_esp32.cpp) và trên Linux
+ * (src/native/hal/, env:native) với dữ liệu cảm biến phát lại từ file trace.
+ */
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#endif
+
+struct Rgb {
+  uint8_t r, g, b;
+};
+
+static inline Rgb rgbFromHex(uint32_t hex) {
+  Rgb c = { (uint8_t)(hex >> 16), (uint8_t)(hex >> 8), (uint8_t)hex };
+  return c;
+}
+
+static inline bool operator==(const Rgb& a, const Rgb& b) {
+  return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+static inline bool operator!=(const Rgb& a, const Rgb& b) { return !(a == b); }
+
+// Thống kê đo nhiệt độ/độ ẩm (DHT22), cộng dồn từ khi khởi động
+struct ClimateStats {
+  uint32_t started;          // lần đo đã kích
+  uint32_t ok;
+  uint32_t timeouts;         // cảm biến không trả lời
+  uint32_t frameErrors;
+  uint32_t checksumErrors;
+  uint32_t deferred;         // lần kích bị hoãn (đang đo / chưa đủ khoảng cách tối thiểu)
+};
+
+// DHT22 + các kênh ADC (LDR, độ ẩm đất)
+class SensorHal {
+public:
+  virtual ~SensorHal() {}
+  virtual void begin() {}
+  // Giá trị NaN nếu đọc lỗi; trả về true khi cả hai giá trị hợp lệ
+  virtual bool readClimate(float& temperature, float& humidity) = 0;
+  virtual int readAnalog(uint8_t pin) = 0;
+  virtual ClimateStats climateStats() { return ClimateStats(); }
+};
+
+// Servo van tưới, LED/buzzer báo động, vòng LED WS2812
+class ActuatorHal {
+public:
+  virtual ~ActuatorHal() {}
+  virtual void begin() {}
+  virtual void servoWrite(int angle) = 0;
+  virtual void digitalOut(uint8_t pin, bool high) = 0;
+  virtual void buzzerTone(uint32_t freq) = 0;  // 0 = tắt
+  virtual void showLeds(const Rgb* pixels, uint16_t count) = 0;
+};
+
+// Màn hình OLED SSD1306 128x64
+class DisplayHal {
+public:
+  virtual ~DisplayHal() {}
+  virtual bool begin() = 0;
+  virtual void clear() = 0;
+  virtual void drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap,
+                          int16_t w, int16_t h, bool on) = 0;
+  virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, bool on) = 0;
+  virtual void text(int16_t x, int16_t y, const char* s) = 0;
+  virtual void flush() = 0;  // đẩy toàn bộ framebuffer ra màn hình
+  // Chỉ đẩy page [page0..page1] x cột [col0..col1] (mỗi page = 8 hàng pixel)
+  virtual void flushRegion(uint8_t page0, uint8_t page1, uint8_t col0, uint8_t col1) { flush(); }
+};
+
+typedef void (*MessageHandler)(char* topic, uint8_t* payload, unsigned int length);
+
+// WiFi + MQTT
+class TransportHal {
+public:
+  virtual ~TransportHal() {}
+  virtual void begin(const char* host, uint16_t port, MessageHandler handler) = 0;
+  // Bật WiFi, không chờ; backend nhớ kênh/BSSID/IP lần trước (kể cả qua deep sleep) để vào mạng nhanh
+  virtual void beginLink(const char* ssid, const char* password) = 0;
+  // Tắt hẳn WiFi (trước khi ngủ), beginLink() để bật lại
+  virtual void endLink() {}
+  // Luồng mạng gọi lặp lại trong lúc chờ vào mạng: backend lưu kênh/BSSID/IP, đổi cách vào mạng khi quá hạn
+  virtual void serviceLink() {}
+  // Chỉ hỏi trạng thái, không thay đổi gì (gọi được từ mọi nơi trên luồng mạng)
+  virtual bool linkUp() = 0;
+  virtual const char* localIp() = 0;
+  virtual bool connected() = 0;
+  virtual bool connect(const char* clientId) = 0;
+  virtual int state() = 0;
+  virtual bool subscribe(const char* topic) = 0;
+  virtual bool publish(const char* topic, const uint8_t* payload, size_t length,
+                       bool retained) = 0;
+  virtual void loop() = 0;
+  // Cường độ WiFi (dBm), 0 nếu không có
+  virtual int8_t rssi() { return 0; }
+
+  bool publish(const char* topic, const char* text, bool retained = false) {
+    return publish(topic, (const uint8_t*)text, strlen(text), retained);
+  }
+};
+
+// Vùng flash NOR dành cho dữ liệu (ESP32: phân vùng "spiffs" của bảng phân vùng mặc định,
+// firmware không dùng SPIFFS/LittleFS). Ghi chỉ đổi bit 1 -> 0; muốn ghi lại phải xóa cả
+// sector (về 0xFF). Offset tính từ đầu vùng.
+class FlashHal {
+public:
+  virtual ~FlashHal() {}
+  virtual size_t size() = 0;                 // 0 = không có vùng dữ liệu
+  virtual size_t sectorSize() { return 4096; }
+  virtual bool read(size_t offset, void* out, size_t length) = 0;
+  virtual bool write(size_t offset, const void* data, size_t length) = 0;
+  virtual bool erase(size_t sector) = 0;     // chỉ số sector
+};
+
+// Máy chủ TCP không chặn cho HTTP cục bộ. Kết nối là số do backend cấp (socket), mọi hàm
+// trả về ngay: read/write làm được bao nhiêu thì làm, không chờ mạng.
+class ServerHal {
+public:
+  virtual ~ServerHal() {}
+  virtual bool listen(uint16_t port) = 0;   // false nếu chưa có mạng hoặc không mở được cổng
+  virtual int accept() = 0;                 // kết nối mới, -1 nếu không có
+  // > 0: số byte đọc/ghi được; 0: chưa có dữ liệu / buffer gửi đầy; -1: kết nối đã đóng hoặc lỗi
+  virtual int read(int conn, void* out, size_t capacity) = 0;
+  virtual int write(int conn, const void* data, size_t length) = 0;
+  virtual void close(int conn) = 0;
+};
+
+// Hai phân vùng firmware (A/B) cho cập nhật qua mạng (lib/Ota). running() là bản đang chạy,
+// chỉ đọc; inactive() là phân vùng còn lại, ghi bản mới vào đây. activate() chọn inactive()
+// cho lần khởi động sau (ESP32: otadata, kiểm tra header ảnh), restart() khởi động lại ngay.
+class OtaHal {
+public:
+  virtual ~OtaHal() {}
+  virtual FlashHal& running() = 0;
+  virtual FlashHal& inactive() = 0;
+  virtual bool activate(size_t imageSize) = 0;
+  virtual void restart() = 0;
+};
+
+struct Hal {
+  SensorHal& sensors;
+  ActuatorHal& actuators;
+  DisplayHal& display;
+  TransportHal& transport;
+  FlashHal& flash;
+  ServerHal& server;
+  OtaHal& ota;
+};
+
+// Cài đặt bởi backend (src/hal_esp32.cpp hoặc src/native/hal/)
+Hal& hal();
+void halBegin();
+uint32_t halMillis();
+uint32_t halMicros();
+// Bộ đếm chu kỳ CPU (ESP32: CCOUNT, tràn sau ~17 s ở 240 MHz) để đo đoạn mã ngắn;
+// halCpuMhz() là số chu kỳ mỗi micro-giây. Native: nanosecond của đồng hồ thật, 1000 MHz.
+uint32_t halCycles();
+uint32_t halCpuMhz();
+// Heap còn trống hiện tại và thấp nhất từng ghi nhận (byte), 0 nếu không đo được
+uint32_t halFreeHeap();
+uint32_t halMinFreeHeap();
+void halDelay(uint32_t ms);  // chỉ dùng trong setup()
+// Tên riêng của thiết bị cho clientId/topic MQTT (ESP32: "esp32-" + 3 byte cuối MAC WiFi)
+void halDeviceId(char* out, size_t capacity);
+void halLog(const char* fmt, ...);
+
+// --------------------- Ngủ tiết kiệm năng lượng -----------------
+enum SleepMode : uint8_t { SLEEP_LIGHT, SLEEP_DEEP };
+enum WakeCause : uint8_t { WAKE_POWER_ON, WAKE_TIMER, WAKE_THRESHOLD, WAKE_OTHER };
+
+// Đánh thức sớm khi giá trị thô của kênh ADC1 < below hoặc > above (0 / 4095 = bỏ qua).
+// ESP32: chương trình ULP đọc ADC mỗi pollMs trong lúc ngủ.
+struct WakeThreshold {
+  uint8_t pin;
+  uint16_t below;
+  uint16_t above;
+};
+const uint8_t HAL_MAX_WAKE_THRESHOLDS = 2;
+void halSetWakeThresholds(const WakeThreshold* thresholds, uint8_t count, uint32_t pollMs);
+
+// Ngủ tối đa ms, WiFi phải đã tắt (endLink()). SLEEP_LIGHT giữ RAM và trả về lý do thức dậy.
+// SLEEP_DEEP trên ESP32 không trở về: chip khởi động lại từ setup(), chỉ halRtcMemory() và
+// halMillis() (vẫn tăng liên tục) được giữ; native mô phỏng bằng cách trả về như SLEEP_LIGHT.
+WakeCause halSleep(SleepMode mode, uint32_t ms);
+// Lý do của lần khởi động / thức dậy gần nhất
+WakeCause halWakeCause();
+// Vùng nhớ giữ qua deep sleep (ESP32: RTC slow memory), HAL_RTC_BYTES byte, ban đầu toàn 0
+const size_t HAL_RTC_BYTES = 3072;
+uint8_t* halRtcMemory();
+
+// --------------------- Lưu bền (NVS) -----------------
+// Blob nhỏ theo khóa, giữ qua mất điện và nạp lại firmware (ESP32: NVS namespace "garden";
+// native: trong RAM của tiến trình). halNvsRead trả về số byte đã đọc, 0 nếu chưa có khóa
+// hoặc blob lớn hơn capacity. Ghi chậm (ms) và có giới hạn số lần: chỉ ghi khi giá trị đổi.
+size_t halNvsRead(const char* key, void* out, size_t capacity);
+bool halNvsWrite(const char* key, const void* data, size_t length);
+
+// Luồng chạy nền gắn với một core (ESP32: task FreeRTOS). fn được gọi lặp lại và
+// trả về số ms tối đa được ngủ trước lần gọi kế tiếp; halWakeWorker() đánh thức sớm.
+// Backend không có luồng (native) trả về NO_WORKER, khi đó firmware tự gọi fn trong loop().
+typedef uint32_t (*WorkerFn)();
+typedef int8_t WorkerId;
+const WorkerId NO_WORKER = -1;
+
+WorkerId halStartWorker(const char* name, WorkerFn fn, uint8_t core, uint32_t stackBytes, uint8_t priority);
+void halWakeWorker(WorkerId worker);
+// Stack còn trống ít nhất từng ghi nhận (byte); NO_WORKER = luồng đang gọi. 0 nếu không đo được
+uint32_t halStackHighWater(WorkerId worker);
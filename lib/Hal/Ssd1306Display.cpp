@@ -0,0 +1,42 @@
+#ifdef ARDUINO
+#include "Ssd1306Display.h"
+#include <Wire.h>
+
+bool Ssd1306Display::begin() {
+  if (!oled.begin(SSD1306_SWITCHCAPVCC, address)) return false;
+  oled.setTextColor(SSD1306_WHITE);
+  oled.setTextSize(1);
+  // flushRegion() ghi thẳng qua Wire; OLED là thiết bị I2C duy nhất nên giữ bus ở 400 kHz
+  Wire.setClock(400000);
+  return true;
+}
+
+void Ssd1306Display::flushRegion(uint8_t page0, uint8_t page1, uint8_t col0, uint8_t col1) {
+  const uint8_t pages = oled.height() / 8;
+  const uint8_t width = oled.width();
+  if (page1 >= pages) page1 = pages - 1;
+  if (col1 >= width) col1 = width - 1;
+  if (page0 > page1 || col0 > col1) return;
+
+  // cửa sổ địa chỉ (horizontal addressing mode do begin() cấu hình)
+  oled.ssd1306_command(SSD1306_PAGEADDR);
+  oled.ssd1306_command(page0);
+  oled.ssd1306_command(page1);
+  oled.ssd1306_command(SSD1306_COLUMNADDR);
+  oled.ssd1306_command(col0);
+  oled.ssd1306_command(col1);
+
+  const uint8_t* buffer = oled.getBuffer();
+  for (uint8_t page = page0; page <= page1; page++) {
+    const uint8_t* row = buffer + page * width;
+    uint8_t col = col0;
+    while (col <= col1) {
+      // buffer Wire nhỏ: mỗi giao dịch 1 byte control + tối đa 31 byte dữ liệu
+      Wire.beginTransmission(address);
+      Wire.write((uint8_t)0x40);
+      for (uint8_t n = 0; n < 31 && col <= col1; n++, col++) Wire.write(row[col]);
+      Wire.endTransmission();
+    }
+  }
+}
+#endif
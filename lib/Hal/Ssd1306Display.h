@@ -0,0 +1,31 @@
+#pragma once
+#ifdef ARDUINO
+// DisplayHal trên Adafruit_SSD1306, có thêm flushRegion() gửi riêng một vùng
+// page/cột qua I2C thay vì cả framebuffer 1 KB như display()
+#include <Adafruit_SSD1306.h>
+#include "Hal.h"
+
+class Ssd1306Display : public DisplayHal {
+public:
+  Ssd1306Display(Adafruit_SSD1306& oled, uint8_t address = 0x3C) : oled(oled), address(address) {}
+
+  bool begin() override;
+  void clear() override { oled.clearDisplay(); }
+  void drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h, bool on) override {
+    oled.drawBitmap(x, y, bitmap, w, h, on ? SSD1306_WHITE : SSD1306_BLACK);
+  }
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, bool on) override {
+    oled.fillRect(x, y, w, h, on ? SSD1306_WHITE : SSD1306_BLACK);
+  }
+  void text(int16_t x, int16_t y, const char* s) override {
+    oled.setCursor(x, y);
+    oled.print(s);
+  }
+  void flush() override { oled.display(); }
+  void flushRegion(uint8_t page0, uint8_t page1, uint8_t col0, uint8_t col1) override;
+
+private:
+  Adafruit_SSD1306& oled;
+  uint8_t address;
+};
+#endif
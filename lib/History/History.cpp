@@ -0,0 +1,460 @@
+#include "History.h"
+#include <math.h>
+#include <string.h>
+
+static const uint32_t HISTORY_MAGIC = 0x31545348;   // "HST1"
+static const uint8_t NO_WINDOW = 0xFF;              // chưa có cửa sổ XOR trước đó
+// Trường hợp xấu nhất một mẫu: 4+32 (thời gian) + 2 x (2+5+5+32) (float) + 2 x (3+8)
+static const uint16_t MAX_SAMPLE_BITS = 146;
+
+struct SectorHeader {
+  uint32_t magic;
+  uint32_t seq;
+  uint32_t wear;        // số lần sector này đã bị xóa
+  uint32_t reserved;
+  uint64_t firstTime;
+};
+static_assert(sizeof(SectorHeader) == HISTORY_HEADER_SIZE, "SectorHeader layout");
+
+static uint8_t crc8(const uint8_t* data, size_t length) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (uint8_t k = 0; k < 8; k++) crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+static uint8_t leadingZeros(uint32_t x) {
+  uint8_t n = 0;
+  while (!(x & 0x80000000u)) { x <<= 1; n++; }
+  return n;
+}
+
+static uint8_t trailingZeros(uint32_t x) {
+  uint8_t n = 0;
+  while (!(x & 1)) { x >>= 1; n++; }
+  return n;
+}
+
+static uint32_t floatBits(float v) {
+  uint32_t u;
+  memcpy(&u, &v, sizeof(u));
+  return u;
+}
+
+static float bitsFloat(uint32_t u) {
+  float v;
+  memcpy(&v, &u, sizeof(v));
+  return v;
+}
+
+// Dòng bit MSB trước
+struct BitWriter {
+  uint8_t* buf;
+  uint16_t& bits;
+
+  void put(uint32_t v, uint8_t n) {
+    while (n) {
+      uint8_t room = 8 - (bits & 7);
+      uint8_t take = n < room ? n : room;
+      uint8_t chunk = (v >> (n - take)) & ((1u << take) - 1);
+      uint8_t& b = buf[bits >> 3];
+      if (!(bits & 7)) b = 0;
+      b |= chunk << (room - take);
+      bits += take;
+      n -= take;
+    }
+  }
+};
+
+struct BitReader {
+  const uint8_t* buf;
+  uint16_t& bit;
+  uint16_t end;
+  bool overrun;
+
+  uint32_t get(uint8_t n) {
+    if (bit + n > end) {
+      overrun = true;
+      return 0;
+    }
+    uint32_t v = 0;
+    while (n) {
+      uint8_t room = 8 - (bit & 7);
+      uint8_t take = n < room ? n : room;
+      v = (v << take) | ((buf[bit >> 3] >> (room - take)) & ((1u << take) - 1));
+      bit += take;
+      n -= take;
+    }
+    return v;
+  }
+};
+
+void HistoryPredictor::reset(uint64_t firstTime) {
+  t = firstTime;
+  delta = 0;
+  temp = hum = 0;
+  tempLead = humLead = NO_WINDOW;
+  tempTrail = humTrail = 0;
+  light = soil = 0;
+}
+
+// ---- mã hóa / giải mã từng kênh ----
+static void putFloat(BitWriter& w, uint32_t value, uint32_t& prev, uint8_t& lead, uint8_t& trail) {
+  uint32_t x = value ^ prev;
+  prev = value;
+  if (!x) {
+    w.put(0, 1);
+    return;
+  }
+  uint8_t l = leadingZeros(x), r = trailingZeros(x);
+  if (lead != NO_WINDOW && l >= lead && r >= trail) {
+    w.put(2, 2);                      // 10: cùng cửa sổ
+    w.put(x >> trail, 32 - lead - trail);
+    return;
+  }
+  uint8_t length = 32 - l - r;
+  w.put(3, 2);                        // 11: cửa sổ mới
+  w.put(l, 5);
+  w.put(length - 1, 5);
+  w.put(x >> r, length);
+  lead = l;
+  trail = r;
+}
+
+static uint32_t getFloat(BitReader& r, uint32_t& prev, uint8_t& lead, uint8_t& trail) {
+  if (!r.get(1)) return prev;
+  if (!r.get(1)) {
+    if (lead == NO_WINDOW) r.overrun = true;   // dữ liệu hỏng
+    else prev ^= r.get(32 - lead - trail) << trail;
+    return prev;
+  }
+  lead = r.get(5);
+  uint8_t length = r.get(5) + 1;
+  if (lead + length > 32) {
+    r.overrun = true;
+    return prev;
+  }
+  trail = 32 - lead - length;
+  prev ^= r.get(length) << trail;
+  return prev;
+}
+
+static void putByte(BitWriter& w, uint8_t value, uint8_t& prev) {
+  uint32_t z = zigzag((int32_t)value - prev);
+  prev = value;
+  if (!z) w.put(0, 1);
+  else if (z < 8) { w.put(2, 2); w.put(z, 3); }
+  else if (z < 64) { w.put(6, 3); w.put(z, 6); }
+  else { w.put(7, 3); w.put(value, 8); }
+}
+
+static uint8_t getByte(BitReader& r, uint8_t& prev) {
+  if (!r.get(1)) return prev;
+  if (!r.get(1)) prev += unzigzag(r.get(3));
+  else if (!r.get(1)) prev += unzigzag(r.get(6));
+  else prev = r.get(8);
+  return prev;
+}
+
+static void encodeSample(BitWriter& w, HistoryPredictor& p, const HistorySample& s) {
+  int64_t delta = (int64_t)(s.t - p.t);
+  int64_t dod = delta - p.delta;
+  if (!dod) {
+    w.put(0, 1);
+  } else if (dod >= -32768 && dod < 32768) {
+    uint32_t z = zigzag((int32_t)dod);
+    if (z < 128) { w.put(2, 2); w.put(z, 7); }
+    else if (z < 1024) { w.put(6, 3); w.put(z, 10); }
+    else { w.put(14, 4); w.put(z, 16); }
+  } else {
+    w.put(15, 4);
+    w.put((uint32_t)delta, 32);
+  }
+  p.t = s.t;
+  p.delta = delta;
+  putFloat(w, floatBits(s.temp), p.temp, p.tempLead, p.tempTrail);
+  putFloat(w, floatBits(s.hum), p.hum, p.humLead, p.humTrail);
+  putByte(w, s.light, p.light);
+  putByte(w, s.soil, p.soil);
+}
+
+static bool decodeSample(BitReader& r, HistoryPredictor& p, HistorySample& s) {
+  int64_t delta;
+  if (!r.get(1)) delta = p.delta;
+  else if (!r.get(1)) delta = p.delta + unzigzag(r.get(7));
+  else if (!r.get(1)) delta = p.delta + unzigzag(r.get(10));
+  else if (!r.get(1)) delta = p.delta + unzigzag(r.get(16));
+  else delta = r.get(32);
+  p.t += delta;
+  p.delta = delta;
+  s.t = p.t;
+  s.temp = bitsFloat(getFloat(r, p.temp, p.tempLead, p.tempTrail));
+  s.hum = bitsFloat(getFloat(r, p.hum, p.humLead, p.humTrail));
+  s.light = getByte(r, p.light);
+  s.soil = getByte(r, p.soil);
+  return !r.overrun;
+}
+
+// ---- HistoryLog ----
+HistoryLog::HistoryLog(FlashHal& flash, HistorySector* sectors, uint16_t capacity)
+    : flash(flash), sectors(sectors), capacity(capacity) {}
+
+void HistoryLog::noteWear(uint32_t wear) {
+  if (!minWear || wear < minWear) minWear = wear;
+  if (wear > maxWear) maxWear = wear;
+}
+
+bool HistoryLog::begin() {
+  ready = false;
+  head = -1;
+  nextSeq = 1;
+  frameBits = frameCount = 0;
+  hasLast = false;
+  minWear = maxWear = 0;
+  sectorBytes = flash.sectorSize();
+  size_t available = sectorBytes ? flash.size() / sectorBytes : 0;
+  count = available < capacity ? available : capacity;
+  if (!count) return false;
+
+  for (uint16_t i = 0; i < count; i++) {
+    SectorHeader h;
+    sectors[i].seq = 0;
+    sectors[i].firstTime = 0;
+    if (!flash.read((size_t)i * sectorBytes, &h, sizeof(h)) || h.magic != HISTORY_MAGIC || !h.seq ||
+        h.seq == HISTORY_BAD_SECTOR)
+      continue;
+    sectors[i].seq = h.seq;
+    sectors[i].firstTime = h.firstTime;
+    noteWear(h.wear);
+    if (h.seq >= nextSeq) {
+      nextSeq = h.seq + 1;
+      head = i;
+    }
+  }
+  if (head >= 0) recoverHead();
+  ready = true;
+  return true;
+}
+
+// Giải mã lại sector mới nhất để nối tiếp bộ dự đoán; dừng ở frame hỏng đầu tiên
+void HistoryLog::recoverHead() {
+  size_t base = (size_t)head * sectorBytes;
+  predictor.reset(sectors[head].firstTime);
+  last = sectors[head].firstTime;
+  hasLast = true;
+  writeOffset = HISTORY_HEADER_SIZE;
+  uint8_t payload[HISTORY_FRAME_BYTES];
+  while (writeOffset + HISTORY_FRAME_HEADER <= sectorBytes) {
+    uint8_t hdr[HISTORY_FRAME_HEADER];
+    if (!flash.read(base + writeOffset, hdr, sizeof(hdr)) || hdr[0] == 0xFF) return;
+    bool ok = hdr[0] && hdr[0] <= HISTORY_FRAME_BYTES && hdr[1] && writeOffset + HISTORY_FRAME_HEADER + hdr[0] <= sectorBytes &&
+              flash.read(base + writeOffset + HISTORY_FRAME_HEADER, payload, hdr[0]) && crc8(payload, hdr[0]) == hdr[2];
+    HistoryPredictor p = predictor;
+    uint16_t bit = 0;
+    BitReader r = { payload, bit, (uint16_t)(hdr[0] * 8), false };
+    HistorySample s;
+    for (uint8_t k = 0; ok && k < hdr[1]; k++) ok = decodeSample(r, p, s);
+    if (!ok) {
+      writeOffset = sectorBytes;   // phần còn lại không tin được: ghi tiếp ở sector mới
+      return;
+    }
+    predictor = p;
+    last = p.t;
+    writeOffset += HISTORY_FRAME_HEADER + hdr[0];
+  }
+}
+
+bool HistoryLog::openSector(uint64_t t) {
+  for (;;) {
+    // sector trống trước, không thì sector có dữ liệu cũ nhất
+    int32_t victim = -1;
+    for (uint16_t i = 0; i < count; i++) {
+      if (i == head || sectors[i].seq == HISTORY_BAD_SECTOR) continue;
+      if (victim < 0 || sectors[i].seq < sectors[victim].seq) victim = i;
+    }
+    if (victim < 0) return false;
+    size_t base = (size_t)victim * sectorBytes;
+    SectorHeader h;
+    uint32_t wear = flash.read(base, &h, sizeof(h)) && h.magic == HISTORY_MAGIC ? h.wear : 0;
+    if (sectors[victim].seq) rotations++;
+    h.magic = HISTORY_MAGIC;
+    h.seq = nextSeq;
+    h.wear = wear + 1;
+    h.reserved = UINT32_MAX;
+    h.firstTime = t;
+    SectorHeader check;
+    if (flash.erase(victim) && flash.write(base, &h, sizeof(h)) && flash.read(base, &check, sizeof(check)) &&
+        !memcmp(&h, &check, sizeof(h))) {
+      sectors[victim].seq = nextSeq++;
+      sectors[victim].firstTime = t;
+      noteWear(h.wear);
+      bytes += sizeof(h);
+      head = victim;
+      writeOffset = HISTORY_HEADER_SIZE;
+      predictor.reset(t);
+      return true;
+    }
+    sectors[victim].seq = HISTORY_BAD_SECTOR;
+    badSectors++;
+  }
+}
+
+bool HistoryLog::flushFrame() {
+  if (!frameCount) return true;
+  uint8_t length = (frameBits + 7) / 8;
+  uint8_t* payload = frame + HISTORY_FRAME_HEADER;
+  frame[0] = length;
+  frame[1] = frameCount;
+  frame[2] = crc8(payload, length);
+  size_t at = (size_t)head * sectorBytes + writeOffset;
+  size_t n = HISTORY_FRAME_HEADER + length;
+  frameBits = frameCount = 0;
+  uint8_t check[HISTORY_FRAME_HEADER + HISTORY_FRAME_BYTES];
+  if (!flash.write(at, frame, n) || !flash.read(at, check, n) || memcmp(frame, check, n)) {
+    writeErrors++;
+    writeOffset = sectorBytes;   // sector này không ghi tiếp, mẫu trong frame mất
+    return false;
+  }
+  writeOffset += n;
+  frames++;
+  bytes += n;
+  return true;
+}
+
+bool HistoryLog::sync() { return !ready || head < 0 || flushFrame(); }
+
+bool HistoryLog::append(const SensorSample& sample) {
+  if (!ready) return false;
+  uint64_t t = sample.ms;
+  if (hasLast) {
+    uint32_t d = sample.ms - (uint32_t)last;
+    t = d < 0x80000000u ? last + d : last + 1000;
+  }
+  bool ok = true;
+  if (frameCount && (frameBits + MAX_SAMPLE_BITS > HISTORY_FRAME_BYTES * 8 || frameCount == 255)) ok = flushFrame();
+  // delta quá 32 bit (không mã hóa được) hay không đủ chỗ cho một frame đầy: sang sector mới
+  bool far = head >= 0 && t - predictor.t > UINT32_MAX;
+  if (far && frameCount) ok = flushFrame() && ok;
+  if (!frameCount && (head < 0 || far || writeOffset + HISTORY_FRAME_HEADER + HISTORY_FRAME_BYTES > sectorBytes)) {
+    if (!openSector(t)) return false;
+  }
+  HistorySample s = { t, sample.temp, sample.hum, sample.light, sample.soil };
+  BitWriter w = { frame + HISTORY_FRAME_HEADER, frameBits };
+  encodeSample(w, predictor, s);
+  frameCount++;
+  last = t;
+  hasLast = true;
+  samples++;
+  return ok;
+}
+
+static void accumulate(HistoryChannel& c, float v) {
+  if (isnan(v) || v <= -999.0f) return;
+  if (!c.count || v < c.min) c.min = v;
+  if (!c.count || v > c.max) c.max = v;
+  c.sum += v;
+  c.count++;
+}
+
+bool HistoryLog::query(uint64_t from, uint64_t to, HistoryStats& out) {
+  memset(&out, 0, sizeof(out));
+  HistoryCursor cursor(*this, from, to);
+  HistorySample s;
+  while (cursor.next(s)) {
+    if (!out.samples) out.first = s.t;
+    out.last = s.t;
+    out.samples++;
+    accumulate(out.temp, s.temp);
+    accumulate(out.hum, s.hum);
+    accumulate(out.light, s.light);
+    accumulate(out.soil, s.soil);
+  }
+  return out.samples > 0;
+}
+
+// ---- HistoryCursor ----
+HistoryCursor::HistoryCursor(HistoryLog& log, uint64_t from, uint64_t to) : log(log), from(from), to(to) {
+  if (!log.ready || log.head < 0 || from > to) {
+    done = true;
+    return;
+  }
+  // sector chứa from: seq lớn nhất có mẫu đầu <= from; không có thì sector cũ nhất
+  int32_t start = -1, oldest = -1;
+  for (uint16_t i = 0; i < log.count; i++) {
+    const HistorySector& h = log.sectors[i];
+    if (!h.seq || h.seq == HISTORY_BAD_SECTOR) continue;
+    if (oldest < 0 || h.seq < log.sectors[oldest].seq) oldest = i;
+    if (h.firstTime <= from && (start < 0 || h.seq > log.sectors[start].seq)) start = i;
+  }
+  sector = start >= 0 ? start : oldest;
+  seq = log.sectors[sector].seq;
+  offset = HISTORY_HEADER_SIZE;
+  predictor.reset(log.sectors[sector].firstTime);
+}
+
+// Sector kế tiếp theo seq
+bool HistoryCursor::nextSector() {
+  int32_t best = -1;
+  for (uint16_t i = 0; i < log.count; i++) {
+    const HistorySector& h = log.sectors[i];
+    if (!h.seq || h.seq == HISTORY_BAD_SECTOR || h.seq <= seq) continue;
+    if (best < 0 || h.seq < log.sectors[best].seq) best = i;
+  }
+  if (best < 0 || log.sectors[best].firstTime > to) return false;
+  sector = best;
+  seq = log.sectors[best].seq;
+  offset = HISTORY_HEADER_SIZE;
+  inRam = false;
+  predictor.reset(log.sectors[best].firstTime);
+  return true;
+}
+
+// Nạp frame kế tiếp của sector hiện tại (frame đang dở trong RAM nếu là sector đang ghi)
+bool HistoryCursor::loadFrame() {
+  bool isHead = sector == log.head;
+  if (inRam) return false;
+  if (!isHead || offset < log.writeOffset) {
+    size_t base = (size_t)sector * log.sectorBytes;
+    uint8_t hdr[HISTORY_FRAME_HEADER];
+    if (offset + HISTORY_FRAME_HEADER > log.sectorBytes || !log.flash.read(base + offset, hdr, sizeof(hdr)) ||
+        hdr[0] == 0xFF || !hdr[0] || hdr[0] > HISTORY_FRAME_BYTES || !hdr[1] ||
+        offset + HISTORY_FRAME_HEADER + hdr[0] > log.sectorBytes ||
+        !log.flash.read(base + offset + HISTORY_FRAME_HEADER, frame, hdr[0]) || crc8(frame, hdr[0]) != hdr[2])
+      return false;
+    offset += HISTORY_FRAME_HEADER + hdr[0];
+    bits = hdr[0] * 8;
+    left = hdr[1];
+  } else {
+    if (!log.frameCount) return false;
+    memcpy(frame, log.frame + HISTORY_FRAME_HEADER, (log.frameBits + 7) / 8);
+    bits = log.frameBits;
+    left = log.frameCount;
+    inRam = true;
+  }
+  bit = 0;
+  return true;
+}
+
+bool HistoryCursor::next(HistorySample& out) {
+  while (!done) {
+    if (!left && !loadFrame()) {
+      if (!nextSector()) done = true;
+      continue;
+    }
+    BitReader r = { frame, bit, bits, false };
+    left--;
+    if (!decodeSample(r, predictor, out)) {
+      left = 0;
+      inRam = true;   // frame hỏng: bỏ phần còn lại của sector
+      continue;
+    }
+    if (out.t > to) done = true;
+    else if (out.t >= from) return true;
+  }
+  return false;
+}
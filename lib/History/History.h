@@ -0,0 +1,143 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <Hal.h>
+#include <Telemetry.h>
+
+/* ===== HistoryLog =====
+ * Lịch sử số đo trên flash của chính node (FlashHal): vòng các sector, chỉ ghi nối.
+ *
+ * Sector = header HISTORY_HEADER_SIZE byte (magic, seq tăng dần, số lần đã xóa, thời
+ * điểm mẫu đầu) rồi các frame [độ dài payload][số mẫu][CRC-8 payload][payload]; byte độ
+ * dài 0xFF là vùng chưa ghi. Payload là dòng bit, bộ dự đoán nối tiếp qua các frame của
+ * cùng sector và bắt đầu lại ở mỗi sector (sector nào cũng giải mã độc lập được):
+ *  - thời gian: delta-of-delta (ms), tiền tố 0 | 10+7 | 110+10 | 1110+16 bit zigzag,
+ *    1111+32 bit delta nguyên
+ *  - temp/hum: XOR với giá trị trước kiểu Gorilla (float 32 bit, giữ cửa sổ leading/
+ *    trailing zero của lần trước nếu vừa)
+ *  - light/soil: delta, tiền tố 0 | 10+3 | 110+6 bit zigzag, 111+8 bit giá trị
+ * Frame nằm trong RAM tới khi đầy rồi ghi một lần (đọc lại để kiểm tra); sync() ghi frame
+ * dở. Hết chỗ thì xóa sector có dữ liệu cũ nhất: các sector bị xóa lần lượt nên mòn đều,
+ * sector xóa/ghi lỗi bị bỏ qua về sau. Frame hỏng (mất điện giữa lúc ghi) được nhận ra nhờ
+ * CRC, phần sau nó trong sector bị bỏ.
+ *
+ * Thời gian trong log là ms 64 bit liên tục: ms của mẫu (halMillis) được nối qua lần tràn
+ * 32 bit; đồng hồ lùi (khởi động lại sau mất điện) thì coi như 1 s sau mẫu cuối.
+ * Không cấp phát; bảng sector do người gọi cấp (16 byte mỗi sector).
+ */
+
+const uint16_t HISTORY_HEADER_SIZE = 24;
+const uint8_t HISTORY_FRAME_BYTES = 64;     // payload tối đa của một frame
+const uint8_t HISTORY_FRAME_HEADER = 3;
+
+struct HistorySample {
+  uint64_t t;      // ms, trục thời gian của log
+  float temp;      // -999 hoặc NaN nếu lỗi, như SensorSample
+  float hum;
+  uint8_t light;   // %
+  uint8_t soil;    // %
+};
+
+struct HistorySector {
+  uint64_t firstTime;   // thời gian mẫu đầu
+  uint32_t seq;         // 0 = trống, HISTORY_BAD_SECTOR = hỏng
+};
+const uint32_t HISTORY_BAD_SECTOR = UINT32_MAX;
+
+struct HistoryChannel {
+  uint32_t count;
+  float min, max;
+  double sum;
+
+  float avg() const { return count ? (float)(sum / count) : 0.0f; }
+};
+
+struct HistoryStats {
+  uint32_t samples;
+  uint64_t first, last;
+  HistoryChannel temp, hum, light, soil;   // temp/hum chỉ tính giá trị hợp lệ
+};
+
+// Trạng thái dự đoán của một sector, dùng chung cho mã hóa và giải mã
+struct HistoryPredictor {
+  uint64_t t;
+  int64_t delta;
+  uint32_t temp, hum;                  // bit pattern float
+  uint8_t tempLead, tempTrail, humLead, humTrail;
+  uint8_t light, soil;
+
+  void reset(uint64_t firstTime);
+};
+
+class HistoryLog {
+public:
+  HistoryLog(FlashHal& flash, HistorySector* sectors, uint16_t capacity);
+
+  // Đọc header mọi sector, tìm vị trí ghi và khôi phục bộ dự đoán của sector mới nhất.
+  // false nếu không có vùng flash.
+  bool begin();
+  bool append(const SensorSample& sample);
+  bool sync();   // ghi frame dở (trước deep sleep / khởi động lại)
+
+  // min/max/trung bình các kênh trong [from, to] (thời gian của log); false nếu không có mẫu
+  bool query(uint64_t from, uint64_t to, HistoryStats& out);
+  uint64_t lastTime() const { return last; }
+  uint16_t sectorCount() const { return count; }
+  size_t capacityBytes() const { return (size_t)count * sectorBytes; }
+
+  uint32_t samples = 0;        // mẫu đã ghi từ lần begin()
+  uint32_t frames = 0;         // frame đã ghi xuống flash
+  uint32_t bytes = 0;          // byte đã ghi (header sector + frame)
+  uint32_t rotations = 0;      // số lần xóa sector để ghi tiếp
+  uint32_t badSectors = 0;
+  uint32_t writeErrors = 0;
+  uint32_t minWear = 0, maxWear = 0;   // số lần xóa ít/nhiều nhất trong các sector đã dùng
+
+private:
+  friend class HistoryCursor;
+
+  bool flushFrame();
+  bool openSector(uint64_t t);
+  void recoverHead();
+  void noteWear(uint32_t wear);
+
+  FlashHal& flash;
+  HistorySector* sectors;
+  uint16_t capacity;
+  uint16_t count = 0;
+  size_t sectorBytes = 0;
+  int32_t head = -1;           // sector đang ghi
+  uint32_t nextSeq = 1;
+  size_t writeOffset = 0;      // trong sector head
+  HistoryPredictor predictor;
+  uint8_t frame[HISTORY_FRAME_HEADER + HISTORY_FRAME_BYTES];
+  uint16_t frameBits = 0;
+  uint8_t frameCount = 0;
+  uint64_t last = 0;
+  bool hasLast = false;
+  bool ready = false;
+};
+
+// Đọc tuần tự các mẫu trong [from, to] (kể cả frame còn trong RAM), theo thứ tự thời gian.
+// Đọc flash từng frame, không cấp phát. Không dùng song song với append() ở luồng khác.
+class HistoryCursor {
+public:
+  HistoryCursor(HistoryLog& log, uint64_t from, uint64_t to);
+  bool next(HistorySample& out);
+
+private:
+  bool nextSector();
+  bool loadFrame();
+
+  HistoryLog& log;
+  uint64_t from, to;
+  int32_t sector = -1;
+  uint32_t seq = 0;
+  size_t offset = 0;
+  bool inRam = false;
+  bool done = false;
+  HistoryPredictor predictor;
+  uint8_t frame[HISTORY_FRAME_BYTES];
+  uint16_t bits = 0, bit = 0;
+  uint8_t left = 0;
+};
@@ -0,0 +1,249 @@
+#include "HttpServer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static_assert(HTTP_CHUNK_BYTES <= 0xFFF, "chunk size must fit in 3 hex digits");
+
+static const char CHUNK_END[] = "0\r\n\r\n";
+
+static char lower(char c) { return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c; }
+
+// word có trong [s, s+len) không (không phân biệt hoa thường)
+static bool containsWord(const char* s, size_t len, const char* word) {
+  size_t n = strlen(word);
+  for (size_t i = 0; i + n <= len; i++) {
+    size_t k = 0;
+    while (k < n && lower(s[i + k]) == word[k]) k++;
+    if (k == n) return true;
+  }
+  return false;
+}
+
+bool httpQueryU32(const char* query, const char* key, uint32_t& out) {
+  size_t n = strlen(key);
+  for (const char* p = query; p && *p; p = strchr(p, '&'), p = p ? p + 1 : p) {
+    if (strncmp(p, key, n) || p[n] != '=') continue;
+    const char* v = p + n + 1;
+    if (*v < '0' || *v > '9') return false;
+    char* end;
+    unsigned long x = strtoul(v, &end, 10);
+    if (*end && *end != '&') return false;
+    out = (uint32_t)x;
+    return true;
+  }
+  return false;
+}
+
+HttpServer::HttpServer(ServerHal& server, const HttpRoute* routes, uint8_t routeCount, uint32_t idleMs)
+    : server(server), routes(routes), routeCount(routeCount), idleMs(idleMs) {
+  for (Client& c : clients) {
+    c.conn = -1;
+    c.state = CLIENT_FREE;
+  }
+}
+
+bool HttpServer::begin(uint16_t port) {
+  if (!open) open = server.listen(port);
+  return open;
+}
+
+uint8_t HttpServer::active() const {
+  uint8_t n = 0;
+  for (const Client& c : clients) n += c.state != CLIENT_FREE;
+  return n;
+}
+
+void HttpServer::poll(uint32_t nowMs) {
+  if (!open) return;
+  accept(nowMs);
+  for (Client& c : clients) {
+    if (c.state == CLIENT_FREE) continue;
+    service(c, nowMs);
+    if (c.state != CLIENT_FREE && nowMs - c.activeMs > idleMs) {
+      // keep-alive đang chờ request kế tiếp: đóng bình thường, không tính là timeout
+      if (c.state == CLIENT_WRITING || c.rxLen) timeouts++;
+      drop(c);
+    }
+  }
+}
+
+void HttpServer::accept(uint32_t nowMs) {
+  // số kết nối nhận mỗi lần có giới hạn để poll() luôn ngắn
+  for (uint8_t i = 0; i < HTTP_MAX_CLIENTS; i++) {
+    int conn = server.accept();
+    if (conn < 0) return;
+    Client* slot = nullptr;
+    for (Client& c : clients)
+      if (c.state == CLIENT_FREE) {
+        slot = &c;
+        break;
+      }
+    if (!slot) {
+      static const char busy[] = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nRetry-After: 1\r\n"
+                                 "Connection: close\r\n\r\n";
+      server.write(conn, busy, sizeof(busy) - 1);
+      server.close(conn);
+      rejected++;
+      continue;
+    }
+    slot->conn = conn;
+    slot->state = CLIENT_READING;
+    slot->rxLen = 0;
+    slot->activeMs = nowMs;
+    connections++;
+    uint8_t n = active();
+    if (n > maxActive) maxActive = n;
+  }
+}
+
+void HttpServer::service(Client& c, uint32_t nowMs) {
+  if (c.state == CLIENT_READING && !readRequest(c, nowMs)) return;
+  for (uint8_t chunks = 0; c.state == CLIENT_WRITING;) {
+    if (c.txOff == c.txLen) {
+      if (c.done) {
+        finish(c, nowMs);
+        return;
+      }
+      if (chunks++ == HTTP_CHUNKS_PER_POLL) return;
+      nextChunk(c);
+      continue;
+    }
+    int n = server.write(c.conn, c.tx + c.txOff, c.txLen - c.txOff);
+    if (n < 0) {
+      resets++;
+      drop(c);
+      return;
+    }
+    if (n == 0) return;   // buffer gửi đầy, tiếp ở lần poll sau
+    c.txOff += n;
+    bytesSent += n;
+    c.activeMs = nowMs;
+  }
+}
+
+// Đọc tới khi đủ header; true nếu đã bắt đầu response
+bool HttpServer::readRequest(Client& c, uint32_t nowMs) {
+  for (;;) {
+    c.rx[c.rxLen] = '\0';
+    char* end = strstr(c.rx, "\r\n\r\n");
+    if (end) {
+      startResponse(c, c.rx, end + 4 - c.rx);
+      return c.state == CLIENT_WRITING;
+    }
+    if (c.rxLen + 1u >= sizeof(c.rx)) {
+      fail(c, "431 Request Header Fields Too Large");
+      return true;
+    }
+    int n = server.read(c.conn, c.rx + c.rxLen, sizeof(c.rx) - 1 - c.rxLen);
+    if (n == 0) return false;
+    if (n < 0) {
+      if (c.rxLen) resets++;
+      drop(c);
+      return false;
+    }
+    c.rxLen += n;
+    c.activeMs = nowMs;
+  }
+}
+
+void HttpServer::startResponse(Client& c, char* request, size_t headerLen) {
+  requests++;
+  // "GET /path?query HTTP/1.x\r\n" rồi các header
+  char* lineEnd = strstr(request, "\r\n");
+  char* target = strchr(request, ' ');
+  char* version = target && target < lineEnd ? strchr(target + 1, ' ') : nullptr;
+  if (!version || version > lineEnd) return fail(c, "400 Bad Request");
+  *target++ = '\0';
+  *version++ = '\0';
+  // HTTP/1.0 không có chunked: body thô rồi đóng kết nối
+  bool http11 = !strncmp(version, "HTTP/1.1", 8);
+  c.chunked = http11;
+  c.keepAlive = http11;
+  for (char* line = lineEnd + 2; line < request + headerLen - 2;) {
+    char* next = strstr(line, "\r\n");
+    size_t len = next - line;
+    if (len > 11 && containsWord(line, 11, "connection:") && containsWord(line + 11, len - 11, "close"))
+      c.keepAlive = false;
+    line = next + 2;
+  }
+  if (strcmp(request, "GET")) return fail(c, "405 Method Not Allowed");
+
+  char* query = strchr(target, '?');
+  if (query) *query++ = '\0';
+  HttpHandler* handler = nullptr;
+  for (uint8_t i = 0; i < routeCount && !handler; i++)
+    if (!strcmp(routes[i].path, target)) handler = routes[i].handler;
+  if (!handler) return fail(c, "404 Not Found");
+
+  c.x.query = query ? query : "";
+  c.x.step = 0;
+  const char* type = handler->start(c.x);
+  c.x.query = nullptr;
+  if (!type) return fail(c, "400 Bad Request");
+
+  // phần còn lại trong rx là request pipeline kế tiếp
+  c.rxLen -= headerLen;
+  memmove(c.rx, c.rx + headerLen, c.rxLen);
+  c.handler = handler;
+  c.done = false;
+  c.state = CLIENT_WRITING;
+  c.txOff = 0;
+  int n = snprintf(c.tx, sizeof(c.tx), "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nCache-Control: no-store\r\n"
+                   "Access-Control-Allow-Origin: *\r\n%s%s\r\n", type,
+                   c.chunked ? "Transfer-Encoding: chunked\r\n" : "", c.keepAlive ? "" : "Connection: close\r\n");
+  c.txLen = n > 0 && (size_t)n < sizeof(c.tx) ? n : 0;
+}
+
+void HttpServer::nextChunk(Client& c) {
+  c.txOff = 0;
+  if (!c.chunked) {
+    c.txLen = c.handler->fill(c.x, c.tx, HTTP_CHUNK_BYTES);
+    c.done = !c.txLen;
+    return;
+  }
+  size_t n = c.handler->fill(c.x, c.tx + 5, HTTP_CHUNK_BYTES);
+  if (!n) {
+    memcpy(c.tx, CHUNK_END, sizeof(CHUNK_END) - 1);
+    c.txLen = sizeof(CHUNK_END) - 1;
+    c.done = true;
+    return;
+  }
+  // độ dài cố định 3 chữ số hex để body ghi thẳng vào buffer, không phải dời
+  static const char hex[] = "0123456789abcdef";
+  c.tx[0] = hex[(n >> 8) & 0xF];
+  c.tx[1] = hex[(n >> 4) & 0xF];
+  c.tx[2] = hex[n & 0xF];
+  c.tx[3] = '\r';
+  c.tx[4] = '\n';
+  c.tx[5 + n] = '\r';
+  c.tx[6 + n] = '\n';
+  c.txLen = n + 7;
+}
+
+void HttpServer::finish(Client& c, uint32_t nowMs) {
+  if (c.handler) responses++;
+  if (!c.keepAlive) return drop(c);
+  c.state = CLIENT_READING;
+  c.activeMs = nowMs;
+}
+
+// Lỗi: response ngắn rồi đóng kết nối
+void HttpServer::fail(Client& c, const char* status) {
+  errors++;
+  c.handler = nullptr;
+  c.keepAlive = false;
+  c.chunked = false;
+  c.done = true;
+  c.state = CLIENT_WRITING;
+  c.txOff = 0;
+  int n = snprintf(c.tx, sizeof(c.tx), "HTTP/1.1 %s\r\nContent-Type: text/plain\r\nContent-Length: %u\r\n"
+                   "Connection: close\r\n\r\n%s\n", status, (unsigned)strlen(status) + 1, status);
+  c.txLen = n > 0 && (size_t)n < sizeof(c.tx) ? n : 0;
+}
+
+void HttpServer::drop(Client& c) {
+  server.close(c.conn);
+  c.conn = -1;
+  c.state = CLIENT_FREE;
+}
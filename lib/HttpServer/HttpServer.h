@@ -0,0 +1,97 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <Hal.h>
+
+/* ===== HttpServer =====
+ * Máy chủ HTTP/1.1 tối giản trên ServerHal, chạy bằng poll() từ scheduler: không chặn, không
+ * cấp phát, số client cố định (HTTP_MAX_CLIENTS, client thừa nhận 503 rồi đóng).
+ *
+ * Chỉ GET. Handler (HttpHandler) không dựng cả response: start() chọn Content-Type và khởi tạo
+ * trạng thái trong HttpExchange, fill() ghi phần body kế tiếp thẳng vào buffer gửi của client
+ * (tối đa HTTP_CHUNK_BYTES), server gửi đi rồi mới gọi fill() tiếp. Body của HTTP/1.1 đi dạng
+ * chunked và kết nối được giữ lại (keep-alive, nhận cả request pipeline); HTTP/1.0 thì body
+ * thô rồi đóng. Mỗi poll() một client được tối đa HTTP_CHUNKS_PER_POLL chunk để một response
+ * dài không giữ vòng lặp. Client không có tiến triển sau idleMs bị đóng.
+ */
+
+const uint8_t HTTP_MAX_CLIENTS = 4;
+const uint16_t HTTP_REQUEST_BYTES = 384;    // dòng request + header
+const uint16_t HTTP_CHUNK_BYTES = 1024;     // body tối đa mỗi lần fill()
+const uint16_t HTTP_SCRATCH_BYTES = 160;    // trạng thái riêng của handler mỗi client
+const uint8_t HTTP_CHUNKS_PER_POLL = 4;
+
+struct HttpExchange {
+  const char* query;   // phần sau '?' ("" nếu không có), chỉ hợp lệ trong start()
+  uint32_t step;       // handler tự dùng, 0 khi bắt đầu
+  alignas(8) uint8_t scratch[HTTP_SCRATCH_BYTES];
+};
+
+class HttpHandler {
+public:
+  virtual ~HttpHandler() {}
+  // Bắt đầu một response: trả về Content-Type, nullptr = tham số sai (400)
+  virtual const char* start(HttpExchange& x) = 0;
+  // Ghi phần body kế tiếp vào out (không quá capacity byte); 0 = hết body
+  virtual size_t fill(HttpExchange& x, char* out, size_t capacity) = 0;
+};
+
+struct HttpRoute {
+  const char* path;    // so khớp nguyên văn, không gồm query
+  HttpHandler* handler;
+};
+
+// Lấy tham số key=... trong query ("a=1&b=2"); false nếu không có hoặc không phải số
+bool httpQueryU32(const char* query, const char* key, uint32_t& out);
+
+class HttpServer {
+public:
+  HttpServer(ServerHal& server, const HttpRoute* routes, uint8_t routeCount, uint32_t idleMs = 5000);
+
+  bool begin(uint16_t port);   // false: chưa có mạng, gọi lại sau
+  bool listening() const { return open; }
+  void poll(uint32_t nowMs);
+  uint8_t active() const;
+
+  uint32_t connections = 0;    // kết nối đã nhận vào slot
+  uint32_t requests = 0;
+  uint32_t responses = 0;      // response 200 đã gửi xong
+  uint32_t rejected = 0;       // hết slot: 503
+  uint32_t errors = 0;         // 400/404/405/431
+  uint32_t timeouts = 0;
+  uint32_t resets = 0;         // client đóng/lỗi giữa chừng
+  uint64_t bytesSent = 0;
+  uint8_t maxActive = 0;
+
+private:
+  enum ClientState : uint8_t { CLIENT_FREE, CLIENT_READING, CLIENT_WRITING };
+
+  struct Client {
+    int conn;
+    ClientState state;
+    bool keepAlive, chunked, done;
+    uint32_t activeMs;
+    uint16_t rxLen;
+    uint16_t txOff, txLen;
+    HttpHandler* handler;
+    char rx[HTTP_REQUEST_BYTES];
+    char tx[HTTP_CHUNK_BYTES + 8];   // "xxx\r\n" + body + "\r\n"
+    HttpExchange x;
+  };
+
+  void accept(uint32_t nowMs);
+  void service(Client& c, uint32_t nowMs);
+  bool readRequest(Client& c, uint32_t nowMs);
+  void startResponse(Client& c, char* request, size_t headerLen);
+  void nextChunk(Client& c);
+  void finish(Client& c, uint32_t nowMs);
+  void fail(Client& c, const char* status);
+  void drop(Client& c);
+
+  ServerHal& server;
+  const HttpRoute* routes;
+  uint8_t routeCount;
+  uint32_t idleMs;
+  bool open = false;
+  Client clients[HTTP_MAX_CLIENTS];
+};
@@ -0,0 +1,114 @@
+#include "Irrigation.h"
+#include <math.h>
+#include <string.h>
+
+static const float FORGET = 0.98f;         // hệ số quên: nhớ chừng 50 quan sát gần nhất
+static const float MAX_COVARIANCE = 1e3f;  // không phình thêm khi VPD đứng yên (ban đêm)
+static const float MS_PER_H = 3600000.0f;
+
+// Thiếu hụt áp suất hơi nước (kPa), công thức Tetens
+static float vaporDeficit(float tempC, float humidity) {
+  float es = 0.6108f * expf(17.27f * tempC / (tempC + 237.3f));
+  float d = es * (1.0f - humidity / 100.0f);
+  return d > 0 ? d : 0;
+}
+
+static bool validClimate(float tempC, float humidity) {
+  return !isnan(tempC) && !isnan(humidity) && tempC > -40.0f && humidity >= 0.0f && humidity <= 100.0f;
+}
+
+IrrigationController::IrrigationController(const IrrigationPolicy& policy) : policy(policy) {
+  memset(&st, 0, sizeof(st));
+  st.a = policy.dryPerH;
+  st.p00 = st.p11 = 10.0f;
+  st.gain = policy.gainPerS;
+  st.vpd = 1.0f;
+}
+
+float IrrigationController::dryRate() const {
+  float rate = st.a + st.b * st.vpd;
+  return rate > 0 ? rate : 0;
+}
+
+// Bình phương tối thiểu đệ quy với x = (1, vpd); P đối xứng nên chỉ giữ 3 phần tử
+void IrrigationController::observeRate(float rate, float vpd) {
+  float px0 = st.p00 + st.p01 * vpd;
+  float px1 = st.p01 + st.p11 * vpd;
+  float denom = FORGET + px0 + px1 * vpd;
+  float k0 = px0 / denom, k1 = px1 / denom;
+  float err = rate - (st.a + st.b * vpd);
+  st.a += k0 * err;
+  st.b += k1 * err;
+  st.p00 -= k0 * px0;
+  st.p01 -= k0 * px1;
+  st.p11 -= k1 * px1;
+  if (st.p00 + st.p11 < MAX_COVARIANCE) {
+    st.p00 /= FORGET;
+    st.p01 /= FORGET;
+    st.p11 /= FORGET;
+  }
+  rateUpdates++;
+}
+
+// Hết thời gian ngấm: phần tăng so với đường khô dự báo chia cho thời gian mở van
+void IrrigationController::finishSoak(float soil, uint32_t nowMs) {
+  st.soaking = false;
+  float hours = (nowMs - st.pulseStartMs) / MS_PER_H;
+  float rise = soil - (st.pulseSoil - dryRate() * hours);
+  float measured = rise / (st.pulseMs / 1000.0f);
+  if (measured <= 0) return;   // đất không phản hồi (cảm biến/van lỗi): giữ ước lượng cũ
+  st.gain += 0.5f * (measured - st.gain);
+  if (st.gain < policy.gainPerS / 10) st.gain = policy.gainPerS / 10;
+  if (st.gain > policy.gainPerS * 10) st.gain = policy.gainPerS * 10;
+  gainUpdates++;
+}
+
+void IrrigationController::interrupt() {
+  st.windowOpen = false;
+  st.soaking = false;
+}
+
+uint32_t IrrigationController::update(float soil, float tempC, float humidity, uint32_t nowMs) {
+  if (isnan(soil)) return 0;
+  if (validClimate(tempC, humidity)) st.vpd = vaporDeficit(tempC, humidity);
+
+  if (st.soaking) {
+    if (nowMs - st.pulseStartMs < st.pulseMs + policy.soakMs) return 0;
+    finishSoak(soil, nowMs);
+  }
+
+  if (st.windowOpen) {
+    st.windowVpdSum += st.vpd;
+    st.windowSamples++;
+    uint32_t elapsed = nowMs - st.windowMs;
+    if (elapsed >= policy.rateWindowMs) {
+      // độ ẩm tăng rõ: mưa hoặc tưới ngoài bộ điều khiển, không phải quan sát tốc độ khô
+      if (soil - st.windowSoil < 1.0f) observeRate((st.windowSoil - soil) * MS_PER_H / elapsed,
+                                                   st.windowVpdSum / st.windowSamples);
+      st.windowOpen = false;
+    }
+  }
+  if (!st.windowOpen) {
+    st.windowOpen = true;
+    st.windowMs = nowMs;
+    st.windowSoil = soil;
+    st.windowVpdSum = 0;
+    st.windowSamples = 0;
+  }
+
+  float rate = dryRate();
+  if (soil - rate * policy.horizonMs / MS_PER_H >= policy.lowPercent) return 0;
+
+  // đủ để về targetPercent khi hết thời gian ngấm (đất vẫn khô tiếp trong lúc đó)
+  float deficit = policy.targetPercent - soil + rate * (policy.soakMs / MS_PER_H);
+  float ms = deficit / st.gain * 1000.0f;
+  uint32_t pulse = ms > policy.maxPulseMs ? policy.maxPulseMs : ms < policy.minPulseMs ? policy.minPulseMs : (uint32_t)ms;
+  st.soaking = true;
+  st.pulseStartMs = nowMs;
+  st.pulseMs = pulse;
+  st.pulseSoil = soil;
+  st.windowOpen = false;
+  pulses++;
+  openMs += pulse;
+  return pulse;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+
+/* ===== IrrigationController =====
+ * Tưới theo mô hình thay cho "dưới 30 % thì mở van 1 s":
+ *  - tốc độ khô của đất (%/giờ) được ước lượng trực tuyến theo khí hậu:
+ *    rate = a + b * VPD (kPa, từ nhiệt độ + độ ẩm không khí), bình phương tối thiểu
+ *    đệ quy 2 tham số có hệ số quên, mỗi cửa sổ rateWindowMs không tưới cho một quan sát;
+ *  - độ ẩm tăng mỗi giây mở van (gain) được đo lại sau mỗi lần tưới, khi nước đã ngấm
+ *    tới cảm biến (soakMs);
+ *  - khi độ ẩm dự báo sau horizonMs xuống dưới lowPercent: một xung duy nhất, đủ dài để
+ *    độ ẩm về targetPercent lúc hết soakMs; trong soakMs không tưới thêm (cảm biến trễ
+ *    so với đất, tưới tiếp theo số đo cũ là tưới thừa).
+ * O(1) mỗi mẫu, bộ nhớ cố định, không cấp phát. Toàn bộ trạng thái nằm trong
+ * IrrigationState (POD) để giữ qua deep sleep.
+ */
+
+struct IrrigationPolicy {
+  float lowPercent;        // không để độ ẩm dự báo xuống dưới mức này
+  float targetPercent;     // độ ẩm muốn có sau một lần tưới
+  uint32_t horizonMs;      // tưới trước nếu dự báo chạm lowPercent trong khoảng này
+  uint32_t soakMs;         // thời gian nước ngấm tới cảm biến, không tưới lại trong khoảng này
+  uint32_t rateWindowMs;   // độ dài một quan sát tốc độ khô
+  uint32_t minPulseMs;     // xung ngắn hơn thì bỏ (van không kịp mở)
+  uint32_t maxPulseMs;
+  float gainPerS;          // ước lượng ban đầu: % độ ẩm tăng mỗi giây mở van
+  float dryPerH;           // ước lượng ban đầu: % độ ẩm giảm mỗi giờ
+};
+
+struct IrrigationState {
+  float a, b;              // rate = a + b * vpd (%/giờ)
+  float p00, p01, p11;     // hiệp phương sai của (a, b)
+  float gain;              // %/giây mở van
+  float vpd;               // VPD của mẫu hợp lệ gần nhất
+  // cửa sổ đo tốc độ khô đang mở
+  uint32_t windowMs;
+  float windowSoil, windowVpdSum;
+  uint16_t windowSamples;
+  bool windowOpen;
+  // lần tưới gần nhất, chờ đo gain
+  bool soaking;
+  uint32_t pulseStartMs, pulseMs;
+  float pulseSoil;
+};
+
+class IrrigationController {
+public:
+  explicit IrrigationController(const IrrigationPolicy& policy);
+
+  // Mỗi mẫu: độ ẩm đất (%), nhiệt độ (C) và độ ẩm không khí (%), NaN/-999 nếu lỗi.
+  // Trả về thời gian mở van (ms), 0 = không tưới.
+  uint32_t update(float soil, float tempC, float humidity, uint32_t nowMs);
+  // Đất được tưới ngoài bộ điều khiển (tưới tay, tắt auto): bỏ quan sát đang dở
+  void interrupt();
+
+  float dryRate() const;                 // %/giờ theo khí hậu của mẫu gần nhất
+  float gain() const { return st.gain; }
+  bool soaking() const { return st.soaking; }
+  const IrrigationState& state() const { return st; }
+  void restore(const IrrigationState& s) { st = s; }
+
+  uint32_t pulses = 0;        // số lần mở van
+  uint32_t openMs = 0;        // tổng thời gian mở van
+  uint32_t rateUpdates = 0;   // số quan sát tốc độ khô đã dùng
+  uint32_t gainUpdates = 0;   // số lần đo lại gain
+
+private:
+  void observeRate(float rate, float vpd);
+  void finishSoak(float soil, uint32_t nowMs);
+
+  const IrrigationPolicy& policy;
+  IrrigationState st;
+};
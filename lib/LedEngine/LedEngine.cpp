@@ -0,0 +1,88 @@
+#include "LedEngine.h"
+
+// round(255 * (i / 255) ^ 2.2): giá trị cảm nhận -> độ rộng xung của WS2812
+static const uint8_t GAMMA22[256] PROGMEM = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+    1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+    3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+    6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+   12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+   20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+   30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+   42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+   56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+   73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+   91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+  113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+  137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+  163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+  192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+  223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+static inline uint8_t lerp8(uint8_t a, uint8_t b, uint32_t elapsed, uint32_t duration) {
+  return (uint8_t)((int32_t)a + ((int32_t)b - (int32_t)a) * (int32_t)elapsed / (int32_t)duration);
+}
+
+LedEngine::LedEngine(Rgb* frame, uint16_t count, uint16_t frameMs)
+    : frame(frame), pixelCount(count), period(frameMs),
+      fromColor{ 0, 0, 0 }, toColor{ 0, 0, 0 }, fadeStartMs(0), fadeMs(0), fadeActive(false),
+      fromLevel(255), toLevel(255), rampStartMs(0), rampMs(0), rampActive(false),
+      lutLevel(0), lastOut{ 0, 0, 0 }, shown(false) {
+  buildLut(255);
+}
+
+// Độ sáng áp trên thang cảm nhận trước gamma để ramp trông đều ở mức thấp
+void LedEngine::buildLut(uint8_t level) {
+  for (uint16_t i = 0; i < 256; i++) lut[i] = GAMMA22[(i * level + 127) / 255];
+  lutLevel = level;
+  lutBuilds++;
+}
+
+Rgb LedEngine::colorAt(uint32_t nowMs) const {
+  uint32_t elapsed = nowMs - fadeStartMs;
+  if (!fadeActive || elapsed >= fadeMs) return toColor;
+  Rgb c = { lerp8(fromColor.r, toColor.r, elapsed, fadeMs),
+            lerp8(fromColor.g, toColor.g, elapsed, fadeMs),
+            lerp8(fromColor.b, toColor.b, elapsed, fadeMs) };
+  return c;
+}
+
+uint8_t LedEngine::levelAt(uint32_t nowMs) const {
+  uint32_t elapsed = nowMs - rampStartMs;
+  if (!rampActive || elapsed >= rampMs) return toLevel;
+  return lerp8(fromLevel, toLevel, elapsed, rampMs);
+}
+
+void LedEngine::setColor(Rgb color, uint32_t fadeMs, uint32_t nowMs) {
+  fromColor = colorAt(nowMs);   // đổi đích giữa chừng thì đi tiếp từ màu đang hiện
+  toColor = color;
+  fadeStartMs = nowMs;
+  this->fadeMs = fadeMs;
+  fadeActive = fadeMs > 0 && fromColor != toColor;
+}
+
+void LedEngine::setBrightness(uint8_t level, uint32_t rampMs, uint32_t nowMs) {
+  fromLevel = levelAt(nowMs);
+  toLevel = level;
+  rampStartMs = nowMs;
+  this->rampMs = rampMs;
+  rampActive = rampMs > 0 && fromLevel != toLevel;
+}
+
+bool LedEngine::render(uint32_t nowMs) {
+  frames++;
+  Rgb c = colorAt(nowMs);
+  uint8_t level = levelAt(nowMs);
+  if (fadeActive && nowMs - fadeStartMs >= fadeMs) fadeActive = false;
+  if (rampActive && nowMs - rampStartMs >= rampMs) rampActive = false;
+
+  if (level != lutLevel) buildLut(level);
+  Rgb out = { lut[c.r], lut[c.g], lut[c.b] };
+  if (shown && out == lastOut) return false;
+  for (uint16_t i = 0; i < pixelCount; i++) frame[i] = out;
+  lastOut = out;
+  shown = true;
+  shows++;
+  return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <Hal.h>
+
+/* ===== LedEngine =====
+ * Tính khung cho vòng LED WS2812 (một màu cho cả vòng) với chuyển màu và
+ * tăng/giảm độ sáng mượt theo thời gian thực:
+ *  - màu đích là giá trị người dùng chọn (#RRGGBB, cảm nhận), nội suy tuyến
+ *    tính trên thang đó rồi mới qua bảng gamma 2.2 ra giá trị PWM của LED
+ *  - độ sáng gộp sẵn với gamma vào một bảng 256 byte, chỉ dựng lại khi mức
+ *    sáng đổi (lúc đang ramp), mỗi pixel chỉ còn một lần tra bảng
+ *  - render() trả về true chỉ khi khung khác khung đã gửi lần trước, người
+ *    gọi mới truyền ra LED; màu đứng yên thì không tốn gì ngoài một phép so sánh
+ * Tiến độ tính theo nowMs chứ không đếm khung nên khung bị trễ không làm
+ * chậm hiệu ứng. Nhịp khung cố định (frameMs) do người gọi lập lịch, chỉ
+ * trong lúc animating(). Không cấp phát, an toàn khi millis() tràn.
+ */
+
+class LedEngine {
+public:
+  // frame: bộ đệm count pixel của người gọi, được ghi khi khung đổi
+  LedEngine(Rgb* frame, uint16_t count, uint16_t frameMs);
+
+  // Đổi màu đích, chuyển dần trong fadeMs (0 = ngay ở khung kế tiếp)
+  void setColor(Rgb color, uint32_t fadeMs, uint32_t nowMs);
+  // Đổi độ sáng đích 0..255, chuyển dần trong rampMs
+  void setBrightness(uint8_t level, uint32_t rampMs, uint32_t nowMs);
+
+  // Tính khung tại nowMs; true = pixels() đã đổi, cần gửi ra LED
+  bool render(uint32_t nowMs);
+  // Gửi lại khung ở lần render() kế tiếp dù không đổi (vd. sau khi LED mất nguồn)
+  void invalidate() { shown = false; }
+
+  bool animating() const { return fadeActive || rampActive; }
+  Rgb target() const { return toColor; }
+  uint8_t targetBrightness() const { return toLevel; }
+  Rgb output() const { return lastOut; }   // giá trị đã gửi (sau gamma/độ sáng)
+  const Rgb* pixels() const { return frame; }
+  uint16_t count() const { return pixelCount; }
+  uint16_t frameMs() const { return period; }
+
+  uint32_t frames = 0;      // số lần render()
+  uint32_t shows = 0;       // số khung thực sự đổi
+  uint32_t lutBuilds = 0;   // số lần dựng lại bảng gamma x độ sáng
+
+private:
+  Rgb colorAt(uint32_t nowMs) const;
+  uint8_t levelAt(uint32_t nowMs) const;
+  void buildLut(uint8_t level);
+
+  Rgb* frame;
+  uint16_t pixelCount;
+  uint16_t period;
+
+  Rgb fromColor, toColor;
+  uint32_t fadeStartMs, fadeMs;
+  bool fadeActive;
+
+  uint8_t fromLevel, toLevel;
+  uint32_t rampStartMs, rampMs;
+  bool rampActive;
+
+  uint8_t lut[256];
+  uint8_t lutLevel;
+  Rgb lastOut;
+  bool shown;
+};
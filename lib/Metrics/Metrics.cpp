@@ -0,0 +1,84 @@
+#include "Metrics.h"
+#include <stdio.h>
+#include <string.h>
+
+Histogram::Histogram(const char* name, const uint32_t* bounds, uint8_t boundCount)
+  : name(name), bounds(bounds),
+    boundCount(boundCount < METRICS_MAX_BUCKETS ? boundCount : METRICS_MAX_BUCKETS - 1),
+    total(0), maxSeen(0) {
+  memset(counts, 0, sizeof(counts));
+}
+
+void Histogram::observe(uint32_t v) {
+  uint8_t i = 0;
+  while (i < boundCount && v > bounds[i]) i++;
+  counts[i]++;
+  total++;
+  if (v > maxSeen) maxSeen = v;
+}
+
+bool MetricsRegistry::add(Counter& c) {
+  if (counterCount >= MAX_COUNTERS) return false;
+  counters[counterCount++] = &c;
+  return true;
+}
+
+bool MetricsRegistry::add(Gauge& g) {
+  if (gaugeCount >= MAX_GAUGES) return false;
+  gauges[gaugeCount++] = &g;
+  return true;
+}
+
+bool MetricsRegistry::add(Histogram& h) {
+  if (histogramCount >= MAX_HISTOGRAMS) return false;
+  histograms[histogramCount++] = &h;
+  return true;
+}
+
+// Ghi nối tiếp vào buffer, nhớ lỗi tràn để format() trả về 0
+struct JsonOut {
+  char* p;
+  size_t left;
+  bool overflow;
+
+  template <typename... Args>
+  void append(const char* fmt, Args... args) {
+    if (overflow) return;
+    int n = snprintf(p, left, fmt, args...);
+    if (n < 0 || (size_t)n >= left) {
+      overflow = true;
+      return;
+    }
+    p += n;
+    left -= n;
+  }
+};
+
+size_t MetricsRegistry::format(char* out, size_t size, uint32_t uptimeS) const {
+  if (size == 0) return 0;
+  JsonOut j = { out, size, false };
+  j.append("{\"up\":%lu", (unsigned long)uptimeS);
+
+  j.append(",\"c\":{");
+  for (uint8_t i = 0; i < counterCount; i++)
+    j.append("%s\"%s\":%lu", i ? "," : "", counters[i]->name, (unsigned long)counters[i]->value);
+
+  j.append("},\"g\":{");
+  for (uint8_t i = 0; i < gaugeCount; i++)
+    j.append("%s\"%s\":%ld", i ? "," : "", gauges[i]->name, (long)gauges[i]->value);
+
+  j.append("},\"h\":{");
+  for (uint8_t i = 0; i < histogramCount; i++) {
+    const Histogram& h = *histograms[i];
+    j.append("%s\"%s\":[", i ? "," : "", h.name);
+    for (uint8_t b = 0; b < h.buckets(); b++) j.append("%s%lu", b ? "," : "", (unsigned long)h.bucket(b));
+    j.append("],\"%s_max\":%lu", h.name, (unsigned long)h.max());
+  }
+  j.append("}}");
+
+  if (j.overflow) {
+    out[0] = '\0';
+    return 0;
+  }
+  return size - j.left;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* ===== Metrics =====
+ * Bộ đếm, gauge và histogram bucket cố định cho chẩn đoán lúc chạy. Mỗi metric
+ * là biến toàn cục chỉ một luồng ghi (tăng/gán một word 32 bit), đăng ký vào
+ * MetricsRegistry để định kỳ xuất thành JSON gọn trên topic chẩn đoán:
+ *
+ *   {"up":3600,"c":{"rc":2,"pf":0},"g":{"heap":182340,"rssi":-61},
+ *    "h":{"pub":[12,40,3,0,0,0],"pub_max":8123}}
+ *
+ * Giá trị cộng dồn từ khi khởi động (không reset khi xuất) nên phía nhận tự tính
+ * tốc độ/delta và việc đọc từ luồng khác không cần khóa. Histogram: phần tử i đếm
+ * số quan sát <= bounds[i], phần tử cuối là phần vượt bound lớn nhất.
+ */
+
+const uint8_t METRICS_MAX_BUCKETS = 8;
+
+struct Counter {
+  const char* name;
+  uint32_t value;
+
+  explicit Counter(const char* name) : name(name), value(0) {}
+  void inc(uint32_t n = 1) { value += n; }
+};
+
+struct Gauge {
+  const char* name;
+  int32_t value;
+
+  explicit Gauge(const char* name) : name(name), value(0) {}
+  void set(int32_t v) { value = v; }
+};
+
+class Histogram {
+public:
+  // bounds tăng dần, tối đa METRICS_MAX_BUCKETS - 1 phần tử
+  Histogram(const char* name, const uint32_t* bounds, uint8_t boundCount);
+
+  void observe(uint32_t v);
+
+  const char* name;
+  uint32_t count() const { return total; }
+  uint32_t max() const { return maxSeen; }
+  uint8_t buckets() const { return boundCount + 1; }
+  uint32_t bucket(uint8_t i) const { return counts[i]; }
+
+private:
+  const uint32_t* bounds;
+  uint8_t boundCount;
+  uint32_t counts[METRICS_MAX_BUCKETS];
+  uint32_t total;
+  uint32_t maxSeen;
+};
+
+class MetricsRegistry {
+public:
+  static const uint8_t MAX_COUNTERS = 16;
+  static const uint8_t MAX_GAUGES = 8;
+  static const uint8_t MAX_HISTOGRAMS = 4;
+
+  MetricsRegistry() : counterCount(0), gaugeCount(0), histogramCount(0) {}
+
+  // false nếu bảng đã đầy
+  bool add(Counter& c);
+  bool add(Gauge& g);
+  bool add(Histogram& h);
+
+  // Ghi JSON vào out, trả về số byte (không tính '\0'); 0 nếu out không đủ chỗ
+  size_t format(char* out, size_t size, uint32_t uptimeS) const;
+
+private:
+  Counter* counters[MAX_COUNTERS];
+  Gauge* gauges[MAX_GAUGES];
+  Histogram* histograms[MAX_HISTOGRAMS];
+  uint8_t counterCount, gaugeCount, histogramCount;
+};
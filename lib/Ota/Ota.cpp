@@ -0,0 +1,420 @@
+#include "Ota.h"
+#include <string.h>
+
+// --------------------- SHA-256 -----------------
+static const uint32_t shaK[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotr(uint32_t x, uint8_t n) { return (x >> n) | (x << (32 - n)); }
+
+void Sha256::reset() {
+  static const uint32_t init[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+  memcpy(state, init, sizeof(state));
+  bytes = 0;
+}
+
+void Sha256::compress(const uint8_t* block) {
+  uint32_t w[64];
+  for (uint8_t i = 0; i < 16; i++)
+    w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 | (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+  for (uint8_t i = 16; i < 64; i++) {
+    uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+  uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+  for (uint8_t i = 0; i < 64; i++) {
+    uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + shaK[i] + w[i];
+    uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+  state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+  state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void Sha256::update(const void* data, size_t length) {
+  const uint8_t* p = (const uint8_t*)data;
+  size_t used = bytes % 64;
+  bytes += length;
+  if (used) {
+    size_t n = 64 - used < length ? 64 - used : length;
+    memcpy(buffer + used, p, n);
+    p += n;
+    length -= n;
+    if (used + n < 64) return;
+    compress(buffer);
+  }
+  for (; length >= 64; p += 64, length -= 64) compress(p);
+  memcpy(buffer, p, length);
+}
+
+void Sha256::finish(uint8_t digest[SHA256_SIZE]) {
+  uint64_t bits = bytes * 8;
+  uint8_t pad[72] = { 0x80 };
+  size_t padLength = (bytes % 64 < 56 ? 56 : 120) - bytes % 64;
+  for (uint8_t i = 0; i < 8; i++) pad[padLength + i] = (uint8_t)(bits >> (56 - 8 * i));
+  update(pad, padLength + 8);
+  for (uint8_t i = 0; i < 8; i++) {
+    digest[4 * i] = (uint8_t)(state[i] >> 24);
+    digest[4 * i + 1] = (uint8_t)(state[i] >> 16);
+    digest[4 * i + 2] = (uint8_t)(state[i] >> 8);
+    digest[4 * i + 3] = (uint8_t)state[i];
+  }
+  reset();
+}
+
+static int hexDigit(uint8_t c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+bool sha256FromHex(const uint8_t* text, size_t length, uint8_t out[SHA256_SIZE]) {
+  if (length != 2 * SHA256_SIZE) return false;
+  for (size_t i = 0; i < SHA256_SIZE; i++) {
+    int hi = hexDigit(text[2 * i]), lo = hexDigit(text[2 * i + 1]);
+    if (hi < 0 || lo < 0) return false;
+    out[i] = (uint8_t)(hi << 4 | lo);
+  }
+  return true;
+}
+
+void sha256ToHex(const uint8_t digest[SHA256_SIZE], char out[2 * SHA256_SIZE + 1]) {
+  static const char hex[] = "0123456789abcdef";
+  for (size_t i = 0; i < SHA256_SIZE; i++) {
+    out[2 * i] = hex[digest[i] >> 4];
+    out[2 * i + 1] = hex[digest[i] & 0x0F];
+  }
+  out[2 * SHA256_SIZE] = '\0';
+}
+
+// --------------------- OtaPatcher -----------------
+void OtaPatcher::begin(uint32_t deltaSize, const uint8_t targetSha[SHA256_SIZE]) {
+  base = &slots.running();
+  target = &slots.inactive();
+  state = OtaCheckpoint();
+  memcpy(state.targetSha, targetSha, SHA256_SIZE);
+  state.deltaSize = deltaSize;
+  state.op = OTA_OP_NONE;
+  state.phase = OTA_PATCH;
+  current = OTA_HEADER;
+  failure = OTA_OK;
+  stage = STAGE_OP;
+  varint = 0;
+  varintShift = 0;
+  fill = 0;
+  sectorsSinceCheckpoint = 0;
+  checkpointPending = false;
+  input = nullptr;
+  inputLength = 0;
+  copied = literal = erased = checkpoints = 0;
+  if (target->sectorSize() % OTA_PAGE) fail(OTA_FLASH);
+  else if (deltaSize <= OTA_DELTA_HEADER) fail(OTA_BAD_DELTA);
+}
+
+bool OtaPatcher::resume(const OtaCheckpoint& cp) {
+  size_t sector = slots.inactive().sectorSize();
+  bool op = cp.op == OTA_OP_NONE || cp.op == OTA_OP_COPY || cp.op == OTA_OP_DATA;
+  if (cp.phase != OTA_PATCH || !op || sector % OTA_PAGE || cp.outPos % sector || cp.outPos > cp.targetSize ||
+      cp.targetSize > slots.inactive().size() || cp.baseSize > slots.running().size() || cp.deltaPos > cp.deltaSize ||
+      cp.deltaPos <= OTA_DELTA_HEADER || (cp.op == OTA_OP_NONE) != (cp.opRemaining == 0) ||
+      (cp.op == OTA_OP_COPY && (uint64_t)cp.copySrc + cp.opRemaining > cp.baseSize) ||
+      (uint64_t)cp.outPos + cp.opRemaining > cp.targetSize)
+    return false;
+  begin(cp.deltaSize, cp.targetSha);
+  state = cp;
+  current = OTA_PATCH;
+  stage = cp.op == OTA_OP_NONE ? STAGE_OP : STAGE_BODY;
+  return true;
+}
+
+bool OtaPatcher::feed(const uint8_t* data, size_t length) {
+  if (!wantsInput() || !length || length > state.deltaSize - state.deltaPos) return false;
+  input = data;
+  inputLength = length;
+  return true;
+}
+
+bool OtaPatcher::busy() const {
+  switch (current) {
+    case OTA_BASE_CHECK:
+    case OTA_VERIFY: return true;
+    case OTA_HEADER:
+    case OTA_PATCH:  return inputLength || (stage == STAGE_BODY && state.op == OTA_OP_COPY);
+    default:         return false;
+  }
+}
+
+void OtaPatcher::fail(OtaError e) {
+  failure = e;
+  current = OTA_FAILED;
+  input = nullptr;
+  inputLength = 0;
+}
+
+bool OtaPatcher::step(size_t budget) {
+  size_t work = 0;
+  while (work < budget) {
+    switch (current) {
+      case OTA_HEADER:
+        if (!inputLength) return false;
+        consumeHeader();
+        break;
+      case OTA_BASE_CHECK:
+        work += hashStep(*base, state.baseSize);
+        break;
+      case OTA_VERIFY:
+        work += hashStep(*target, state.targetSize);
+        break;
+      case OTA_PATCH: {
+        if (stage != STAGE_BODY) {
+          if (!inputLength) {
+            // hết delta mà chưa gặp END
+            if (state.deltaPos == state.deltaSize) fail(OTA_BAD_DELTA);
+            return false;
+          }
+          parseOp();
+          break;
+        }
+        size_t n = OTA_PAGE - fill < state.opRemaining ? OTA_PAGE - fill : state.opRemaining;
+        if (state.op == OTA_OP_COPY) {
+          if (!base->read(state.copySrc, page + fill, n)) {
+            fail(OTA_FLASH);
+            break;
+          }
+          state.copySrc += n;
+          copied += n;
+          work += n;
+        } else {
+          if (!inputLength) {
+            if (state.deltaPos == state.deltaSize) fail(OTA_BAD_DELTA);
+            return false;
+          }
+          if (n > inputLength) n = inputLength;
+          memcpy(page + fill, input, n);
+          input += n;
+          inputLength -= n;
+          state.deltaPos += n;
+          literal += n;
+        }
+        fill += n;
+        state.opRemaining -= n;
+        if (!state.opRemaining) {
+          state.op = OTA_OP_NONE;
+          stage = STAGE_OP;
+        }
+        if (fill == OTA_PAGE) {
+          size_t w = fill + (state.outPos % target->sectorSize() ? 0 : target->sectorSize());
+          if (flushPage()) work += w;
+        }
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  return busy();
+}
+
+bool OtaPatcher::consumeHeader() {
+  size_t n = OTA_DELTA_HEADER - fill < inputLength ? OTA_DELTA_HEADER - fill : inputLength;
+  memcpy(page + fill, input, n);
+  input += n;
+  inputLength -= n;
+  state.deltaPos += n;
+  fill += n;
+  if (fill < OTA_DELTA_HEADER) return false;
+  fill = 0;
+
+  OtaDeltaHeader h;
+  h.magic = otaGet32(page);
+  h.version = otaGet16(page + 4);
+  h.blockSize = otaGet16(page + 6);
+  h.baseSize = otaGet32(page + 8);
+  h.targetSize = otaGet32(page + 12);
+  memcpy(h.baseSha, page + 16, SHA256_SIZE);
+  memcpy(h.targetSha, page + 16 + SHA256_SIZE, SHA256_SIZE);
+  if (h.magic != OTA_DELTA_MAGIC || h.version != OTA_DELTA_VERSION ||
+      memcmp(h.targetSha, state.targetSha, SHA256_SIZE) != 0) {
+    fail(OTA_BAD_DELTA);
+    return false;
+  }
+  if (h.targetSize > target->size()) {
+    fail(OTA_NO_SPACE);
+    return false;
+  }
+  if (h.baseSize > base->size()) {
+    fail(OTA_BASE_MISMATCH);
+    return false;
+  }
+  state.baseSize = h.baseSize;
+  state.targetSize = h.targetSize;
+  memcpy(expectedSha, h.baseSha, SHA256_SIZE);
+  sha.reset();
+  hashed = 0;
+  current = OTA_BASE_CHECK;
+  return true;
+}
+
+// Một byte lệnh hoặc một byte varint của tham số
+bool OtaPatcher::parseOp() {
+  if (stage == STAGE_OP) {
+    uint8_t op = *input++;
+    inputLength--;
+    state.deltaPos++;
+    switch (op) {
+      case OTA_OP_END:  finishPatch(); return false;
+      case OTA_OP_COPY: stage = STAGE_SRC; break;
+      case OTA_OP_DATA: stage = STAGE_LEN; break;
+      default:          fail(OTA_BAD_DELTA); return false;
+    }
+    state.op = op;
+    return true;
+  }
+  uint32_t v;
+  if (!readVarint(v)) return false;
+  if (stage == STAGE_SRC) {
+    state.copySrc = v;
+    stage = STAGE_LEN;
+    return true;
+  }
+  if ((uint64_t)state.outPos + fill + v > state.targetSize ||
+      (state.op == OTA_OP_COPY && (uint64_t)state.copySrc + v > state.baseSize)) {
+    fail(OTA_BAD_DELTA);
+    return false;
+  }
+  state.opRemaining = v;
+  stage = STAGE_BODY;
+  if (!v) {
+    state.op = OTA_OP_NONE;
+    stage = STAGE_OP;
+  }
+  return true;
+}
+
+// LEB128 32 bit, một byte mỗi lần gọi; true khi đủ số
+bool OtaPatcher::readVarint(uint32_t& out) {
+  uint8_t b = *input++;
+  inputLength--;
+  state.deltaPos++;
+  if (varintShift > 28 || (varintShift == 28 && (b & 0x70))) {
+    fail(OTA_BAD_DELTA);
+    return false;
+  }
+  varint |= (uint32_t)(b & 0x7F) << varintShift;
+  if (b & 0x80) {
+    varintShift += 7;
+    return false;
+  }
+  out = varint;
+  varint = 0;
+  varintShift = 0;
+  return true;
+}
+
+bool OtaPatcher::flushPage() {
+  size_t sector = target->sectorSize();
+  if (state.outPos % sector == 0) {
+    if (!target->erase(state.outPos / sector)) {
+      fail(OTA_FLASH);
+      return false;
+    }
+    erased++;
+  }
+  if (!target->write(state.outPos, page, fill)) {
+    fail(OTA_FLASH);
+    return false;
+  }
+  state.outPos += fill;
+  fill = 0;
+  if (state.outPos % sector == 0 && ++sectorsSinceCheckpoint >= checkpointSectors) takeCheckpoint();
+  return true;
+}
+
+void OtaPatcher::takeCheckpoint() {
+  saved = state;
+  checkpointPending = true;
+  checkpoints++;
+  sectorsSinceCheckpoint = 0;
+}
+
+void OtaPatcher::finishPatch() {
+  if (state.deltaPos != state.deltaSize || inputLength) {
+    fail(OTA_BAD_DELTA);   // còn byte sau END
+    return;
+  }
+  if (fill && !flushPage()) return;
+  if (state.outPos != state.targetSize) {
+    fail(OTA_BAD_DELTA);
+    return;
+  }
+  memcpy(expectedSha, state.targetSha, SHA256_SIZE);
+  sha.reset();
+  hashed = 0;
+  current = OTA_VERIFY;
+}
+
+// Băm tiếp một trang của base (BASE_CHECK) hoặc bản đã ghi (VERIFY), so khi đủ size byte
+size_t OtaPatcher::hashStep(FlashHal& flash, uint32_t size) {
+  size_t n = size - hashed < OTA_PAGE ? size - hashed : OTA_PAGE;
+  if (n) {
+    if (!flash.read(hashed, page, n)) {
+      fail(OTA_FLASH);
+      return n;
+    }
+    sha.update(page, n);
+    hashed += n;
+  }
+  if (hashed < size) return n;
+
+  uint8_t digest[SHA256_SIZE];
+  sha.finish(digest);
+  bool match = memcmp(digest, expectedSha, SHA256_SIZE) == 0;
+  if (current == OTA_BASE_CHECK) {
+    if (!match) fail(OTA_BASE_MISMATCH);
+    else current = OTA_PATCH;
+  } else if (!match) {
+    fail(OTA_HASH_MISMATCH);
+  } else {
+    state.phase = OTA_DONE;
+    current = OTA_DONE;
+  }
+  return n ? n : 1;
+}
+
+const char* otaPhaseText(OtaPhase phase) {
+  switch (phase) {
+    case OTA_IDLE:       return "idle";
+    case OTA_HEADER:     return "header";
+    case OTA_BASE_CHECK: return "base";
+    case OTA_PATCH:      return "patch";
+    case OTA_VERIFY:     return "verify";
+    case OTA_DONE:       return "done";
+    case OTA_FAILED:     return "failed";
+  }
+  return "?";
+}
+
+const char* otaErrorText(OtaError error) {
+  switch (error) {
+    case OTA_OK:            return "ok";
+    case OTA_BAD_DELTA:     return "bad delta";
+    case OTA_NO_SPACE:      return "no space";
+    case OTA_BASE_MISMATCH: return "base mismatch";
+    case OTA_FLASH:         return "flash error";
+    case OTA_HASH_MISMATCH: return "hash mismatch";
+  }
+  return "?";
+}
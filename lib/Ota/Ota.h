@@ -0,0 +1,175 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <Hal.h>
+
+/* ===== Ota =====
+ * Cập nhật firmware bằng delta nhị phân theo khối, áp dụng dạng luồng từ phân vùng đang chạy
+ * (base) sang phân vùng còn lại (target), RAM cố định (~600 byte, không cấp phát).
+ *
+ * Delta (tools/ota_delta.py tạo): header OTA_DELTA_HEADER byte little-endian
+ *   [magic "GDLT"][version][blockSize][baseSize][targetSize][SHA-256 base][SHA-256 target]
+ * rồi các lệnh, số nguyên là varint LEB128 không dấu:
+ *   0x01 COPY src len   chép len byte của base từ offset src
+ *   0x02 DATA len bytes len byte mới đi kèm
+ *   0x00 END            phải là byte cuối của delta
+ *
+ * OtaPatcher đọc base từ OtaHal::running(), ghi OtaHal::inactive() (chọn lúc begin()/resume()),
+ * nhận delta từng đoạn theo thứ tự (feed()), step() làm một phần việc giới hạn
+ * theo số byte đọc/ghi flash nên gọi được từ task cooperative:
+ *  - header: kiểm tra kích thước và SHA-256 target khớp lệnh begin, rồi băm base đang chạy
+ *    (baseSize byte đầu) so với header: delta cho bản khác bị từ chối trước khi ghi gì
+ *  - patch: byte đích gom theo trang OTA_PAGE rồi ghi; sector đích được xóa khi trang đầu
+ *    của nó được ghi. Cứ checkpointSectors sector đích ghi xong thì có checkpoint (vị trí
+ *    trong delta + lệnh đang dở) để lưu NVS: mất điện/mất mạng thì resume() từ đó, phần
+ *    sau checkpoint được xóa và ghi lại
+ *  - verify: băm lại targetSize byte đã ghi trên flash, khớp SHA-256 trong header mới DONE;
+ *    nơi gọi chỉ chuyển phân vùng khởi động sau đó
+ */
+
+const size_t SHA256_SIZE = 32;
+
+// SHA-256 (FIPS 180-4), thuần C++ để chạy giống nhau trên ESP32 và native
+class Sha256 {
+public:
+  Sha256() { reset(); }
+  void reset();
+  void update(const void* data, size_t length);
+  void finish(uint8_t digest[SHA256_SIZE]);
+
+private:
+  void compress(const uint8_t* block);
+  uint32_t state[8];
+  uint64_t bytes;
+  uint8_t buffer[64];
+};
+
+// 64 ký tự hex -> 32 byte; false nếu sai độ dài hoặc ký tự
+bool sha256FromHex(const uint8_t* text, size_t length, uint8_t out[SHA256_SIZE]);
+void sha256ToHex(const uint8_t digest[SHA256_SIZE], char out[2 * SHA256_SIZE + 1]);
+
+// Số little-endian trong delta và lệnh OTA, đọc từng byte nên không phụ thuộc thứ tự byte của máy
+static inline uint16_t otaGet16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static inline uint32_t otaGet32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+const uint32_t OTA_DELTA_MAGIC = 0x544C4447;   // "GDLT"
+const uint16_t OTA_DELTA_VERSION = 1;
+struct OtaDeltaHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t blockSize;      // khối so khớp của bộ tạo delta, chỉ để tham khảo
+  uint32_t baseSize;
+  uint32_t targetSize;
+  uint8_t baseSha[SHA256_SIZE];
+  uint8_t targetSha[SHA256_SIZE];
+};
+const size_t OTA_DELTA_HEADER = sizeof(OtaDeltaHeader);
+static_assert(OTA_DELTA_HEADER == 80, "OtaDeltaHeader must match tools/ota_delta.py");
+
+enum OtaOp : uint8_t { OTA_OP_END = 0, OTA_OP_COPY = 1, OTA_OP_DATA = 2, OTA_OP_NONE = 0xFF };
+
+enum OtaPhase : uint8_t { OTA_IDLE, OTA_HEADER, OTA_BASE_CHECK, OTA_PATCH, OTA_VERIFY, OTA_DONE, OTA_FAILED };
+
+enum OtaError : uint8_t {
+  OTA_OK,
+  OTA_BAD_DELTA,       // magic/version, lệnh lạ, varint hỏng, COPY ngoài base, dài/ngắn hơn targetSize
+  OTA_NO_SPACE,        // targetSize lớn hơn phân vùng đích
+  OTA_BASE_MISMATCH,   // firmware đang chạy không phải base của delta
+  OTA_FLASH,           // đọc/ghi/xóa flash lỗi
+  OTA_HASH_MISMATCH,   // SHA-256 của bản đã ghi khác header
+};
+
+// Điểm tiếp tục, lưu NVS nguyên struct (không byte đệm)
+struct OtaCheckpoint {
+  uint8_t targetSha[SHA256_SIZE];   // định danh bản cập nhật
+  uint32_t deltaSize;
+  uint32_t deltaPos;       // byte delta đã áp dụng
+  uint32_t outPos;         // byte đích đã ghi, ở biên sector
+  uint32_t baseSize;
+  uint32_t targetSize;
+  uint32_t opRemaining;    // byte còn lại của lệnh COPY/DATA đang dở
+  uint32_t copySrc;        // offset base kế tiếp của COPY đang dở
+  uint8_t op;              // OtaOp đang dở, OTA_OP_NONE = chờ lệnh mới
+  uint8_t phase;           // OTA_PATCH, hoặc OTA_DONE khi đã xong và chuyển phân vùng
+  uint8_t spare[2];
+};
+static_assert(sizeof(OtaCheckpoint) == 64, "OtaCheckpoint has padding");
+const uint16_t OTA_CHECKPOINT_VERSION = 1;
+
+const size_t OTA_PAGE = 256;   // đơn vị ghi flash và đọc base/target
+
+class OtaPatcher {
+public:
+  OtaPatcher(OtaHal& slots, uint16_t checkpointSectors = 16) : slots(slots), checkpointSectors(checkpointSectors) {}
+
+  // Bắt đầu bản cập nhật mới: deltaSize byte delta, SHA-256 target được công bố trước
+  void begin(uint32_t deltaSize, const uint8_t targetSha[SHA256_SIZE]);
+  // Tiếp tục từ checkpoint (phase OTA_PATCH); false nếu checkpoint không dùng được
+  bool resume(const OtaCheckpoint& cp);
+  void abort() { current = OTA_IDLE; input = nullptr; inputLength = 0; }
+
+  // Đoạn delta kế tiếp, bắt đầu tại offset next(). Không chép: data phải còn nguyên tới khi
+  // wantsInput() trở lại true. false nếu không nhận (đang dở đoạn trước, quá deltaSize, sai phase).
+  bool feed(const uint8_t* data, size_t length);
+  // Làm tới khoảng budget byte đọc/ghi flash (xóa sector tính như ghi cả sector).
+  // true nếu còn việc làm được ngay, không cần thêm dữ liệu.
+  bool step(size_t budget);
+
+  OtaPhase phase() const { return current; }
+  OtaError error() const { return failure; }
+  bool active() const { return current != OTA_IDLE && current != OTA_DONE && current != OTA_FAILED; }
+  bool wantsInput() const { return (current == OTA_HEADER || current == OTA_PATCH) && inputLength == 0; }
+  uint32_t next() const { return state.deltaPos; }
+  uint32_t deltaSize() const { return state.deltaSize; }
+  uint32_t targetSize() const { return state.targetSize; }
+  const uint8_t* targetSha() const { return state.targetSha; }
+  bool busy() const;
+
+  // Có checkpoint mới từ lần checkpointTaken() trước; nơi gọi lưu NVS
+  bool checkpointReady() const { return checkpointPending; }
+  const OtaCheckpoint& checkpointTaken() { checkpointPending = false; return saved; }
+  // Checkpoint của trạng thái hiện tại, dùng sau khi DONE
+  OtaCheckpoint snapshot() const { return state; }
+
+  // thống kê
+  uint32_t copied = 0, literal = 0, erased = 0, checkpoints = 0;
+
+private:
+  enum Stage : uint8_t { STAGE_OP, STAGE_SRC, STAGE_LEN, STAGE_BODY };
+
+  void fail(OtaError e);
+  bool readVarint(uint32_t& out);
+  bool consumeHeader();
+  bool parseOp();
+  bool flushPage();
+  void takeCheckpoint();
+  size_t hashStep(FlashHal& flash, uint32_t size);
+  void finishPatch();
+
+  OtaHal& slots;
+  FlashHal* base = nullptr;
+  FlashHal* target = nullptr;
+  uint16_t checkpointSectors;
+
+  OtaCheckpoint state = {};
+  OtaPhase current = OTA_IDLE;
+  OtaError failure = OTA_OK;
+  Stage stage = STAGE_OP;
+  uint32_t varint = 0;
+  uint8_t varintShift = 0;
+  uint32_t hashed = 0;               // base/target đã băm
+  uint16_t sectorsSinceCheckpoint = 0;
+  uint16_t fill = 0;                 // byte trong page chưa ghi
+  uint8_t expectedSha[SHA256_SIZE];  // base trong BASE_CHECK, target trong VERIFY
+  const uint8_t* input = nullptr;
+  size_t inputLength = 0;
+  bool checkpointPending = false;
+  OtaCheckpoint saved = {};
+  Sha256 sha;
+  uint8_t page[OTA_PAGE];            // cũng là buffer header, đọc base khi băm
+};
+
+const char* otaPhaseText(OtaPhase phase);
+const char* otaErrorText(OtaError error);
@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* ===== RingBuffer =====
+ * Hàng đợi vòng kích thước cố định, không cấp phát động. Khi đầy:
+ *  - OVERWRITE_OLDEST: ghi đè bản ghi cũ nhất (giữ dữ liệu mới nhất)
+ *  - DROP_NEWEST:      bỏ bản ghi mới (giữ dữ liệu đầu đợt mất kết nối)
+ */
+
+enum OverflowPolicy : uint8_t { OVERWRITE_OLDEST, DROP_NEWEST };
+
+template <typename T, size_t N>
+class RingBuffer {
+public:
+  explicit RingBuffer(OverflowPolicy policy = OVERWRITE_OLDEST)
+    : head(0), count(0), policy(policy), droppedCount(0), highWater(0) {}
+
+  // false nếu có bản ghi bị mất (bản mới bị bỏ hoặc bản cũ bị ghi đè)
+  bool push(const T& item) {
+    if (count == N) {
+      droppedCount++;
+      if (policy == DROP_NEWEST) return false;
+      items[head] = item;
+      head = (head + 1) % N;
+      return false;
+    }
+    items[(head + count) % N] = item;
+    count++;
+    if (count > highWater) highWater = count;
+    return true;
+  }
+
+  bool pop(T& out) {
+    if (count == 0) return false;
+    out = items[head];
+    head = (head + 1) % N;
+    count--;
+    return true;
+  }
+
+  // Bỏ n bản ghi cũ nhất (sau khi đã gửi thành công)
+  void discard(size_t n) {
+    if (n > count) n = count;
+    head = (head + n) % N;
+    count -= n;
+  }
+
+  // i = 0 là bản ghi cũ nhất
+  const T& peek(size_t i) const { return items[(head + i) % N]; }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  bool full() const { return count == N; }
+  static constexpr size_t capacity() { return N; }
+  void clear() { head = count = 0; }
+
+  void setPolicy(OverflowPolicy p) { policy = p; }
+  uint32_t dropped() const { return droppedCount; }
+  size_t maxUsed() const { return highWater; }
+
+private:
+  T items[N];
+  size_t head;
+  size_t count;
+  OverflowPolicy policy;
+  uint32_t droppedCount;
+  size_t highWater;
+};
@@ -0,0 +1,101 @@
+#include "Scheduler.h"
+#include <string.h>
+
+// so sánh thời gian an toàn khi millis() tràn (~49 ngày)
+static inline bool reached(uint32_t now, uint32_t t) { return (int32_t)(now - t) >= 0; }
+
+Scheduler::Scheduler(ClockFn clockMs, ClockFn clockUs)
+  : taskCount(0), nowMs(clockMs), nowUs(clockUs) {
+  memset(tasks, 0, sizeof(tasks));
+}
+
+TaskId Scheduler::add(const char* name, TaskFn fn, bool periodic, uint32_t periodMs,
+                      uint32_t deadlineMs, uint32_t budgetUs) {
+  if (taskCount >= MAX_TASKS || fn == nullptr) return NO_TASK;
+  Task& t = tasks[taskCount];
+  memset(&t, 0, sizeof(t));
+  t.name = name;
+  t.fn = fn;
+  t.periodic = periodic;
+  t.periodMs = periodMs;
+  t.deadlineMs = deadlineMs;
+  t.budgetUs = budgetUs;
+  return (TaskId)taskCount++;
+}
+
+TaskId Scheduler::every(const char* name, TaskFn fn, uint32_t periodMs,
+                        uint32_t deadlineMs, uint32_t budgetUs, bool startNow) {
+  TaskId id = add(name, fn, true, periodMs, deadlineMs, budgetUs);
+  if (id != NO_TASK) runIn(id, startNow ? 0 : periodMs);
+  return id;
+}
+
+TaskId Scheduler::once(const char* name, TaskFn fn, uint32_t deadlineMs, uint32_t budgetUs) {
+  return add(name, fn, false, 0, deadlineMs, budgetUs);
+}
+
+void Scheduler::runIn(TaskId id, uint32_t delayMs) {
+  if (id < 0 || id >= taskCount) return;
+  tasks[id].nextRunMs = nowMs() + delayMs;
+  tasks[id].enabled = true;
+}
+
+void Scheduler::enable(TaskId id, bool on) {
+  if (id < 0 || id >= taskCount) return;
+  if (on && !tasks[id].enabled) tasks[id].nextRunMs = nowMs();
+  tasks[id].enabled = on;
+}
+
+bool Scheduler::pending(TaskId id) const {
+  return id >= 0 && id < taskCount && tasks[id].enabled;
+}
+
+uint8_t Scheduler::tick() {
+  uint8_t ran = 0;
+  for (uint8_t i = 0; i < taskCount; i++) {
+    Task& t = tasks[i];
+    uint32_t now = nowMs();
+    if (!t.enabled || !reached(now, t.nextRunMs)) continue;
+
+    if (now - t.nextRunMs > t.deadlineMs) t.missed++;
+
+    if (t.periodic) {
+      // giữ nhịp cố định; nếu tụt lại quá một chu kỳ thì bỏ qua các lần đã lỡ
+      t.nextRunMs += t.periodMs;
+      if (reached(now, t.nextRunMs)) t.nextRunMs = now + t.periodMs;
+    } else {
+      t.enabled = false;  // tắt trước khi chạy để task có thể tự hẹn lại
+    }
+
+    uint32_t start = nowUs();
+    t.fn();
+    uint32_t took = nowUs() - start;
+
+    t.runs++;
+    t.lastRunUs = took;
+    if (took > t.maxRunUs) t.maxRunUs = took;
+    if (t.budgetUs && took > t.budgetUs) t.overruns++;
+    ran++;
+  }
+  return ran;
+}
+
+uint32_t Scheduler::msUntilNext() const {
+  uint32_t now = nowMs();
+  uint32_t best = UINT32_MAX;
+  for (uint8_t i = 0; i < taskCount; i++) {
+    const Task& t = tasks[i];
+    if (!t.enabled || (t.periodic && t.periodMs == 0)) continue;  // task chạy mỗi tick không hẹn giờ
+    if (reached(now, t.nextRunMs)) return 0;
+    uint32_t wait = t.nextRunMs - now;
+    if (wait < best) best = wait;
+  }
+  return best;
+}
+
+void Scheduler::resetStats() {
+  for (uint8_t i = 0; i < taskCount; i++) {
+    tasks[i].runs = tasks[i].missed = tasks[i].overruns = 0;
+    tasks[i].lastRunUs = tasks[i].maxRunUs = 0;
+  }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+
+/* ===== Scheduler =====
+ * Bộ lập lịch hợp tác (cooperative) chạy theo millis(): mỗi lần loop() gọi
+ * tick() một lần, các task đến hạn được chạy lần lượt và phải trả về ngay
+ * (không delay). Không cấp phát động, số task tối đa cố định.
+ */
+
+typedef void (*TaskFn)();
+typedef uint32_t (*ClockFn)();
+typedef int8_t TaskId;
+
+const TaskId NO_TASK = -1;
+
+struct Task {
+  const char* name;
+  TaskFn   fn;
+  bool     periodic;     // false = one-shot, tự tắt sau khi chạy
+  bool     enabled;
+  uint32_t periodMs;     // chu kỳ (periodic), 0 = chạy mỗi tick
+  uint32_t deadlineMs;   // được phép bắt đầu trễ tối đa bao nhiêu ms
+  uint32_t budgetUs;     // thời gian chạy tối đa cho một lần
+  uint32_t nextRunMs;
+
+  // thống kê
+  uint32_t runs;
+  uint32_t missed;       // bắt đầu trễ quá deadlineMs
+  uint32_t overruns;     // chạy lâu hơn budgetUs
+  uint32_t lastRunUs;
+  uint32_t maxRunUs;
+};
+
+class Scheduler {
+public:
+  static const uint8_t MAX_TASKS = 16;
+
+  Scheduler(ClockFn clockMs, ClockFn clockUs);
+
+  // Task định kỳ; startNow=false thì lần chạy đầu sau một chu kỳ
+  TaskId every(const char* name, TaskFn fn, uint32_t periodMs,
+               uint32_t deadlineMs, uint32_t budgetUs, bool startNow = true);
+  // Task một lần, tạo ở trạng thái tắt, kích hoạt bằng runIn()/runNow()
+  TaskId once(const char* name, TaskFn fn, uint32_t deadlineMs, uint32_t budgetUs);
+
+  void runIn(TaskId id, uint32_t delayMs);
+  void runNow(TaskId id) { runIn(id, 0); }
+  void enable(TaskId id, bool on);
+  bool pending(TaskId id) const;
+
+  // Chạy tất cả task đến hạn, trả về số task đã chạy
+  uint8_t tick();
+  // Số ms tới task kế tiếp (0 nếu đã có task đến hạn, UINT32_MAX nếu không có).
+  // Task periodMs = 0 (chạy mỗi tick) không được tính.
+  uint32_t msUntilNext() const;
+
+  uint8_t count() const { return taskCount; }
+  const Task& task(TaskId id) const { return tasks[id]; }
+  void resetStats();
+
+private:
+  TaskId add(const char* name, TaskFn fn, bool periodic, uint32_t periodMs,
+             uint32_t deadlineMs, uint32_t budgetUs);
+
+  Task tasks[MAX_TASKS];
+  uint8_t taskCount;
+  ClockFn nowMs;
+  ClockFn nowUs;
+};
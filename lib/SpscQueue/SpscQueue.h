@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+/* ===== SpscQueue =====
+ * Hàng đợi một producer / một consumer không khóa, kích thước cố định (N là lũy
+ * thừa của 2). push() chỉ được gọi từ một luồng, pop() từ đúng một luồng khác;
+ * head/tail là bộ đếm tăng dần, chỉ chủ của nó ghi, nên không cần mutex hay
+ * tắt ngắt. Khi đầy, push() bỏ bản ghi mới và tăng dropped().
+ */
+
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+  SpscQueue() : head(0), tail(0), droppedCount(0), highWater(0) {}
+
+  // Chỉ gọi từ luồng producer
+  bool push(const T& item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t used = h - tail.load(std::memory_order_acquire);
+    if (used == N) {
+      droppedCount.store(droppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    items[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    if (used + 1 > highWater.load(std::memory_order_relaxed)) highWater.store(used + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Chỉ gọi từ luồng consumer
+  bool pop(T& out) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    out = items[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Đọc được từ bất kỳ luồng nào (giá trị tức thời)
+  size_t size() const {
+    uint32_t t = tail.load(std::memory_order_acquire);   // đọc tail trước để không bao giờ > head
+    return head.load(std::memory_order_acquire) - t;
+  }
+  bool empty() const { return size() == 0; }
+  size_t capacity() const { return N; }
+  uint32_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+  size_t maxUsed() const { return highWater.load(std::memory_order_relaxed); }
+
+private:
+  T items[N];
+  std::atomic<uint32_t> head;           // producer ghi
+  std::atomic<uint32_t> tail;           // consumer ghi
+  std::atomic<uint32_t> droppedCount;   // producer ghi
+  std::atomic<uint32_t> highWater;      // producer ghi
+};
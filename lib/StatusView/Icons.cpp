@@ -0,0 +1,55 @@
+#include "Icons.h"
+
+//--------------------- tạo icon cho màn hình OLED --------------------- 
+// 16x16 - Nhiệt độ (nhiệt kế)
+const unsigned char PROGMEM icon_temp16[] = {
+  0x06,0x00, 0x06,0x00, 0x06,0x00, 0x06,0x00,
+  0x06,0x00, 0x06,0x00, 0x06,0x00, 0x06,0x00,
+  0x0F,0x00, 0x1F,0x80, 0x3F,0xC0, 0x3F,0xC0,
+  0x3F,0xC0, 0x1F,0x80, 0x0F,0x00, 0x06,0x00
+};
+
+// 16x16 - Độ ẩm (giọt nước)
+const unsigned char PROGMEM icon_humid16[] = {
+  0x03,0x00, 0x07,0x80, 0x0F,0xC0, 0x1F,0xE0,
+  0x1F,0xE0, 0x3F,0xF0, 0x3F,0xF0, 0x3F,0xF0,
+  0x1F,0xE0, 0x1F,0xE0, 0x0F,0xC0, 0x07,0x80,
+  0x03,0x00, 0x03,0x00, 0x01,0x00, 0x00,0x00
+};
+
+// 16x16 - Ánh sáng (mặt trời + tia)
+const unsigned char PROGMEM icon_light16[] = {
+  0x01,0x00, 0x03,0x80, 0x07,0xC0, 0x0C,0x60,
+  0x10,0x10, 0x10,0x10, 0x20,0x08, 0x21,0x08,
+  0x20,0x08, 0x10,0x10, 0x10,0x10, 0x0C,0x60,
+  0x07,0xC0, 0x03,0x80, 0x01,0x00, 0x00,0x00
+};
+
+// 16x16 - Độ ẩm đất (mầm cây + nền đất)
+const unsigned char PROGMEM icon_soil16[] = {
+  0x00,0x00, 0x01,0x00, 0x03,0x80, 0x06,0xC0,
+  0x03,0x80, 0x01,0x00, 0x00,0x00, 0xFF,0xFF,
+  0xFF,0xFF, 0xFF,0xFF, 0x00,0x00, 0x00,0x00,
+  0x00,0x00, 0x00,0x00, 0x00,0x00, 0x00,0x00
+};
+
+
+const unsigned char wifi_icon [] PROGMEM = {
+  0x00,0x00,0x00,0x07,0xe0,0x1f,0xf8,0x7f,0xfc,0xff,0xfe,0x7f,0xfc,0x1f,0xf8,0x07,
+  0xe0,0x00,0x00,0x00
+};
+
+const unsigned char wifi_dc [] PROGMEM = {
+  0x00,0x00,0x00,0x03,0xc0,0x0f,0xf0,0x3f,0xf8,0x7f,0xfc,0x3f,0xf8,0x0f,0xf0,0x03,
+  0xc0,0x00,0x00,0x00
+};
+
+const unsigned char Update_OK [] PROGMEM = {
+  0x01,0x80,0x06,0xf0,0x10,0x18,0x20,0x20,0x40,0x40,0x32,0x0c,0x62,0x06,0x84,0x03,
+  0x83,0x03,0x41,0x82,0x40,0x82,0x20,0x84,0x10,0x88,0x08,0x90,0x07,0xe0,0x01,0x80
+};
+
+const unsigned char Update_NOK [] PROGMEM = {
+  0x01,0x80,0x06,0x70,0x08,0x08,0x10,0x10,0x20,0x20,0x44,0x44,0x82,0x82,0x82,0x82,
+  0x82,0x82,0x44,0x44,0x20,0x20,0x10,0x10,0x08,0x08,0x06,0x70,0x01,0x80,0x00,0x00
+};
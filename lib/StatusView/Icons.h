@@ -0,0 +1,12 @@
+#pragma once
+#include <Hal.h>
+
+// Icon 16x16 cho màn hình OLED (định dạng drawBitmap: theo hàng, MSB trước)
+extern const unsigned char icon_temp16[];
+extern const unsigned char icon_humid16[];
+extern const unsigned char icon_light16[];
+extern const unsigned char icon_soil16[];
+extern const unsigned char wifi_icon[];
+extern const unsigned char wifi_dc[];
+extern const unsigned char Update_OK[];
+extern const unsigned char Update_NOK[];
@@ -0,0 +1,95 @@
+#include "StatusView.h"
+#include "Icons.h"
+#include <stdio.h>
+#include <string.h>
+
+const StatusFormats STATUS_FORMATS_DEFAULT = { "Temp: %.1f C", "H: %.0f %%", "Light: %d %%", "Soil: %d %%" };
+
+// Bố cục: hàng i chiếm y = 16*i .. 16*i+15, icon ở x = 0, chữ ở (20, 16*i+4)
+static const int16_t TEXT_X = 20;
+static const int16_t TEXT_H = 8;
+static const int16_t TEXT_W[] = { 84, 84, 72, 72 };  // hàng 2-3 chừa chỗ cho cờ LAMP/PUMP
+static const int16_t WIFI_X = 110;
+static const int16_t FLAG_X = 92, FLAG_W = 24;
+static const int16_t LAMP_Y = 36, PUMP_Y = 52;
+static const uint8_t PAGES = 8;      // 64 hàng / 8
+static const uint8_t WIDTH = 128;
+
+StatusView::StatusView(DisplayHal& display, const StatusFormats& formats)
+  : display(display), formats(formats), valid(false), wifi(false), lamp(false), pump(false) {
+  memset(lines, 0, sizeof(lines));
+  memset(dirtyMin, 0xFF, sizeof(dirtyMin));
+  memset(dirtyMax, 0, sizeof(dirtyMax));
+}
+
+void StatusView::markDirty(int16_t x, int16_t y, int16_t w, int16_t h) {
+  for (int16_t page = y / 8; page <= (y + h - 1) / 8 && page < PAGES; page++) {
+    if (x < dirtyMin[page]) dirtyMin[page] = x;
+    if (x + w - 1 > dirtyMax[page]) dirtyMax[page] = x + w - 1;
+  }
+}
+
+bool StatusView::updateText(uint8_t row, const char* line) {
+  if (valid && strcmp(lines[row], line) == 0) return false;
+  strncpy(lines[row], line, TEXT_LEN - 1);
+  int16_t y = row * 16 + 4;
+  display.fillRect(TEXT_X, y, TEXT_W[row], TEXT_H, false);
+  display.text(TEXT_X, y, lines[row]);
+  markDirty(TEXT_X, y, TEXT_W[row], TEXT_H);
+  return true;
+}
+
+void StatusView::drawFlag(int16_t x, int16_t y, bool on, const char* label) {
+  display.fillRect(x, y, FLAG_W, TEXT_H, false);
+  if (on) display.text(x, y, label);
+  markDirty(x, y, FLAG_W, TEXT_H);
+}
+
+void StatusView::drawWifi(bool up) {
+  display.fillRect(WIFI_X, 0, 16, 16, false);
+  display.drawBitmap(WIFI_X, 0, up ? wifi_icon : wifi_dc, 16, 16, true);
+  markDirty(WIFI_X, 0, 16, 16);
+}
+
+uint8_t StatusView::render(const StatusFields& f) {
+  char line[TEXT_LEN];
+  bool full = !valid;
+
+  if (full) {
+    display.clear();
+    display.drawBitmap(0, 0,  icon_temp16,  16, 16, true);
+    display.drawBitmap(0, 16, icon_humid16, 16, 16, true);
+    display.drawBitmap(0, 32, icon_light16, 16, 16, true);
+    display.drawBitmap(0, 48, icon_soil16,  16, 16, true);
+  }
+
+  uint8_t changed = 0;
+  snprintf(line, sizeof(line), formats.temp, f.temp);   changed += updateText(0, line);
+  snprintf(line, sizeof(line), formats.hum, f.hum);     changed += updateText(1, line);
+  snprintf(line, sizeof(line), formats.light, f.light); changed += updateText(2, line);
+  snprintf(line, sizeof(line), formats.soil, f.soil);   changed += updateText(3, line);
+
+  if (full || f.wifi != wifi) { drawWifi(f.wifi); wifi = f.wifi; changed++; }
+  if (full || f.lamp != lamp) { drawFlag(FLAG_X, LAMP_Y, f.lamp, "LAMP"); lamp = f.lamp; changed++; }
+  if (full || f.pump != pump) { drawFlag(FLAG_X, PUMP_Y, f.pump, "PUMP"); pump = f.pump; changed++; }
+
+  uint8_t pagesSent = 0;
+  if (full) {
+    display.flush();
+    bytesPushed += WIDTH * PAGES;
+    fullRedraws++;
+    pagesSent = PAGES;
+    valid = true;
+  } else if (changed) {
+    fieldRedraws += changed;
+    for (uint8_t page = 0; page < PAGES; page++) {
+      if (dirtyMin[page] > dirtyMax[page]) continue;
+      display.flushRegion(page, page, dirtyMin[page], dirtyMax[page]);
+      bytesPushed += dirtyMax[page] - dirtyMin[page] + 1;
+      pagesSent++;
+    }
+  }
+  memset(dirtyMin, 0xFF, sizeof(dirtyMin));
+  memset(dirtyMax, 0, sizeof(dirtyMax));
+  return pagesSent;
+}
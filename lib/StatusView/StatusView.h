@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include <Hal.h>
+
+/* ===== StatusView =====
+ * Màn hình trạng thái 128x64 (4 hàng icon 16x16 + chữ, icon WiFi, cờ LAMP/PUMP).
+ * Giữ lại nội dung đã vẽ của từng trường; render() chỉ xóa/vẽ lại trường thay
+ * đổi và chỉ gửi các page/cột SSD1306 bị ảnh hưởng qua flushRegion().
+ */
+
+struct StatusFields {
+  float temp;
+  float hum;
+  int light;
+  int soil;
+  bool wifi;
+  bool lamp;
+  bool pump;
+};
+
+// Chuỗi printf cho 4 hàng (temp, hum dùng float; light, soil dùng int)
+struct StatusFormats {
+  const char* temp;
+  const char* hum;
+  const char* light;
+  const char* soil;
+};
+
+extern const StatusFormats STATUS_FORMATS_DEFAULT;  // "Temp: 25.0 C", "H: 50 %", ...
+
+class StatusView {
+public:
+  explicit StatusView(DisplayHal& display, const StatusFormats& formats = STATUS_FORMATS_DEFAULT);
+
+  // Lần render() kế tiếp vẽ lại toàn màn hình (sau khi màn hình bị vẽ đè)
+  void invalidate() { valid = false; }
+  // Trả về số page đã gửi (0 nếu không có gì thay đổi)
+  uint8_t render(const StatusFields& f);
+
+  uint32_t fullRedraws = 0;
+  uint32_t fieldRedraws = 0;
+  uint32_t bytesPushed = 0;   // byte dữ liệu framebuffer đã gửi
+
+private:
+  enum { ROWS = 4, TEXT_LEN = 16 };
+
+  void markDirty(int16_t x, int16_t y, int16_t w, int16_t h);
+  bool updateText(uint8_t row, const char* line);
+  void drawFlag(int16_t x, int16_t y, bool on, const char* label);
+  void drawWifi(bool up);
+
+  DisplayHal& display;
+  StatusFormats formats;
+  bool valid;
+  char lines[ROWS][TEXT_LEN];
+  bool wifi, lamp, pump;
+
+  // cột bẩn nhỏ nhất/lớn nhất của mỗi page, dirtyMin > dirtyMax = sạch
+  uint8_t dirtyMin[8];
+  uint8_t dirtyMax[8];
+};
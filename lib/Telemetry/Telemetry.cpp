@@ -0,0 +1,68 @@
+#include "Telemetry.h"
+#include <math.h>
+
+static inline void put16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static inline void put32(uint8_t* p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+static inline uint16_t get16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static inline uint32_t get32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+TelemetryBatcher::TelemetryBatcher(uint8_t batchSize)
+  : batchSize(batchSize == 0 ? 1 : batchSize > TELEMETRY_MAX_BATCH ? TELEMETRY_MAX_BATCH : batchSize),
+    count(0), seq(0) {}
+
+bool TelemetryBatcher::add(const SensorSample& s) {
+  if (count < batchSize) samples[count++] = s;
+  return count >= batchSize;
+}
+
+size_t TelemetryBatcher::encode(uint8_t* out, size_t capacity) {
+  size_t len = telemetryFrameSize(count);
+  if (count == 0 || capacity < len) return 0;
+
+  uint32_t base = samples[0].ms;
+  out[0] = TELEMETRY_VERSION;
+  out[1] = count;
+  put16(out + 2, 0);
+  put32(out + 4, seq++);
+  put32(out + 8, base);
+
+  uint8_t* p = out + TELEMETRY_HEADER_SIZE;
+  for (uint8_t i = 0; i < count; i++, p += TELEMETRY_SAMPLE_SIZE) {
+    const SensorSample& s = samples[i];
+    bool tempOk = !isnan(s.temp) && s.temp > -300.0f && s.temp < 327.0f;
+    bool humOk = !isnan(s.hum) && s.hum >= 0.0f && s.hum <= 100.0f;
+    put32(p, s.ms - base);
+    put16(p + 4, tempOk ? (uint16_t)(int16_t)lroundf(s.temp * 100.0f) : (uint16_t)TELEMETRY_INVALID_TEMP);
+    put16(p + 6, humOk ? (uint16_t)lroundf(s.hum * 100.0f) : TELEMETRY_INVALID_HUM);
+    p[8] = s.light;
+    p[9] = s.soil;
+  }
+  count = 0;
+  return len;
+}
+
+int decodeTelemetryFrame(const uint8_t* data, size_t length, TelemetryHeader& header,
+                         SensorSample* samples, uint8_t maxSamples) {
+  if (length < TELEMETRY_HEADER_SIZE || data[0] != TELEMETRY_VERSION) return -1;
+  header.version = data[0];
+  header.count = data[1];
+  header.flags = get16(data + 2);
+  header.seq = get32(data + 4);
+  header.baseMs = get32(data + 8);
+  if (length != telemetryFrameSize(header.count)) return -1;
+
+  uint8_t n = header.count < maxSamples ? header.count : maxSamples;
+  const uint8_t* p = data + TELEMETRY_HEADER_SIZE;
+  for (uint8_t i = 0; i < n; i++, p += TELEMETRY_SAMPLE_SIZE) {
+    int16_t t = (int16_t)get16(p + 4);
+    uint16_t h = get16(p + 6);
+    samples[i].ms = header.baseMs + get32(p);
+    samples[i].temp = t == TELEMETRY_INVALID_TEMP ? NAN : t / 100.0f;
+    samples[i].hum = h == TELEMETRY_INVALID_HUM ? NAN : h / 100.0f;
+    samples[i].light = p[8];
+    samples[i].soil = p[9];
+  }
+  return n;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* ===== Telemetry frame =====
+ * Khung nhị phân gom nhiều mẫu cảm biến vào một lần publish. Mọi trường đều
+ * little-endian, ghi từng byte nên không phụ thuộc packing của compiler.
+ *
+ *  header (12 byte)
+ *    0  u8   version (TELEMETRY_VERSION)
+ *    1  u8   count   số mẫu trong khung
+ *    2  u16  flags   dự phòng, = 0
+ *    4  u32  seq     tăng 1 sau mỗi khung (phát hiện mất khung)
+ *    8  u32  baseMs  millis() của mẫu đầu tiên
+ *  sample (10 byte) x count
+ *    0  u32  dtMs    lệch so với baseMs
+ *    4  i16  temp    0.01 °C, TELEMETRY_INVALID_TEMP nếu lỗi
+ *    6  u16  hum     0.01 %,  TELEMETRY_INVALID_HUM nếu lỗi
+ *    8  u8   light   %
+ *    9  u8   soil    %
+ */
+
+const uint8_t TELEMETRY_VERSION = 1;
+const size_t TELEMETRY_HEADER_SIZE = 12;
+const size_t TELEMETRY_SAMPLE_SIZE = 10;
+const uint8_t TELEMETRY_MAX_BATCH = 16;
+const int16_t TELEMETRY_INVALID_TEMP = INT16_MIN;
+const uint16_t TELEMETRY_INVALID_HUM = 0xFFFF;
+
+struct SensorSample {
+  uint32_t ms;
+  float temp;      // -999 hoặc NaN nếu lỗi
+  float hum;
+  uint8_t light;   // %
+  uint8_t soil;    // %
+};
+
+inline size_t telemetryFrameSize(uint8_t count) {
+  return TELEMETRY_HEADER_SIZE + (size_t)count * TELEMETRY_SAMPLE_SIZE;
+}
+
+// Gom batch mẫu rồi mã hóa thành một khung
+class TelemetryBatcher {
+public:
+  explicit TelemetryBatcher(uint8_t batchSize);
+
+  // Trả về true khi batch đã đầy và cần encode()
+  bool add(const SensorSample& s);
+  bool empty() const { return count == 0; }
+  uint8_t size() const { return count; }
+
+  // Ghi khung vào out, xóa batch; trả về số byte (0 nếu out không đủ chỗ)
+  size_t encode(uint8_t* out, size_t capacity);
+
+  uint32_t sequence() const { return seq; }
+
+private:
+  SensorSample samples[TELEMETRY_MAX_BATCH];
+  uint8_t batchSize;
+  uint8_t count;
+  uint32_t seq;
+};
+
+// Giải mã khung (dùng cho host/gateway); trả về số mẫu, -1 nếu khung sai
+struct TelemetryHeader {
+  uint8_t version;
+  uint8_t count;
+  uint16_t flags;
+  uint32_t seq;
+  uint32_t baseMs;
+};
+
+int decodeTelemetryFrame(const uint8_t* data, size_t length, TelemetryHeader& header,
+                         SensorSample* samples, uint8_t maxSamples);
@@ -0,0 +1,199 @@
+#include "ThingSpeakBulk.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifndef ARDUINO
+#include <time.h>
+// Host: đồng hồ đơn điệu thay millis() của Arduino
+static uint32_t millis() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000ull + ts.tv_nsec / 1000000);
+}
+#endif
+
+// Header được đặt ngay trước body để cả request đi trong một lần write()
+// (hai lần write nhỏ gặp Nagle + delayed ACK, thêm ~40 ms mỗi request)
+static const size_t HEAD_MAX = 192;
+static char request[HEAD_MAX + TS_MAX_BATCH * 200 + 96];
+
+ThingSpeakBulk::ThingSpeakBulk(Client& client, const char* host, uint16_t port,
+                               unsigned long channel, const char* writeKey)
+  : client(client), host(host), port(port), channel(channel), writeKey(writeKey) {}
+
+void ThingSpeakBulk::setField(uint8_t field, float value) {
+  if (field < 1 || field > TS_FIELDS) return;
+  current.field[field - 1] = value;
+  current.mask |= 1 << (field - 1);
+}
+
+bool ThingSpeakBulk::commit() {
+  if (!current.mask) return true;
+  current.ms = millis();
+  bool kept = queue.push(current);
+  counters.committed++;
+  current.mask = 0;
+  return kept;
+}
+
+void ThingSpeakBulk::poll() {
+  uint32_t now = millis();
+
+  if (state == WAIT_RESPONSE) {
+    while (parse != DONE && client.available() > 0) feed((char)client.read());
+    if (parse == BODY_CLOSE && !client.connected()) parse = DONE;   // body kết thúc khi server đóng
+    if (parse == DONE) {
+      finish(status >= 200 && status < 300);
+    } else if (!client.connected()) {
+      counters.failures++;
+      client.stop();
+      state = IDLE;
+    } else if (now - requestMs > timeoutMs) {
+      counters.timeouts++;
+      client.stop();   // response dở dang, kết nối không dùng lại được
+      state = IDLE;
+    }
+    return;
+  }
+
+  if (queue.empty() || now - lastFlushMs < flushIntervalMs) return;
+  lastFlushMs = now;
+  if (!sendBatch()) {
+    counters.failures++;
+    client.stop();
+  }
+}
+
+// {"write_api_key":"...","updates":[{"delta_t":0,"field1":23.50,...},...]}
+// delta_t: số giây kể từ bản ghi trước trong cùng request (bản đầu: 0)
+size_t ThingSpeakBulk::buildBody(char* out, size_t cap, uint8_t& count) const {
+  size_t n = snprintf(out, cap, "{\"write_api_key\":\"%s\",\"updates\":[", writeKey);
+  count = 0;
+  while (count < queue.size() && count < TS_MAX_BATCH && n + 200 < cap) {
+    const TsSnapshot& s = queue.peek(count);
+    uint32_t dt = count ? (s.ms - queue.peek(count - 1).ms + 500) / 1000 : 0;
+    n += snprintf(out + n, cap - n, "%s{\"delta_t\":%lu", count ? "," : "", (unsigned long)dt);
+    for (uint8_t f = 0; f < TS_FIELDS; f++) {
+      if (s.mask & (1 << f)) n += snprintf(out + n, cap - n, ",\"field%u\":%.2f", f + 1, s.field[f]);
+    }
+    out[n++] = '}';
+    count++;
+  }
+  n += snprintf(out + n, cap - n, "]}");
+  return n;
+}
+
+bool ThingSpeakBulk::sendBatch() {
+  if (!client.connected()) {
+    client.stop();
+    // bắt tay TCP là bước chặn duy nhất, chỉ khi chưa có kết nối keep-alive
+    if (!client.connect(host, port)) return false;
+    counters.connects++;
+  }
+
+  uint8_t count;
+  char* body = request + HEAD_MAX;
+  size_t len = buildBody(body, sizeof(request) - HEAD_MAX, count);
+  char head[HEAD_MAX];
+  size_t headLen = snprintf(head, sizeof(head),
+                            "POST /channels/%lu/bulk_update.json HTTP/1.1\r\n"
+                            "Host: %s\r\n"
+                            "Connection: keep-alive\r\n"
+                            "Content-Type: application/json\r\n"
+                            "Content-Length: %u\r\n\r\n",
+                            channel, host, (unsigned)len);
+  char* start = body - headLen;
+  memcpy(start, head, headLen);
+  if (client.write((const uint8_t*)start, headLen + len) != headLen + len) return false;
+
+  counters.requests++;
+  inFlight = count;
+  droppedAtSend = queue.dropped();
+  requestMs = millis();
+  state = WAIT_RESPONSE;
+  parse = STATUS_LINE;
+  lineLen = 0;
+  status = 0;
+  return true;
+}
+
+void ThingSpeakBulk::feed(char c) {
+  switch (parse) {
+    case BODY_LENGTH:
+      if (--remaining <= 0) parse = DONE;
+      return;
+    case BODY_CLOSE:
+      return;
+    case CHUNK_DATA:
+      if (--remaining <= 0) parse = CHUNK_END;
+      return;
+    default:
+      break;
+  }
+  if (c == '\r') return;
+  if (c != '\n') {
+    if (lineLen < sizeof(line) - 1) line[lineLen++] = c;
+    return;
+  }
+  line[lineLen] = 0;
+  onLine();
+  lineLen = 0;
+}
+
+void ThingSpeakBulk::onLine() {
+  switch (parse) {
+    case STATUS_LINE: {
+      const char* code = strchr(line, ' ');
+      status = (strncmp(line, "HTTP/", 5) == 0 && code) ? atoi(code + 1) : 0;
+      remaining = -1;
+      chunked = false;
+      closeAfter = false;
+      parse = HEADER;
+      break;
+    }
+    case HEADER:
+      if (lineLen == 0) {
+        if (chunked) parse = CHUNK_SIZE;
+        else if (remaining > 0) parse = BODY_LENGTH;
+        else if (remaining == 0) parse = DONE;
+        else { parse = BODY_CLOSE; closeAfter = true; }
+      } else if (strncasecmp(line, "content-length:", 15) == 0) {
+        remaining = atol(line + 15);
+      } else if (strncasecmp(line, "transfer-encoding:", 18) == 0) {
+        chunked = strstr(line + 18, "chunked") != NULL;
+      } else if (strncasecmp(line, "connection:", 11) == 0) {
+        closeAfter = strstr(line + 11, "close") != NULL;
+      }
+      break;
+    case CHUNK_SIZE:
+      remaining = strtol(line, NULL, 16);
+      parse = remaining > 0 ? CHUNK_DATA : TRAILER;
+      break;
+    case CHUNK_END:
+      parse = CHUNK_SIZE;
+      break;
+    case TRAILER:
+      if (lineLen == 0) parse = DONE;
+      break;
+    default:
+      break;
+  }
+}
+
+void ThingSpeakBulk::finish(bool ok) {
+  uint32_t latency = millis() - requestMs;
+  counters.lastLatencyMs = latency;
+  if (latency > counters.maxLatencyMs) counters.maxLatencyMs = latency;
+  if (ok) {
+    // bản ghi đã gửi có thể đã bị ghi đè khỏi đầu hàng đợi trong lúc chờ
+    uint32_t overwritten = queue.dropped() - droppedAtSend;
+    if (overwritten < inFlight) queue.discard(inFlight - overwritten);
+    counters.sent += inFlight;
+  } else {
+    counters.failures++;
+  }
+  if (closeAfter) client.stop();
+  state = IDLE;
+}
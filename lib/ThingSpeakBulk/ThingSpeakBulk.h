@@ -0,0 +1,105 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <RingBuffer.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <Client.h>
+#else
+// Host (src/native/thingspeak): phần interface Client của Arduino mà lib dùng
+class Client {
+public:
+  virtual ~Client() {}
+  virtual int connect(const char* host, uint16_t port) = 0;
+  virtual size_t write(const uint8_t* buf, size_t size) = 0;
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual void stop() = 0;
+  virtual uint8_t connected() = 0;
+};
+#endif
+
+/* ===== ThingSpeakBulk =====
+ * Gửi ThingSpeak không chặn. setField()/commit() chụp một bản ghi (tối đa 8 field)
+ * vào hàng đợi; poll() gửi dồn các bản ghi thành một request bulk_update.json
+ * mỗi flushInterval ms, trên một kết nối TCP giữ lại giữa các lần gửi
+ * (keep-alive). Response được đọc dần mỗi lần poll(), không chờ.
+ * Lỗi (kết nối, HTTP != 2xx, hết giờ) giữ nguyên dữ liệu để gửi lại lần sau.
+ */
+
+const uint8_t TS_FIELDS = 8;
+const uint8_t TS_MAX_BATCH = 8;          // bản ghi mỗi request
+const size_t  TS_QUEUE_CAPACITY = 32;
+
+struct TsSnapshot {
+  uint32_t ms;
+  uint8_t mask;                           // bit i = field i+1 có giá trị
+  float field[TS_FIELDS];
+};
+
+struct TsStats {
+  uint32_t committed;
+  uint32_t sent;                          // bản ghi đã được server nhận
+  uint32_t requests;
+  uint32_t failures;                      // HTTP != 2xx hoặc không kết nối được
+  uint32_t timeouts;
+  uint32_t connects;                      // số lần phải mở kết nối mới
+  uint32_t lastLatencyMs;
+  uint32_t maxLatencyMs;
+};
+
+class ThingSpeakBulk {
+public:
+  ThingSpeakBulk(Client& client, const char* host, uint16_t port,
+                 unsigned long channel, const char* writeKey);
+
+  void setFlushInterval(uint32_t ms) { flushIntervalMs = ms; }
+  void setTimeout(uint32_t ms) { timeoutMs = ms; }
+
+  void setField(uint8_t field, float value);   // field 1..8
+  // Đưa các field đã set vào hàng đợi; false nếu phải ghi đè bản cũ nhất
+  bool commit();
+  // Gọi thường xuyên (luồng mạng); không bao giờ chờ response
+  void poll();
+
+  size_t pending() const { return queue.size(); }
+  uint32_t dropped() const { return queue.dropped(); }
+  const TsStats& stats() const { return counters; }
+
+private:
+  enum State : uint8_t { IDLE, WAIT_RESPONSE };
+  enum Parse : uint8_t { STATUS_LINE, HEADER, BODY_LENGTH, BODY_CLOSE, CHUNK_SIZE, CHUNK_DATA, CHUNK_END, TRAILER, DONE };
+
+  bool sendBatch();
+  size_t buildBody(char* out, size_t cap, uint8_t& count) const;
+  void feed(char c);
+  void onLine();
+  void finish(bool ok);
+
+  Client& client;
+  const char* host;
+  uint16_t port;
+  unsigned long channel;
+  const char* writeKey;
+  uint32_t flushIntervalMs = 60000;
+  uint32_t timeoutMs = 5000;
+
+  TsSnapshot current = {};
+  RingBuffer<TsSnapshot, TS_QUEUE_CAPACITY> queue;
+
+  State state = IDLE;
+  uint32_t lastFlushMs = 0;
+  uint32_t requestMs = 0;
+  uint8_t inFlight = 0;
+  uint32_t droppedAtSend = 0;             // bản cũ bị ghi đè trong lúc chờ response
+
+  Parse parse = STATUS_LINE;
+  char line[96];
+  uint8_t lineLen = 0;
+  int status = 0;
+  long remaining = 0;
+  bool chunked = false;
+  bool closeAfter = false;
+
+  TsStats counters = {};
+};
@@ -0,0 +1,573 @@
+#ifdef ARDUINO
+// Backend HAL cho ESP32 (Arduino): bọc DHT22 (lib/Dht22), Servo, FastLED,
+// SSD1306 (lib/Hal/Ssd1306Display) và PubSubClient sau các interface trong lib/Hal/Hal.h
+#include <Arduino.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <esp_sleep.h>
+#include <esp_system.h>
+#include <esp_partition.h>
+#include <esp_ota_ops.h>
+#include <esp32/ulp.h>
+#include <driver/adc.h>
+#include <soc/rtc_cntl_reg.h>
+#include <lwip/sockets.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <ESP32Servo.h>
+#include <FastLED.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+#include <Hal.h>
+#include <Dht22.h>
+#include <AnalogStream.h>
+#include <AdcDmaSampler.h>
+#include <Ssd1306Display.h>
+#include "board.h"
+
+// ADC DMA: 20 kHz chia cho LDR + độ ẩm đất = 10 kHz mỗi kênh, 500 mẫu -> 1 giá trị (20 Hz)
+static const uint32_t ADC_SAMPLE_HZ = 20000;
+static const uint16_t ADC_DECIMATION = 500;
+static const uint8_t ADC_PINS[] = { Board::LDR_PIN, Board::SOIL_PIN };
+// Giá trị decimate đầu tiên có sau ~50 ms; quá mức này coi như DMA không chạy
+static const uint32_t ADC_FIRST_VALUE_MS = 200;
+
+// Kết quả DHT22 cũ hơn mức này coi như lỗi đọc (cảm biến ngừng trả lời)
+static const uint32_t DHT_MAX_AGE_MS = 10000;
+
+// Gói MQTT tối đa (topic + payload + header) cho PubSubClient; đoạn OTA (512 B + offset) vừa cùng topic
+static const uint16_t MQTT_BUFFER_SIZE = 640;
+
+// Vào mạng bằng kênh/BSSID đã lưu mà quá thời gian này thì quét lại từ đầu (AP đổi kênh)
+static const uint32_t CACHED_JOIN_TIMEOUT_MS = 3000;
+
+// IP nhận qua DHCP chỉ được dùng lại làm cấu hình tĩnh trong khoảng này (giây, đồng hồ RTC chạy cả
+// khi deep sleep); quá hạn thì xin lại qua DHCP để lease được gia hạn, router không cấp IP cho máy khác
+static const uint32_t CACHED_IP_MAX_AGE_S = 1800;
+
+// Giữ qua deep sleep (RTC slow memory)
+RTC_DATA_ATTR static uint8_t rtcMemory[HAL_RTC_BYTES];
+RTC_DATA_ATTR static int32_t cachedChannel = 0;        // 0 = chưa có
+RTC_DATA_ATTR static uint8_t cachedBssid[6];
+RTC_DATA_ATTR static uint32_t cachedIp[4];                // ip, gateway, mask, dns: bỏ qua DHCP
+RTC_DATA_ATTR static time_t cachedIpAt = 0;            // giây RTC lúc nhận cachedIp qua DHCP
+RTC_DATA_ATTR static uint32_t sleepStartMs = 0;        // halMillis() lúc vào deep sleep
+RTC_DATA_ATTR static struct timeval sleepStartTv;      // đồng hồ RTC lúc vào deep sleep
+static uint32_t clockOffsetMs = 0;                     // millis() bắt đầu lại từ 0 sau deep sleep
+static WakeCause wakeCause = WAKE_POWER_ON;
+
+class Esp32Sensors : public SensorHal {
+public:
+  Esp32Sensors() : dht(Board::DHT_PIN), analog(ADC_DECIMATION), adc(analog, ADC_SAMPLE_HZ) {}
+
+  void begin() override {
+    dht.begin();
+    dht.start();
+    resumeAdc();
+  }
+
+  // ULP cần ADC1 trong lúc ngủ: dừng DMA trước, chạy lại sau khi thức
+  void suspendAdc() { adc.end(); }
+  // Chờ giá trị decimate đầu tiên của mọi kênh: mẫu đầu sau khi thức không được là 0 thô
+  void resumeAdc() {
+    if (!adc.begin(ADC_PINS, sizeof(ADC_PINS))) {
+      halLog("ADC DMA init failed, using analogRead()");
+      return;
+    }
+    uint32_t start = millis();
+    while (!adcReady()) {
+      if (millis() - start >= ADC_FIRST_VALUE_MS) {
+        adc.end();
+        halLog("ADC DMA produced no data, using analogRead()");
+        return;
+      }
+      delay(1);
+    }
+  }
+
+  // Không chặn: trả về kết quả hợp lệ gần nhất rồi kích lần đo kế tiếp
+  // (driver tự bỏ qua nếu chưa đủ 2 s kể từ lần trước)
+  bool readClimate(float& temperature, float& humidity) override {
+    bool ok = dht.read(temperature, humidity, DHT_MAX_AGE_MS);
+    dht.start();
+    return ok;
+  }
+
+  // Giá trị decimate mới nhất từ luồng DMA, không chờ ADC
+  int readAnalog(uint8_t pin) override {
+    if (!adc.running()) return analogRead(pin);
+    uint16_t value;
+    if (!analog.latest(adc1Channel(pin), value)) return analogRead(pin);
+    return value;
+  }
+
+  ClimateStats climateStats() override {
+    Dht22Stats s = dht.stats();
+    return { s.started, s.ok, s.timeouts, s.frameErrors, s.checksumErrors, s.deferred };
+  }
+
+private:
+  bool adcReady() const {
+    uint16_t value;
+    for (uint8_t pin : ADC_PINS)
+      if (!analog.latest(adc1Channel(pin), value)) return false;
+    return true;
+  }
+
+  Dht22 dht;
+  AnalogDecimator analog;
+  AdcDmaSampler adc;
+};
+
+class Esp32Actuators : public ActuatorHal {
+public:
+  void begin() override {
+    pinMode(Board::ALARM_LED_PIN, OUTPUT);
+    pinMode(Board::BUZZER_PIN, OUTPUT);
+    pinMode(Board::LAMP_PIN, OUTPUT);
+    digitalWrite(Board::LAMP_PIN, LOW);
+
+    // Setup servo
+    servo.attach(Board::SERVO_PIN, 500, 2400);
+
+    // Setup buzzer
+    ledcSetup(Board::BUZZER_CHANNEL, 2000, 8); // tần số 2kHz, độ phân giải 8 bit
+    ledcAttachPin(Board::BUZZER_PIN, Board::BUZZER_CHANNEL);
+
+    // Setup WS2812 LED strip
+    FastLED.addLeds<WS2812B, Board::RING_PIN, GRB>(leds, Board::RING_PIXELS);
+  }
+
+  void servoWrite(int angle) override { servo.write(angle); }
+  void digitalOut(uint8_t pin, bool high) override { digitalWrite(pin, high ? HIGH : LOW); }
+  void buzzerTone(uint32_t freq) override { ledcWriteTone(Board::BUZZER_CHANNEL, freq); }
+
+  void showLeds(const Rgb* pixels, uint16_t count) override {
+    if (count > Board::RING_PIXELS) count = Board::RING_PIXELS;
+    for (uint16_t i = 0; i < count; i++) leds[i] = CRGB(pixels[i].r, pixels[i].g, pixels[i].b);
+    FastLED.show();
+  }
+
+private:
+  Servo servo;
+  CRGB leds[Board::RING_PIXELS];
+};
+
+class Esp32Transport : public TransportHal {
+public:
+  Esp32Transport() : client(net) {}
+
+  void begin(const char* host, uint16_t port, MessageHandler handler) override {
+    client.setServer(host, port);
+    client.setCallback(handler);
+    client.setBufferSize(MQTT_BUFFER_SIZE);   // mặc định 256 B không đủ cho JSON chẩn đoán
+  }
+
+  void beginLink(const char* ssid, const char* password) override {
+    this->ssid = ssid;
+    this->password = password;
+    WiFi.persistent(false);
+    WiFi.mode(WIFI_STA);
+    joinStartMs = millis();
+    joining = true;
+    usingCache = cachedChannel != 0;
+    staticIp = usingCache && cachedIp[0] && cachedIpFresh();
+    if (staticIp) WiFi.config(IPAddress(cachedIp[0]), IPAddress(cachedIp[1]), IPAddress(cachedIp[2]), IPAddress(cachedIp[3]));
+    else WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    if (usingCache) WiFi.begin(ssid, password, cachedChannel, cachedBssid, true);
+    else WiFi.begin(ssid, password);
+  }
+
+  void endLink() override {
+    client.disconnect();
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+    joining = false;
+    usingCache = false;
+  }
+
+  // Chỉ luồng mạng, trong lúc chờ vào mạng: lưu kênh/BSSID (và IP nếu vừa xin qua DHCP) khi
+  // vào được, quá CACHED_JOIN_TIMEOUT_MS với kênh đã lưu thì quét lại và xin IP qua DHCP
+  void serviceLink() override {
+    if (!joining) return;
+    if (WiFi.status() == WL_CONNECTED) {
+      cachedChannel = WiFi.channel();
+      memcpy(cachedBssid, WiFi.BSSID(), sizeof(cachedBssid));
+      if (!staticIp) {
+        cachedIp[0] = WiFi.localIP();
+        cachedIp[1] = WiFi.gatewayIP();
+        cachedIp[2] = WiFi.subnetMask();
+        cachedIp[3] = WiFi.dnsIP();
+        cachedIpAt = rtcSeconds();
+      }
+      joining = false;
+      usingCache = false;
+      return;
+    }
+    if (usingCache && ssid && millis() - joinStartMs > CACHED_JOIN_TIMEOUT_MS) {
+      cachedChannel = 0;   // AP đã đổi kênh/BSSID: quét lại, xin lại IP qua DHCP
+      cachedIp[0] = 0;
+      usingCache = false;
+      staticIp = false;
+      WiFi.disconnect();
+      WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+      WiFi.begin(ssid, password);
+    }
+  }
+
+  bool linkUp() override { return WiFi.status() == WL_CONNECTED; }
+
+  const char* localIp() override {
+    WiFi.localIP().toString().toCharArray(ip, sizeof(ip));
+    return ip;
+  }
+
+  bool connected() override { return client.connected(); }
+  bool connect(const char* clientId) override { return client.connect(clientId); }
+  int state() override { return client.state(); }
+  bool subscribe(const char* topic) override { return client.subscribe(topic); }
+
+  bool publish(const char* topic, const uint8_t* payload, size_t length, bool retained) override {
+    return client.publish(topic, payload, length, retained);
+  }
+
+  void loop() override {
+    // Phiên dài trên IP lấy từ cache (luôn thức, khởi động lại sau OTA): quá hạn thì bật lại DHCP
+    if (staticIp && !cachedIpFresh()) {
+      staticIp = false;
+      WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    }
+    client.loop();
+  }
+  int8_t rssi() override { return linkUp() ? WiFi.RSSI() : 0; }
+
+private:
+  WiFiClient net;
+  PubSubClient client;
+  char ip[16];
+  const char* ssid = nullptr;
+  const char* password = nullptr;
+  uint32_t joinStartMs = 0;
+  bool joining = false;      // beginLink() tới lần đầu vào mạng
+  bool usingCache = false;   // đang vào bằng kênh/BSSID đã lưu
+  bool staticIp = false;     // đang dùng cachedIp thay cho DHCP
+
+  static time_t rtcSeconds() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec;
+  }
+  static bool cachedIpFresh() {
+    time_t now = rtcSeconds();
+    return now >= cachedIpAt && now - cachedIpAt < (time_t)CACHED_IP_MAX_AGE_S;
+  }
+};
+
+// --------------------- Flash: một phân vùng của bảng phân vùng -----------------
+// Tìm phân vùng lần đầu cần tới; dữ liệu: "spiffs", OTA: app đang chạy / app còn lại
+class Esp32Flash : public FlashHal {
+public:
+  typedef const esp_partition_t* (*Finder)();
+  explicit Esp32Flash(Finder find) : find(find) {}
+
+  size_t size() override { return partition() ? part->size : 0; }
+  size_t sectorSize() override { return SPI_FLASH_SEC_SIZE; }
+
+  bool read(size_t offset, void* out, size_t length) override {
+    return partition() && esp_partition_read(part, offset, out, length) == ESP_OK;
+  }
+  bool write(size_t offset, const void* data, size_t length) override {
+    return partition() && esp_partition_write(part, offset, data, length) == ESP_OK;
+  }
+  bool erase(size_t sector) override {
+    return partition() &&
+           esp_partition_erase_range(part, sector * SPI_FLASH_SEC_SIZE, SPI_FLASH_SEC_SIZE) == ESP_OK;
+  }
+
+private:
+  const esp_partition_t* partition() {
+    if (!part) part = find();
+    return part;
+  }
+  Finder find;
+  const esp_partition_t* part = nullptr;
+};
+
+static const esp_partition_t* dataPartition() {
+  return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, nullptr);
+}
+static const esp_partition_t* runningPartition() { return esp_ota_get_running_partition(); }
+static const esp_partition_t* updatePartition() { return esp_ota_get_next_update_partition(nullptr); }
+
+// --------------------- OTA: app0/app1 của bảng phân vùng mặc định -----------------
+// Ghi thẳng bằng esp_partition_* (lib/Ota tự xóa/ghi theo sector); esp_ota_set_boot_partition()
+// kiểm tra header ảnh trước khi ghi otadata.
+class Esp32Ota : public OtaHal {
+public:
+  FlashHal& running() override { return current; }
+  FlashHal& inactive() override { return update; }
+  bool activate(size_t) override {
+    const esp_partition_t* p = updatePartition();
+    return p && esp_ota_set_boot_partition(p) == ESP_OK;
+  }
+  void restart() override { esp_restart(); }
+
+private:
+  Esp32Flash current{ runningPartition };
+  Esp32Flash update{ updatePartition };
+};
+
+// --------------------- Máy chủ TCP: socket lwip không chặn -----------------
+class Esp32Server : public ServerHal {
+public:
+  bool listen(uint16_t port) override {
+    if (fd >= 0) return true;
+    if (WiFi.status() != WL_CONNECTED) return false;
+    int s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s < 0) return false;
+    int on = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(s, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(s, 4) < 0) {
+      ::close(s);
+      return false;
+    }
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+    fd = s;
+    return true;
+  }
+
+  int accept() override {
+    if (fd < 0) return -1;
+    int c = ::accept(fd, nullptr, nullptr);
+    if (c < 0) return -1;
+    fcntl(c, F_SETFL, fcntl(c, F_GETFL, 0) | O_NONBLOCK);
+    int on = 1;
+    setsockopt(c, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return c;
+  }
+
+  int read(int conn, void* out, size_t capacity) override {
+    int n = recv(conn, out, capacity, MSG_DONTWAIT);
+    if (n > 0) return n;
+    if (n == 0) return -1;   // phía kia đã đóng
+    return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+  }
+
+  int write(int conn, const void* data, size_t length) override {
+    int n = send(conn, data, length, MSG_DONTWAIT);
+    if (n >= 0) return n;
+    return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+  }
+
+  void close(int conn) override { ::close(conn); }
+
+private:
+  int fd = -1;
+};
+
+static Esp32Sensors sensors;
+static Esp32Actuators actuators;
+// clkAfter = 400 kHz: lệnh của thư viện không hạ bus về 100 kHz sau mỗi giao dịch
+static Adafruit_SSD1306 oled(Board::SCREEN_WIDTH, Board::SCREEN_HEIGHT, &Wire, -1, 400000UL, 400000UL);
+static Ssd1306Display display(oled, Board::OLED_ADDRESS);
+static Esp32Transport transport;
+static Esp32Flash flash(dataPartition);
+static Esp32Server server;
+static Esp32Ota ota;
+
+Hal& hal() {
+  static Hal h = { sensors, actuators, display, transport, flash, server, ota };
+  return h;
+}
+
+// ULP tự dừng sau I_WAKE; thức vì timer thì phải dừng nó trước khi ADC DMA dùng lại ADC1
+static void stopUlp() { CLEAR_PERI_REG_MASK(RTC_CNTL_STATE0_REG, RTC_CNTL_ULP_CP_SLP_TIMER_EN); }
+
+static WakeCause toWakeCause(esp_sleep_wakeup_cause_t cause) {
+  switch (cause) {
+    case ESP_SLEEP_WAKEUP_UNDEFINED: return WAKE_POWER_ON;
+    case ESP_SLEEP_WAKEUP_TIMER:     return WAKE_TIMER;
+    case ESP_SLEEP_WAKEUP_ULP:       return WAKE_THRESHOLD;
+    default:                         return WAKE_OTHER;
+  }
+}
+
+void halBegin() {
+  Serial.begin(115200);
+  wakeCause = toWakeCause(esp_sleep_get_wakeup_cause());
+  if (wakeCause == WAKE_POWER_ON) {
+    delay(100);
+    return;
+  }
+  stopUlp();
+  // thức dậy từ deep sleep: nối tiếp đồng hồ bằng thời gian RTC đã trôi
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  int64_t sleptMs = (int64_t)(now.tv_sec - sleepStartTv.tv_sec) * 1000 + (now.tv_usec - sleepStartTv.tv_usec) / 1000;
+  clockOffsetMs = sleepStartMs + (uint32_t)sleptMs - millis();
+}
+
+uint32_t halMillis() { return millis() + clockOffsetMs; }
+uint32_t halMicros() { return micros(); }
+uint32_t halCycles() { return ESP.getCycleCount(); }
+uint32_t halCpuMhz() { return getCpuFrequencyMhz(); }
+uint32_t halFreeHeap() { return ESP.getFreeHeap(); }
+uint32_t halMinFreeHeap() { return ESP.getMinFreeHeap(); }
+void halDelay(uint32_t ms) { delay(ms); }
+
+void halDeviceId(char* out, size_t capacity) {
+  uint8_t mac[6];
+  esp_read_mac(mac, ESP_MAC_WIFI_STA);
+  snprintf(out, capacity, "esp32-%02x%02x%02x", mac[3], mac[4], mac[5]);
+}
+
+void halLog(const char* fmt, ...) {
+  char line[192];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+  Serial.println(line);
+}
+
+// --------------------- Ngủ -----------------
+static WakeThreshold wakeThresholds[HAL_MAX_WAKE_THRESHOLDS];
+static uint8_t wakeThresholdCount = 0;
+static uint32_t wakePollMs = 1000;
+
+void halSetWakeThresholds(const WakeThreshold* thresholds, uint8_t count, uint32_t pollMs) {
+  if (count > HAL_MAX_WAKE_THRESHOLDS) count = HAL_MAX_WAKE_THRESHOLDS;
+  memcpy(wakeThresholds, thresholds, count * sizeof(WakeThreshold));
+  wakeThresholdCount = count;
+  wakePollMs = pollMs;
+}
+
+// Chương trình ULP: đọc từng kênh, ra ngoài khoảng [below, above] thì đánh thức CPU.
+// Luôn đủ HAL_MAX_WAKE_THRESHOLDS khối, khối thừa lặp lại ngưỡng đầu tiên.
+static bool startUlp() {
+  if (!wakeThresholdCount) return false;
+  // M_BGE so sánh >=, nên ngưỡng trên là above + 1 (4096 = không bao giờ với ADC 12 bit)
+  uint8_t ch[HAL_MAX_WAKE_THRESHOLDS];
+  uint16_t below[HAL_MAX_WAKE_THRESHOLDS], over[HAL_MAX_WAKE_THRESHOLDS];
+  for (uint8_t i = 0; i < HAL_MAX_WAKE_THRESHOLDS; i++) {
+    const WakeThreshold& t = wakeThresholds[i < wakeThresholdCount ? i : 0];
+    int8_t c = adc1Channel(t.pin);
+    if (c < 0) return false;
+    ch[i] = c;
+    below[i] = t.below;
+    over[i] = t.above >= 4095 ? 4096 : t.above + 1;
+    adc1_config_channel_atten((adc1_channel_t)c, ADC_ATTEN_DB_11);
+  }
+  adc1_config_width(ADC_WIDTH_BIT_12);
+  adc1_ulp_enable();
+
+  const ulp_insn_t program[] = {
+    I_ADC(R0, 0, ch[0]),
+    M_BL(1, below[0]),
+    M_BGE(1, over[0]),
+    I_ADC(R0, 0, ch[1]),
+    M_BL(1, below[1]),
+    M_BGE(1, over[1]),
+    I_HALT(),
+    M_LABEL(1),
+    I_WAKE(),
+    I_END(),     // dừng timer ULP, CPU chạy lại nó ở lần ngủ sau
+    I_HALT(),
+  };
+  size_t size = sizeof(program) / sizeof(ulp_insn_t);
+  if (ulp_process_macros_and_load(0, program, &size) != ESP_OK) return false;
+  ulp_set_wakeup_period(0, wakePollMs * 1000);
+  if (ulp_run(0) != ESP_OK) return false;
+  return esp_sleep_enable_ulp_wakeup() == ESP_OK;
+}
+
+WakeCause halSleep(SleepMode mode, uint32_t ms) {
+  esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+  esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000);
+  bool ulp = wakeThresholdCount > 0;
+  if (ulp) {
+    sensors.suspendAdc();
+    ulp = startUlp();
+  }
+  Serial.flush();
+
+  if (mode == SLEEP_DEEP) {
+    sleepStartMs = halMillis();
+    gettimeofday(&sleepStartTv, NULL);
+    esp_deep_sleep_start();   // không trở về, khởi động lại từ setup()
+  }
+
+  esp_light_sleep_start();
+  wakeCause = toWakeCause(esp_sleep_get_wakeup_cause());
+  if (wakeThresholdCount) {
+    if (ulp) stopUlp();
+    sensors.resumeAdc();
+  }
+  return wakeCause;
+}
+
+WakeCause halWakeCause() { return wakeCause; }
+uint8_t* halRtcMemory() { return rtcMemory; }
+
+// NVS của Arduino-ESP32 (Preferences), mở namespace khi cần rồi đóng ngay: ít khi gọi
+size_t halNvsRead(const char* key, void* out, size_t capacity) {
+  Preferences prefs;
+  if (!prefs.begin("garden", true)) return 0;   // chưa từng ghi: namespace chưa có
+  size_t length = prefs.getBytesLength(key);
+  size_t n = length && length <= capacity ? prefs.getBytes(key, out, capacity) : 0;
+  prefs.end();
+  return n;
+}
+
+bool halNvsWrite(const char* key, const void* data, size_t length) {
+  Preferences prefs;
+  if (!prefs.begin("garden", false)) return false;
+  bool ok = prefs.putBytes(key, data, length) == length;
+  prefs.end();
+  return ok;
+}
+
+struct Worker {
+  WorkerFn fn;
+  TaskHandle_t handle;
+};
+static const uint8_t MAX_WORKERS = 4;
+static Worker workers[MAX_WORKERS];
+static uint8_t workerCount = 0;
+
+static void workerMain(void* arg) {
+  Worker* w = (Worker*)arg;
+  for (;;) {
+    TickType_t wait = pdMS_TO_TICKS(w->fn());
+    ulTaskNotifyTake(pdTRUE, wait ? wait : 1);   // luôn nhường ít nhất 1 tick cho idle task/WDT
+  }
+}
+
+WorkerId halStartWorker(const char* name, WorkerFn fn, uint8_t core, uint32_t stackBytes, uint8_t priority) {
+  if (workerCount >= MAX_WORKERS) return NO_WORKER;
+  Worker& w = workers[workerCount];
+  w.fn = fn;
+  if (xTaskCreatePinnedToCore(workerMain, name, stackBytes, &w, priority, &w.handle, core) != pdPASS) return NO_WORKER;
+  return workerCount++;
+}
+
+void halWakeWorker(WorkerId worker) {
+  if (worker >= 0 && worker < workerCount) xTaskNotifyGive(workers[worker].handle);
+}
+
+uint32_t halStackHighWater(WorkerId worker) {
+  if (worker == NO_WORKER) return uxTaskGetStackHighWaterMark(NULL);
+  if (worker < 0 || worker >= workerCount) return 0;
+  return uxTaskGetStackHighWaterMark(workers[worker].handle);   // ESP-IDF: đơn vị byte
+}
+
+#endif
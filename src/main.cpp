@@ -1,108 +1,95 @@
-#include <Adafruit_Sensor.h>
-#include <DHT_U.h>
-#include <WiFi.h>
-#include <PubSubClient.h>
-#include <ESP32Servo.h>
-#include <FastLED.h>
-#include <Wire.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
-
-
-// define chân kết nối cảm biến và các thiết bị khác
-#define DHTPIN 12
-#define LED_DHT 33
-#define BUZZER_PIN 32
-#define LED 26
-#define SERVO_PIN 2
-#define LED_PIN 4
-#define NUM_LEDS 16
-#define DHTTYPE DHT22
-#define LDR_PIN 34
-#define SOIL_MOISTURE_PIN 35
-
-// Khai báo đối tượng thiết bị 
-DHT_Unified dht(DHTPIN, DHTTYPE);
-Servo servo;
-CRGB leds[NUM_LEDS];
-
-// màn hình OLED
-#define SCREEN_WIDTH 128
-#define SCREEN_HEIGHT 64
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire);
-
-//--------------------- tạo icon cho màn hình OLED --------------------- 
-// 16x16 - Nhiệt độ (nhiệt kế)
-const unsigned char PROGMEM icon_temp16[] = {
-  0x06,0x00, 0x06,0x00, 0x06,0x00, 0x06,0x00,
-  0x06,0x00, 0x06,0x00, 0x06,0x00, 0x06,0x00,
-  0x0F,0x00, 0x1F,0x80, 0x3F,0xC0, 0x3F,0xC0,
-  0x3F,0xC0, 0x1F,0x80, 0x0F,0x00, 0x06,0x00
-};
-
-// 16x16 - Độ ẩm (giọt nước)
-const unsigned char PROGMEM icon_humid16[] = {
-  0x03,0x00, 0x07,0x80, 0x0F,0xC0, 0x1F,0xE0,
-  0x1F,0xE0, 0x3F,0xF0, 0x3F,0xF0, 0x3F,0xF0,
-  0x1F,0xE0, 0x1F,0xE0, 0x0F,0xC0, 0x07,0x80,
-  0x03,0x00, 0x03,0x00, 0x01,0x00, 0x00,0x00
-};
-
-// 16x16 - Ánh sáng (mặt trời + tia)
-const unsigned char PROGMEM icon_light16[] = {
-  0x01,0x00, 0x03,0x80, 0x07,0xC0, 0x0C,0x60,
-  0x10,0x10, 0x10,0x10, 0x20,0x08, 0x21,0x08,
-  0x20,0x08, 0x10,0x10, 0x10,0x10, 0x0C,0x60,
-  0x07,0xC0, 0x03,0x80, 0x01,0x00, 0x00,0x00
-};
-
-// 16x16 - Độ ẩm đất (mầm cây + nền đất)
-const unsigned char PROGMEM icon_soil16[] = {
-  0x00,0x00, 0x01,0x00, 0x03,0x80, 0x06,0xC0,
-  0x03,0x80, 0x01,0x00, 0x00,0x00, 0xFF,0xFF,
-  0xFF,0xFF, 0xFF,0xFF, 0x00,0x00, 0x00,0x00,
-  0x00,0x00, 0x00,0x00, 0x00,0x00, 0x00,0x00
-};
-
+#include <math.h>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+#include <Hal.h>
+#include <Scheduler.h>
+#include <Telemetry.h>
+#include <RingBuffer.h>
+#include <Dispatcher.h>
+#include <Filters.h>
+#include <StatusView.h>
+#include <CycleStats.h>
+#include <Metrics.h>
+#include <ChangeReporter.h>
+#include <ConnectionManager.h>
+#include <LedEngine.h>
+#include <Irrigation.h>
+#include <ConfigStore.h>
+#include <Ota.h>
+#include "board.h"
+#include "garden.h"
 
-const unsigned char wifi_icon [] PROGMEM = {
-  0x00,0x00,0x00,0x07,0xe0,0x1f,0xf8,0x7f,0xfc,0xff,0xfe,0x7f,0xfc,0x1f,0xf8,0x07,
-  0xe0,0x00,0x00,0x00
-};
+// Thiết bị truy cập qua HAL (ESP32: src/hal_esp32.cpp, Linux: src/native/hal/)
+SensorHal&    sensors   = hal().sensors;
+ActuatorHal&  actuators = hal().actuators;
+DisplayHal&   display   = hal().display;
+TransportHal& client    = hal().transport;
+FlashHal&     flash     = hal().flash;
+ServerHal&    server    = hal().server;
+OtaHal&       firmware  = hal().ota;
 
-const unsigned char wifi_dc [] PROGMEM = {
-  0x00,0x00,0x00,0x03,0xc0,0x0f,0xf0,0x3f,0xf8,0x7f,0xfc,0x3f,0xf8,0x0f,0xf0,0x03,
-  0xc0,0x00,0x00,0x00
-};
+Rgb leds[Board::RING_PIXELS];
+const Rgb RGB_WHITE  = { 255, 255, 255 };
+const Rgb RGB_YELLOW = { 255, 255, 0 };
+const Rgb RGB_BLUE   = { 0, 0, 255 };
+const Rgb RGB_RED    = { 255, 0, 0 };
+const Rgb RGB_BLACK  = { 0, 0, 0 };
 
-const unsigned char Update_OK [] PROGMEM = {
-  0x01,0x80,0x06,0xf0,0x10,0x18,0x20,0x20,0x40,0x40,0x32,0x0c,0x62,0x06,0x84,0x03,
-  0x83,0x03,0x41,0x82,0x40,0x82,0x20,0x84,0x10,0x88,0x08,0x90,0x07,0xe0,0x01,0x80
+// Tên màu nhận trên LightColor; ngoài ra nhận "#RRGGBB" bất kỳ, sai thì về trắng
+struct NamedColor { const char* name; Rgb color; };
+const NamedColor namedColors[] = {
+  { "Red", RGB_RED }, { "Yellow", RGB_YELLOW }, { "Blue", RGB_BLUE }, { "White", RGB_WHITE },
 };
 
-const unsigned char Update_NOK [] PROGMEM = {
-  0x01,0x80,0x06,0x70,0x08,0x08,0x10,0x10,0x20,0x20,0x44,0x44,0x82,0x82,0x82,0x82,
-  0x82,0x82,0x44,0x44,0x20,0x20,0x10,0x10,0x08,0x08,0x06,0x70,0x01,0x80,0x00,0x00
-};
+// Khung LED chỉ gửi khi đổi; chuyển màu/độ sáng mượt ở ledFrameMs (lib/LedEngine)
+const uint16_t ledFrameMs = 20;        // 50 khung/s khi đang chuyển
+const uint32_t ledFadeMs = 400;        // thời gian chuyển giữa hai màu
+LedEngine ring(leds, Board::RING_PIXELS, ledFrameMs);
 
 // MQTT Credentials
 const char* ssid = "Wokwi-GUEST";
 const char* password = "";
 const char* mqttServer = "broker.hivemq.com";
-const char* clientID = "ESP32-wokwi";
+const char* nodeName = "";             // trống = halDeviceId() ("esp32-" + MAC), cũng là clientID MQTT
+
+// Topic theo node: <topicRoot>/<nodeId>/<kênh>, nhiều node dùng chung broker không đè nhau.
+// Lệnh nhận ở <topicRoot>/<nodeId>/signal/... và <topicRoot>/<groupId>/signal/... (mọi node).
+// Gateway trên host (src/native/gateway) đăng ký <topicRoot>/+/sensors/#.
+constexpr char topicRoot[] = "garden";
+constexpr char groupId[] = "all";
+const size_t TOPIC_LEN = 64;
+char nodeId[24];
 
-// Các topic MQTT riêng biệt cho từng loại dữ liệu
-const char* tempTopic = "sensors/temperature";
-const char* humTopic = "sensors/humidity";
-const char* lightTopic = "sensors/light";
-const char* soilTopic = "sensors/soil_moisture";
+// Kênh của node, ghép với nodeId một lần trong setup_topics(). Khung nhị phân (lib/Telemetry)
+// và topic text theo Board::FRAME_TOPIC / Board::TEXT_TOPICS; text giữ cho flow Node-RED
+// trong DashBoard.json. Metrics chẩn đoán JSON gọn (lib/Metrics), panel "Diagnostics".
+enum NodeTopic { TOPIC_TEMP, TOPIC_HUM, TOPIC_LIGHT, TOPIC_SOIL, TOPIC_FRAME, TOPIC_DIAG,
+                 TOPIC_OTA, TOPIC_COMMANDS, NODE_TOPICS };
+constexpr const char* nodeChannels[NODE_TOPICS] = {
+  "sensors/temperature", "sensors/humidity", "sensors/light", "sensors/soil_moisture",
+  "sensors/frame", "diagnostics", "ota",
+  "signal/#",                            // một lần subscribe cho mọi topic lệnh bên dưới
+};
+constexpr size_t longest_channel(size_t i = 0, size_t best = 0) {
+  return i == NODE_TOPICS ? best
+       : longest_channel(i + 1, topicLength(nodeChannels[i]) > best ? topicLength(nodeChannels[i]) : best);
+}
+static_assert(sizeof(topicRoot) + sizeof(nodeId) + longest_channel() <= TOPIC_LEN, "TOPIC_LEN too small");
+char topics[NODE_TOPICS][TOPIC_LEN];
+char groupFilter[TOPIC_LEN];           // <topicRoot>/<groupId>/signal/#
 
-// các topic lấy dữ liệu
-const char* autoLightTopic = "signal/auto_light";
-const char* autoWateringTopic = "signal/auto_watering";
-const char* SwitchLight = "signal/switch_light";
-const char* SwitchWatering = "signal/switch_watering";
-const char* LightColor = "signal/light_color";
+// các topic lệnh (phần sau <topicRoot>/<nodeId|groupId>/); hash tính lúc biên dịch (commandRoutes)
+constexpr char autoLightTopic[] = "signal/auto_light";
+constexpr char autoWateringTopic[] = "signal/auto_watering";
+constexpr char SwitchLight[] = "signal/switch_light";
+constexpr char SwitchWatering[] = "signal/switch_watering";
+constexpr char LightColor[] = "signal/light_color";
+constexpr char configTopic[] = "signal/config";
+constexpr char otaBeginTopic[] = "signal/ota/begin";
+constexpr char otaChunkTopic[] = "signal/ota/chunk";
+constexpr char otaAbortTopic[] = "signal/ota/abort";
+constexpr char otaTopicPrefix[] = "signal/ota/";   // chỉ nhận trên topic của node, không qua groupId
 
 // --- khai báo biến toàn cục ---
 bool autoLightOn = false;
@@ -110,342 +97,1237 @@ bool autoWateringOn = false;
 char switchWateringState = false;
 char switchLightState = false;
 char lightColor[10] = "white";
+Rgb manualColor = RGB_WHITE;           // lightColor đã phân tích, dùng khi tắt auto light
+
+// Chu kỳ các task (ms)
+const long interval = 5000;            // lấy mẫu cảm biến
+const long reconnectInterval = 5000;   // thử gửi bù lại sau khi publish lỗi
+const long wateringPulse = 1000;       // thời gian mở van mỗi lần tưới theo ngưỡng (IRRIGATION_THRESHOLD)
+const long statsInterval = 60000;      // in thống kê scheduler
+const long drainInterval = 250;        // nhịp gửi bù dữ liệu sau khi kết nối lại
+const long diagInterval = 60000;       // gửi metrics chẩn đoán
+const long linkPollMs = 100;           // kiểm tra WiFi đã vào mạng chưa
+
+#if GARDEN_HTTP
+// HTTP cục bộ (lib/HttpServer): poll mỗi httpPollMs, httpBusyPollMs khi đang có client
+const uint16_t httpPort = 80;
+const uint32_t httpPollMs = 20;
+const uint32_t httpBusyPollMs = 2;
+const uint32_t httpRetryMs = 10000;    // chưa mở được cổng (chưa có WiFi)
+const uint32_t httpIdleMs = 5000;      // đóng client không có tiến triển
+#endif
+
+// Thử lại MQTT: 1 s, 2 s, 4 s ... tối đa 60 s, trừ ngẫu nhiên tới 50 % mỗi lần
+const BackoffPolicy mqttBackoff = { 1000, 60000, 50 };
+
+// Chế độ năng lượng (garden.h). Mặc định luôn thức; board chạy pin (Board::BATTERY) ngủ sâu.
+const PowerMode defaultPowerMode = Board::BATTERY ? POWER_DEEP_SLEEP : POWER_ALWAYS_ON;
+//                   mode              sampleMs uploadEvery listenMs maxAwakeMs minSleepMs
+PowerConfig power = { defaultPowerMode, 60000,   10,         1000,    20000,     200 };
+const uint32_t wakePollMs = 1000;      // ULP đọc ngưỡng soil/LDR khi ngủ
+const int wakeHysteresisRaw = 40;      // tránh thức liên tục khi giá trị nằm sát ngưỡng
+// Thức từ deep sleep: DHT chưa có kết quả, bộ lọc rỗng. Mẫu đầu chờ DHT đọc được (thử lại mỗi
+// wakeSettleMs, tối đa wakeSettleTries lần ~ một chu kỳ đo 2 s của driver); vẫn lỗi thì mẫu đó
+// được ghi/gửi nhưng không điều khiển tưới (bộ điều khiển dự báo học cả số đo sai)
+const uint32_t wakeSettleMs = 100;
+const uint8_t wakeSettleTries = 25;
+
+// Ngưỡng điều khiển và hiệu chuẩn ADC (GardenConfig trong garden.h): mặc định theo board, lệnh
+// <topicRoot>/<nodeId|groupId>/signal/config "overheatC=36 soilDryPercent=28 ..." đổi lúc chạy.
+// Lệnh được parse vào bản sao, kiểm tra từng trường (configFields) rồi ràng buộc chéo (config_error()),
+// hợp lệ mới thay config trong handler ở luồng io: giữa hai lần run_control(), không lần điều khiển
+// nào thấy nửa cũ nửa mới. Lưu NVS sau configSaveDelayMs để gom lệnh liên tiếp thành một lần ghi.
+const GardenConfig defaultConfig = {
+  Board::OVERHEAT_C, Board::SOIL_TARGET_PERCENT, Board::Light::range(), Board::Soil::range(),
+  Board::SOIL_DRY_PERCENT, Board::LIGHT_DIM_PERCENT, Board::LIGHT_BRIGHT_PERCENT, 0,
+};
+GardenConfig config = defaultConfig;
+constexpr ConfigField configFields[] = {
+  CONFIG_FIELD(GardenConfig, overheatC,          CONFIG_FLOAT, 15,  80),
+  CONFIG_FIELD(GardenConfig, soilDryPercent,     CONFIG_U8,    1,   95),
+  CONFIG_FIELD(GardenConfig, soilTargetPercent,  CONFIG_FLOAT, 2,   100),
+  CONFIG_FIELD(GardenConfig, lightDimPercent,    CONFIG_U8,    0,   99),
+  CONFIG_FIELD(GardenConfig, lightBrightPercent, CONFIG_U8,    1,   100),
+  CONFIG_FIELD(GardenConfig, light.minRaw,       CONFIG_U16,   0,   4095),
+  CONFIG_FIELD(GardenConfig, light.maxRaw,       CONFIG_U16,   0,   4095),
+  CONFIG_FIELD(GardenConfig, soil.minRaw,        CONFIG_U16,   0,   4095),
+  CONFIG_FIELD(GardenConfig, soil.maxRaw,        CONFIG_U16,   0,   4095),
+};
+const size_t CONFIG_FIELDS = sizeof(configFields) / sizeof(configFields[0]);
+static_assert(configCommandChars(configFields, CONFIG_FIELDS) <= sizeof(CommandMsg::payload),
+              "CommandMsg::payload too small for a signal/config command setting every field");
+const int minCalibrationSpan = 256;    // khoảng hiệu chuẩn hẹp hơn thì % nhảy theo nhiễu ADC
+const char* const configKey = "config";
+const uint32_t configSaveDelayMs = 5000;
+
+// Tưới tự động (lib/Irrigation): tưới khi độ ẩm dự báo sau horizonMs dưới lowPercent (config.soilDryPercent),
+// một xung đưa về targetPercent rồi chờ soakMs cho nước ngấm tới cảm biến. gain/dry là ước lượng ban đầu.
+// low/target theo config (apply_config()).
+//                                    low                       target                       horizonMs soakMs   windowMs minPulse maxPulse gain/s dry/h
+IrrigationPolicy irrigationPolicy = { Board::SOIL_DRY_PERCENT, Board::SOIL_TARGET_PERCENT, 1800000,  1800000, 1800000, 500,     30000,   0.5f,  2.0f };
+IrrigationMode irrigationMode = IRRIGATION_PREDICTIVE;
+
+// Report-on-change: mỗi kênh chỉ gửi khi lệch đủ lớn, khi vượt ngưỡng điều khiển,
+// hoặc sau heartbeat; không dày hơn minInterval (lib/ChangeReporter). threshold của temp/soil theo
+// config, do luồng io ghi (apply_config()) và luồng mạng đọc: một float 32 bit, ghi/đọc nguyên vẹn,
+// tệ nhất một mẫu còn so với ngưỡng cũ.
+//                                abs    rel    minIntervalMs heartbeatMs threshold
+ReportPolicy tempPolicy        = { 0.3f,  0.0f,   4000,         300000,     Board::OVERHEAT_C };
+const ReportPolicy humPolicy   = { 2.0f,  0.0f,   30000,        300000,     NAN };
+const ReportPolicy lightPolicy = { 3.0f,  0.1f,   30000,        300000,     NAN };
+ReportPolicy soilPolicy        = { 2.0f,  0.0f,   30000,        300000,     Board::SOIL_DRY_PERCENT - 0.5f };  // % nguyên
+
+// Cập nhật firmware bằng delta (lib/Ota), toàn bộ ở luồng mạng. Host (tools/ota_delta.py send) gửi
+// trên <topicRoot>/<nodeId>/ (lệnh OTA trên groupId bị bỏ qua)
+//   signal/ota/begin  "size=<byte delta> sha256=<SHA-256 firmware mới>"
+//   signal/ota/chunk  [offset u32 LE][tối đa OTA_CHUNK_MAX byte delta]
+//   signal/ota/abort
+// rồi chờ <topicRoot>/<nodeId>/ota "state=patch next=<offset> size=<byte delta>" trước mỗi đoạn kế
+// tiếp (stop-and-wait): next là offset node cần, đoạn lệch offset (mất, lặp) chỉ làm node nhắc lại next.
+// Đoạn được áp dụng thẳng từ otaChunk, không đệm cả delta. begin trùng size và sha256 với bản đang dở
+// (trong RAM, hoặc checkpoint NVS sau khi khởi động lại) tiếp tục từ đó.
+const size_t OTA_CHUNK_MAX = 512;      // vừa buffer PubSubClient cùng topic (MQTT_BUFFER_SIZE)
+const size_t otaStepBytes = 4096;      // byte flash đọc/ghi mỗi lần chạy otaTask, ~1 sector
+const uint32_t otaRestartMs = 2000;    // status "done" kịp đi trước khi khởi động lại
+const uint32_t otaIdleMs = 30000;      // cửa sổ gửi (chế độ ngủ) giữ WiFi khi đoạn gần nhất mới hơn mức này
+const uint16_t otaCheckpointSectors = 16;   // checkpoint NVS mỗi 64 KB đích, ~20 lần ghi cho 1,25 MB
+const char* const otaKey = "ota";
+
+// Luồng mạng (MQTT) chạy riêng trên core 0 cùng WiFi stack; cảm biến/điều khiển/
+// hiển thị ở loop() trên core 1. Hai bên chỉ trao đổi qua sampleQueue/commandQueue.
+const uint8_t  netCore = 0;
+const uint32_t netStackBytes = 8192;
+const uint8_t  netPriority = 1;
+const uint32_t netPollMs = 10;         // client.loop() ít nhất mỗi netPollMs
+
+// Bộ đệm mẫu khi mất MQTT (store-and-forward, BACKLOG_CAPACITY trong garden.h).
+// Gửi bù theo định dạng của board: khung nhị phân trên topic khung (giữ nguyên timestamp) nếu
+// Board::FRAME_TOPIC, không thì từng kênh trên topic text (mất timestamp); tối đa
+// Board::FRAME_BATCH mẫu mỗi drainInterval để không làm nghẽn broker.
+const OverflowPolicy backlogPolicy = OVERWRITE_OLDEST;
+
+// Lọc kênh analog (đã decimate từ ADC DMA), cấu hình theo board (include/board.h)
+Board::LightFilter lightFilter;
+Board::SoilFilter soilFilter;
+
+// Giá trị cảm biến của lần lấy mẫu gần nhất
+float temp = -999.0, hum = -999.0;
+int lightPercent = 0, soilPercent = 0;
+float soilLevel = 0;                   // soilPercent chưa làm tròn, cho bộ điều khiển tưới
+bool wateringActive = false;
+IrrigationController irrigation(irrigationPolicy);
+OtaPatcher ota(firmware, otaCheckpointSectors);
+uint8_t otaChunk[OTA_CHUNK_MAX];       // đoạn delta đang áp dụng, ota đọc tại chỗ tới khi wantsInput()
+
+#if GARDEN_HISTORY
+// Lịch sử số đo trên flash (lib/History): mỗi mẫu vào log, nén ~vài byte/mẫu. Phân vùng
+// "spiffs" của bảng phân vùng mặc định (default.csv) 0x160000 byte = 352 sector 4 KB;
+// bảng sector trong RAM 16 byte mỗi sector. Phân vùng lớn hơn chỉ dùng HISTORY_SECTORS đầu.
+const size_t HISTORY_PARTITION_BYTES = 0x160000;
+const uint16_t HISTORY_SECTORS = HISTORY_PARTITION_BYTES / 4096;
+HistorySector historySectors[HISTORY_SECTORS];
+HistoryLog history(flash, historySectors, HISTORY_SECTORS);
+#endif
+StatusView statusView(display);
+ConnectionManager connection(client, mqttBackoff, linkPollMs);
+TelemetryBatcher telemetry(Board::FRAME_BATCH);
+TelemetryBatcher replay(Board::FRAME_BATCH);   // khung gửi bù, seq riêng
+SampleBacklog backlog(backlogPolicy);
+ChangeReporter tempReport(tempPolicy), humReport(humPolicy), lightReport(lightPolicy), soilReport(soilPolicy);
+ChangeReporter* const reporters[] = { &tempReport, &humReport, &lightReport, &soilReport };
+
+// Bộ lập lịch không chặn (thay cho delay()), mỗi luồng một bộ
+Scheduler netScheduler(halMillis, halMicros);
+Scheduler ioScheduler(halMillis, halMicros);
+SampleQueue sampleQueue;
+CommandQueue commandQueue;
+WorkerId netWorker = NO_WORKER;
+
+// Đo đường nóng bằng bộ đếm chu kỳ CPU, build với -DHOTPATH_PROFILE (env esp32-profile);
+// kết quả (cộng dồn từ khi khởi động) in cùng print_stats(). callback/publish chạy ở
+// luồng mạng, phần còn lại ở luồng io; mỗi CycleStats chỉ một luồng ghi.
+// Tắt thì HOTPATH_SCOPE không sinh mã.
+#ifdef HOTPATH_PROFILE
+CycleStats sampleCycles("sample"), convertCycles("convert"), callbackCycles("callback"),
+           dispatchCycles("dispatch"), publishCycles("publish"), displayCycles("display"),
+           lightCycles("light"), controlCycles("control");
+CycleStats* const hotPath[] = { &sampleCycles, &convertCycles, &callbackCycles, &dispatchCycles,
+                                &publishCycles, &displayCycles, &lightCycles, &controlCycles };
+#define HOTPATH_SCOPE(stats) CycleScope stats##Scope(stats)
+#else
+#define HOTPATH_SCOPE(stats)
+#endif
+
+// Metrics chẩn đoán: luồng mạng ghi rc/rcf/pub/pf/cmd, pubt và các gauge (trong publish_metrics),
+// luồng io ghi jit (lệch chu kỳ lấy mẫu, ms), tick (thời gian một tick có task chạy, µs) và
+// cfg/cfgx (lệnh config áp dụng/bị từ chối), cfgc (CRC cấu hình đang dùng: so nhanh cả fleet);
+// ota là số đoạn delta đã nhận (luồng mạng); dht* chép từ driver DHT22 (sensors.climateStats()) trong
+// publish_metrics: đo thành công, timeout, lỗi khung, lỗi checksum, lần kích bị hoãn
+Counter reconnectAttempts("rc"), reconnectFailures("rcf"), publishOk("pub"), publishFailures("pf"),
+        commandsReceived("cmd"), readingsSuppressed("sup"), configUpdates("cfg"), configRejected("cfgx"),
+        otaChunks("ota"), dhtOk("dht"), dhtTimeouts("dhtt"), dhtFrameErrors("dhtf"), dhtChecksumErrors("dhtc"),
+        dhtDeferred("dhtr");
+Gauge freeHeap("heap"), minFreeHeap("hmin"), wifiRssi("rssi"), backlogDepth("bl"), backlogDropped("bld"),
+      queueDropped("qd"), configCrc("cfgc");
+const uint32_t jitterBoundsMs[] = { 1, 10, 50, 200, 1000 };
+const uint32_t tickBoundsUs[] = { 100, 1000, 5000, 20000, 100000 };
+const uint32_t publishBoundsUs[] = { 500, 2000, 10000, 50000, 200000 };
+Histogram sampleJitter("jit", jitterBoundsMs, 5);
+Histogram tickTime("tick", tickBoundsUs, 5);
+Histogram publishTime("pubt", publishBoundsUs, 5);
+const uint32_t onlineBoundsMs[] = { 300, 1000, 3000, 10000, 60000 };
+Histogram onlineTime("tto", onlineBoundsMs, 5);   // time-to-online: bật WiFi/mất kết nối -> MQTT sẵn sàng
+MetricsRegistry metrics;
+uint32_t lastSampleMs = 0;
+uint8_t settleTries = 0;               // > 0: mẫu đầu sau khi thức chưa lấy
 
-// Parameters for non-blocking delay
-unsigned long previousMillis = 0;
-const long interval = 5000;
+// Chế độ ngủ: luồng io quyết định khi nào cần WiFi (radioWanted), luồng mạng bật/tắt
+// WiFi và báo lại (radioOff, sessions, uploadIdle). Mỗi biến chỉ một luồng ghi.
+volatile bool radioWanted = true;      // io
+volatile bool radioOff = false;        // mạng: WiFi đã tắt hẳn
+volatile bool linkReady = false;       // mạng: WiFi đã vào mạng; màn hình và /status đọc cờ này
+volatile uint32_t sessions = 0;        // mạng: số lần kết nối MQTT thành công
+volatile bool uploadIdle = false;      // mạng: đã kết nối, không còn mẫu/backlog chờ gửi
+volatile uint32_t otaChunkMs = 0;      // mạng: lần cuối nhận lệnh OTA, 0 = chưa có
+uint32_t windowStartMs = 0, onlineMs = 0, windowSessions = 0;
+bool windowOnline = false;
+uint8_t samplesSinceUpload = 0;
+bool uploadNow = false;
 
-// Setting up WiFi and MQTT client
-WiFiClient espClient;
-PubSubClient client(espClient);
+// Trạng thái giữ qua deep sleep (RTC memory): cờ điều khiển và phần mới nhất của backlog
+const uint32_t RTC_MAGIC = 0x47415244;   // "GARD"
+const size_t RTC_BACKLOG = 160;
+struct RtcState {
+  uint32_t magic;
+  uint32_t boots;
+  bool autoLightOn, autoWateringOn;
+  char switchWateringState, switchLightState;
+  char lightColor[10];
+  uint8_t samplesSinceUpload;
+  IrrigationState irrigation;       // mô hình tốc độ khô/gain đã học và lần tưới đang ngấm
+  uint16_t backlogCount;
+  SensorSample backlog[RTC_BACKLOG];
+};
+static_assert(sizeof(RtcState) <= HAL_RTC_BYTES, "RtcState does not fit in RTC memory");
+
+TaskId mqttTask, reconnectTask, publishTask, drainTask, metricsTask, otaTask, otaRestartTask;   // netScheduler
+TaskId commandsTask, sampleTask, displayTask, controlTask, wateringOffTask, statsTask, windowTask, ledTask,
+       configSaveTask, httpTask;  // ioScheduler (httpTask khi GARDEN_HTTP)
+uint32_t net_worker();
+void mqtt_service();
+void run_commands();
+void reconnect();
+void sample_sensors();
+void publish_readings();
+void publish_sample(const SensorSample& sample);
+void refresh_display();
+void run_control();
+void watering_off();
+void drain_backlog();
+void publish_metrics();
+bool publish_metered(const char* topic, const char* text);
+void print_stats();
+void save_config();
+void ota_service();
+void ota_restart();
+#if GARDEN_HTTP
+void http_service();
+#endif
+uint32_t sample_period();
+void start_upload();
+void upload_window();
+bool rtc_restore();
+void power_manage();
+
+// --------------------- Topic theo node -----------------
+void node_topic(char* out, const char* node, const char* channel) {
+  snprintf(out, TOPIC_LEN, "%s/%s/%s", topicRoot, node, channel);
+}
+
+void setup_topics() {
+  if (nodeName[0]) snprintf(nodeId, sizeof(nodeId), "%s", nodeName);
+  else halDeviceId(nodeId, sizeof(nodeId));
+  for (uint8_t i = 0; i < NODE_TOPICS; i++) node_topic(topics[i], nodeId, nodeChannels[i]);
+  node_topic(groupFilter, groupId, nodeChannels[TOPIC_COMMANDS]);
+}
 
 // --------------------- Hàm kết nối WiFi -----------------
+// Không chờ: sampling/điều khiển chạy ngay, reconnect() đưa node lên mạng ở luồng mạng
 void setup_wifi() {
-  int a = 0, i=0 ;
-  Serial.println("Connecting to WiFi...");
-
-  WiFi.begin(ssid, password);
-  while (WiFi.status() != WL_CONNECTED) {
-    Serial.print(".");
-    display.clearDisplay();
-    display.setTextSize(1);
-    if (a == 0) { display.drawBitmap(52, 15, wifi_icon, 16, 16, WHITE); a = 1; }
-    else { display.drawBitmap(52, 15, wifi_icon, 16, 16, BLACK); a = 0; }
-    display.setCursor(25, 38); display.print("Connecting ...");
-    display.display();
-    delay(1000);
-  }
-
-  display.clearDisplay();
-  display.setTextSize(1);
-    if (WiFi.status() == WL_CONNECTED) {
-      Serial.println("\n Connected!");
-      display.drawBitmap(52, 15, wifi_icon, 16, 16, WHITE);
-      display.setCursor(33, 38); display.print("Connected!");
-    } else {
-      display.drawBitmap(52, 15, wifi_dc, 16, 16, WHITE);
-      display.setCursor(20, 38); display.print("Wifi Connection");
-      display.setCursor(36, 48); display.print("Failed!");
-    }
-  display.display();
-  delay(1200);
-  
-  Serial.println("\nWiFi connected");
-  Serial.print("IP address: ");
-  Serial.println(WiFi.localIP());
+  halLog("Connecting to WiFi...");
+  connection.start();
+  netScheduler.runNow(reconnectTask);
 }
 
-// Hàm kết nối lại
+// Một bước của connection (chờ WiFi / thử MQTT), task tự hẹn lại theo khoảng chờ trả về
 void reconnect() {
-  while (!client.connected()) {
-    Serial.print("Attempting MQTT connection...");
-    if (client.connect(clientID)) {
-      Serial.println("MQTT connected");
-      client.subscribe(autoLightTopic);
-      client.subscribe(autoWateringTopic);
-      client.subscribe(SwitchWatering);
-      client.subscribe(SwitchLight);
-      client.subscribe(LightColor);
-      Serial.println("Topic Subscribed");
-    } else {
-      Serial.print("failed, rc=");
-      Serial.print(client.state());
-      Serial.println(" try again in 5 seconds");
-      delay(5000);
+  if (!radioWanted) return;
+  const ConnectStats& s = connection.stats();
+  uint32_t onlinesBefore = s.onlines, attemptsBefore = s.attempts;
+  uint32_t wait = connection.service();
+  reconnectAttempts.inc(s.attempts - attemptsBefore);
+  if (!connection.online()) {
+    if (s.attempts != attemptsBefore) {
+      reconnectFailures.inc();
+      halLog("MQTT failed, rc=%d, try again in %lu ms", client.state(), (unsigned long)wait);
     }
+    netScheduler.runIn(reconnectTask, wait);
+    return;
   }
+  if (s.onlines == onlinesBefore) return;
+
+  halLog("Online in %lu ms (WiFi %lu ms), subscribed %s, %s", (unsigned long)s.lastOnlineMs,
+         (unsigned long)s.lastLinkMs, topics[TOPIC_COMMANDS], groupFilter);
+  onlineTime.observe(s.lastOnlineMs);
+  for (ChangeReporter* r : reporters) r->invalidate();   // gửi lại giá trị hiện tại sau khi kết nối
+  if (!backlog.empty()) netScheduler.runNow(drainTask);
+  sessions = sessions + 1;
+  if (power.mode != POWER_ALWAYS_ON) publish_metrics();   // không có metricsTask định kỳ khi ngủ
 }
 
 // --- callback nhận dữ liệu ---
-void callback(char* topic, byte* payload, unsigned int length) {
-  String message;
-  for (int i = 0; i < length; i++) {
-    message += (char)payload[i];
-  }
-  
-  Serial.print("Nhận từ topic: ");
-  Serial.println(topic);
-  Serial.print("Nội dung: ");
-  Serial.println(message);
-
-  if (String(topic) == autoWateringTopic) {
-    Serial.println(message);
-    if (message == "true") {
-      autoWateringOn = true;
-    } else if (message == "false") {
-      autoWateringOn = false;
-    }
+// Mỗi topic một handler, payload đọc trực tiếp từ buffer MQTT (không String/heap)
+void on_auto_watering(const uint8_t* payload, size_t length) {
+  int8_t v = payloadBool(payload, length);
+  if (v >= 0) autoWateringOn = v;
+}
+
+void on_switch_watering(const uint8_t* payload, size_t length) {
+  int8_t v = payloadBool(payload, length);
+  if (v < 0) return;
+  switchWateringState = v;
+  halLog(v ? "Manual Watering ON via MQTT" : "Manual Watering OFF via MQTT");
+}
+
+void on_auto_light(const uint8_t* payload, size_t length) {
+  int8_t v = payloadBool(payload, length);
+  if (v >= 0) autoLightOn = v;
+}
+
+void on_switch_light(const uint8_t* payload, size_t length) {
+  int8_t v = payloadBool(payload, length);
+  if (v < 0) return;
+  switchLightState = v;
+  halLog(v ? "LED turned ON via MQTT" : "LED turned OFF via MQTT");
+}
+
+Rgb parse_light_color(const char* text) {
+  uint32_t hex;
+  if (payloadHexColor((const uint8_t*)text, strlen(text), hex)) return rgbFromHex(hex);
+  for (size_t i = 0; i < sizeof(namedColors) / sizeof(namedColors[0]); i++)
+    if (strcmp(text, namedColors[i].name) == 0) return namedColors[i].color;
+  return RGB_WHITE;
+}
+
+void on_light_color(const uint8_t* payload, size_t length) {
+  payloadCopy(payload, length, lightColor, sizeof(lightColor));
+  manualColor = parse_light_color(lightColor);
+  halLog("LED color set to %s via MQTT", lightColor);
+}
+
+// --------------------- Cấu hình lúc chạy -----------------
+// Ràng buộc giữa các trường (từng trường đã được kiểm tra khoảng trong configParse()); nullptr = hợp lệ
+const char* config_error(const GardenConfig& c) {
+  if (c.soilTargetPercent <= c.soilDryPercent) return "soilTargetPercent must be above soilDryPercent";
+  if (c.lightBrightPercent <= c.lightDimPercent) return "lightBrightPercent must be above lightDimPercent";
+  if (c.light.maxRaw - c.light.minRaw < minCalibrationSpan) return "light.maxRaw - light.minRaw too small";
+  if (c.soil.maxRaw - c.soil.minRaw < minCalibrationSpan) return "soil.maxRaw - soil.minRaw too small";
+  return nullptr;
+}
+
+uint32_t config_crc(const GardenConfig& c) { return configCrc32(&c, sizeof(c)); }
+
+// Thay cả bộ cấu hình và các policy dẫn xuất từ nó, chỉ gọi ở luồng io
+void apply_config(const GardenConfig& c) {
+  config = c;
+  irrigationPolicy.lowPercent = c.soilDryPercent;
+  irrigationPolicy.targetPercent = c.soilTargetPercent;
+  tempPolicy.threshold = c.overheatC;
+  soilPolicy.threshold = c.soilDryPercent - 0.5f;
+  configCrc.set((int32_t)config_crc(c));
+}
+
+void log_config(const char* what) {
+  char text[200];
+  configFormat(configFields, CONFIG_FIELDS, &config, text, sizeof(text));
+  halLog("Config %s: %s", what, text);
+}
+
+// Blob NVS: header + struct, kiểm tra version/CRC rồi chép thẳng, không parse lại
+void load_config() {
+  uint8_t blob[CONFIG_BLOB_HEADER + sizeof(GardenConfig)];
+  size_t n = halNvsRead(configKey, blob, sizeof(blob));
+  GardenConfig stored;
+  if (n && configDecode(GARDEN_CONFIG_VERSION, blob, n, &stored, sizeof(stored)) && !config_error(stored)) {
+    apply_config(stored);
+    log_config("loaded from NVS");
+    return;
+  }
+  apply_config(defaultConfig);
+  if (n) halLog("Config in NVS ignored (version, CRC or range), using board defaults");
+}
+
+void save_config() {
+  uint8_t blob[CONFIG_BLOB_HEADER + sizeof(GardenConfig)], stored[sizeof(blob)];
+  size_t n = configEncode(GARDEN_CONFIG_VERSION, &config, sizeof(config), blob, sizeof(blob));
+  // lệnh đổi rồi đổi lại trong lúc chờ: NVS đã đúng, không ghi
+  if (halNvsRead(configKey, stored, sizeof(stored)) == n && memcmp(stored, blob, n) == 0) return;
+  if (!halNvsWrite(configKey, blob, n)) halLog("Config NVS write failed");
+}
+
+void on_config(const uint8_t* payload, size_t length) {
+  GardenConfig next = config;
+  ConfigResult r = configParse(configFields, CONFIG_FIELDS, &next, payload, length);
+  const char* error = r.status != CONFIG_OK ? configStatusText(r.status) : config_error(next);
+  if (error) {
+    configRejected.inc();
+    halLog("Config rejected: %s%s%s", error, r.field ? ": " : "", r.field ? r.field->name : "");
+    return;
   }
+  if (!r.changed) return;
+  apply_config(next);
+  configUpdates.inc();
+  log_config("updated via MQTT");
+  ioScheduler.runIn(configSaveTask, configSaveDelayMs);
+}
+
+// --------------------- Cập nhật firmware (luồng mạng) -----------------
+void ota_status() {
+  char text[96];
+  if (ota.phase() == OTA_FAILED) snprintf(text, sizeof(text), "state=failed error=%s", otaErrorText(ota.error()));
+  else snprintf(text, sizeof(text), "state=%s next=%lu size=%lu", otaPhaseText(ota.phase()),
+                (unsigned long)ota.next(), (unsigned long)ota.deltaSize());
+  publish_metered(topics[TOPIC_OTA], text);
+}
+
+// Checkpoint dạng blob NVS như cấu hình (header + CRC của lib/ConfigStore)
+bool load_ota_checkpoint(OtaCheckpoint& cp) {
+  uint8_t blob[CONFIG_BLOB_HEADER + sizeof(OtaCheckpoint)];
+  size_t n = halNvsRead(otaKey, blob, sizeof(blob));
+  return n && configDecode(OTA_CHECKPOINT_VERSION, blob, n, &cp, sizeof(cp));
+}
 
-  if (String(topic) == SwitchWatering) {
-    if (message == "true") {
-      switchWateringState = true;
-      Serial.println("Manual Watering ON via MQTT");
-    } else if (message == "false") {
-      switchWateringState = false;
-      Serial.println("Manual Watering OFF via MQTT");
+void save_ota_checkpoint(const OtaCheckpoint& cp) {
+  uint8_t blob[CONFIG_BLOB_HEADER + sizeof(OtaCheckpoint)];
+  size_t n = configEncode(OTA_CHECKPOINT_VERSION, &cp, sizeof(cp), blob, sizeof(blob));
+  if (!halNvsWrite(otaKey, blob, n)) halLog("OTA checkpoint NVS write failed");
+}
+
+void clear_ota_checkpoint() {
+  OtaCheckpoint none = {};   // phase OTA_IDLE: không tiếp tục được
+  save_ota_checkpoint(none);
+}
+
+// "size=<byte> sha256=<64 hex>", thứ tự tùy ý
+bool parse_ota_begin(const uint8_t* payload, size_t length, uint32_t& size, uint8_t sha[SHA256_SIZE]) {
+  bool haveSize = false, haveSha = false;
+  size_t i = 0;
+  while (i < length) {
+    while (i < length && payload[i] == ' ') i++;
+    size_t start = i;
+    while (i < length && payload[i] != ' ') i++;
+    const uint8_t* word = payload + start;
+    size_t n = i - start;
+    long v;
+    if (!n) break;
+    if (payloadStartsWith(word, n, "size=")) {
+      haveSize = payloadInt(word + 5, n - 5, v) && v > 0;
+      if (haveSize) size = (uint32_t)v;
+    } else if (payloadStartsWith(word, n, "sha256=")) {
+      haveSha = sha256FromHex(word + 7, n - 7, sha);
+    } else {
+      return false;
     }
   }
+  return haveSize && haveSha;
+}
 
-  if (String(topic) == autoLightTopic) {
-    Serial.println(message);
-    if (message == "true") {
-      autoLightOn = true;
-    } else if (message == "false") {
-      autoLightOn = false;
+void on_ota_begin(const uint8_t* payload, size_t length) {
+  uint32_t size = 0;
+  uint8_t sha[SHA256_SIZE];
+  if (!parse_ota_begin(payload, length, size, sha)) {
+    halLog("OTA begin ignored: expected \"size=<bytes> sha256=<hex>\"");
+    return;
+  }
+  otaChunkMs = halMillis();
+  char hex[2 * SHA256_SIZE + 1];
+  sha256ToHex(sha, hex);
+  bool same = ota.deltaSize() == size && memcmp(ota.targetSha(), sha, SHA256_SIZE) == 0;
+  if (same && (ota.active() || ota.phase() == OTA_DONE)) {
+    ota_status();   // host hỏi lại sau khi mất kết nối: báo next hiện tại
+    return;
+  }
+  OtaCheckpoint cp;
+  if (load_ota_checkpoint(cp) && cp.deltaSize == size && memcmp(cp.targetSha, sha, SHA256_SIZE) == 0) {
+    if (cp.phase == OTA_DONE) {
+      // đã cài xong trước lần khởi động lại này
+      char text[64];
+      snprintf(text, sizeof(text), "state=done next=%lu size=%lu", (unsigned long)size, (unsigned long)size);
+      publish_metered(topics[TOPIC_OTA], text);
+      return;
     }
+    if (ota.resume(cp)) {
+      halLog("OTA %.12s resumed at %lu/%lu bytes", hex, (unsigned long)cp.deltaPos, (unsigned long)size);
+      ota_status();
+      return;
+    }
+  }
+  ota.begin(size, sha);
+  halLog("OTA %.12s started, %lu bytes delta", hex, (unsigned long)size);
+  ota_status();
+}
+
+void on_ota_chunk(const uint8_t* payload, size_t length) {
+  otaChunkMs = halMillis();
+  if (ota.active() && !ota.wantsInput()) return;   // đoạn trước chưa xong, status sẽ báo next
+  bool ok = length > 4 && length - 4 <= OTA_CHUNK_MAX;
+  if (ok && otaGet32(payload) == ota.next()) {
+    memcpy(otaChunk, payload + 4, length - 4);
+    ok = ota.feed(otaChunk, length - 4);
+  } else {
+    ok = false;
+  }
+  if (!ok) {
+    ota_status();   // mất/lặp đoạn: host gửi lại từ next
+    return;
   }
+  otaChunks.inc();
+  netScheduler.runNow(otaTask);
+}
+
+void on_ota_abort(const uint8_t* payload, size_t length) {
+  if (!ota.active()) return;
+  ota.abort();
+  clear_ota_checkpoint();
+  halLog("OTA aborted");
+  ota_status();
+}
 
-  if (String(topic) == SwitchLight) {
-    if (message == "true") {
-      switchLightState = true;
-      Serial.println("LED turned ON via MQTT");
-    } else if (message == "false") {
-      switchLightState = false;
-      Serial.println("LED turned OFF via MQTT");
+// Áp dụng tới otaStepBytes mỗi lần chạy rồi nhường luồng mạng; hết đoạn thì báo next cho host
+void ota_service() {
+  bool more = ota.step(otaStepBytes);
+  if (ota.checkpointReady()) save_ota_checkpoint(ota.checkpointTaken());
+  if (more) {
+    netScheduler.runNow(otaTask);
+    return;
+  }
+  if (ota.phase() == OTA_DONE) {
+    save_ota_checkpoint(ota.snapshot());
+    if (!firmware.activate(ota.targetSize())) {
+      halLog("OTA verified but boot partition not switched");
+      publish_metered(topics[TOPIC_OTA], "state=failed error=activate");
+      return;
     }
+    halLog("OTA verified (%lu bytes, %lu copied, %lu new), restarting in %lu ms", (unsigned long)ota.targetSize(),
+           (unsigned long)ota.copied, (unsigned long)ota.literal, (unsigned long)otaRestartMs);
+    netScheduler.runIn(otaRestartTask, otaRestartMs);
+  } else if (ota.phase() == OTA_FAILED) {
+    halLog("OTA failed: %s", otaErrorText(ota.error()));
+    clear_ota_checkpoint();
+  }
+  ota_status();
+}
+
+// Khung lịch sử dở trong RAM mất như khi reset
+void ota_restart() { firmware.restart(); }
+
+constexpr CommandRoute otaRoutes[] = {
+  COMMAND_ROUTE(otaBeginTopic, on_ota_begin),
+  COMMAND_ROUTE(otaChunkTopic, on_ota_chunk),
+  COMMAND_ROUTE(otaAbortTopic, on_ota_abort),
+};
+CommandDispatcher otaCommands(otaRoutes, sizeof(otaRoutes) / sizeof(otaRoutes[0]));
+
+constexpr CommandRoute commandRoutes[] = {
+  COMMAND_ROUTE(autoWateringTopic, on_auto_watering),
+  COMMAND_ROUTE(SwitchWatering,    on_switch_watering),
+  COMMAND_ROUTE(autoLightTopic,    on_auto_light),
+  COMMAND_ROUTE(SwitchLight,       on_switch_light),
+  COMMAND_ROUTE(LightColor,        on_light_color),
+  COMMAND_ROUTE(configTopic,       on_config),
+};
+CommandDispatcher commands(commandRoutes, sizeof(commandRoutes) / sizeof(commandRoutes[0]));
+
+// Chạy trên luồng mạng: chỉ chép lệnh sang commandQueue, run_commands() ở luồng io
+// dispatch và áp dụng nên trạng thái điều khiển chỉ có một luồng ghi. Lệnh OTA (nhị phân,
+// không đụng trạng thái điều khiển) xử lý luôn ở đây.
+void callback(char* topic, uint8_t* payload, unsigned int length) {
+  HOTPATH_SCOPE(callbackCycles);
+  // bỏ <topicRoot>/<nodeId|groupId>/, bảng lệnh dùng phần còn lại
+  const char* command;
+  size_t skip;
+  if (!topicLevel(topic, 2, command, skip)) return;
+  if (strncmp(command, otaTopicPrefix, sizeof(otaTopicPrefix) - 1) == 0) {
+    // một lệnh trên groupId không được cập nhật firmware cả nhóm
+    const char* node;
+    size_t nodeLen;
+    topicLevel(topic, 1, node, nodeLen);
+    if (nodeLen == strlen(nodeId) && memcmp(node, nodeId, nodeLen) == 0) otaCommands.dispatch(command, payload, length);
+    else halLog("OTA command ignored on %s: only accepted on the node topic", topic);
+    return;
   }
 
-  if (String(topic) == LightColor) {
-    message.toCharArray(lightColor, sizeof(lightColor));
+  commandsReceived.inc();
+  halLog("Nhận từ topic: %s", topic);
+  halLog("Nội dung: %.*s", (int)length, (const char*)payload);
+
+  CommandMsg msg;
+  size_t topicLen = strlen(command);
+  if (topicLen >= sizeof(msg.topic) || length > sizeof(msg.payload)) {
+    halLog("Command too long (%u bytes), ignored", length);
+    if (strcmp(command, configTopic) == 0) configRejected.inc();
+    return;
   }
+  memcpy(msg.topic, command, topicLen + 1);
+  memcpy(msg.payload, payload, length);
+  msg.length = length;
+  if (!commandQueue.push(msg)) halLog("Command queue full, %lu dropped", (unsigned long)commandQueue.dropped());
 }
 
 // --------------------- Hàm Báo động quá nhiệt -----------------
 void alert_overheat(float temperature) {
-  if (temperature > 35.0) {
-    Serial.println("Temperature exceeds threshold! Activating alert.");
-    digitalWrite(LED_DHT, HIGH);
-    ledcWriteTone(5, 600);
+  if (temperature > config.overheatC) {
+    halLog("Temperature exceeds threshold! Activating alert.");
+    actuators.digitalOut(Board::ALARM_LED_PIN, true);
+    actuators.buzzerTone(600);
   } else {
-    digitalWrite(LED_DHT, LOW);
-    ledcWriteTone(5, 0);
+    actuators.digitalOut(Board::ALARM_LED_PIN, false);
+    actuators.buzzerTone(0);
   }
 }
 
 //------------kiểm tra auto light-----------------------
 void control_light(bool autoLightOn, int lightPercent) {
+      HOTPATH_SCOPE(lightCycles);
+      Rgb color;
       if (autoLightOn) {
-        Serial.println("Auto Light ON - Turning ON LED.");
+        halLog("Auto Light ON - Turning ON LED.");
     // Điều khiển màu sắc của dải LED WS2812 dựa trên mức độ ánh sáng
-        CRGB color;
-        if(lightPercent > 80){
-          Serial.println("High Light - NeoPixel color : White");
-          color = CRGB::White;
+        if(lightPercent > config.lightBrightPercent){
+          halLog("High Light - NeoPixel color : White");
+          color = RGB_WHITE;
         }
-        else if (lightPercent > 40){
-          color = CRGB::Yellow;
+        else if (lightPercent > config.lightDimPercent){
+          color = RGB_YELLOW;
         }else{
-          Serial.println("Low Light - NeoPixel color : Blue");
-          color = CRGB::Blue;
+          halLog("Low Light - NeoPixel color : Blue");
+          color = RGB_BLUE;
         }
-        fill_solid(leds, NUM_LEDS, color);
-        FastLED.show();
       } else {
-        Serial.println("Auto Light OFF - Turning OFF LED.");
+        halLog("Auto Light OFF - Turning OFF LED.");
         // Bật tắt đèn LED theo lệnh từ MQTT
-        if(switchLightState) {
-          digitalWrite(LED, HIGH);
-          Serial.println(lightColor);
-          if(strcmp(lightColor, "Red") == 0) {
-            fill_solid(leds, NUM_LEDS, CRGB::Red);
-            Serial.println("LED color set to Red via MQTT");
-          } else if(strcmp(lightColor, "Yellow") == 0) {
-            fill_solid(leds, NUM_LEDS, CRGB::Yellow);
-            Serial.println("LED color set to Yellow via MQTT");
-          } else if(strcmp(lightColor, "Blue") == 0) {
-            fill_solid(leds, NUM_LEDS, CRGB::Blue);
-            Serial.println("LED color set to Blue via MQTT");
-          } else {
-            fill_solid(leds, NUM_LEDS, CRGB::White);
-            Serial.println("LED color set to White (default)");
-          }
-        } else {
-          digitalWrite(LED, LOW);
-          fill_solid(leds, NUM_LEDS, CRGB::Black);
-        }
-        FastLED.show();
-
+        actuators.digitalOut(Board::LAMP_PIN, switchLightState);
+        color = switchLightState ? manualColor : RGB_BLACK;
+      }
+      // chỉ khi màu đích đổi mới bắt đầu chuyển màu; khung do ledTask gửi
+      if (color != ring.target()) {
+        ring.setColor(color, ledFadeMs, halMillis());
+        ioScheduler.runNow(ledTask);
       }
 }
 
+// Một khung của hiệu ứng LED; tự hẹn khung kế tiếp sau ledFrameMs khi còn đang chuyển
+void render_leds() {
+  if (ring.render(halMillis())) actuators.showLeds(ring.pixels(), ring.count());
+  if (ring.animating()) ioScheduler.runIn(ledTask, ring.frameMs());
+}
+
 //------------Điều kiển tưới nước-----------------------
+void watering_off() {
+  actuators.servoWrite(90);
+  wateringActive = false;
+}
+
+// Mở van, wateringOffTask đóng lại sau ms
+void watering_pulse(uint32_t ms) {
+  actuators.servoWrite(0);
+  wateringActive = true;
+  ioScheduler.runIn(wateringOffTask, ms);
+}
+
 void control_watering(bool autoWateringOn, int soilPercent) 
 {
-    if (autoWateringOn)
-      if (soilPercent < 30) {
-      Serial.println("Soil is Dry. Activating automatic watering");
-      servo.write(0);
-      delay(1000);
-      servo.write(90);
+    if (autoWateringOn && irrigationMode == IRRIGATION_PREDICTIVE) {
+      uint32_t pulse = irrigation.update(soilLevel, temp, hum, halMillis());
+      if (pulse && !wateringActive) {
+        halLog("Soil %.1f%%, drying %.2f%%/h. Watering for %lu ms", soilLevel, irrigation.dryRate(), (unsigned long)pulse);
+        watering_pulse(pulse);
+      } else if (!wateringActive) {
+        actuators.servoWrite(90);
+      }
+    } else if (autoWateringOn)
+      if (soilPercent < config.soilDryPercent) {
+      if (!wateringActive) {
+        halLog("Soil is Dry. Activating automatic watering");
+        watering_pulse(wateringPulse);
+      }
     } else {
-      Serial.println("Soil is Moist/Wet");
-      servo.write(90);
-      delay(100);
+      halLog("Soil is Moist/Wet");
+      if (!wateringActive) actuators.servoWrite(90);
     }
     else {
-      Serial.println("Auto Watering OFF.");
+      halLog("Auto Watering OFF.");
+      irrigation.interrupt();
       if (switchWateringState) {
-        Serial.println("Manual Watering ON via MQTT");
-        servo.write(0);
+        halLog("Manual Watering ON via MQTT");
+        ioScheduler.enable(wateringOffTask, false);
+        wateringActive = false;
+        actuators.servoWrite(0);
       } else {
-        Serial.println("Manual Watering OFF via MQTT");
-        servo.write(90);
-        delay(100);
+        halLog("Manual Watering OFF via MQTT");
+        ioScheduler.enable(wateringOffTask, false);
+        watering_off();
       }
     }
 
-    Serial.println("Data published successfully to separate topics.");
-    Serial.println("-----------------------------");
+    halLog("-----------------------------");
 }
 
 //--------------------- Điều khiển màn hình -----------------
+// StatusView chỉ vẽ lại và gửi qua I2C những trường thay đổi
 void displayStatus(float temp, float hum, int lightPercent, int soilPercent) 
 {
-    display.clearDisplay();
-    display.setTextSize(1);
+    HOTPATH_SCOPE(displayCycles);
+    StatusFields fields = { temp, hum, lightPercent, soilPercent, linkReady,
+                            switchLightState || autoLightOn, wateringActive || (bool)switchWateringState };
+    statusView.render(fields);
+}
+// --------------------- Hàm setup (cấu hình ban đầu để hoạt động) -----------------
+void setup() {
 
-    // Temp
-    display.drawBitmap(0, 0,  icon_temp16,  16, 16, WHITE); display.setCursor(20, 4); display.print("Temp: "); display.print(temp, 1); display.print(" C");
+  halBegin();
 
-    // Humidity
-    display.drawBitmap(0, 16, icon_humid16, 16, 16, WHITE); display.setCursor(20, 20); display.print("H: "); display.print(hum, 0); display.print(" %");
+  // Initialize sensors and components (servo, buzzer, WS2812 trong backend)
+  sensors.begin();
+  actuators.begin();
+  actuators.servoWrite(90);
 
-    // Light
-    display.drawBitmap(0, 32, icon_light16, 16, 16, WHITE); display.setCursor(20, 36); display.print("Light: "); display.print((int)roundf(lightPercent)); display.print(" %");
+  // Setup OLED display
+  if(!display.begin()) {
+    halLog("SSD1306 allocation failed");
+    for(;;);
+  }
 
-    // Soil moisture
-    display.drawBitmap(0, 48, icon_soil16, 16, 16, WHITE); display.setCursor(20, 52); display.print("Soil: "); display.print((int)roundf(soilPercent)); display.print(" %");
-    
-    // WiFi status
-    if (WiFi.status() != WL_CONNECTED) {
-      display.drawBitmap(110, 0, wifi_dc, 16, 16, WHITE);
-    } else {
-      display.drawBitmap(110, 0, wifi_icon, 16, 16, WHITE);
+  // Thức dậy từ deep sleep: lấy lại trạng thái, bỏ màn hình chào, WiFi chỉ bật khi tới lượt gửi
+  bool resumed = power.mode == POWER_DEEP_SLEEP && halWakeCause() != WAKE_POWER_ON && rtc_restore();
+  if (!resumed) {
+    display.clear();
+    display.text(18, 20, "Hellooo");
+    display.text(10, 35, "DHT22 + LDR + Soil Moisture");
+    display.flush();
+    halDelay(1200);
+    statusView.invalidate();  // màn hình chào đã vẽ đè
+  } else {
+    settleTries = wakeSettleTries;
+  }
+
+  load_config();
+#if GARDEN_HISTORY
+  if (history.begin())
+    halLog("History: %u sectors (%lu KB), last sample at %llu ms", history.sectorCount(),
+           (unsigned long)(history.capacityBytes() / 1024), (unsigned long long)history.lastTime());
+  else
+    halLog("History: no flash partition");
+#endif
+
+  // Setup WiFi and MQTT
+  setup_topics();
+  connection.configure(ssid, password, nodeId, topics[TOPIC_COMMANDS], groupFilter);
+  client.begin(mqttServer, 1883, callback);
+  if (power.mode != POWER_ALWAYS_ON) {
+    radioOff = true;              // mqtt_service() bật WiFi khi radioWanted
+    radioWanted = false;
+    if (halWakeCause() == WAKE_THRESHOLD) uploadNow = true;
+  }
+
+  // Đăng ký task: thứ tự đăng ký cũng là thứ tự chạy trong một tick
+  mqttTask        = netScheduler.every("mqtt",      mqtt_service,     0,                 20,    5000);
+  reconnectTask   = netScheduler.once ("reconnect", reconnect,                           1000,  0);
+  publishTask     = netScheduler.once ("publish",   publish_readings,                    100,   20000);
+  drainTask       = netScheduler.once ("drain",     drain_backlog,                       100,   20000);
+  metricsTask     = netScheduler.every("metrics",   publish_metrics,  diagInterval,      1000,  20000, false);
+  otaTask         = netScheduler.once ("ota",       ota_service,                         100,   100000);
+  otaRestartTask  = netScheduler.once ("otaRestart", ota_restart,                        1000,  0);
+
+  commandsTask    = ioScheduler.every("commands",  run_commands,     0,                 20,    5000);
+  sampleTask      = ioScheduler.every("sample",    sample_sensors,   sample_period(),   100,   50000);
+  displayTask     = ioScheduler.once ("display",   refresh_display,                     200,   60000);
+  controlTask     = ioScheduler.once ("control",   run_control,                         20,    5000);
+  wateringOffTask = ioScheduler.once ("wateringOff", watering_off,                      20,    2000);
+  statsTask       = ioScheduler.every("stats",     print_stats,      statsInterval,     1000,  0, false);
+  windowTask      = ioScheduler.once ("window",    upload_window,                       100,   5000);
+  ledTask         = ioScheduler.once ("leds",      render_leds,                         ledFrameMs, 2000);
+  configSaveTask  = ioScheduler.once ("configSave", save_config,                        1000,  50000);
+#if GARDEN_HTTP
+  httpTask        = ioScheduler.once ("http",      http_service,                        100,   20000);
+#endif
+  if (power.mode != POWER_ALWAYS_ON) {
+    // task định kỳ sẽ đánh thức node: metrics gửi khi kết nối, thống kê in khi hết cửa sổ gửi
+    netScheduler.enable(metricsTask, false);
+    ioScheduler.enable(statsTask, false);
+  }
+#if GARDEN_HTTP
+  if (power.mode == POWER_ALWAYS_ON) ioScheduler.runNow(httpTask);   // khi ngủ WiFi tắt phần lớn thời gian
+#endif
+  ioScheduler.runNow(ledTask);          // khung đầu: vòng LED về đúng trạng thái sau reset
+
+  Counter* counters[] = { &reconnectAttempts, &reconnectFailures, &publishOk, &publishFailures, &commandsReceived,
+                          &readingsSuppressed, &configUpdates, &configRejected, &otaChunks, &dhtOk, &dhtTimeouts,
+                          &dhtFrameErrors, &dhtChecksumErrors, &dhtDeferred };
+  Gauge* gauges[] = { &freeHeap, &minFreeHeap, &wifiRssi, &backlogDepth, &backlogDropped, &queueDropped, &configCrc };
+  for (Counter* c : counters) metrics.add(*c);
+  for (Gauge* g : gauges) metrics.add(*g);
+  metrics.add(sampleJitter);
+  metrics.add(tickTime);
+  metrics.add(publishTime);
+  metrics.add(onlineTime);
+
+  if (power.mode == POWER_ALWAYS_ON) setup_wifi();
+  else if (!resumed) start_upload();
+
+  netWorker = halStartWorker("net", net_worker, netCore, netStackBytes, netPriority);
+  if (netWorker == NO_WORKER) halLog("Network worker not started, running in loop()");
+}
+
+
+// --------------------- Các task: luồng mạng -----------------
+uint32_t net_worker() {
+  netScheduler.tick();
+  uint32_t wait = netScheduler.msUntilNext();
+  return wait < netPollMs ? wait : netPollMs;
+}
+
+// Bật/tắt WiFi theo radioWanted của luồng io; false khi WiFi đang (hoặc vừa) tắt
+bool radio_service() {
+  if (!radioWanted) {
+    if (!radioOff) {
+      connection.stop();
+      netScheduler.enable(reconnectTask, false);
+      netScheduler.enable(drainTask, false);
+      uploadIdle = false;
+      radioOff = true;
     }
-    display.display();
-    delay(100);
+    return false;
+  }
+  if (radioOff) {
+    connection.start();
+    radioOff = false;
+  }
+  return true;
 }
 
-// --------------------- Hàm setup (cấu hình ban đầu để hoạt động) -----------------
-void setup() {
+void mqtt_service() {
+  if (!sampleQueue.empty()) netScheduler.runNow(publishTask);
+  if (!radio_service()) {
+    linkReady = false;
+    return;
+  }
+  linkReady = client.linkUp();
+  if (!client.connected()) {
+    uploadIdle = false;
+    if (!netScheduler.pending(reconnectTask)) netScheduler.runNow(reconnectTask);
+    return;
+  }
+  client.loop();
+  uploadIdle = sampleQueue.empty() && backlog.empty();
+}
 
-  Serial.begin(115200);
-  delay(100);
+// Mọi publish đi qua đây: đếm thành công/thất bại (client.publish trả về false khi
+// mất kết nối hoặc buffer không đủ) và đo thời gian ghi vào socket
+bool publish_metered(const char* topic, const uint8_t* payload, size_t length, bool retained) {
+  uint32_t start = halMicros();
+  bool ok = client.publish(topic, payload, length, retained);
+  publishTime.observe(halMicros() - start);
+  if (ok) publishOk.inc();
+  else publishFailures.inc();
+  return ok;
+}
 
-  // Initialize sensors and components
-  dht.begin();
-  pinMode(LED_DHT, OUTPUT);
-  pinMode(BUZZER_PIN, OUTPUT);
-  pinMode(LED, OUTPUT);
-  digitalWrite(LED, LOW);
+bool publish_metered(const char* topic, const char* text) {
+  return publish_metered(topic, (const uint8_t*)text, strlen(text), false);
+}
 
-  // Setup servo
-  servo.attach(SERVO_PIN, 500, 2400);
-  servo.write(90);
+// Kênh ChangeReporter đã cho gửi: update() coi giá trị là đã gửi, nên gửi lỗi thì invalidate()
+// để mẫu kế tiếp gửi lại thay vì chờ lần đổi/heartbeat sau
+bool publish_reported(ChangeReporter& report, const char* topic, const char* text) {
+  if (publish_metered(topic, text)) return true;
+  report.invalidate();
+  return false;
+}
 
-  // Setup buzzer
-  ledcSetup(5, 2000, 8); // tần số 2kHz, độ phân giải 8 bit
-  ledcAttachPin(BUZZER_PIN, 5);
+// encode() đã xóa batch: khung gửi lỗi được giải mã lại vào backlog (cùng độ phân giải như
+// trong khung) để drain_backlog() gửi bù như mẫu lúc mất kết nối
+void backlog_frame(const uint8_t* frame, size_t len) {
+  TelemetryHeader header;
+  SensorSample samples[TELEMETRY_MAX_BATCH];
+  int n = decodeTelemetryFrame(frame, len, header, samples, TELEMETRY_MAX_BATCH);
+  for (int i = 0; i < n; i++)
+    if (!backlog.push(samples[i])) halLog("Backlog full, %lu records dropped", (unsigned long)backlog.dropped());
+  halLog("Telemetry frame #%lu failed, %d samples kept in backlog", (unsigned long)header.seq, n);
+  if (!netScheduler.pending(drainTask)) netScheduler.runIn(drainTask, reconnectInterval);
+}
 
-  // Setup WS2812 LED strip
-  FastLED.addLeds<WS2812B, LED_PIN, GRB>(leds, NUM_LEDS);
+void publish_readings() {
+    SensorSample sample;
+    while (sampleQueue.pop(sample)) publish_sample(sample);
+}
 
-  // Setup OLED display
-  if(!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
-    Serial.println(F("SSD1306 allocation failed"));
-    for(;;);
+void publish_sample(const SensorSample& sample) {
+    HOTPATH_SCOPE(publishCycles);
+    if (!client.connected()) {
+      // vẫn lấy mẫu khi mất kết nối, gửi bù sau khi reconnect() thành công
+      if (!backlog.push(sample)) halLog("Backlog full, %lu records dropped", (unsigned long)backlog.dropped());
+      return;
+    }
+
+    if (Board::FRAME_TOPIC) {
+      if (telemetry.add(sample)) {
+        uint8_t frame[TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_BATCH * TELEMETRY_SAMPLE_SIZE];
+        size_t len = telemetry.encode(frame, sizeof(frame));
+        if (publish_metered(topics[TOPIC_FRAME], frame, len, false))
+          halLog("Telemetry frame #%lu published (%u bytes)", (unsigned long)telemetry.sequence() - 1, (unsigned)len);
+        else
+          backlog_frame(frame, len);
+      }
+    }
+
+    if (!Board::TEXT_TOPICS) return;
+    //------------Gửi dữ liệu lên MQTT với các topic riêng biệt (chỉ kênh thay đổi)-----------
+    char value[16];
+    bool ok = true;
+    uint8_t sent = 0;
+    if (tempReport.update(sample.temp, sample.ms)) {
+      snprintf(value, sizeof(value), "%.2f", sample.temp); ok &= publish_reported(tempReport, topics[TOPIC_TEMP], value); sent++;
+    }
+    if (humReport.update(sample.hum, sample.ms)) {
+      snprintf(value, sizeof(value), "%.2f", sample.hum);  ok &= publish_reported(humReport, topics[TOPIC_HUM], value); sent++;
+    }
+    if (lightReport.update(sample.light, sample.ms)) {
+      snprintf(value, sizeof(value), "%d", sample.light);  ok &= publish_reported(lightReport, topics[TOPIC_LIGHT], value); sent++;
+    }
+    if (soilReport.update(sample.soil, sample.ms)) {
+      snprintf(value, sizeof(value), "%d", sample.soil);   ok &= publish_reported(soilReport, topics[TOPIC_SOIL], value); sent++;
+    }
+    readingsSuppressed.inc(4 - sent);
+    if (!ok) halLog("Publish failed (%lu so far)", (unsigned long)publishFailures.value);
+    else if (sent) halLog("Data published successfully to %u topics.", sent);
+}
+
+// Một mẫu gửi bù trên bốn topic text, không qua ChangeReporter
+bool publish_text(const SensorSample& sample) {
+  char value[16];
+  snprintf(value, sizeof(value), "%.2f", sample.temp);
+  if (!publish_metered(topics[TOPIC_TEMP], value)) return false;
+  snprintf(value, sizeof(value), "%.2f", sample.hum);
+  if (!publish_metered(topics[TOPIC_HUM], value)) return false;
+  snprintf(value, sizeof(value), "%d", sample.light);
+  if (!publish_metered(topics[TOPIC_LIGHT], value)) return false;
+  snprintf(value, sizeof(value), "%d", sample.soil);
+  return publish_metered(topics[TOPIC_SOIL], value);
+}
+
+void drain_backlog() {
+  if (backlog.empty() || !client.connected()) return;
+
+  uint8_t n = 0;
+  bool ok = true;
+  if (Board::FRAME_TOPIC) {
+    while (n < backlog.size()) {
+      bool full = replay.add(backlog.peek(n++));
+      if (full) break;
+    }
+    uint8_t frame[TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_BATCH * TELEMETRY_SAMPLE_SIZE];
+    size_t len = replay.encode(frame, sizeof(frame));
+    ok = publish_metered(topics[TOPIC_FRAME], frame, len, false);
+    if (!ok) n = 0;
+  } else {
+    // mẫu gửi dở (lỗi giữa bốn topic) được gửi lại cả mẫu ở lần sau
+    while (n < backlog.size() && n < Board::FRAME_BATCH && (ok = publish_text(backlog.peek(n)))) n++;
+  }
+  backlog.discard(n);
+  if (!ok) {
+    netScheduler.runIn(drainTask, reconnectInterval);  // thử lại sau, giữ nguyên dữ liệu
+    return;
   }
-  
-  display.clearDisplay();
-  display.setTextColor(SSD1306_WHITE);
-  display.setTextSize(1);
-  display.setCursor(18, 20); display.println(F("Hellooo"));
-  display.setCursor(10, 35); display.println(F("DHT22 + LDR + Soil Moisture"));
-  display.display();
-  delay(1200);
+  halLog("Backlog: sent %u records, %u left", n, (unsigned)backlog.size());
+  if (!backlog.empty()) netScheduler.runIn(drainTask, drainInterval);
+  // topic text giờ mang giá trị cũ của backlog: gửi lại giá trị hiện tại ở mẫu kế tiếp
+  else if (!Board::FRAME_TOPIC) for (ChangeReporter* r : reporters) r->invalidate();
+}
 
-  // Setup WiFi and MQTT
-  setup_wifi();
-  client.setServer(mqttServer, 1883);
-  client.setCallback(callback);
+void publish_metrics() {
+  freeHeap.set(halFreeHeap());
+  minFreeHeap.set(halMinFreeHeap());
+  wifiRssi.set(client.rssi());
+  backlogDepth.set(backlog.size());
+  backlogDropped.set(backlog.dropped());
+  queueDropped.set(sampleQueue.dropped() + commandQueue.dropped());
+  ClimateStats dht = sensors.climateStats();
+  dhtOk.value = dht.ok;
+  dhtTimeouts.value = dht.timeouts;
+  dhtFrameErrors.value = dht.frameErrors;
+  dhtChecksumErrors.value = dht.checksumErrors;
+  dhtDeferred.value = dht.deferred;
+  if (!client.connected()) return;
+
+  char json[512];
+  size_t len = metrics.format(json, sizeof(json), halMillis() / 1000);
+  if (len) publish_metered(topics[TOPIC_DIAG], (const uint8_t*)json, len, false);
+  else halLog("Metrics do not fit in %u bytes", (unsigned)sizeof(json));
 }
 
+#if GARDEN_HTTP
+// --------------------- HTTP cục bộ (luồng io) -----------------
+// Số đo hiện tại, trạng thái cơ cấu chấp hành và lịch sử trên cổng 80 (Wokwi chuyển tiếp
+// localhost:8180, xem wokwi.toml). Handler ghi thẳng từ biến toàn cục / HistoryCursor vào
+// buffer gửi của HttpServer, không dựng chuỗi trung gian. Chạy ở luồng io như cảm biến và
+// lịch sử nên đọc không cần khóa; chỉ bật khi luôn thức (POWER_ALWAYS_ON).
+const size_t HTTP_ROW_MAX = 96;        // một dòng lịch sử JSON/CSV dài nhất
 
-// --------------------- Hàm loop (hàm hoạt động hiển thị và lấy dữ liệu) -----------------
-void loop() {
-  if (!client.connected()) {
-    reconnect();
+// Giá trị cảm biến dạng text, missing nếu lỗi (NaN hoặc -999): "null" cho JSON, "" cho CSV
+const char* sensor_text(char* out, size_t capacity, float v, const char* fmt, const char* missing = "null") {
+  if (isnan(v) || v <= -999.0f) return missing;
+  snprintf(out, capacity, fmt, v);
+  return out;
+}
+
+// Màu đèn cho JSON: tên trong namedColors, còn lại là màu đã phân tích dạng "#rrggbb".
+// lightColor là text tùy ý từ MQTT nên không đưa thẳng vào JSON.
+const char* light_color_text(char* out, size_t capacity) {
+  for (size_t i = 0; i < sizeof(namedColors) / sizeof(namedColors[0]); i++)
+    if (strcmp(lightColor, namedColors[i].name) == 0) return namedColors[i].name;
+  snprintf(out, capacity, "#%02x%02x%02x", manualColor.r, manualColor.g, manualColor.b);
+  return out;
+}
+
+class StatusHandler : public HttpHandler {
+public:
+  const char* start(HttpExchange&) override { return "application/json"; }
+
+  size_t fill(HttpExchange& x, char* out, size_t capacity) override {
+    if (x.step++) return 0;
+    char t[16], h[16], c[200], color[8];
+    configFormat(configFields, CONFIG_FIELDS, &config, c, sizeof(c));
+    int n = snprintf(out, capacity,
+        "{\"node\":\"%s\",\"uptime\":%lu,\"sample\":%lu,\"temp\":%s,\"hum\":%s,\"light\":%d,\"soil\":%d,"
+        "\"soilLevel\":%.1f,\"wifi\":%s,"
+        "\"actuators\":{\"watering\":%s,\"light\":%s,\"color\":\"%s\",\"autoLight\":%s,\"autoWatering\":%s},"
+        "\"irrigation\":{\"mode\":\"%s\",\"dryRate\":%.2f,\"gain\":%.3f,\"soaking\":%s,\"pulses\":%lu},"
+        "\"config\":{\"crc\":\"%08lx\",\"values\":\"%s\"}",
+        nodeId, (unsigned long)halMillis(), (unsigned long)lastSampleMs,
+        sensor_text(t, sizeof(t), temp, "%.2f"), sensor_text(h, sizeof(h), hum, "%.1f"), lightPercent, soilPercent,
+        soilLevel, linkReady ? "true" : "false",
+        wateringActive || switchWateringState ? "true" : "false", switchLightState || autoLightOn ? "true" : "false",
+        light_color_text(color, sizeof(color)), autoLightOn ? "true" : "false", autoWateringOn ? "true" : "false",
+        irrigationMode == IRRIGATION_PREDICTIVE ? "predictive" : "threshold", irrigation.dryRate(), irrigation.gain(),
+        irrigation.soaking() ? "true" : "false", (unsigned long)irrigation.pulses,
+        (unsigned long)(uint32_t)configCrc.value, c);
+    if (n <= 0 || (size_t)n >= capacity) return 0;
+#if GARDEN_HISTORY
+    int m = snprintf(out + n, capacity - n, ",\"history\":{\"samples\":%lu,\"bytes\":%lu,\"last\":%llu}",
+                     (unsigned long)history.samples, (unsigned long)history.bytes,
+                     (unsigned long long)history.lastTime());
+    if (m <= 0 || (size_t)(n += m) >= capacity) return 0;
+#endif
+    n += snprintf(out + n, capacity - n, "}\n");
+    return (size_t)n < capacity ? n : 0;
   }
-  client.loop();
+};
 
-  unsigned long currentMillis = millis();
-  if (currentMillis - previousMillis >= interval) {
-    previousMillis = currentMillis;
-    
+#if GARDEN_HISTORY
+// Cửa sổ [from, to] của ?minutes=N (mặc định 60) tính lùi từ mẫu mới nhất
+void history_window(const char* query, uint64_t& from, uint64_t& to) {
+  uint32_t minutes = 60;
+  httpQueryU32(query, "minutes", minutes);
+  to = history.lastTime();
+  uint64_t span = (uint64_t)minutes * 60000;
+  from = to > span ? to - span : 0;
+}
+
+// Từng mẫu trong cửa sổ, HistoryCursor nằm trong scratch của exchange
+class HistoryHandler : public HttpHandler {
+public:
+  explicit HistoryHandler(bool csv) : csv(csv) {}
+
+  const char* start(HttpExchange& x) override {
+    uint64_t from, to;
+    history_window(x.query, from, to);
+    new (x.scratch) HistoryCursor(history, from, to);
+    return csv ? "text/csv" : "application/json";
+  }
+
+  size_t fill(HttpExchange& x, char* out, size_t capacity) override {
+    HistoryCursor& cursor = *(HistoryCursor*)x.scratch;
+    size_t len = 0;
+    if (x.step == 0) {
+      len = csv ? snprintf(out, capacity, "t_ms,temp,hum,light,soil\n")
+                : snprintf(out, capacity, "{\"node\":\"%s\",\"now\":%llu,\"samples\":[", nodeId,
+                           (unsigned long long)history.lastTime());
+      x.step = 1;
+    }
+    HistorySample s;
+    while (x.step < 3 && capacity - len > HTTP_ROW_MAX) {
+      if (!cursor.next(s)) {
+        if (!csv) len += snprintf(out + len, capacity - len, "]}\n");
+        x.step = 3;
+        break;
+      }
+      char t[16], h[16];
+      const char* fmt = csv ? "%llu,%s,%s,%u,%u\n" : x.step == 1 ? "[%llu,%s,%s,%u,%u]" : ",[%llu,%s,%s,%u,%u]";
+      const char* missing = csv ? "" : "null";
+      len += snprintf(out + len, capacity - len, fmt, (unsigned long long)s.t,
+                      sensor_text(t, sizeof(t), s.temp, "%.1f", missing), sensor_text(h, sizeof(h), s.hum, "%.1f", missing),
+                      s.light, s.soil);
+      x.step = 2;
+    }
+    return len;
+  }
+
+private:
+  bool csv;
+};
+static_assert(sizeof(HistoryCursor) <= HTTP_SCRATCH_BYTES, "HistoryCursor does not fit in HttpExchange::scratch");
+
+// "[min,trung bình,max]" của một kênh, null nếu cửa sổ không có giá trị hợp lệ nào
+const char* channel_text(char* out, size_t capacity, const HistoryChannel& c, const char* fmt) {
+  if (!c.count) return "null";
+  snprintf(out, capacity, fmt, c.min, c.avg(), c.max);
+  return out;
+}
+
+// min/trung bình/max trong cửa sổ (HistoryLog::query)
+class HistoryStatsHandler : public HttpHandler {
+public:
+  const char* start(HttpExchange& x) override {
+    uint64_t* window = (uint64_t*)x.scratch;
+    history_window(x.query, window[0], window[1]);
+    return "application/json";
+  }
+
+  size_t fill(HttpExchange& x, char* out, size_t capacity) override {
+    if (x.step++) return 0;
+    const uint64_t* window = (const uint64_t*)x.scratch;
+    HistoryStats s;
+    if (!history.query(window[0], window[1], s))
+      return snprintf(out, capacity, "{\"from\":%llu,\"to\":%llu,\"samples\":0}\n",
+                      (unsigned long long)window[0], (unsigned long long)window[1]);
+    char t[48], h[48], l[48], m[48];
+    int n = snprintf(out, capacity, "{\"from\":%llu,\"to\":%llu,\"samples\":%lu,\"temp\":%s,\"hum\":%s,"
+        "\"light\":%s,\"soil\":%s}\n",
+        (unsigned long long)s.first, (unsigned long long)s.last, (unsigned long)s.samples,
+        channel_text(t, sizeof(t), s.temp, "[%.1f,%.2f,%.1f]"), channel_text(h, sizeof(h), s.hum, "[%.1f,%.2f,%.1f]"),
+        channel_text(l, sizeof(l), s.light, "[%.0f,%.1f,%.0f]"), channel_text(m, sizeof(m), s.soil, "[%.0f,%.1f,%.0f]"));
+    return n > 0 && (size_t)n < capacity ? n : 0;
+  }
+};
+
+HistoryHandler historyJson(false), historyCsv(true);
+HistoryStatsHandler historyStats;
+#endif
+
+StatusHandler statusHandler;
+const HttpRoute httpRoutes[] = {
+  { "/",                &statusHandler },
+  { "/status",          &statusHandler },
+#if GARDEN_HISTORY
+  { "/history.json",    &historyJson },
+  { "/history.csv",     &historyCsv },
+  { "/history/stats",   &historyStats },
+#endif
+};
+HttpServer http(server, httpRoutes, sizeof(httpRoutes) / sizeof(httpRoutes[0]), httpIdleMs);
+
+// Task một lần tự hẹn lại: chưa mở được cổng (chưa có WiFi) thì thử lại sau httpRetryMs;
+// có client thì poll dày hơn để một response dài không kéo dài theo httpPollMs mỗi chunk
+void http_service() {
+  if (!http.begin(httpPort)) {
+    ioScheduler.runIn(httpTask, httpRetryMs);
+    return;
+  }
+  http.poll(halMillis());
+  ioScheduler.runIn(httpTask, http.active() ? httpBusyPollMs : httpPollMs);
+}
+#endif
+
+// --------------------- Các task: luồng io (loop()) -----------------
+void run_commands() {
+  CommandMsg msg;
+  bool handled = false;
+  HOTPATH_SCOPE(dispatchCycles);
+  while (commandQueue.pop(msg)) handled |= commands.dispatch(msg.topic, msg.payload, msg.length);
+  // áp dụng lệnh ngay ở tick này thay vì chờ chu kỳ lấy mẫu
+  if (handled) ioScheduler.runNow(controlTask);
+}
+
+uint32_t sample_period() {
+  return power.mode == POWER_ALWAYS_ON ? interval : power.sampleMs;
+}
+
+void sample_sensors() {
+    HOTPATH_SCOPE(sampleCycles);
     // Read sensor data
-    sensors_event_t temp_event, hum_event;
-    dht.temperature().getEvent(&temp_event);
-    dht.humidity().getEvent(&hum_event);
-    
-    // Nhiệt độ 
-    float temp = isnan(temp_event.temperature) ? -999.0 : temp_event.temperature;
-    float hum = isnan(hum_event.relative_humidity) ? -999.0 : hum_event.relative_humidity;
-    int lightValue = analogRead(LDR_PIN);
-    int soilMoistureValue = analogRead(SOIL_MOISTURE_PIN);
-
-    // Độ ẩm
-    int soilMax = 4095;
-    int soilPercent =( (float)(soilMoistureValue) / (soilMax) ) * 100;
-    if (soilPercent < 0) soilPercent = 0;
-    if (soilPercent > 100) soilPercent = 100;
-
-    // Ánh sáng
-    int lightMin = 0;
-    int lightMax = 4095;
-    int lightPercent = 100 - ( (float)(lightValue - lightMin) / (lightMax - lightMin) ) * 100;
-    if(lightPercent < 0) {
-      lightPercent = 0;
+    float t, h;
+    bool climateOk = sensors.readClimate(t, h);
+    bool settled = true;
+    if (settleTries) {
+      if (!climateOk && --settleTries) {
+        ioScheduler.runIn(sampleTask, wakeSettleMs);
+        return;
+      }
+      settleTries = 0;
+      settled = climateOk;
+    }
+
+    uint32_t now = halMillis();
+    uint32_t period = sample_period();
+    if (lastSampleMs) {
+      uint32_t gap = now - lastSampleMs;
+      sampleJitter.observe(gap > period ? gap - period : period - gap);
     }
-    if(lightPercent > 100) {
-      lightPercent = 100;
+    lastSampleMs = now;
+
+    // Nhiệt độ 
+    temp = isnan(t) ? -999.0 : t;
+    hum = isnan(h) ? -999.0 : h;
+    int lightValue = lightFilter.update(sensors.readAnalog(Board::LDR_PIN));
+    int soilMoistureValue = soilFilter.update(sensors.readAnalog(Board::SOIL_PIN));
+
+    {
+      HOTPATH_SCOPE(convertCycles);
+      soilPercent = config.soil.percent(soilMoistureValue);    // Độ ẩm
+      soilLevel = config.soil.level(soilMoistureValue);
+      lightPercent = config.light.percent(lightValue);         // Ánh sáng
     }
 
     //----------In giá trị ra terminal---------------
-    Serial.printf("Temperature: %.2f C\r\n", temp);
-    Serial.printf("Humidity: %.2f %%\r\n", hum);
-    Serial.printf("LDR Value: %d%%\r\n", lightPercent);
-    Serial.printf("Soil Moisture Value: %d%%\r\n", soilPercent);
+    halLog("Temperature: %.2f C", temp);
+    halLog("Humidity: %.2f %%", hum);
+    halLog("LDR Value: %d%%", lightPercent);
+    halLog("Soil Moisture Value: %d%%", soilPercent);
+
+    // gửi đi ở luồng mạng; hiển thị/điều khiển chạy thành task riêng ở cùng tick
+    SensorSample sample = { halMillis(), temp, hum, (uint8_t)lightPercent, (uint8_t)soilPercent };
+#if GARDEN_HISTORY
+    history.append(sample);
+#endif
+    if (sampleQueue.push(sample)) halWakeWorker(netWorker);
+    else halLog("Sample queue full, %lu dropped", (unsigned long)sampleQueue.dropped());
+    ioScheduler.runNow(displayTask);
+    if (settled) ioScheduler.runNow(controlTask);
+    else halLog("No climate reading after wake, control skipped");
 
-    //------------Gửi dữ liệu lên MQTT với các topic riêng biệt-----------
-    client.publish(tempTopic, String(temp).c_str());
-    client.publish(humTopic, String(hum).c_str());
-    client.publish(lightTopic, String(lightPercent).c_str());
-    client.publish(soilTopic, String(soilPercent).c_str());
+    if (power.mode != POWER_ALWAYS_ON && !radioWanted) {
+      if (++samplesSinceUpload >= power.uploadEvery || uploadNow) start_upload();
+    }
+}
 
+void refresh_display() {
     //--------Hiển thị dữ liệu lên màn hình----------
     displayStatus(temp, hum, lightPercent, soilPercent);
+}
 
+void run_control() {
+    HOTPATH_SCOPE(controlCycles);
     //------------Phân loại độ ẩm đất-----------------
     control_watering(autoWateringOn,soilPercent);
 
@@ -454,10 +1336,206 @@ void loop() {
     
     //------------Báo động quá nhiệt-----------------------
     alert_overheat(temp);
+}
 
-    // Cập nhật hiển thị OLED
-    display.clearDisplay();
-    display.setTextSize(1);
+void print_tasks(const char* thread, const Scheduler& s) {
+  halLog("%-4s task         runs  missed overrun  last_us   max_us", thread);
+  for (uint8_t i = 0; i < s.count(); i++) {
+    const Task& t = s.task(i);
+    halLog("     %-12s %5lu %7lu %7lu %8lu %8lu", t.name,
+                  (unsigned long)t.runs, (unsigned long)t.missed, (unsigned long)t.overruns,
+                  (unsigned long)t.lastRunUs, (unsigned long)t.maxRunUs);
+  }
+}
+
+void print_hotpath() {
+#ifdef HOTPATH_PROFILE
+  halLog("hot path     count  mean_ns   min_ns   max_ns  (CPU %lu MHz)", (unsigned long)halCpuMhz());
+  for (CycleStats* c : hotPath) {
+    if (!c->count) continue;
+    halLog("     %-10s %6lu %8lu %8lu %8lu", c->name, (unsigned long)c->count,
+           (unsigned long)CycleStats::toNs(c->meanCycles()), (unsigned long)CycleStats::toNs(c->minCycles),
+           (unsigned long)CycleStats::toNs(c->maxCycles));
+  }
+#endif
+}
+
+void print_stats() {
+  print_tasks("net", netScheduler);
+  print_tasks("io", ioScheduler);
+  print_hotpath();
+  halLog("stack free: net %lu B, io %lu B", (unsigned long)halStackHighWater(netWorker),
+         (unsigned long)halStackHighWater(NO_WORKER));
+  halLog("queues: samples %u/%u (max %u, dropped %lu), commands %u/%u (max %u, dropped %lu)",
+         (unsigned)sampleQueue.size(), (unsigned)sampleQueue.capacity(), (unsigned)sampleQueue.maxUsed(),
+         (unsigned long)sampleQueue.dropped(), (unsigned)commandQueue.size(), (unsigned)commandQueue.capacity(),
+         (unsigned)commandQueue.maxUsed(), (unsigned long)commandQueue.dropped());
+  halLog("backlog %u/%u (max %u), dropped %lu", (unsigned)backlog.size(), (unsigned)backlog.capacity(),
+         (unsigned)backlog.maxUsed(), (unsigned long)backlog.dropped());
+  halLog("reports (sent/unchanged/rate-limited): temp %lu/%lu/%lu, hum %lu/%lu/%lu, light %lu/%lu/%lu, soil %lu/%lu/%lu",
+         (unsigned long)tempReport.reports, (unsigned long)tempReport.suppressed, (unsigned long)tempReport.limited,
+         (unsigned long)humReport.reports, (unsigned long)humReport.suppressed, (unsigned long)humReport.limited,
+         (unsigned long)lightReport.reports, (unsigned long)lightReport.suppressed, (unsigned long)lightReport.limited,
+         (unsigned long)soilReport.reports, (unsigned long)soilReport.suppressed, (unsigned long)soilReport.limited);
+  ClimateStats dht = sensors.climateStats();
+  halLog("dht: %lu started, %lu ok, %lu timeouts, %lu frame errors, %lu checksum errors, %lu deferred",
+         (unsigned long)dht.started, (unsigned long)dht.ok, (unsigned long)dht.timeouts,
+         (unsigned long)dht.frameErrors, (unsigned long)dht.checksumErrors, (unsigned long)dht.deferred);
+  const ConnectStats& c = connection.stats();
+  halLog("connection: %lu online, %lu/%lu MQTT attempts failed, time-to-online last %lu ms (WiFi %lu ms), max %lu ms",
+         (unsigned long)c.onlines, (unsigned long)c.failures, (unsigned long)c.attempts, (unsigned long)c.lastOnlineMs,
+         (unsigned long)c.lastLinkMs, (unsigned long)c.maxOnlineMs);
+  halLog("leds: %lu frames, %lu sent, %lu LUT builds",
+         (unsigned long)ring.frames, (unsigned long)ring.shows, (unsigned long)ring.lutBuilds);
+#if GARDEN_HTTP
+  if (http.listening())
+    halLog("http: %lu connections (%u active, max %u), %lu requests, %lu responses, %lu errors, %lu busy, "
+           "%lu timeouts, %lu resets, %llu B sent",
+           (unsigned long)http.connections, http.active(), http.maxActive, (unsigned long)http.requests,
+           (unsigned long)http.responses, (unsigned long)http.errors, (unsigned long)http.rejected,
+           (unsigned long)http.timeouts, (unsigned long)http.resets, (unsigned long long)http.bytesSent);
+#endif
+#if GARDEN_HISTORY
+  HistoryStats h;
+  uint64_t newest = history.lastTime();
+  if (history.query(newest > 3600000 ? newest - 3600000 : 0, newest, h))
+    halLog("history: %lu samples, %lu frames, %lu B, %lu rotations, wear %lu..%lu; last hour %lu samples, "
+           "temp %.1f/%.1f/%.1f C, soil %.0f/%.0f/%.0f %% (min/avg/max)",
+           (unsigned long)history.samples, (unsigned long)history.frames, (unsigned long)history.bytes,
+           (unsigned long)history.rotations, (unsigned long)history.minWear, (unsigned long)history.maxWear,
+           (unsigned long)h.samples, h.temp.min, h.temp.avg(), h.temp.max, h.soil.min, h.soil.avg(), h.soil.max);
+#endif
+  halLog("irrigation: %lu pulses, %lu ms open, drying %.2f%%/h, gain %.2f%%/s (%lu rate, %lu gain updates)",
+         (unsigned long)irrigation.pulses, (unsigned long)irrigation.openMs, irrigation.dryRate(), irrigation.gain(),
+         (unsigned long)irrigation.rateUpdates, (unsigned long)irrigation.gainUpdates);
+  halLog("config: crc %08lx, %lu updates, %lu rejected", (unsigned long)(uint32_t)configCrc.value,
+         (unsigned long)configUpdates.value, (unsigned long)configRejected.value);
+}
+
+// --------------------- Chế độ ngủ (luồng io) -----------------
+void start_upload() {
+  radioWanted = true;
+  windowStartMs = halMillis();
+  windowSessions = sessions;
+  windowOnline = false;
+  samplesSinceUpload = 0;
+  uploadNow = false;
+  ioScheduler.runNow(windowTask);
+}
 
+// Theo dõi cửa sổ gửi mỗi linkPollMs: kết nối xong thì lấy mẫu mới (các kênh đã invalidate
+// nên gửi đủ giá trị hiện tại), gửi hết và nghe lệnh listenMs rồi tắt WiFi. Task còn hẹn
+// tới khi luồng mạng báo WiFi đã tắt để power_manage() không ngủ trước lúc đó.
+void upload_window() {
+  if (!radioWanted) {
+    if (!radioOff) ioScheduler.runIn(windowTask, netPollMs);
+    return;
+  }
+  uint32_t now = halMillis();
+  if (!windowOnline && sessions != windowSessions) {
+    windowOnline = true;
+    onlineMs = now;
+    ioScheduler.runNow(sampleTask);
   }
-}
\ No newline at end of file
+  // đang nhận OTA: giữ WiFi quá maxAwakeMs tới khi host ngừng gửi otaIdleMs
+  bool updating = otaChunkMs && now - otaChunkMs < otaIdleMs;
+  bool done = windowOnline && uploadIdle && now - onlineMs >= power.listenMs && !updating;
+  if (!done && (now - windowStartMs < power.maxAwakeMs || updating)) {
+    ioScheduler.runIn(windowTask, linkPollMs);
+    return;
+  }
+  if (!done) halLog("Upload window timed out after %lu ms", (unsigned long)(now - windowStartMs));
+  radioWanted = false;
+  ioScheduler.runIn(windowTask, netPollMs);
+  print_stats();
+}
+
+// Backlog thuộc luồng mạng: chỉ gọi khi WiFi đã tắt và không còn mẫu trong sampleQueue
+void rtc_save() {
+  RtcState* s = (RtcState*)halRtcMemory();
+  s->magic = RTC_MAGIC;
+  s->boots++;
+  s->autoLightOn = autoLightOn;
+  s->autoWateringOn = autoWateringOn;
+  s->switchWateringState = switchWateringState;
+  s->switchLightState = switchLightState;
+  memcpy(s->lightColor, lightColor, sizeof(lightColor));
+  s->samplesSinceUpload = samplesSinceUpload;
+  s->irrigation = irrigation.state();
+  size_t skip = backlog.size() > RTC_BACKLOG ? backlog.size() - RTC_BACKLOG : 0;   // giữ phần mới nhất
+  if (skip) halLog("RTC backlog full, %u oldest records dropped", (unsigned)skip);
+  s->backlogCount = backlog.size() - skip;
+  for (size_t i = 0; i < s->backlogCount; i++) s->backlog[i] = backlog.peek(skip + i);
+}
+
+bool rtc_restore() {
+  const RtcState* s = (const RtcState*)halRtcMemory();
+  if (s->magic != RTC_MAGIC || s->backlogCount > RTC_BACKLOG) return false;
+  autoLightOn = s->autoLightOn;
+  autoWateringOn = s->autoWateringOn;
+  switchWateringState = s->switchWateringState;
+  switchLightState = s->switchLightState;
+  memcpy(lightColor, s->lightColor, sizeof(lightColor));
+  lightColor[sizeof(lightColor) - 1] = '\0';
+  manualColor = parse_light_color(lightColor);
+  samplesSinceUpload = s->samplesSinceUpload;
+  irrigation.restore(s->irrigation);
+  backlog.discard(backlog.size());
+  for (size_t i = 0; i < s->backlogCount; i++) backlog.push(s->backlog[i]);
+  return true;
+}
+
+// Đánh thức sớm khi đất chuyển khô/ẩm (tưới tự động) hoặc trời chuyển sáng/tối (đèn tự động):
+// chỉ theo dõi chiều ngược với trạng thái hiện tại
+uint16_t wake_raw(int raw) { return raw < 0 ? 0 : raw > 4095 ? 4095 : raw; }
+
+void arm_wake_thresholds() {
+  WakeThreshold t[HAL_MAX_WAKE_THRESHOLDS];
+  uint8_t n = 0;
+  if (autoWateringOn) {
+    int dryRaw = config.soil.raw(config.soilDryPercent);       // đất thô dưới mức này: tưới
+    if (soilPercent < config.soilDryPercent) t[n++] = { Board::SOIL_PIN, 0, wake_raw(dryRaw + wakeHysteresisRaw) };
+    else t[n++] = { Board::SOIL_PIN, wake_raw(dryRaw - wakeHysteresisRaw), 4095 };
+  }
+  if (autoLightOn) {
+    int darkRaw = config.light.raw(config.lightDimPercent);    // LDR thô từ đây trở lên: đèn xanh
+    if (lightPercent <= config.lightDimPercent) t[n++] = { Board::LDR_PIN, wake_raw(darkRaw - wakeHysteresisRaw), 4095 };
+    else t[n++] = { Board::LDR_PIN, 0, wake_raw(darkRaw + wakeHysteresisRaw) };
+  }
+  halSetWakeThresholds(t, n, wakePollMs);
+}
+
+// Gọi cuối mỗi loop(): ngủ tới task kế tiếp khi WiFi đã tắt và không còn việc dở
+void power_manage() {
+  if (power.mode == POWER_ALWAYS_ON || radioWanted || !radioOff) return;
+  // không ngủ khi van đang mở, còi báo động đang kêu hoặc còn việc giữa hai luồng
+  if (wateringActive || temp > config.overheatC || !sampleQueue.empty() || !commandQueue.empty()) return;
+
+  uint32_t ms = ioScheduler.msUntilNext();
+  uint32_t netMs = netScheduler.msUntilNext();
+  if (netMs < ms) ms = netMs;
+  if (ms == UINT32_MAX || ms < power.minSleepMs) return;
+
+  arm_wake_thresholds();
+  if (power.mode == POWER_DEEP_SLEEP) {
+    rtc_save();
+#if GARDEN_HISTORY
+    history.sync();   // frame dở trong RAM mất khi chip khởi động lại
+#endif
+  }
+  WakeCause cause = halSleep(power.mode == POWER_DEEP_SLEEP ? SLEEP_DEEP : SLEEP_LIGHT, ms);
+  // ESP32 không trở về từ deep sleep; native coi như vừa khởi động lại và đọc lại RTC memory
+  if (power.mode == POWER_DEEP_SLEEP && rtc_restore()) settleTries = wakeSettleTries;
+  if (cause == WAKE_THRESHOLD) {
+    uploadNow = true;
+    ioScheduler.runNow(sampleTask);
+  }
+}
+
+// --------------------- Hàm loop (hàm hoạt động hiển thị và lấy dữ liệu) -----------------
+void loop() {
+  if (netWorker == NO_WORKER) net_worker();   // backend không có luồng riêng
+  uint32_t start = halMicros();
+  if (ioScheduler.tick()) tickTime.observe(halMicros() - start);
+  power_manage();
+}
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef ARDUINO
+// Khung benchmark tối giản cho env:bench: đo ns/op bằng steady_clock và đếm
+// số lần cấp phát heap (operator new) trong vòng đo.
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+
+extern uint64_t benchAllocCount;
+extern uint64_t benchAllocBytes;
+
+// Ngăn compiler bỏ đi kết quả không dùng
+template <typename T> inline void benchKeep(const T& v) { asm volatile("" : : "g"(&v) : "memory"); }
+
+struct BenchResult {
+  double nsPerOp;
+  double allocsPerOp;
+  double bytesPerOp;
+};
+
+template <typename Fn>
+BenchResult benchRun(const char* name, uint32_t iterations, Fn fn) {
+  for (uint32_t i = 0; i < iterations / 10 + 1; i++) fn();  // warm-up
+
+  uint64_t allocs0 = benchAllocCount, bytes0 = benchAllocBytes;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) fn();
+  auto t1 = std::chrono::steady_clock::now();
+
+  BenchResult r;
+  r.nsPerOp = std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+  r.allocsPerOp = (double)(benchAllocCount - allocs0) / iterations;
+  r.bytesPerOp = (double)(benchAllocBytes - bytes0) / iterations;
+  printf("%-40s %10.1f ns/op %8.2f allocs/op %8.1f B/op\n", name, r.nsPerOp, r.allocsPerOp, r.bytesPerOp);
+  return r;
+}
+
+// Các nhóm benchmark (mỗi file bench_*.cpp một nhóm)
+void benchDispatch();
+void benchDisplay();
+void benchFilters();
+void benchGateway();
+void benchHistory();
+void benchHttp();
+void benchHotpath();
+#endif
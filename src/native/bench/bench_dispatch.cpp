@@ -0,0 +1,63 @@
+#ifndef ARDUINO
+// callback() MQTT: bảng dispatch hiện tại so với cách cũ (String ghép từng byte,
+// tạo String(topic) cho mỗi lần so sánh) mô phỏng bằng std::string.
+#include <string>
+#include <string.h>
+#include "garden.h"
+#include "bench.h"
+
+void callback(char* topic, uint8_t* payload, unsigned int length);
+void run_commands();
+
+static bool legacyAutoLight, legacyAutoWatering, legacySwitchLight, legacySwitchWatering;
+static char legacyColor[10];
+
+static void legacy_callback(char* topic, uint8_t* payload, unsigned int length) {
+  std::string message;
+  for (unsigned int i = 0; i < length; i++) message += (char)payload[i];
+  if (std::string(topic) == "garden/all/signal/auto_watering") {
+    if (message == "true") legacyAutoWatering = true; else if (message == "false") legacyAutoWatering = false;
+  }
+  if (std::string(topic) == "garden/all/signal/switch_watering") {
+    if (message == "true") legacySwitchWatering = true; else if (message == "false") legacySwitchWatering = false;
+  }
+  if (std::string(topic) == "garden/all/signal/auto_light") {
+    if (message == "true") legacyAutoLight = true; else if (message == "false") legacyAutoLight = false;
+  }
+  if (std::string(topic) == "garden/all/signal/switch_light") {
+    if (message == "true") legacySwitchLight = true; else if (message == "false") legacySwitchLight = false;
+  }
+  if (std::string(topic) == "garden/all/signal/light_color") {
+    strncpy(legacyColor, message.c_str(), sizeof(legacyColor) - 1);
+  }
+}
+
+struct Msg {
+  char topic[48];
+  uint8_t payload[16];
+  unsigned int length;
+};
+
+static Msg messages[] = {
+  { "garden/all/signal/auto_light", "true", 4 },
+  { "garden/all/signal/switch_watering", "false", 5 },
+  { "garden/all/signal/light_color", "Yellow", 6 },
+  { "garden/all/signal/unknown/topic", "x", 1 },
+};
+static const size_t N = sizeof(messages) / sizeof(messages[0]);
+
+void benchDispatch() {
+  size_t i = 0;
+  benchRun("callback: legacy String compare", 500000, [&] {
+    Msg& m = messages[i++ % N];
+    legacy_callback(m.topic, m.payload, m.length);
+  });
+  i = 0;
+  // callback() chỉ xếp lệnh vào commandQueue; run_commands() (luồng io) dispatch
+  benchRun("callback: queue + hashed dispatch", 500000, [&] {
+    Msg& m = messages[i++ % N];
+    callback(m.topic, m.payload, m.length);
+    run_commands();
+  });
+}
+#endif
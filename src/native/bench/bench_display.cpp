@@ -0,0 +1,47 @@
+#ifndef ARDUINO
+// Làm mới OLED: vẽ lại toàn màn hình + đẩy 1 KB (cách cũ) so với StatusView
+// chỉ vẽ/gửi trường thay đổi. Đo trên FramebufferDisplay của HAL giả lập.
+#include <stdio.h>
+#include <StatusView.h>
+#include <Icons.h>
+#include "../hal/hal_native.h"
+#include "bench.h"
+
+static void fullRedraw(FramebufferDisplay& d, const StatusFields& f) {
+  char line[24];
+  d.clear();
+  d.drawBitmap(0, 0,  icon_temp16,  16, 16, true); snprintf(line, sizeof(line), "Temp: %.1f C", f.temp); d.text(20, 4, line);
+  d.drawBitmap(0, 16, icon_humid16, 16, 16, true); snprintf(line, sizeof(line), "H: %.0f %%", f.hum); d.text(20, 20, line);
+  d.drawBitmap(0, 32, icon_light16, 16, 16, true); snprintf(line, sizeof(line), "Light: %d %%", f.light); d.text(20, 36, line);
+  d.drawBitmap(0, 48, icon_soil16,  16, 16, true); snprintf(line, sizeof(line), "Soil: %d %%", f.soil); d.text(20, 52, line);
+  d.drawBitmap(110, 0, f.wifi ? wifi_icon : wifi_dc, 16, 16, true);
+  d.flush();
+}
+
+void benchDisplay() {
+  const uint32_t iters = 100000;
+  StatusFields f = { 26.4f, 55.0f, 70, 42, true, false, false };
+
+  FramebufferDisplay legacy;
+  benchRun("display: full redraw", iters, [&] { fullRedraw(legacy, f); });
+  printf("%-40s %10.1f B/refresh\n", "  i2c payload", (double)legacy.bytesSent / legacy.flushes);
+
+  FramebufferDisplay d1;
+  StatusView same(d1);
+  same.render(f);
+  uint32_t before = same.bytesPushed;
+  benchRun("display: StatusView, no change", iters, [&] { same.render(f); });
+  printf("%-40s %10.1f B/refresh\n", "  i2c payload", (double)(same.bytesPushed - before) / (iters + iters / 10 + 1));
+
+  FramebufferDisplay d2;
+  StatusView one(d2);
+  one.render(f);
+  before = one.bytesPushed;
+  int i = 0;
+  benchRun("display: StatusView, temp changes", iters, [&] {
+    f.temp = 20.0f + (i++ % 100) * 0.1f;
+    one.render(f);
+  });
+  printf("%-40s %10.1f B/refresh\n", "  i2c payload", (double)(one.bytesPushed - before) / (iters + iters / 10 + 1));
+}
+#endif
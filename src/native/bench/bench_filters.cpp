@@ -0,0 +1,63 @@
+#ifndef ARDUINO
+// Trung vị cửa sổ N: medianRead<N>() cũ (chép N mẫu rồi sắp xếp đổi chỗ O(N²)
+// cho mỗi kết quả) so với MedianFilter<N> trượt O(log N), N = 7, 31, 127.
+// Thêm cả chuỗi median -> EMA -> deadband của test/main.cpp viết tay vs FilterChain.
+#include <math.h>
+#include <stdlib.h>
+#include <Filters.h>
+#include "bench.h"
+
+static const size_t SIGNAL_LEN = 4096;
+static int signal[SIGNAL_LEN];
+
+// Cùng thuật toán medianRead<N>(), analogRead() thay bằng đọc từ mảng
+template <int N> static int legacyMedian(size_t at) {
+  int a[N];
+  for (int i = 0; i < N; i++) a[i] = signal[(at + i) % SIGNAL_LEN];
+  for (int i = 0; i < N - 1; i++)
+    for (int j = i + 1; j < N; j++)
+      if (a[j] < a[i]) { int t = a[i]; a[i] = a[j]; a[j] = t; }
+  return a[N / 2];
+}
+
+template <int N> static void compareMedian(uint32_t iters) {
+  char name[48];
+  size_t at = 0;
+  snprintf(name, sizeof(name), "median N=%d: medianRead (sort)", N);
+  benchRun(name, iters, [&] { int m = legacyMedian<N>(at++); benchKeep(m); });
+
+  MedianFilter<int, N> filter;
+  at = 0;
+  snprintf(name, sizeof(name), "median N=%d: MedianFilter", N);
+  benchRun(name, iters, [&] { int m = filter.update(signal[at++ % SIGNAL_LEN]); benchKeep(m); });
+}
+
+void benchFilters() {
+  srand(1);
+  for (size_t i = 0; i < SIGNAL_LEN; i++) signal[i] = 2000 + (int)(800 * sinf(i * 0.01f)) + rand() % 64 - 32;
+
+  compareMedian<7>(1000000);
+  compareMedian<31>(200000);
+  compareMedian<127>(20000);
+
+  // chuỗi LDR của test/main.cpp: median 7 -> EMA 0.15 -> deadband 4
+  size_t at = 0;
+  float emaRaw = -1;
+  int lastStable = -1;
+  benchRun("ldr chain: hand-written", 1000000, [&] {
+    int med = legacyMedian<7>(at++);
+    if (emaRaw < 0) emaRaw = med;
+    emaRaw = 0.15f * med + (1.0f - 0.15f) * emaRaw;
+    int raw = lroundf(emaRaw);
+    if (lastStable >= 0 && abs(raw - lastStable) <= 4) raw = lastStable; else lastStable = raw;
+    benchKeep(raw);
+  });
+
+  FilterChain<MedianFilter<int, 7>, EmaFilter<int, 3, 20>, Deadband<int, 4>> chain;
+  at = 0;
+  benchRun("ldr chain: FilterChain", 1000000, [&] {
+    int raw = chain.update(signal[at++ % SIGNAL_LEN]);
+    benchKeep(raw);
+  });
+}
+#endif
@@ -0,0 +1,39 @@
+#ifndef ARDUINO
+// lib/Gateway: nhận một số đo text/khung nhị phân và ghi batch cuối chu kỳ cho 500 node
+// (chương trình tải đầy đủ: src/native/gateway).
+#include <stdio.h>
+#include <string.h>
+#include <Gateway.h>
+#include "bench.h"
+
+void benchGateway() {
+  const uint16_t nodes = 500;
+  static NodeSlot slots[1024];
+  Gateway gateway(slots, 1024, "garden");
+
+  static char topics[nodes][48];
+  for (uint16_t i = 0; i < nodes; i++) snprintf(topics[i], sizeof(topics[i]), "garden/sim-%06u/sensors/temperature", i + 1);
+  const uint8_t value[] = "24.37";
+  uint32_t i = 0;
+  benchRun("ingest: text reading, 500 nodes", 1000000, [&] {
+    gateway.ingest(topics[i % nodes], value, 5, i);
+    i++;
+  });
+
+  TelemetryBatcher batcher(TELEMETRY_MAX_BATCH);
+  for (uint8_t k = 0; k < TELEMETRY_MAX_BATCH; k++) batcher.add(SensorSample{ k * 5000u, 24.5f, 60.0f, 70, 40 });
+  uint8_t frame[TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_BATCH * TELEMETRY_SAMPLE_SIZE];
+  size_t frameLen = batcher.encode(frame, sizeof(frame));
+  benchRun("ingest: frame of 16 samples", 200000, [&] {
+    gateway.ingest("garden/sim-000001/sensors/frame", frame, frameLen, i++);
+  });
+
+  char chunk[4096];
+  benchRun("close interval + batch 500 nodes", 2000, [&] {
+    for (uint16_t k = 0; k < nodes; k++) gateway.ingest(topics[k], value, 5, i);
+    gateway.closeInterval(i++);
+    size_t n;
+    while ((n = gateway.nextChunk(chunk, sizeof(chunk))) > 0) benchKeep(n);
+  });
+}
+#endif
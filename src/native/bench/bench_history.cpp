@@ -0,0 +1,53 @@
+#ifndef ARDUINO
+// lib/History: ghi mẫu (mã hóa + ghi flash giả lập), đọc lại bằng HistoryCursor và truy vấn
+// cửa sổ 24 h. Mẫu 5 s theo chu kỳ ngày, làm tròn như cảm biến thật (0,1 C, 0,1 %).
+#include <math.h>
+#include <stdio.h>
+#include <History.h>
+#include "../hal/hal_native.h"
+#include "bench.h"
+
+static SensorSample daySample(uint32_t i) {
+  const uint32_t step = 5000;
+  float phase = 2 * (float)M_PI * (float)((uint64_t)i * step % 86400000) / 86400000.0f;
+  SensorSample s;
+  s.ms = i * step;
+  s.temp = roundf((24.0f + 6.0f * sinf(phase) + 0.1f * (i % 7 == 0)) * 10) / 10;
+  s.hum = roundf((60.0f - 15.0f * sinf(phase)) * 10) / 10;
+  s.light = (uint8_t)(sinf(phase) > 0 ? 90 * sinf(phase) : 0);
+  s.soil = (uint8_t)(45 - (i / 720) % 15);
+  return s;
+}
+
+void benchHistory() {
+  static SimFlash flash;
+  static HistorySector sectors[384];
+  HistoryLog log(flash, sectors, 384);
+  log.begin();
+
+  const uint32_t samples = 500000;   // ~29 ngày
+  uint32_t i = 0;
+  benchRun("append: encode + flash frame", samples, [&] { log.append(daySample(i++)); });
+  log.sync();
+  printf("  %u samples -> %u B (%.2f B/sample; SensorSample %u B, telemetry frame %.1f B/sample), %u rotations\n",
+         log.samples, log.bytes, (double)log.bytes / log.samples, (unsigned)sizeof(SensorSample),
+         (double)telemetryFrameSize(TELEMETRY_MAX_BATCH) / TELEMETRY_MAX_BATCH, log.rotations);
+
+  uint32_t decoded = 0;
+  BenchResult r = benchRun("cursor: decode whole log", 5, [&] {
+    HistoryCursor cursor(log, 0, log.lastTime());
+    HistorySample s;
+    decoded = 0;
+    while (cursor.next(s)) decoded++;
+    benchKeep(s);
+  });
+  printf("  %u samples per pass, %.1f ns/sample\n", decoded, decoded ? r.nsPerOp / decoded : 0.0);
+
+  HistoryStats stats;
+  benchRun("query: last 24 h (min/max/avg)", 200, [&] {
+    log.query(log.lastTime() - 86400000, log.lastTime(), stats);
+    benchKeep(stats);
+  });
+  printf("  %u samples, temp %.1f..%.1f avg %.2f\n", stats.samples, stats.temp.min, stats.temp.max, stats.temp.avg());
+}
+#endif
@@ -0,0 +1,165 @@
+#ifndef ARDUINO
+// Các bước của một chu kỳ lấy mẫu → gửi → hiển thị → điều khiển trong src/main.cpp,
+// từng bước riêng và cả chu kỳ, trên HAL giả lập. Trên ESP32 cùng các bước được đo
+// bằng bộ đếm chu kỳ CPU (env esp32-profile, bảng "hot path" trong print_stats()).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Irrigation.h>
+#include <LedEngine.h>
+#include "garden.h"
+#include "../hal/hal_native.h"
+#include "bench.h"
+
+void sample_sensors();
+void publish_sample(const SensorSample& sample);
+void displayStatus(float temp, float hum, int lightPercent, int soilPercent);
+void control_light(bool autoLightOn, int lightPercent);
+void callback(char* topic, uint8_t* payload, unsigned int length);
+void run_commands();
+void setup_topics();
+
+extern Rgb leds[Board::RING_PIXELS];
+extern LedEngine ring;
+extern float temp, hum;
+extern int lightPercent, soilPercent;
+
+// Cách gửi cũ: client.publish(topic, String(value).c_str()). String của Arduino (WString) không có
+// SSO như std::string: mỗi giá trị được chép vào buffer realloc() len + 1 byte trên heap, nên
+// cấp phát được đếm trực tiếp vào benchAllocCount (hook operator new không thấy realloc)
+class LegacyString {
+public:
+  explicit LegacyString(const char* s) : len(strlen(s)) {
+    buffer = (char*)realloc(nullptr, len + 1);
+    benchAllocCount++;
+    benchAllocBytes += len + 1;
+    memcpy(buffer, s, len + 1);
+  }
+  LegacyString(LegacyString&& other) noexcept : buffer(other.buffer), len(other.len) { other.buffer = nullptr; }
+  LegacyString(const LegacyString&) = delete;
+  LegacyString& operator=(const LegacyString&) = delete;
+  ~LegacyString() { free(buffer); }
+
+  const char* c_str() const { return buffer; }
+  size_t length() const { return len; }
+
+private:
+  char* buffer;
+  size_t len;
+};
+
+static LegacyString legacyString(float v) {
+  char buf[33];
+  snprintf(buf, sizeof(buf), "%.2f", v);
+  return LegacyString(buf);
+}
+static LegacyString legacyString(int v) {
+  char buf[2 + 8 * sizeof(int)];
+  snprintf(buf, sizeof(buf), "%d", v);
+  return LegacyString(buf);
+}
+
+// Cách đổ màu cũ của control_light(): ghi cả vòng rồi gửi mỗi lần điều khiển
+static void legacyFill(Rgb* pixels, int count, Rgb color) {
+  for (int i = 0; i < count; i++) pixels[i] = color;
+}
+
+void benchHotpath() {
+  const uint32_t iters = 200000;
+  LoopbackTransport& net = simTransport();
+  net.connect("bench");
+  setup_topics();
+  simSensors().set(TraceRow{ 0, 26.4f, 55.0f, 1800, 2300 });
+
+  int raw = 0;
+  benchRun("sensor math: soil + light percent", 2000000, [&] {
+    raw = (raw + 37) & 4095;
+    int s = config.soil.percent(raw);
+    int l = config.light.percent(raw);
+    benchKeep(s);
+    benchKeep(l);
+  });
+
+  benchRun("sample_sensors (read + filter + queue)", iters, [&] {
+    sample_sensors();
+    SensorSample s;
+    while (sampleQueue.pop(s)) benchKeep(s);
+  });
+
+  char topic[] = "garden/all/signal/light_color";
+  uint8_t payload[] = "Yellow";
+  benchRun("callback -> run_commands", iters, [&] {
+    callback(topic, payload, 6);
+    run_commands();
+  });
+
+  SensorSample sample = { 0, 26.4f, 55.0f, 70, 42 };
+  benchRun("publish: String(value) (legacy)", iters, [&] {
+    LegacyString t = legacyString(sample.temp), h = legacyString(sample.hum);
+    LegacyString l = legacyString((int)sample.light), s = legacyString((int)sample.soil);
+    net.publish("sensors/temperature", (const uint8_t*)t.c_str(), t.length(), false);
+    net.publish("sensors/humidity", (const uint8_t*)h.c_str(), h.length(), false);
+    net.publish("sensors/light", (const uint8_t*)l.c_str(), l.length(), false);
+    net.publish("sensors/soil_moisture", (const uint8_t*)s.c_str(), s.length(), false);
+  });
+  // mỗi lần cả bốn kênh lệch quá ngưỡng và cách lần trước quá minIntervalMs: cả bốn được định dạng và
+  // gửi như dòng legacy; mẫu không đổi chỉ đo nhánh bị ChangeReporter chặn
+  uint32_t k = 0;
+  benchRun("publish_sample (snprintf, 4 sent)", iters, [&] {
+    k++;
+    SensorSample changed = { k * 30000, (k & 1) ? 22.0f : 26.0f, (k & 1) ? 40.0f : 60.0f,
+                             (uint8_t)((k & 1) ? 30 : 70), (uint8_t)((k & 1) ? 40 : 60) };
+    publish_sample(changed);
+  });
+  SensorSample unchanged = { k * 30000 + 1000, (k & 1) ? 22.0f : 26.0f, (k & 1) ? 40.0f : 60.0f,
+                             (uint8_t)((k & 1) ? 30 : 70), (uint8_t)((k & 1) ? 40 : 60) };
+  benchRun("publish_sample, unchanged (suppressed)", iters, [&] { publish_sample(unchanged); });
+
+  int i = 0;
+  benchRun("displayStatus, unchanged", iters, [&] { displayStatus(26.4f, 55.0f, 70, 42); });
+  benchRun("displayStatus, temp changes", iters, [&] { displayStatus(20.0f + (i++ % 100) * 0.1f, 55.0f, 70, 42); });
+
+  RecordingActuators& act = simActuators();
+  benchRun("fill_solid + showLeds (legacy)", iters, [&] {
+    legacyFill(leds, Board::RING_PIXELS, (i++ & 1) ? Rgb{ 255, 255, 0 } : Rgb{ 0, 0, 255 });
+    act.showLeds(leds, Board::RING_PIXELS);
+  });
+  uint32_t ms = 0;
+  benchRun("LedEngine render, unchanged", iters, [&] {
+    if (ring.render(ms++)) act.showLeds(ring.pixels(), ring.count());
+  });
+  // màu và độ sáng cùng chuyển: mỗi khung dựng lại bảng LUT và gửi ra LED
+  Rgb pixels[Board::RING_PIXELS];
+  LedEngine fader(pixels, Board::RING_PIXELS, 20);
+  benchRun("LedEngine render + showLeds, fading", iters, [&] {
+    if (!fader.animating()) {
+      fader.setColor((i++ & 1) ? Rgb{ 255, 255, 0 } : Rgb{ 0, 0, 255 }, 400, ms);
+      fader.setBrightness((i & 2) ? 255 : 40, 400, ms);
+    }
+    ms += 20;
+    if (fader.render(ms)) act.showLeds(fader.pixels(), fader.count());
+  });
+  benchRun("control_light (auto)", iters, [&] { control_light(true, (i++ * 7) % 101); });
+
+  // bộ điều khiển tưới riêng (không mở servo): đất khô dần, mỗi mẫu 5 s, thỉnh thoảng tưới + ngấm
+  const IrrigationPolicy policy = { 30.0f, 33.0f, 1800000, 1800000, 1800000, 500, 30000, 0.5f, 2.0f };
+  IrrigationController irrigation(policy);
+  float soil = 40.0f;
+  uint32_t sampleMs = 0;
+  benchRun("IrrigationController update", iters, [&] {
+    sampleMs += 5000;
+    soil -= 0.003f;
+    uint32_t pulse = irrigation.update(soil, 24.0f + (sampleMs / 600000 % 12), 60.0f, sampleMs);
+    soil += pulse * 0.0005f;
+    benchKeep(pulse);
+  });
+
+  benchRun("full cycle: sample..control", iters, [&] {
+    sample_sensors();
+    SensorSample s;
+    while (sampleQueue.pop(s)) publish_sample(s);
+    displayStatus(temp, hum, lightPercent, soilPercent);
+    control_light(true, lightPercent);
+  });
+}
+#endif
@@ -0,0 +1,76 @@
+#ifndef ARDUINO
+// lib/HttpServer: một request keep-alive tới hết response qua ServerHal trong bộ nhớ (không
+// có socket), body ngắn và body dài nhiều chunk; đo riêng phần server + handler.
+#include <stdio.h>
+#include <string.h>
+#include <HttpServer.h>
+#include "bench.h"
+
+// Một kết nối: read() trả request đã nạp, write() nhận hết và bỏ đi
+class MemoryServer : public ServerHal {
+public:
+  bool listen(uint16_t) override { return true; }
+  int accept() override { return pendingAccept ? (pendingAccept = false, 1) : -1; }
+  int read(int, void* out, size_t capacity) override {
+    size_t n = requestLen < capacity ? requestLen : capacity;
+    memcpy(out, request, n);
+    requestLen -= n;
+    return (int)n;
+  }
+  int write(int, const void*, size_t length) override {
+    bytes += length;
+    return (int)length;
+  }
+  void close(int) override {}
+
+  bool pendingAccept = true;
+  const char* request = nullptr;
+  size_t requestLen = 0;
+  uint64_t bytes = 0;
+};
+
+// rows dòng CSV giống /history.csv
+class RowsHandler : public HttpHandler {
+public:
+  explicit RowsHandler(uint32_t rows) : rows(rows) {}
+  const char* start(HttpExchange&) override { return "text/csv"; }
+  size_t fill(HttpExchange& x, char* out, size_t capacity) override {
+    size_t len = 0;
+    while (x.step < rows && capacity - len > 48) {
+      len += snprintf(out + len, capacity - len, "%lu,24.5,61.0,70,40\n", 1000ul + 5000ul * x.step);
+      x.step++;
+    }
+    return len;
+  }
+
+private:
+  uint32_t rows;
+};
+
+void benchHttp() {
+  MemoryServer server;
+  RowsHandler small(1), large(720);
+  const HttpRoute routes[] = { { "/small", &small }, { "/large", &large } };
+  HttpServer http(server, routes, 2);
+  http.begin(80);
+  http.poll(0);   // nhận kết nối
+
+  static const char smallReq[] = "GET /small HTTP/1.1\r\nHost: node\r\n\r\n";
+  static const char largeReq[] = "GET /large?minutes=60 HTTP/1.1\r\nHost: node\r\n\r\n";
+  uint32_t now = 0;
+  benchRun("request: 1-row body, keep-alive", 200000, [&] {
+    server.request = smallReq;
+    server.requestLen = sizeof(smallReq) - 1;
+    http.poll(now++);
+  });
+  uint64_t bytes0 = server.bytes;
+  uint32_t responses0 = http.responses;
+  benchRun("request: 720 rows (~1 h CSV), chunked", 2000, [&] {
+    server.request = largeReq;
+    server.requestLen = sizeof(largeReq) - 1;
+    uint32_t before = http.responses;
+    while (http.responses == before) http.poll(now++);
+  });
+  printf("  %.0f B per 720-row response\n", (double)(server.bytes - bytes0) / (http.responses - responses0));
+}
+#endif
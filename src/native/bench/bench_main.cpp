@@ -0,0 +1,46 @@
+#ifndef ARDUINO
+// env:bench — micro-benchmark các đường nóng của firmware trên host.
+//   pio run -e bench && .pio/build/bench/program [nhóm...]
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+uint64_t benchAllocCount = 0;
+uint64_t benchAllocBytes = 0;
+
+void* operator new(size_t n) {
+  benchAllocCount++;
+  benchAllocBytes += n;
+  if (void* p = malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+struct BenchGroup {
+  const char* name;
+  void (*run)();
+};
+
+static const BenchGroup groups[] = {
+  { "dispatch", benchDispatch },
+  { "display",  benchDisplay },
+  { "filters",  benchFilters },
+  { "gateway",  benchGateway },
+  { "history",  benchHistory },
+  { "http",     benchHttp },
+  { "hotpath",  benchHotpath },
+};
+
+int main(int argc, char** argv) {
+  for (const BenchGroup& g : groups) {
+    bool selected = argc < 2;
+    for (int i = 1; i < argc; i++) selected = selected || !strcmp(argv[i], g.name);
+    if (!selected) continue;
+    printf("== %s\n", g.name);
+    g.run();
+  }
+  return 0;
+}
+#endif
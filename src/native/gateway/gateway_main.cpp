@@ -0,0 +1,173 @@
+#ifndef ARDUINO
+// Gateway/aggregator trên host (lib/Gateway) chạy tải với N node mô phỏng qua broker
+// giả trong bộ nhớ, theo đồng hồ ảo: gateway đăng ký <root>/+/sensors/#, gom số đo
+// thành batch mỗi --interval-ms và publish lên <root>/gateway/batch (JSON, tối đa
+// --max-payload byte mỗi message). Mỗi giờ gửi một lệnh chung <root>/all/signal/...
+//
+//   garden_gateway [--nodes 200] [--hours 24] [--trace sim/traces/day_cycle.csv]
+//                  [--sample-ms 5000] [--interval-ms 60000] [--max-payload 4096]
+//                  [--capacity SLOTS] [--outages-per-day 1] [--dump FILE]
+//
+// --capacity N   số ô node của gateway (mặc định gấp đôi --nodes); node thừa bị từ chối
+// --dump FILE    ghi mọi message batch, mỗi dòng một JSON ("-" = stdout)
+#include <chrono>
+#include <memory>
+#include <queue>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Gateway.h>
+#include "local_broker.h"
+#include "sim_fleet.h"
+
+typedef std::chrono::steady_clock WallClock;
+
+static double nsSince(WallClock::time_point start) {
+  return std::chrono::duration<double, std::nano>(WallClock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+  const char* root = "garden";
+  const char* tracePath = "sim/traces/day_cycle.csv";
+  const char* dumpPath = nullptr;
+  uint32_t nodeCount = 200;
+  double hours = 24;
+  uint32_t intervalMs = 60000;
+  size_t maxPayload = 4096;
+  uint32_t capacity = 0;
+  FleetConfig fleet;
+  bool badOption = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--nodes") && i + 1 < argc) nodeCount = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--hours") && i + 1 < argc) hours = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--trace") && i + 1 < argc) tracePath = argv[++i];
+    else if (!strcmp(argv[i], "--sample-ms") && i + 1 < argc) fleet.sampleMs = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--interval-ms") && i + 1 < argc) intervalMs = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--max-payload") && i + 1 < argc) maxPayload = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--capacity") && i + 1 < argc) capacity = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--outages-per-day") && i + 1 < argc) fleet.outagesPerDay = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--dump") && i + 1 < argc) dumpPath = argv[++i];
+    else badOption = true;
+  }
+  if (!capacity) capacity = nodeCount * 2;
+  if (badOption || !nodeCount || !fleet.sampleMs || !intervalMs || maxPayload < 64 || capacity > UINT16_MAX) {
+    fprintf(stderr, "usage: %s [--nodes N] [--hours H] [--trace FILE] [--sample-ms MS] [--interval-ms MS]\n"
+                    "       [--max-payload BYTES] [--capacity SLOTS] [--outages-per-day X] [--dump FILE]\n",
+            argv[0]);
+    return 2;
+  }
+  TraceSensors trace;
+  if (!trace.load(tracePath)) {
+    fprintf(stderr, "cannot load trace %s\n", tracePath);
+    return 1;
+  }
+  FILE* dump = nullptr;
+  if (dumpPath) dump = strcmp(dumpPath, "-") ? fopen(dumpPath, "w") : stdout;
+  if (dumpPath && !dump) {
+    fprintf(stderr, "cannot open %s\n", dumpPath);
+    return 1;
+  }
+
+  LocalBroker broker;
+  std::vector<NodeSlot> slots(capacity);
+  Gateway gateway(slots.data(), (uint16_t)capacity, root);
+  uint64_t nowMs = 0;
+  double ingestNs = 0, flushNs = 0, maxFlushNs = 0;
+  broker.subscribe((std::string(root) + "/+/sensors/#").c_str(), [&](const char* topic, const uint8_t* p, size_t n) {
+    WallClock::time_point start = WallClock::now();
+    gateway.ingest(topic, p, n, (uint32_t)nowMs);
+    ingestNs += nsSince(start);
+  });
+  uint64_t batchMessages = 0, batchBytes = 0;
+  std::string batchTopic = std::string(root) + "/gateway/batch";
+  broker.subscribe(batchTopic.c_str(), [&](const char*, const uint8_t* p, size_t n) {
+    batchMessages++;
+    batchBytes += n;
+    if (dump) fprintf(dump, "%.*s\n", (int)n, (const char*)p);
+  });
+
+  std::vector<std::unique_ptr<SimNode>> nodes;
+  typedef std::pair<uint64_t, uint32_t> Due;   // (ms, node)
+  std::priority_queue<Due, std::vector<Due>, std::greater<Due>> due;
+  for (uint32_t i = 0; i < nodeCount; i++) {
+    nodes.emplace_back(new SimNode(i, root, trace, broker, fleet));
+    due.push(Due(nodes.back()->nextMs, i));
+  }
+
+  std::vector<char> chunk(maxPayload);
+  auto flushBatches = [&]() {
+    WallClock::time_point start = WallClock::now();
+    gateway.closeInterval((uint32_t)nowMs);
+    size_t n;
+    while ((n = gateway.nextChunk(chunk.data(), chunk.size())) > 0)
+      broker.publish(batchTopic.c_str(), (const uint8_t*)chunk.data(), n);
+    double ns = nsSince(start);
+    flushNs += ns;
+    if (ns > maxFlushNs) maxFlushNs = ns;
+    broker.deliver();
+  };
+
+  const uint32_t commandEveryMs = 3600000;
+  uint64_t endMs = (uint64_t)(hours * 3600e3);
+  uint64_t nextFlushMs = intervalMs, nextCommandMs = commandEveryMs;
+  uint32_t commandsSent = 0;
+  WallClock::time_point wallStart = WallClock::now();
+  while (true) {
+    uint64_t next = due.top().first;
+    if (nextFlushMs < next) next = nextFlushMs;
+    if (nextCommandMs < next) next = nextCommandMs;
+    if (next >= endMs) break;
+    nowMs = next;
+    if (nowMs == nextCommandMs) {
+      broker.publish((std::string(root) + "/all/signal/auto_light").c_str(), commandsSent++ & 1 ? "false" : "true");
+      nextCommandMs += commandEveryMs;
+    }
+    while (due.top().first == nowMs) {
+      uint32_t i = due.top().second;
+      due.pop();
+      nodes[i]->sample(nowMs);
+      nodes[i]->nextMs = nowMs + fleet.sampleMs;
+      due.push(Due(nodes[i]->nextMs, i));
+    }
+    broker.deliver();
+    if (nowMs == nextFlushMs) {
+      flushBatches();
+      nextFlushMs += intervalMs;
+    }
+  }
+  nowMs = endMs;
+  flushBatches();   // phần còn lại của chu kỳ cuối
+  double wall = std::chrono::duration<double>(WallClock::now() - wallStart).count();
+
+  uint64_t samples = 0, publishes = 0, frames = 0, commands = 0, outages = 0, dropped = 0;
+  for (const std::unique_ptr<SimNode>& n : nodes) {
+    samples += n->samples;
+    publishes += n->publishes;
+    frames += n->frames;
+    commands += n->commands;
+    outages += n->outages;
+    dropped += n->dropped;
+  }
+  bool conserved = gateway.batchedReadings == gateway.readings;
+  printf("simulated     %.1f h, %u nodes in %.3f s (%.0f sim-h/s)\n", hours, nodeCount, wall, wall > 0 ? hours / wall : 0.0);
+  printf("nodes         %llu samples, %llu publishes (%llu backlog frames), %llu outages, %llu samples dropped\n",
+         (unsigned long long)samples, (unsigned long long)publishes, (unsigned long long)frames,
+         (unsigned long long)outages, (unsigned long long)dropped);
+  printf("commands      %u broadcast, %llu received by nodes\n", commandsSent, (unsigned long long)commands);
+  printf("broker        %llu published, %llu delivered, %.1f MB, max queue %zu, %llu unrouted\n",
+         (unsigned long long)broker.published, (unsigned long long)broker.delivered, broker.bytes / 1e6,
+         broker.maxQueued, (unsigned long long)broker.unrouted);
+  printf("gateway       %u messages, %u readings, %u frames (%u lost), %u nodes (%u rejected msgs), %u bad, %u ignored\n",
+         gateway.messages, gateway.readings, gateway.frames, gateway.framesLost, gateway.nodes(),
+         gateway.rejectedNodes, gateway.badPayloads, gateway.ignored);
+  printf("batches       %u intervals, %u messages (%llu received), avg %.0f B, max %u B; %u readings batched (%s)\n",
+         gateway.intervals, gateway.chunks, (unsigned long long)batchMessages,
+         gateway.chunks ? (double)gateway.chunkBytes / gateway.chunks : 0.0, gateway.maxChunkBytes,
+         gateway.batchedReadings, conserved ? "all" : "MISMATCH");
+  printf("cost          ingest %.0f ns/msg (%.2f M msg/s), flush %.1f us/interval (max %.1f us)\n",
+         gateway.messages ? ingestNs / gateway.messages : 0.0, ingestNs > 0 ? gateway.messages / ingestNs * 1e3 : 0.0,
+         gateway.intervals ? flushNs / gateway.intervals / 1e3 : 0.0, maxFlushNs / 1e3);
+  if (dump && dump != stdout) fclose(dump);
+  return conserved && !gateway.oversized ? 0 : 1;
+}
+#endif
@@ -0,0 +1,55 @@
+#ifndef ARDUINO
+#include "local_broker.h"
+#include <string.h>
+#include <Dispatcher.h>
+
+// Hai cấp đầu của topic/filter; wildcard = filter có '+'/'#' trong đó (không chia được)
+std::string LocalBroker::bucketOf(const char* topic, bool& wildcard) {
+  const char* end = strchr(topic, '/');
+  if (end) end = strchr(end + 1, '/');
+  size_t n = end ? (size_t)(end - topic) : strlen(topic);
+  wildcard = memchr(topic, '+', n) || memchr(topic, '#', n);
+  return std::string(topic, n);
+}
+
+void LocalBroker::subscribe(const char* filter, BrokerHandler handler) {
+  bool wildcard;
+  std::string bucket = bucketOf(filter, wildcard);
+  Subscription s = { filter, handler };
+  if (wildcard) wildcards.push_back(s);
+  else buckets[bucket].push_back(s);
+}
+
+void LocalBroker::publish(const char* topic, const uint8_t* payload, size_t length) {
+  published++;
+  bytes += length;
+  queue.push_back(Message{ topic, std::string((const char*)payload, length) });
+  if (queue.size() > maxQueued) maxQueued = queue.size();
+}
+
+size_t LocalBroker::route(const Message& m, const std::vector<Subscription>& subs) {
+  size_t n = 0;
+  for (const Subscription& s : subs) {
+    if (!topicMatches(s.filter.c_str(), m.topic.c_str())) continue;
+    s.handler(m.topic.c_str(), (const uint8_t*)m.payload.data(), m.payload.size());
+    n++;
+  }
+  return n;
+}
+
+size_t LocalBroker::deliver() {
+  size_t calls = 0;
+  while (!queue.empty()) {
+    Message m = std::move(queue.front());
+    queue.pop_front();
+    bool wildcard;
+    auto it = buckets.find(bucketOf(m.topic.c_str(), wildcard));
+    size_t n = route(m, wildcards);
+    if (it != buckets.end()) n += route(m, it->second);
+    if (!n) unrouted++;
+    calls += n;
+  }
+  delivered += calls;
+  return calls;
+}
+#endif
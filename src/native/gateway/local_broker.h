@@ -0,0 +1,46 @@
+#pragma once
+#ifndef ARDUINO
+// Broker MQTT giả trong bộ nhớ cho bài tải gateway: nhiều client (node mô phỏng,
+// gateway, bên đọc batch) đăng ký filter và publish; publish() chỉ xếp hàng, deliver()
+// phân phát theo thứ tự. Subscription được chia theo hai cấp đầu của filter
+// (garden/<node>) nên mỗi message chỉ so với filter của đúng node đó cộng các
+// filter có wildcard ở hai cấp đầu (gateway: garden/+/sensors/#).
+#include <stdint.h>
+#include <string.h>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef std::function<void(const char* topic, const uint8_t* payload, size_t length)> BrokerHandler;
+
+class LocalBroker {
+public:
+  void subscribe(const char* filter, BrokerHandler handler);
+  void publish(const char* topic, const uint8_t* payload, size_t length);
+  void publish(const char* topic, const char* payload) { publish(topic, (const uint8_t*)payload, strlen(payload)); }
+  // Phân phát mọi message đang chờ (kể cả message handler publish thêm); trả về số lần gọi handler
+  size_t deliver();
+
+  uint64_t published = 0, delivered = 0, bytes = 0, unrouted = 0;
+  size_t maxQueued = 0;
+
+private:
+  struct Subscription {
+    std::string filter;
+    BrokerHandler handler;
+  };
+  struct Message {
+    std::string topic;
+    std::string payload;
+  };
+
+  static std::string bucketOf(const char* topic, bool& wildcard);
+  size_t route(const Message& m, const std::vector<Subscription>& subs);
+
+  std::unordered_map<std::string, std::vector<Subscription>> buckets;
+  std::vector<Subscription> wildcards;
+  std::deque<Message> queue;
+};
+#endif
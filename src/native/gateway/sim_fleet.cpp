@@ -0,0 +1,104 @@
+#ifndef ARDUINO
+#include "sim_fleet.h"
+#include <math.h>
+#include <stdio.h>
+
+// Như tempPolicy/humPolicy/lightPolicy/soilPolicy trong src/main.cpp
+//                                      abs    rel    minIntervalMs heartbeatMs threshold
+static const ReportPolicy tempPolicy  = { 0.3f,  0.0f,  4000,         300000,     35.0f };
+static const ReportPolicy humPolicy   = { 2.0f,  0.0f,  30000,        300000,     NAN };
+static const ReportPolicy lightPolicy = { 3.0f,  0.1f,  30000,        300000,     NAN };
+static const ReportPolicy soilPolicy  = { 2.0f,  0.0f,  30000,        300000,     29.5f };
+
+static const char* const CHANNELS[4] = { "temperature", "humidity", "light", "soil_moisture" };
+
+static int clampPercent(int v) { return v < 0 ? 0 : v > 100 ? 100 : v; }
+
+SimNode::SimNode(uint32_t index, const char* root, TraceSensors& trace, LocalBroker& broker, const FleetConfig& config)
+    : trace(trace), broker(broker), config(config),
+      reporters{ ChangeReporter(tempPolicy), ChangeReporter(humPolicy), ChangeReporter(lightPolicy),
+                 ChangeReporter(soilPolicy) },
+      batcher(TELEMETRY_MAX_BATCH), rng(0x9E3779B9u * (index + 1)) {
+  snprintf(nodeId, sizeof(nodeId), "sim-%06u", (unsigned)index + 1);
+  for (int i = 0; i < 4; i++) topics[i] = std::string(root) + "/" + nodeId + "/sensors/" + CHANNELS[i];
+  frameTopic = std::string(root) + "/" + nodeId + "/sensors/frame";
+  // lệch pha tới 2 giờ, sai số riêng từng node; lần lấy mẫu đầu rải đều trong một chu kỳ
+  phaseMs = random() % (2 * 3600000u);
+  tempOffset = noise(1.5f);
+  humOffset = noise(5.0f);
+  soilOffset = (int)noise(8.0f);
+  nextMs = random() % config.sampleMs;
+
+  BrokerHandler onCommand = [this](const char*, const uint8_t*, size_t) {
+    if (online) commands++;
+  };
+  broker.subscribe((std::string(root) + "/" + nodeId + "/signal/#").c_str(), onCommand);
+  broker.subscribe((std::string(root) + "/all/signal/#").c_str(), onCommand);
+}
+
+uint32_t SimNode::random() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+float SimNode::noise(float span) { return span * ((random() % 2001) / 1000.0f - 1.0f); }
+
+void SimNode::sample(uint64_t nowMs) {
+  samples++;
+  const TraceRow& row = trace.at(nowMs + phaseMs);
+  SensorSample s;
+  s.ms = (uint32_t)nowMs;
+  s.temp = row.temp + tempOffset + noise(0.15f);
+  s.hum = row.hum + humOffset + noise(1.0f);
+  s.light = (uint8_t)clampPercent(100 - row.ldr * 100 / 4095);   // light_percent()
+  s.soil = (uint8_t)clampPercent(row.soil * 100 / 4095 + soilOffset);
+
+  if (online && config.outagesPerDay > 0 &&
+      random() % 1000000 < (uint32_t)(config.outagesPerDay * config.sampleMs / 86400000.0f * 1e6f)) {
+    online = false;
+    offlineUntilMs = nowMs + config.outageMs;
+    outages++;
+  }
+  if (!online && nowMs >= offlineUntilMs) {
+    online = true;
+    drainBacklog();
+    for (ChangeReporter& r : reporters) r.invalidate();   // gửi lại giá trị hiện tại như firmware
+  }
+  if (!online) {
+    if (backlog.size() >= config.backlogCapacity) {
+      backlog.pop_front();
+      dropped++;
+    }
+    backlog.push_back(s);
+    return;
+  }
+  publishReading(s, nowMs);
+}
+
+void SimNode::publishReading(const SensorSample& s, uint64_t nowMs) {
+  const float values[4] = { s.temp, s.hum, (float)s.light, (float)s.soil };
+  char text[16];
+  for (int i = 0; i < 4; i++) {
+    if (reporters[i].update(values[i], (uint32_t)nowMs) == REPORT_NONE) continue;
+    if (i < 2) snprintf(text, sizeof(text), "%.2f", values[i]);
+    else snprintf(text, sizeof(text), "%d", (int)values[i]);
+    broker.publish(topics[i].c_str(), text);
+    publishes++;
+  }
+}
+
+void SimNode::drainBacklog() {
+  uint8_t frame[TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_BATCH * TELEMETRY_SAMPLE_SIZE];
+  while (!backlog.empty()) {
+    bool full = batcher.add(backlog.front());
+    backlog.pop_front();
+    if (!full && !backlog.empty()) continue;
+    size_t len = batcher.encode(frame, sizeof(frame));
+    broker.publish(frameTopic.c_str(), frame, len);
+    publishes++;
+    frames++;
+  }
+}
+#endif
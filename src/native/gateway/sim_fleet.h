@@ -0,0 +1,53 @@
+#pragma once
+#ifndef ARDUINO
+// Node mô phỏng cho bài tải gateway: mỗi node đọc trace chung lệch pha, cộng sai
+// số riêng, gửi theo thay đổi (ChangeReporter, cùng chính sách với src/main.cpp)
+// lên <root>/<nodeId>/sensors/<kênh>. Thỉnh thoảng mất kết nối: mẫu vào backlog,
+// kết nối lại thì gửi bù bằng khung nhị phân .../sensors/frame rồi gửi lại mọi kênh.
+// Nhận lệnh ở <root>/<nodeId>/signal/# và <root>/all/signal/# như firmware.
+#include <deque>
+#include <ChangeReporter.h>
+#include <Telemetry.h>
+#include "../hal/hal_native.h"
+#include "local_broker.h"
+
+struct FleetConfig {
+  uint32_t sampleMs = 5000;        // như interval trong src/main.cpp
+  float outagesPerDay = 1.0f;      // số lần mất kết nối trung bình mỗi node mỗi ngày
+  uint32_t outageMs = 20 * 60000;
+  size_t backlogCapacity = 720;    // BACKLOG_CAPACITY của firmware
+};
+
+class SimNode {
+public:
+  SimNode(uint32_t index, const char* root, TraceSensors& trace, LocalBroker& broker, const FleetConfig& config);
+
+  void sample(uint64_t nowMs);
+  const char* id() const { return nodeId; }
+
+  uint64_t nextMs;
+  uint32_t samples = 0, publishes = 0, frames = 0, commands = 0, outages = 0, dropped = 0;
+
+private:
+  uint32_t random();
+  float noise(float span);  // đều trong [-span, span]
+  void publishReading(const SensorSample& s, uint64_t nowMs);
+  void drainBacklog();
+
+  char nodeId[24];
+  std::string topics[4];
+  std::string frameTopic;
+  TraceSensors& trace;
+  LocalBroker& broker;
+  const FleetConfig& config;
+  ChangeReporter reporters[4];
+  TelemetryBatcher batcher;
+  std::deque<SensorSample> backlog;
+  bool online = true;
+  uint64_t offlineUntilMs = 0;
+  uint64_t phaseMs;
+  float tempOffset, humOffset;
+  int soilOffset;
+  uint32_t rng;
+};
+#endif
@@ -0,0 +1,675 @@
+#ifndef ARDUINO
+#include "hal_native.h"
+#include <Dispatcher.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+static uint64_t nowUs = 0;
+static bool verbose = false;
+static char deviceId[32] = "sim-000001";
+static void accrue(uint64_t us);
+
+uint64_t simNowUs() { return nowUs; }
+void simAdvance(uint32_t ms) { accrue((uint64_t)ms * 1000); }
+void simAdvanceUs(uint32_t us) { accrue(us); }
+void simSetVerbose(bool on) { verbose = on; }
+void simSetDeviceId(const char* id) { snprintf(deviceId, sizeof(deviceId), "%s", id); }
+
+// --------------------- TraceSensors -----------------
+bool TraceSensors::load(const char* path, std::vector<ScriptedCommand>* commands) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  trace.clear();
+  cursor = 0;
+  char line[320];   // đủ cho lệnh signal/config đặt mọi trường
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+    line[strcspn(line, "\r\n")] = 0;
+    char* p = line;
+    uint64_t ms = strtoull(p, &p, 10);
+    if (*p == ',') p++;
+    if (!strncmp(p, "mqtt,", 5)) {
+      char* topic = p + 5;
+      char* comma = strchr(topic, ',');
+      if (!comma || !commands) continue;
+      *comma = 0;
+      ScriptedCommand c = { ms, topic, comma + 1 };
+      commands->push_back(c);
+      continue;
+    }
+    TraceRow r;
+    r.ms = (uint32_t)ms;
+    r.temp = strtof(p, &p);      if (*p == ',') p++;
+    r.hum = strtof(p, &p);       if (*p == ',') p++;
+    r.ldr = strtol(p, &p, 10);   if (*p == ',') p++;
+    r.soil = strtol(p, &p, 10);
+    if (!trace.empty() && r.ms <= trace.back().ms) continue;  // bỏ dòng không tăng dần
+    trace.push_back(r);
+  }
+  fclose(f);
+  if (trace.empty()) return false;
+  if (commands) {
+    std::stable_sort(commands->begin(), commands->end(),
+                     [](const ScriptedCommand& a, const ScriptedCommand& b) { return a.ms < b.ms; });
+  }
+  // chu kỳ lặp: khoảng cách giữa hai dòng cuối được cộng thêm sau dòng cuối
+  uint32_t step = trace.size() > 1 ? trace.back().ms - trace[trace.size() - 2].ms : 1000;
+  periodMs = trace.back().ms + step;
+  return true;
+}
+
+void TraceSensors::set(const TraceRow& row) {
+  trace.clear();
+  fixed = row;
+}
+
+const TraceRow& TraceSensors::current() { return at(simNowUs() / 1000); }
+
+const TraceRow& TraceSensors::at(uint64_t ms) {
+  if (trace.empty()) return fixed;
+  uint32_t t = (uint32_t)(ms % periodMs);
+  // thời gian thường chỉ tăng nên chỉ cần dịch cursor vài bước; lùi lại thì tìm nhị phân
+  if (t < trace[cursor].ms) {
+    cursor = std::upper_bound(trace.begin(), trace.end(), t,
+                              [](uint32_t v, const TraceRow& r) { return v < r.ms; }) - trace.begin();
+    cursor = cursor ? cursor - 1 : 0;
+  }
+  while (cursor + 1 < trace.size() && trace[cursor + 1].ms <= t) cursor++;
+  return trace[cursor];
+}
+
+int TraceSensors::raw(uint8_t pin) {
+  if (pin == Board::LDR_PIN) return current().ldr;
+  if (pin == Board::SOIL_PIN) return plant ? plant->raw() : current().soil;
+  return -1;
+}
+
+bool TraceSensors::readClimate(float& temperature, float& humidity) {
+  climateReads++;
+  const TraceRow& r = current();
+  temperature = r.temp;
+  humidity = r.hum;
+  bool ok = !isnan(temperature) && !isnan(humidity);
+  if (!ok) climateFailures++;
+  return ok;
+}
+
+ClimateStats TraceSensors::climateStats() {
+  return { climateReads, climateReads - climateFailures, climateFailures, 0, 0, 0 };
+}
+
+// Một khối DMA mới cho mỗi thời điểm mô phỏng, dùng chung cho mọi chân đọc cùng lúc
+int TraceSensors::readAnalog(uint8_t pin) {
+  analogReads++;
+  if (simNowUs() != lastBlockUs) {
+    const TraceRow& r = current();
+    const uint8_t channels[] = { (uint8_t)adc1Channel(Board::LDR_PIN), (uint8_t)adc1Channel(Board::SOIL_PIN) };
+    const uint16_t levels[] = { (uint16_t)r.ldr, (uint16_t)(plant ? plant->raw() : r.soil) };
+    adc.produce(channels, levels, 2, analog.factor());
+    lastBlockUs = simNowUs();
+  }
+  uint16_t value = 0;
+  analog.latest(adc1Channel(pin), value);
+  return value;
+}
+
+// --------------------- SoilPlant -----------------
+void SoilPlant::attach(TraceSensors& trace, float startPercent) {
+  climate = &trace;
+  water = sensor = minSensor = maxSensor = startPercent;
+  lastMs = simNowUs() / 1000;
+}
+
+// Bước 1 s: đủ mịn so với sensorLagMs và thời gian mở van
+void SoilPlant::advance(uint64_t ms) {
+  while (climate && lastMs < ms) {
+    uint32_t step = ms - lastMs < 1000 ? (uint32_t)(ms - lastMs) : 1000;
+    const TraceRow& r = climate->at(lastMs);
+    float es = 0.6108f * expf(17.27f * r.temp / (r.temp + 237.3f));
+    float vpd = es * (1.0f - r.hum / 100.0f);
+    if (vpd < 0) vpd = 0;
+    float dry = (baseDryPerH + vpdDryPerH * vpd) * water / referencePercent;
+    water -= dry * step / 3600000.0f;
+    if (valveOpen) {
+      water += flowPctPerS * step / 1000.0f;
+      openMs += step;
+    }
+    if (water > fieldCapacity) {
+      drainedPct += water - fieldCapacity;
+      water = fieldCapacity;
+    }
+    if (water < 0) water = 0;
+    sensor += (water - sensor) * step / sensorLagMs;
+    if (sensor < minSensor) minSensor = sensor;
+    if (sensor > maxSensor) maxSensor = sensor;
+    if (sensor < dryPercent) dryMs += step;
+    lastMs += step;
+  }
+}
+
+void SoilPlant::setValve(bool open) {
+  advance(simNowUs() / 1000);
+  if (open && !valveOpen) openings++;
+  valveOpen = open;
+}
+
+int SoilPlant::raw() {
+  advance(simNowUs() / 1000);
+  return (int)(sensor * 4095 / 100 + 0.5f);
+}
+
+// --------------------- FakeAdcProducer -----------------
+void FakeAdcProducer::produce(const uint8_t* channels, const uint16_t* levels, uint8_t count, uint16_t perChannel) {
+  block.resize((size_t)count * perChannel);
+  size_t k = 0;
+  for (uint16_t i = 0; i < perChannel; i++) {
+    for (uint8_t c = 0; c < count; c++) {
+      rng = rng * 1664525u + 1013904223u;
+      int raw;
+      if ((rng >> 8) % spikeEvery == 0) {
+        raw = (rng & 0x80000000u) ? 4095 : 0;
+        spikes++;
+      } else {
+        raw = levels[c] + (int)((rng >> 16) % (2 * noise + 1)) - noise;
+      }
+      if (raw < 0) raw = 0;
+      if (raw > 4095) raw = 4095;
+      block[k++] = adcWord(channels[c], (uint16_t)raw);
+    }
+  }
+  out.push(block.data(), block.size());
+  blocks++;
+}
+
+// --------------------- RecordingActuators -----------------
+static unsigned long long nowMs() { return (unsigned long long)(nowUs / 1000); }
+
+void RecordingActuators::servoWrite(int angle) {
+  servoWrites++;
+  if (angle != servoAngle) {
+    servoMoves++;
+    if (record) fprintf(record, "%llu,servo,%d\n", nowMs(), angle);
+  }
+  servoAngle = angle;
+  if (plant) plant->setValve(angle == 0);
+}
+
+void RecordingActuators::digitalOut(uint8_t pin, bool high) {
+  if (pin >= sizeof(pins)) return;
+  if (pins[pin] != high) {
+    pinChanges++;
+    if (record) fprintf(record, "%llu,pin%u,%d\n", nowMs(), pin, high);
+  }
+  pins[pin] = high;
+}
+
+void RecordingActuators::buzzerTone(uint32_t freq) {
+  if (freq != toneHz) {
+    toneChanges++;
+    if (record) fprintf(record, "%llu,tone,%u\n", nowMs(), (unsigned)freq);
+  }
+  toneHz = freq;
+}
+
+void RecordingActuators::showLeds(const Rgb* pixels, uint16_t count) {
+  ledShows++;
+  if (count > Board::RING_PIXELS) count = Board::RING_PIXELS;
+  bool changed = false;
+  for (uint16_t i = 0; i < count; i++) {
+    if (frame[i] != pixels[i]) changed = true;
+    frame[i] = pixels[i];
+  }
+  if (!changed) return;
+  ledChanges++;
+  if (!record) return;
+  fprintf(record, "%llu,leds,", nowMs());
+  for (uint16_t i = 0; i < Board::RING_PIXELS; i++)
+    fprintf(record, "%s%02X%02X%02X", i ? " " : "", frame[i].r, frame[i].g, frame[i].b);
+  fputc('\n', record);
+}
+
+// --------------------- FramebufferDisplay -----------------
+// Cùng bố cục với SSD1306: 8 page, mỗi byte là một cột 8 pixel dọc
+void FramebufferDisplay::setPixel(int16_t x, int16_t y, bool on) {
+  if (x < 0 || y < 0 || x >= Board::SCREEN_WIDTH || y >= Board::SCREEN_HEIGHT) return;
+  uint8_t& b = buffer[x + (y / 8) * Board::SCREEN_WIDTH];
+  if (on) b |= (1 << (y & 7));
+  else    b &= ~(1 << (y & 7));
+}
+
+bool FramebufferDisplay::pixel(int16_t x, int16_t y) const {
+  if (x < 0 || y < 0 || x >= Board::SCREEN_WIDTH || y >= Board::SCREEN_HEIGHT) return false;
+  return buffer[x + (y / 8) * Board::SCREEN_WIDTH] & (1 << (y & 7));
+}
+
+void FramebufferDisplay::clear() { memset(buffer, 0, sizeof(buffer)); }
+
+// Giống Adafruit_GFX::drawBitmap: bitmap theo hàng, MSB trước, chỉ vẽ bit 1
+void FramebufferDisplay::drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap,
+                                    int16_t w, int16_t h, bool on) {
+  int16_t byteWidth = (w + 7) / 8;
+  bool inside = x >= 0 && y >= 0 && x + w <= Board::SCREEN_WIDTH && y + h <= Board::SCREEN_HEIGHT;
+  for (int16_t j = 0; j < h; j++) {
+    const uint8_t* row = bitmap + j * byteWidth;
+    if (!inside) {
+      for (int16_t i = 0; i < w; i++)
+        if (row[i / 8] & (0x80 >> (i & 7))) setPixel(x + i, y + j, on);
+      continue;
+    }
+    // đường nhanh khi bitmap nằm trọn trong màn hình
+    uint8_t* col = buffer + ((y + j) / 8) * Board::SCREEN_WIDTH + x;
+    uint8_t bit = 1 << ((y + j) & 7);
+    for (int16_t i = 0; i < w; i++) {
+      if (!(row[i / 8] & (0x80 >> (i & 7)))) continue;
+      if (on) col[i] |= bit;
+      else    col[i] &= ~bit;
+    }
+  }
+}
+
+// Không có font trên host: mỗi ký tự ghi 5 cột byte suy ra từ mã ký tự, đủ để
+// nội dung framebuffer thay đổi khi chữ thay đổi
+void FramebufferDisplay::text(int16_t x, int16_t y, const char* s) {
+  textCalls++;
+  if (y < 0 || y >= Board::SCREEN_HEIGHT) return;
+  uint8_t* page = buffer + (y / 8) * Board::SCREEN_WIDTH;
+  for (; *s && x + 5 <= Board::SCREEN_WIDTH; s++, x += 6)
+    for (int16_t i = 0; i < 5; i++) page[x + i] = (uint8_t)(*s * (i + 1));
+}
+
+void FramebufferDisplay::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, bool on) {
+  for (int16_t j = y; j < y + h; j++)
+    for (int16_t i = x; i < x + w; i++) setPixel(i, j, on);
+}
+
+void FramebufferDisplay::flush() {
+  flushes++;
+  bytesSent += sizeof(buffer);
+}
+
+void FramebufferDisplay::flushRegion(uint8_t page0, uint8_t page1, uint8_t col0, uint8_t col1) {
+  regionFlushes++;
+  bytesSent += (page1 - page0 + 1) * (col1 - col0 + 1) + 6;
+}
+
+// --------------------- LoopbackTransport -----------------
+void LoopbackTransport::begin(const char*, uint16_t, MessageHandler h) { handler = h; }
+
+void LoopbackTransport::beginLink(const char*, const char*) {
+  if (radioOn) return;
+  radioOn = true;
+  joins++;
+  if (cached) cachedJoins++;
+  linkAtUs = nowUs + (uint64_t)(cached ? cachedJoinMs : scanMs) * 1000;
+}
+
+void LoopbackTransport::endLink() {
+  radioOn = false;
+  session = false;
+}
+
+void LoopbackTransport::serviceLink() {
+  if (linkUp()) cached = true;
+}
+
+bool LoopbackTransport::linkUp() {
+  return wifiUp && radioOn && nowUs >= linkAtUs;
+}
+
+bool LoopbackTransport::connect(const char*) {
+  if (!linkUp() || !brokerUp) return false;
+  connects++;
+  session = true;
+  subscriptions.clear();
+  return true;
+}
+
+bool LoopbackTransport::subscribe(const char* topic) {
+  if (!connected()) return false;
+  subscriptions.push_back(topic);
+  return true;
+}
+
+bool LoopbackTransport::publish(const char* topic, const uint8_t* payload, size_t length, bool retained) {
+  if (!connected()) return false;
+  publishes++;
+  publishBytes += length;
+  if (keepPublished || onPublish) {
+    SimMessage m = { topic, std::string((const char*)payload, length), retained };
+    if (onPublish) onPublish(m);
+    if (keepPublished) published.push_back(m);
+  }
+  return true;
+}
+
+void LoopbackTransport::inject(const char* topic, const char* payload) {
+  inject(topic, (const uint8_t*)payload, strlen(payload));
+}
+
+void LoopbackTransport::inject(const char* topic, const uint8_t* payload, size_t length) {
+  SimMessage m = { topic, std::string((const char*)payload, length), false };
+  inbox.push_back(m);
+}
+
+void LoopbackTransport::loop() {
+  if (!connected()) return;
+  while (!inbox.empty()) {
+    SimMessage m = inbox.front();
+    inbox.pop_front();
+    bool wanted = false;
+    for (const std::string& s : subscriptions) wanted = wanted || topicMatches(s.c_str(), m.topic.c_str());
+    if (!wanted || !handler) continue;
+    delivered++;
+    handler(&m.topic[0], (uint8_t*)&m.payload[0], m.payload.size());
+  }
+}
+
+// --------------------- SimFlash -----------------
+void SimFlash::resize(size_t bytes) {
+  data.assign(bytes, 0xFF);
+  erases.assign(bytes / sectorSize(), 0);
+  reads = writes = programErrors = 0;
+  bytesRead = bytesWritten = 0;
+}
+
+bool SimFlash::read(size_t offset, void* out, size_t length) {
+  if (offset + length > data.size()) return false;
+  memcpy(out, &data[offset], length);
+  reads++;
+  bytesRead += length;
+  return true;
+}
+
+bool SimFlash::write(size_t offset, const void* src, size_t length) {
+  if (offset + length > data.size()) return false;
+  const uint8_t* p = (const uint8_t*)src;
+  for (size_t i = 0; i < length; i++) {
+    if (p[i] & ~data[offset + i]) programErrors++;
+    data[offset + i] &= p[i];
+  }
+  writes++;
+  bytesWritten += length;
+  return true;
+}
+
+bool SimFlash::erase(size_t sector) {
+  if (sector >= erases.size()) return false;
+  memset(&data[sector * sectorSize()], 0xFF, sectorSize());
+  erases[sector]++;
+  return true;
+}
+
+// --------------------- SimOta -----------------
+bool SimOta::loadRunning(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  SimFlash& slot = slots[current];
+  slot.resize(SLOT_BYTES);
+  size_t n = fread(slot.data.data(), 1, SLOT_BYTES, f);
+  bool ok = !ferror(f) && fgetc(f) == EOF;
+  fclose(f);
+  runningSize = n;
+  return ok;
+}
+
+bool SimOta::activate(size_t imageSize) {
+  if (!imageSize || imageSize > SLOT_BYTES) return false;
+  boot = 1 - current;
+  bootSize = imageSize;
+  activations++;
+  return true;
+}
+
+void SimOta::restart() {
+  restarts++;
+  halLog("restart: next boot from slot %u (%lu bytes)", boot, (unsigned long)(boot == current ? runningSize : bootSize));
+}
+
+// --------------------- SocketServer -----------------
+bool SocketServer::listen(uint16_t) {
+  if (fd >= 0) return true;
+  if (!port) return false;
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  if (s < 0) return false;
+  int on = 1;
+  setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(s, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(s, 64) < 0) {
+    fprintf(stderr, "http: cannot listen on 127.0.0.1:%u: %s\n", port, strerror(errno));
+    ::close(s);
+    port = 0;   // không thử lại mỗi lần gọi
+    return false;
+  }
+  fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+  fd = s;
+  return true;
+}
+
+int SocketServer::accept() {
+  if (fd < 0) return -1;
+  int c = ::accept(fd, nullptr, nullptr);
+  if (c < 0) return -1;
+  fcntl(c, F_SETFL, fcntl(c, F_GETFL, 0) | O_NONBLOCK);
+  int on = 1;
+  setsockopt(c, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  accepted++;
+  return c;
+}
+
+int SocketServer::read(int conn, void* out, size_t capacity) {
+  ssize_t n = recv(conn, out, capacity, MSG_DONTWAIT);
+  if (n > 0) {
+    bytesIn += n;
+    return (int)n;
+  }
+  if (n == 0) return -1;
+  return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+}
+
+int SocketServer::write(int conn, const void* data, size_t length) {
+  ssize_t n = send(conn, data, length, MSG_DONTWAIT | MSG_NOSIGNAL);
+  if (n >= 0) {
+    bytesOut += n;
+    return (int)n;
+  }
+  return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+}
+
+void SocketServer::close(int conn) { ::close(conn); }
+
+// --------------------- Hal -----------------
+static TraceSensors sensors;
+static RecordingActuators actuators;
+static FramebufferDisplay display;
+static LoopbackTransport transport;
+static SimFlash flash;
+static SocketServer server;
+static SimOta ota;
+
+TraceSensors& simSensors() { return sensors; }
+RecordingActuators& simActuators() { return actuators; }
+FramebufferDisplay& simDisplay() { return display; }
+LoopbackTransport& simTransport() { return transport; }
+SimFlash& simFlash() { return flash; }
+SocketServer& simServer() { return server; }
+SimOta& simOta() { return ota; }
+
+Hal& hal() {
+  static Hal h = { sensors, actuators, display, transport, flash, server, ota };
+  return h;
+}
+
+// --------------------- Năng lượng và ngủ -----------------
+enum SimPowerState : uint8_t { SIM_AWAKE, SIM_LIGHT, SIM_DEEP };
+static EnergyMeter energy;
+static SimPowerState powerState = SIM_AWAKE;
+static bool ulpRunning = false;
+static WakeThreshold wakeThresholds[HAL_MAX_WAKE_THRESHOLDS];
+static uint8_t wakeThresholdCount = 0;
+static uint32_t wakePollMs = 1000;
+static WakeCause wakeCause = WAKE_POWER_ON;
+static uint8_t rtcMemory[HAL_RTC_BYTES];
+
+EnergyMeter& simEnergy() { return energy; }
+
+// Tiến đồng hồ và cộng điện năng; đoạn đang vào mạng được tách tại linkAtUs
+static void accrue(uint64_t us) {
+  const PowerProfile& p = energy.profile;
+  while (us) {
+    uint64_t chunk = us;
+    float ma;
+    if (powerState == SIM_AWAKE) {
+      ma = p.activeMa;
+      if (transport.radioOn) {
+        bool joining = nowUs < transport.linkAtUs;
+        if (joining && nowUs + chunk > transport.linkAtUs) chunk = transport.linkAtUs - nowUs;
+        ma += joining ? p.joinMa : p.radioMa;
+        energy.radioUs += chunk;
+      }
+      energy.awakeUs += chunk;
+    } else {
+      ma = (powerState == SIM_LIGHT ? p.lightMa : p.deepMa) + (ulpRunning ? p.ulpMa : 0);
+      (powerState == SIM_LIGHT ? energy.lightUs : energy.deepUs) += chunk;
+    }
+    energy.mAs += ma * (chunk / 1e6);
+    nowUs += chunk;
+    us -= chunk;
+  }
+}
+
+static bool thresholdCrossed() {
+  for (uint8_t i = 0; i < wakeThresholdCount; i++) {
+    int v = sensors.raw(wakeThresholds[i].pin);
+    if (v >= 0 && (v < wakeThresholds[i].below || v > wakeThresholds[i].above)) return true;
+  }
+  return false;
+}
+
+void halSetWakeThresholds(const WakeThreshold* thresholds, uint8_t count, uint32_t pollMs) {
+  if (count > HAL_MAX_WAKE_THRESHOLDS) count = HAL_MAX_WAKE_THRESHOLDS;
+  memcpy(wakeThresholds, thresholds, count * sizeof(WakeThreshold));
+  wakeThresholdCount = count;
+  wakePollMs = pollMs ? pollMs : 1;
+}
+
+// Như ULP: kiểm tra ngưỡng mỗi wakePollMs trên giá trị trace (không nhiễu ADC).
+// Deep sleep trả về như light sleep, cộng thêm thời gian khởi động lại.
+WakeCause halSleep(SleepMode mode, uint32_t ms) {
+  energy.sleeps++;
+  powerState = mode == SLEEP_DEEP ? SIM_DEEP : SIM_LIGHT;
+  ulpRunning = wakeThresholdCount > 0;
+  wakeCause = WAKE_TIMER;
+  uint32_t step = ulpRunning ? wakePollMs : ms;
+  for (uint32_t slept = 0; slept < ms;) {
+    uint32_t d = ms - slept < step ? ms - slept : step;
+    accrue((uint64_t)d * 1000);
+    slept += d;
+    if (ulpRunning && thresholdCrossed()) {
+      wakeCause = WAKE_THRESHOLD;
+      energy.thresholdWakes++;
+      break;
+    }
+  }
+  powerState = SIM_AWAKE;
+  ulpRunning = false;
+  if (mode == SLEEP_DEEP) accrue((uint64_t)energy.profile.bootMs * 1000);
+  return wakeCause;
+}
+
+WakeCause halWakeCause() { return wakeCause; }
+uint8_t* halRtcMemory() { return rtcMemory; }
+
+static SimNvs nvs;
+SimNvs& simNvs() { return nvs; }
+
+bool SimNvs::load(const char* path) {
+  FILE* f = fopen(path, "r");
+  if (!f) return errno == ENOENT;
+  char key[32], hex[1024];
+  bool ok = true;
+  while (ok && fscanf(f, "%31s %1023s", key, hex) == 2) {
+    std::vector<uint8_t>& blob = blobs[key];
+    blob.clear();
+    size_t n = strlen(hex);
+    ok = n % 2 == 0;
+    for (size_t i = 0; ok && i < n; i += 2) {
+      unsigned v;
+      ok = sscanf(hex + i, "%2x", &v) == 1;
+      blob.push_back((uint8_t)v);
+    }
+  }
+  fclose(f);
+  return ok;
+}
+
+bool SimNvs::save(const char* path) const {
+  FILE* f = fopen(path, "w");
+  if (!f) return false;
+  for (const auto& kv : blobs) {
+    fprintf(f, "%s ", kv.first.c_str());
+    for (uint8_t b : kv.second) fprintf(f, "%02x", b);
+    fputc('\n', f);
+  }
+  return fclose(f) == 0;
+}
+
+size_t halNvsRead(const char* key, void* out, size_t capacity) {
+  nvs.reads++;
+  auto it = nvs.blobs.find(key);
+  if (it == nvs.blobs.end() || it->second.size() > capacity) return 0;
+  memcpy(out, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+bool halNvsWrite(const char* key, const void* data, size_t length) {
+  nvs.writes++;
+  nvs.blobs[key].assign((const uint8_t*)data, (const uint8_t*)data + length);
+  return true;
+}
+
+void halBegin() {}
+uint32_t halMillis() { return (uint32_t)(nowUs / 1000); }
+uint32_t halMicros() { return (uint32_t)nowUs; }
+// Đo thời gian chạy thật của mã trên host, không theo đồng hồ ảo
+uint32_t halCycles() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+uint32_t halCpuMhz() { return 1000; }
+uint32_t halFreeHeap() { return 0; }
+uint32_t halMinFreeHeap() { return 0; }
+void halDelay(uint32_t ms) { simAdvance(ms); }
+
+void halDeviceId(char* out, size_t capacity) { snprintf(out, capacity, "%s", deviceId); }
+
+void halLog(const char* fmt, ...) {
+  if (!verbose) return;
+  va_list args;
+  va_start(args, fmt);
+  printf("[%10.3f] ", nowUs / 1e6);
+  vprintf(fmt, args);
+  putchar('\n');
+  va_end(args);
+}
+
+// Không có luồng thật: firmware tự chạy worker trong loop() để đồng hồ ảo tất định
+WorkerId halStartWorker(const char*, WorkerFn, uint8_t, uint32_t, uint8_t) { return NO_WORKER; }
+void halWakeWorker(WorkerId) {}
+uint32_t halStackHighWater(WorkerId) { return 0; }
+
+#endif
@@ -0,0 +1,317 @@
+#pragma once
+#ifndef ARDUINO
+// Backend HAL giả lập cho env:native. Đồng hồ là đồng hồ ảo do chương trình
+// host điều khiển (simAdvance), cảm biến phát lại từ file trace CSV (kênh analog
+// đi qua nguồn ADC DMA giả + AnalogDecimator như trên ESP32), còn các
+// cơ cấu chấp hành chỉ ghi lại trạng thái để so sánh/đếm.
+#include <Hal.h>
+#include <AnalogStream.h>
+#include <deque>
+#include <map>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "board.h"
+
+// --------------------- Đồng hồ ảo -----------------
+uint64_t simNowUs();
+void simAdvance(uint32_t ms);
+void simAdvanceUs(uint32_t us);
+void simSetVerbose(bool on);
+void simSetDeviceId(const char* id);   // halDeviceId(), mặc định "sim-000001"
+
+// --------------------- Mô hình năng lượng -----------------
+// Dòng tiêu thụ (mA) theo trạng thái, cộng dồn mỗi khi đồng hồ ảo tiến. Số liệu cỡ
+// ESP32-WROOM theo datasheet; OLED/LED/servo không tính (giống nhau ở mọi chế độ).
+struct PowerProfile {
+  float activeMa;    // CPU chạy, WiFi tắt
+  float radioMa;     // cộng thêm khi WiFi bật và đã vào mạng
+  float joinMa;      // cộng thêm trong lúc quét/vào mạng
+  float lightMa;     // light sleep
+  float deepMa;      // deep sleep
+  float ulpMa;       // cộng thêm khi ULP đọc ADC trong lúc ngủ
+  uint32_t bootMs;   // thời gian khởi động lại sau deep sleep (CPU chạy)
+};
+
+struct EnergyMeter {
+  PowerProfile profile = { 40.0f, 80.0f, 120.0f, 0.8f, 0.01f, 0.1f, 250 };
+  double mAs = 0;    // mA x giây
+  uint64_t awakeUs = 0, radioUs = 0, lightUs = 0, deepUs = 0;
+  uint32_t sleeps = 0, thresholdWakes = 0;
+
+  double mAh() const { return mAs / 3600.0; }
+};
+EnergyMeter& simEnergy();
+
+// --------------------- ADC: nguồn DMA giả -----------------
+// Mỗi lần produce() sinh một khối word TYPE1 xen kẽ các kênh quanh mức cho trước,
+// cộng nhiễu ±noise LSB và thỉnh thoảng một gai 0/4095, rồi nạp vào AnalogDecimator.
+class FakeAdcProducer {
+public:
+  explicit FakeAdcProducer(AnalogDecimator& out) : out(out) {}
+
+  void produce(const uint8_t* channels, const uint16_t* levels, uint8_t count, uint16_t perChannel);
+
+  uint16_t noise = 12;
+  uint16_t spikeEvery = 509;   // trung bình một gai sau chừng này mẫu
+  uint32_t blocks = 0, spikes = 0;
+
+private:
+  AnalogDecimator& out;
+  std::vector<uint16_t> block;
+  uint32_t rng = 0x2545F491;
+};
+
+// --------------------- Cảm biến: phát lại trace -----------------
+// Mỗi dòng: ms,temp_c,humidity,ldr_raw,soil_raw  (dòng bắt đầu bằng # là chú thích).
+// Giá trị giữ nguyên tới dòng kế tiếp; hết file thì lặp lại từ đầu.
+// Kịch bản có thể xen dòng lệnh MQTT:  ms,mqtt,topic,payload  — chỉ phát một lần
+// tại đúng thời điểm ms (không lặp theo trace).
+struct TraceRow {
+  uint32_t ms;
+  float temp, hum;
+  int ldr, soil;
+};
+
+struct ScriptedCommand {
+  uint64_t ms;
+  std::string topic;
+  std::string payload;
+};
+
+// --------------------- Đất: mô hình vòng kín cho tưới -----------------
+// Khi gắn vào TraceSensors (sim --soil-model), kênh soil không phát lại cột soil_raw nữa mà đọc
+// từ mô hình một ngăn: nước vùng rễ (water, %) mất theo bốc thoát hơi = baseDryPerH +
+// vpdDryPerH * VPD (từ nhiệt độ/độ ẩm của trace), nhân water / referencePercent (đất ướt mất
+// nhanh hơn); tăng flowPctPerS khi van mở (servo 0°); phần vượt fieldCapacity thấm sâu và mất.
+// Cảm biến trễ sau water với hằng số sensorLagMs (nước ngấm dần tới đầu dò).
+class TraceSensors;
+
+struct SoilPlant {
+  float flowPctPerS = 0.5f;
+  float flowMlPerS = 20.0f;        // chỉ để quy ra lít
+  float baseDryPerH = 0.5f;
+  float vpdDryPerH = 0.8f;
+  float referencePercent = 40.0f;
+  float fieldCapacity = 80.0f;
+  uint32_t sensorLagMs = 600000;
+  float dryPercent = 30.0f;        // đếm thời gian cảm biến dưới mức này
+
+  void attach(TraceSensors& climate, float startPercent);
+  void advance(uint64_t ms);       // tích phân tới thời điểm ms
+  void setValve(bool open);        // tại thời điểm hiện tại của đồng hồ ảo
+  int raw();                       // giá trị ADC của cảm biến lúc này
+  double litres() const { return openMs / 1000.0 * flowMlPerS / 1000.0; }
+
+  float water = 0, sensor = 0;
+  bool valveOpen = false;
+  uint32_t openings = 0;
+  uint64_t openMs = 0, dryMs = 0;
+  double drainedPct = 0;
+  float minSensor = 100, maxSensor = 0;
+
+private:
+  TraceSensors* climate = nullptr;
+  uint64_t lastMs = 0;
+};
+
+class TraceSensors : public SensorHal {
+public:
+  bool load(const char* path, std::vector<ScriptedCommand>* commands = nullptr);
+  void set(const TraceRow& row);  // ghi đè cố định (không dùng trace)
+  const TraceRow& current();
+  const TraceRow& at(uint64_t ms); // giá trị trace tại thời điểm ms bất kỳ (lặp theo chu kỳ trace)
+  int raw(uint8_t pin);           // giá trị ADC thô của trace (không nhiễu), -1 nếu không phải kênh analog
+  size_t rows() const { return trace.size(); }
+
+  bool readClimate(float& temperature, float& humidity) override;
+  int readAnalog(uint8_t pin) override;
+
+  ClimateStats climateStats() override;   // đọc trace NaN tính là timeout
+  uint32_t climateReads = 0, climateFailures = 0, analogReads = 0;
+  SoilPlant* plant = nullptr;      // != nullptr: kênh soil lấy từ mô hình đất thay cho trace
+  AnalogDecimator analog { 64 };   // khối nhỏ hơn ESP32 (500) cho sim chạy nhanh
+  FakeAdcProducer adc { analog };
+
+private:
+  std::vector<TraceRow> trace;
+  uint64_t lastBlockUs = UINT64_MAX;
+  uint32_t periodMs = 0;
+  size_t cursor = 0;
+  TraceRow fixed = { 0, 25.0f, 50.0f, 2048, 2048 };
+};
+
+// --------------------- Cơ cấu chấp hành: ghi lại -----------------
+// Khi record != nullptr, mỗi thay đổi được ghi một dòng CSV để so sánh giữa các lần chạy:
+//   ms,servo,<góc>   ms,tone,<Hz>   ms,pin<n>,<0|1>   ms,leds,<RRGGBB x Board::RING_PIXELS>
+class RecordingActuators : public ActuatorHal {
+public:
+  void servoWrite(int angle) override;
+  void digitalOut(uint8_t pin, bool high) override;
+  void buzzerTone(uint32_t freq) override;
+  void showLeds(const Rgb* pixels, uint16_t count) override;
+
+  int servoAngle = 90;
+  uint32_t toneHz = 0;
+  bool pins[40] = {};
+  Rgb frame[Board::RING_PIXELS] = {};
+
+  uint32_t servoWrites = 0, servoMoves = 0;
+  SoilPlant* plant = nullptr;      // servo 0° = van mở
+  uint32_t toneChanges = 0, pinChanges = 0;
+  uint32_t ledShows = 0, ledChanges = 0;
+  FILE* record = nullptr;
+};
+
+// --------------------- Màn hình: framebuffer 1 bit/pixel -----------------
+class FramebufferDisplay : public DisplayHal {
+public:
+  bool begin() override { return true; }
+  void clear() override;
+  void drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h, bool on) override;
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, bool on) override;
+  void text(int16_t x, int16_t y, const char* s) override;
+  void flush() override;
+  void flushRegion(uint8_t page0, uint8_t page1, uint8_t col0, uint8_t col1) override;
+
+  bool pixel(int16_t x, int16_t y) const;
+
+  uint8_t buffer[Board::SCREEN_WIDTH * Board::SCREEN_HEIGHT / 8] = {};
+  // bytesSent: byte dữ liệu framebuffer + 6 byte lệnh địa chỉ cho mỗi flushRegion()
+  uint32_t flushes = 0, regionFlushes = 0, bytesSent = 0, textCalls = 0;
+
+private:
+  void setPixel(int16_t x, int16_t y, bool on);
+};
+
+// --------------------- WiFi/MQTT: broker giả trong bộ nhớ -----------------
+struct SimMessage {
+  std::string topic;
+  std::string payload;
+  bool retained;
+};
+
+// WiFi bật sẵn lúc khởi động; sau endLink() lần vào mạng kế tiếp mất scanMs (quét đủ kênh)
+// hoặc cachedJoinMs nếu đã biết kênh/BSSID từ lần trước.
+class LoopbackTransport : public TransportHal {
+public:
+  void begin(const char* host, uint16_t port, MessageHandler handler) override;
+  void beginLink(const char*, const char*) override;
+  void endLink() override;
+  void serviceLink() override;   // nhớ kênh/BSSID khi đã vào mạng
+  bool linkUp() override;
+  const char* localIp() override { return "10.0.0.2"; }
+  int8_t rssi() override { return linkUp() ? -55 : 0; }
+  bool connected() override { return session && linkUp(); }
+  bool connect(const char* clientId) override;
+  int state() override { return connected() ? 0 : -2; }
+  bool subscribe(const char* topic) override;
+  bool publish(const char* topic, const uint8_t* payload, size_t length, bool retained) override;
+  void loop() override;
+
+  // phía "broker": đẩy lệnh xuống node, giả lập mất kết nối
+  void inject(const char* topic, const char* payload);
+  void inject(const char* topic, const uint8_t* payload, size_t length);   // nhị phân (đoạn OTA)
+  void drop() { session = false; }
+  size_t pending() const { return inbox.size(); }   // lệnh chờ client.loop()
+
+  bool wifiUp = true;      // AP có sóng
+  bool brokerUp = true;
+  bool radioOn = true;     // WiFi của node đang bật
+  uint64_t linkAtUs = 0;   // thời điểm vào mạng xong
+  uint32_t scanMs = 2500, cachedJoinMs = 300;
+  uint32_t joins = 0, cachedJoins = 0;
+  std::vector<std::string> subscriptions;
+  std::vector<SimMessage> published;  // chỉ giữ khi keepPublished = true
+  bool keepPublished = false;
+  void (*onPublish)(const SimMessage& msg) = nullptr;
+
+  uint32_t connects = 0, publishes = 0, publishBytes = 0, delivered = 0;
+
+private:
+  MessageHandler handler = nullptr;
+  bool session = false;
+  bool cached = false;
+  std::deque<SimMessage> inbox;
+};
+
+// --------------------- Flash: NOR giả trong RAM -----------------
+// Mặc định 0x160000 byte như phân vùng "spiffs" của ESP32. Giữ đúng ngữ nghĩa NOR: ghi chỉ
+// xóa bit (đích &= dữ liệu), bit 0 -> 1 mà chưa erase() được đếm vào programErrors.
+class SimFlash : public FlashHal {
+public:
+  explicit SimFlash(size_t bytes = 0x160000) { resize(bytes); }
+  void resize(size_t bytes);   // xóa toàn bộ (0xFF), đặt lại bộ đếm
+
+  size_t size() override { return data.size(); }
+  bool read(size_t offset, void* out, size_t length) override;
+  bool write(size_t offset, const void* src, size_t length) override;
+  bool erase(size_t sector) override;
+
+  std::vector<uint8_t> data;
+  std::vector<uint32_t> erases;   // số lần xóa từng sector
+  uint32_t reads = 0, writes = 0, programErrors = 0;
+  uint64_t bytesRead = 0, bytesWritten = 0;
+};
+
+// --------------------- OTA: hai phân vùng app giả -----------------
+// app0/app1 0x140000 byte như bảng phân vùng mặc định, chạy từ slot 0. loadRunning() chép file
+// (firmware.bin cũ, base của delta) vào slot đang chạy. activate() chỉ ghi nhận slot khởi động,
+// restart() đếm số lần: firmware mô phỏng chạy tiếp như cũ, running()/inactive() không đổi.
+class SimOta : public OtaHal {
+public:
+  static const size_t SLOT_BYTES = 0x140000;
+  SimOta() { for (SimFlash& s : slots) s.resize(SLOT_BYTES); }
+  bool loadRunning(const char* path);   // false nếu không đọc được hoặc lớn hơn SLOT_BYTES
+
+  FlashHal& running() override { return slots[current]; }
+  FlashHal& inactive() override { return slots[1 - current]; }
+  bool activate(size_t imageSize) override;
+  void restart() override;
+
+  SimFlash slots[2];
+  uint8_t current = 0, boot = 0;
+  size_t runningSize = 0, bootSize = 0;   // byte ảnh trong slot đang chạy / slot khởi động
+  uint32_t activations = 0, restarts = 0;
+};
+
+// --------------------- NVS: blob theo khóa trong RAM -----------------
+// Sống hết tiến trình nên giữ qua deep sleep mô phỏng như NVS thật; writes đếm số lần ghi flash.
+// load()/save() chép ra file (mỗi dòng "khóa hex") để lần chạy sau khởi động với NVS cũ.
+struct SimNvs {
+  bool load(const char* path);   // false nếu không mở được / sai định dạng (file chưa có: true, NVS trống)
+  bool save(const char* path) const;
+
+  std::map<std::string, std::vector<uint8_t>> blobs;
+  uint32_t reads = 0, writes = 0;
+};
+
+// --------------------- Máy chủ TCP: socket POSIX không chặn -----------------
+// Tắt mặc định (listen() trả về false). port khác 0: nghe ở 127.0.0.1:port thay cho cổng firmware
+// yêu cầu (80 cần quyền root), ví dụ 8180 như cổng Wokwi chuyển tiếp trong wokwi.toml.
+class SocketServer : public ServerHal {
+public:
+  bool listen(uint16_t port) override;
+  int accept() override;
+  int read(int conn, void* out, size_t capacity) override;
+  int write(int conn, const void* data, size_t length) override;
+  void close(int conn) override;
+
+  uint16_t port = 0;
+  uint32_t accepted = 0;
+  uint64_t bytesIn = 0, bytesOut = 0;
+
+private:
+  int fd = -1;
+};
+
+TraceSensors& simSensors();
+RecordingActuators& simActuators();
+FramebufferDisplay& simDisplay();
+LoopbackTransport& simTransport();
+SimFlash& simFlash();
+SocketServer& simServer();
+SimNvs& simNvs();
+SimOta& simOta();
+
+#endif
@@ -0,0 +1,414 @@
+#ifndef ARDUINO
+// Chạy firmware (src/main.cpp) trên Linux với đồng hồ ảo: sau mỗi tick nhảy
+// thẳng tới task kế tiếp nên một ngày mô phỏng chỉ mất vài mili-giây.
+//
+//   garden_sim [--trace sim/traces/day_cycle.csv] [--hours 24] [--outage H:D]
+//              [--record FILE] [--expect FILE] [--power always|light|deep]
+//              [--sample-ms MS] [--upload-every N] [--battery MAH] [--node ID]
+//              [--soil-model] [--irrigation predictive|threshold] [--http PORT [--serve S]]
+//              [--nvs FILE] [--ota DELTA --ota-base FILE [--ota-drop BYTES] [--ota-flip OFFSET]] [--verbose]
+//
+// --trace FILE   trace/kịch bản cảm biến, có thể kèm dòng lệnh MQTT (xem hal_native.h)
+// --outage H:D   broker MQTT ngừng từ giờ thứ H trong D giờ
+// --record FILE  ghi mọi thay đổi servo/LED/buzzer/chân ra (CSV, "-" = stdout)
+// --expect FILE  so sánh bản ghi với file đã ghi trước đó, lệch -> in dòng đầu tiên khác, mã thoát 1
+// --power MODE   chế độ năng lượng (PowerConfig trong garden.h), --sample-ms/--upload-every ghi đè
+//                chu kỳ lấy mẫu khi ngủ và số mẫu giữa hai lần bật WiFi
+// --battery MAH  dung lượng pin để ước tính số ngày chạy (mặc định 2000 mAh)
+// --node ID      halDeviceId() của node, tức clientID và cấp thứ hai của topic (mặc định sim-000001)
+// --soil-model   độ ẩm đất lấy từ mô hình vòng kín (SoilPlant trong hal_native.h) thay cho cột soil_raw:
+//                van mở làm đất ướt lên, khô theo nhiệt độ/độ ẩm của trace
+// --irrigation   bộ điều khiển tưới tự động (IrrigationMode trong garden.h), mặc định predictive
+// --http PORT    máy chủ HTTP của firmware nghe ở 127.0.0.1:PORT (firmware mở cổng 80); sau --hours
+//                chạy nhanh, sim chuyển sang đồng hồ thật thêm S giây (--serve, 0 = tới Ctrl-C) để
+//                thử bằng tools/http_load.py
+// --nvs FILE     NVS (cấu hình signal/config) đọc từ FILE khi khởi động và ghi lại khi kết thúc
+// --ota DELTA    host giả gửi delta (tools/ota_delta.py make) qua MQTT như tools/ota_delta.py send;
+//                --ota-base là firmware cũ nạp vào phân vùng đang chạy (SimOta). --ota-drop: khi node
+//                đã nhận quá BYTES thì mất kết nối và quên trạng thái trong RAM (như mất điện), host
+//                gửi lại begin và node tiếp tục từ checkpoint NVS. --ota-flip: đảo một byte delta
+//                trên đường truyền, bản ghi ra phải bị từ chối ở bước kiểm tra hash.
+//                Mã thoát 1 nếu bản mới không được kiểm tra xong và chọn khởi động.
+#include <chrono>
+#include <signal.h>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "garden.h"
+#include "../hal/hal_native.h"
+
+// So từng dòng; in dòng đầu tiên khác nhau. Trả về số dòng khác.
+static uint32_t compareRecords(FILE* got, const char* expectPath) {
+  FILE* want = fopen(expectPath, "r");
+  if (!want) {
+    fprintf(stderr, "cannot open %s\n", expectPath);
+    return 1;
+  }
+  rewind(got);
+  char a[512], b[512];
+  uint32_t line = 0, diffs = 0;
+  for (;;) {
+    bool ha = fgets(a, sizeof(a), got) != nullptr;
+    bool hb = fgets(b, sizeof(b), want) != nullptr;
+    if (!ha && !hb) break;
+    line++;
+    if (ha && hb && !strcmp(a, b)) continue;
+    if (!diffs++) {
+      printf("record        first difference at line %u\n", line);
+      printf("  expected    %s", hb ? b : "<end of file>\n");
+      printf("  got         %s", ha ? a : "<end of file>\n");
+    }
+  }
+  fclose(want);
+  return diffs;
+}
+
+// Host OTA giả: stop-and-wait trên garden/<node>/ota, mỗi status "next=" thì gửi đoạn tại đó.
+// Im lặng quá timeoutMs (mất kết nối) thì gửi lại begin để hỏi node đang ở đâu.
+struct OtaHost {
+  std::vector<uint8_t> delta;
+  std::string beginTopic, chunkTopic, statusTopic, beginPayload;
+  size_t chunk = 512;
+  uint32_t timeoutMs = 5000;
+  uint64_t dropAt = UINT64_MAX;   // một lần
+  uint64_t flipAt = UINT64_MAX;   // một lần
+  bool active = false, dropped = false, flipped = false;
+  uint64_t lastUs = 0;
+  uint32_t chunks = 0, resends = 0, begins = 0, statuses = 0;
+  uint32_t lastOffset = UINT32_MAX;
+  std::string state = "none";
+
+  void sendBegin() {
+    simTransport().inject(beginTopic.c_str(), beginPayload.c_str());
+    begins++;
+    lastUs = simNowUs();
+  }
+
+  void onStatus(const std::string& text) {
+    statuses++;
+    lastUs = simNowUs();
+    char st[16] = "";
+    unsigned long next = 0;
+    sscanf(text.c_str(), "state=%15s next=%lu", st, &next);
+    state = st;
+    if (state == "done" || state == "failed") {
+      active = false;
+      return;
+    }
+    if (state != "header" && state != "patch") return;   // idle: begin kế tiếp; base/verify: chờ
+    if (next >= delta.size()) return;
+    if (!dropped && next >= dropAt) {
+      dropped = true;
+      ota.abort();              // RAM mất như khi khởi động lại; checkpoint NVS còn
+      simTransport().drop();
+      return;
+    }
+    if (next == lastOffset) resends++;
+    lastOffset = next;
+    size_t n = delta.size() - next < chunk ? delta.size() - next : chunk;
+    std::vector<uint8_t> msg(4 + n);
+    uint32_t offset = next;
+    memcpy(&msg[0], &offset, 4);
+    memcpy(&msg[4], &delta[next], n);
+    if (!flipped && flipAt >= next && flipAt < next + n) {
+      flipped = true;
+      msg[4 + flipAt - next] ^= 0x01;
+    }
+    simTransport().inject(chunkTopic.c_str(), msg.data(), msg.size());
+    chunks++;
+  }
+};
+static OtaHost otaHost;
+
+static void otaHostPublish(const SimMessage& m) {
+  if (otaHost.active && m.topic == otaHost.statusTopic) otaHost.onStatus(m.payload);
+}
+
+static bool loadFile(const char* path, std::vector<uint8_t>& out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+  bool ok = !ferror(f);
+  fclose(f);
+  return ok;
+}
+
+static volatile sig_atomic_t interrupted = 0;
+static void onInterrupt(int) { interrupted = 1; }
+
+int main(int argc, char** argv) {
+  const char* tracePath = "sim/traces/day_cycle.csv";
+  double hours = 24;
+  double outageAt = -1, outageFor = 0;
+  const char* recordPath = nullptr;
+  const char* nvsPath = nullptr;
+  const char* expectPath = nullptr;
+  double batteryMah = 2000;
+  bool soilModel = false;
+  double serveS = -1;
+  const char* otaPath = nullptr;
+  const char* otaBasePath = nullptr;
+  bool badOption = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--trace") && i + 1 < argc) tracePath = argv[++i];
+    else if (!strcmp(argv[i], "--hours") && i + 1 < argc) hours = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--outage") && i + 1 < argc) sscanf(argv[++i], "%lf:%lf", &outageAt, &outageFor);
+    else if (!strcmp(argv[i], "--record") && i + 1 < argc) recordPath = argv[++i];
+    else if (!strcmp(argv[i], "--expect") && i + 1 < argc) expectPath = argv[++i];
+    else if (!strcmp(argv[i], "--power") && i + 1 < argc) {
+      const char* mode = argv[++i];
+      if (!strcmp(mode, "always")) power.mode = POWER_ALWAYS_ON;
+      else if (!strcmp(mode, "light")) power.mode = POWER_LIGHT_SLEEP;
+      else if (!strcmp(mode, "deep")) power.mode = POWER_DEEP_SLEEP;
+      else badOption = true;
+    }
+    else if (!strcmp(argv[i], "--sample-ms") && i + 1 < argc) power.sampleMs = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--upload-every") && i + 1 < argc) power.uploadEvery = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--battery") && i + 1 < argc) batteryMah = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--node") && i + 1 < argc) simSetDeviceId(argv[++i]);
+    else if (!strcmp(argv[i], "--soil-model")) soilModel = true;
+    else if (!strcmp(argv[i], "--http") && i + 1 < argc) simServer().port = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--serve") && i + 1 < argc) serveS = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--irrigation") && i + 1 < argc) {
+      const char* mode = argv[++i];
+      if (!strcmp(mode, "predictive")) irrigationMode = IRRIGATION_PREDICTIVE;
+      else if (!strcmp(mode, "threshold")) irrigationMode = IRRIGATION_THRESHOLD;
+      else badOption = true;
+    }
+    else if (!strcmp(argv[i], "--nvs") && i + 1 < argc) nvsPath = argv[++i];
+    else if (!strcmp(argv[i], "--ota") && i + 1 < argc) otaPath = argv[++i];
+    else if (!strcmp(argv[i], "--ota-base") && i + 1 < argc) otaBasePath = argv[++i];
+    else if (!strcmp(argv[i], "--ota-drop") && i + 1 < argc) otaHost.dropAt = strtoull(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--ota-flip") && i + 1 < argc) otaHost.flipAt = strtoull(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--verbose")) simSetVerbose(true);
+    else badOption = true;
+  }
+  if (badOption || !power.sampleMs || !power.uploadEvery || (otaPath && !otaBasePath)) {
+    fprintf(stderr, "usage: %s [--trace FILE] [--hours H] [--outage H:D] [--record FILE] [--expect FILE]\n"
+                    "       [--power always|light|deep] [--sample-ms MS] [--upload-every N] [--battery MAH]\n"
+                    "       [--node ID] [--soil-model] [--irrigation predictive|threshold]\n"
+                    "       [--http PORT [--serve S]] [--nvs FILE]\n"
+                    "       [--ota DELTA --ota-base FILE [--ota-drop BYTES] [--ota-flip OFFSET]] [--verbose]\n",
+            argv[0]);
+    return 2;
+  }
+  if (nvsPath && !simNvs().load(nvsPath)) {
+    fprintf(stderr, "cannot load NVS %s\n", nvsPath);
+    return 1;
+  }
+  if (otaPath) {
+    if (!loadFile(otaPath, otaHost.delta) || otaHost.delta.size() < OTA_DELTA_HEADER) {
+      fprintf(stderr, "cannot load delta %s\n", otaPath);
+      return 1;
+    }
+    if (!simOta().loadRunning(otaBasePath)) {
+      fprintf(stderr, "cannot load %s into the running slot (max %zu bytes)\n", otaBasePath, SimOta::SLOT_BYTES);
+      return 1;
+    }
+    OtaDeltaHeader h;
+    memcpy(&h, otaHost.delta.data(), sizeof(h));
+    char node[32], sha[2 * SHA256_SIZE + 1], text[128];
+    halDeviceId(node, sizeof(node));
+    sha256ToHex(h.targetSha, sha);
+    std::string prefix = std::string("garden/") + node + "/";
+    otaHost.beginTopic = prefix + "signal/ota/begin";
+    otaHost.chunkTopic = prefix + "signal/ota/chunk";
+    otaHost.statusTopic = prefix + "ota";
+    snprintf(text, sizeof(text), "size=%zu sha256=%s", otaHost.delta.size(), sha);
+    otaHost.beginPayload = text;
+    otaHost.active = true;
+    simTransport().onPublish = otaHostPublish;
+    otaHost.sendBegin();   // trong hộp thư tới khi node kết nối
+  }
+  std::vector<ScriptedCommand> script;
+  if (!simSensors().load(tracePath, &script)) {
+    fprintf(stderr, "cannot load trace %s\n", tracePath);
+    return 1;
+  }
+  RecordingActuators& act = simActuators();
+  SoilPlant plant;
+  if (soilModel) {
+    plant.attach(simSensors(), simSensors().at(0).soil * 100.0f / 4095);
+    simSensors().plant = &plant;
+    act.plant = &plant;
+  }
+  FILE* record = nullptr;
+  if (recordPath && !strcmp(recordPath, "-")) record = stdout;
+  else if (recordPath) record = fopen(recordPath, expectPath ? "w+" : "w");
+  else if (expectPath) record = tmpfile();
+  if ((recordPath || expectPath) && !record) {
+    fprintf(stderr, "cannot open %s\n", recordPath ? recordPath : "temporary record");
+    return 1;
+  }
+  if (record == stdout && expectPath) {
+    fprintf(stderr, "--expect needs --record FILE, not stdout\n");
+    return 2;
+  }
+  act.record = record;
+
+  auto wallStart = std::chrono::steady_clock::now();
+  setup();
+
+  uint64_t endUs = simNowUs() + (uint64_t)(hours * 3600e6);
+  // --http: sau phần chạy nhanh, thêm serveS giây theo đồng hồ thật (0 = tới Ctrl-C)
+  bool serving = simServer().port != 0;
+  uint64_t stopUs = !serving ? endUs : serveS > 0 ? endUs + (uint64_t)(serveS * 1e6) : UINT64_MAX;
+  if (serving) signal(SIGINT, onInterrupt);
+  auto realStart = std::chrono::steady_clock::now();
+  uint64_t ticks = 0;
+  int idle = 0;
+  uint64_t outageStartUs = outageAt < 0 ? UINT64_MAX : (uint64_t)(outageAt * 3600e6);
+  uint64_t outageEndUs = outageAt < 0 ? UINT64_MAX : outageStartUs + (uint64_t)(outageFor * 3600e6);
+  LoopbackTransport& net = simTransport();
+  size_t nextCommand = 0;
+  while (simNowUs() < stopUs && !interrupted) {
+    bool down = simNowUs() >= outageStartUs && simNowUs() < outageEndUs;
+    if (down && net.brokerUp) net.drop();
+    net.brokerUp = !down;
+    // lệnh trong kịch bản vào hộp thư broker; node nhận ở lần client.loop() kế tiếp
+    while (nextCommand < script.size() && script[nextCommand].ms * 1000 <= simNowUs()) {
+      const ScriptedCommand& c = script[nextCommand++];
+      net.inject(c.topic.c_str(), c.payload.c_str());
+    }
+    if (otaHost.active && simNowUs() - otaHost.lastUs >= otaHost.timeoutMs * 1000ull) otaHost.sendBegin();
+    loop();
+    ticks++;
+    uint32_t wait = ioScheduler.msUntilNext();
+    uint32_t netWait = netScheduler.msUntilNext();
+    if (netWait < wait) wait = netWait;
+    // không nhảy qua thời điểm của lệnh kế tiếp
+    if (nextCommand < script.size()) {
+      uint64_t dueMs = script[nextCommand].ms, nowMs = simNowUs() / 1000;
+      uint64_t untilCommand = dueMs > nowMs ? dueMs - nowMs : 0;
+      if (untilCommand < wait) wait = (uint32_t)untilCommand;
+    }
+    if (otaHost.active) {
+      uint64_t dueUs = otaHost.lastUs + otaHost.timeoutMs * 1000ull, nowUs = simNowUs();
+      uint32_t untilHost = dueUs > nowUs ? (uint32_t)((dueUs - nowUs + 999) / 1000) : 0;
+      if (untilHost < wait) wait = untilHost;
+    }
+    if (wait == UINT32_MAX) break;
+    // còn mẫu/lệnh trong hàng đợi giữa hai luồng -> tick lại ngay, không nhảy thời gian
+    if (!sampleQueue.empty() || !commandQueue.empty()) continue;
+    // đoạn OTA vừa đẩy xuống: node nhận ngay như trên mạng thật, không đợi task kế tiếp
+    if (otaHost.active && net.connected() && net.pending()) continue;
+    // task một lần được kích hoạt liên tục -> vẫn cho thời gian trôi
+    if (wait == 0 && ++idle < 100) continue;
+    idle = 0;
+    if (simNowUs() < endUs) {
+      simAdvance(wait ? wait : 1);
+      realStart = std::chrono::steady_clock::now();
+      continue;
+    }
+    // đồng hồ thật: ngủ tới task kế tiếp (tối đa 10 ms) rồi cho thời gian ảo trôi đúng bằng đó
+    std::this_thread::sleep_for(std::chrono::milliseconds(wait < 10 ? (wait ? wait : 1) : 10));
+    auto realNow = std::chrono::steady_clock::now();
+    simAdvanceUs((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(realNow - realStart).count());
+    realStart = realNow;
+  }
+
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  double simHours = simNowUs() / 3600e6;
+  FramebufferDisplay& oled = simDisplay();
+
+  printf("simulated     %.1f h in %.3f s (%.0f sim-h/s), %llu ticks\n",
+         simHours, wall, wall > 0 ? simHours / wall : 0.0, (unsigned long long)ticks);
+  printf("sensors       %u climate reads, %u analog reads\n",
+         simSensors().climateReads, simSensors().analogReads);
+  printf("adc           %u DMA blocks, %u samples, %u spikes injected\n",
+         simSensors().adc.blocks, simSensors().analog.samples, simSensors().adc.spikes);
+  printf("mqtt          %u connects, %u publishes, %u payload bytes, %u commands (%zu/%zu scripted)\n",
+         net.connects, net.publishes, net.publishBytes, net.delivered, nextCommand, script.size());
+  printf("backlog       %zu queued, max %zu, %u dropped\n", backlog.size(), backlog.maxUsed(), backlog.dropped());
+  printf("queues        samples max %zu/%zu, %u dropped; commands max %zu/%zu, %u dropped\n",
+         sampleQueue.maxUsed(), sampleQueue.capacity(), sampleQueue.dropped(),
+         commandQueue.maxUsed(), commandQueue.capacity(), commandQueue.dropped());
+  printf("servo         %u writes, %u moves\n", act.servoWrites, act.servoMoves);
+  if (soilModel) {
+    plant.advance(simNowUs() / 1000);
+    printf("soil          %u waterings, %.1f min open, %.2f L, %.1f%% drained; sensor %.1f..%.1f%%, %.1f h below %.0f%%\n",
+           plant.openings, plant.openMs / 60e3, plant.litres(), plant.drainedPct, plant.minSensor, plant.maxSensor,
+           plant.dryMs / 3600e3, plant.dryPercent);
+  }
+  printf("config        %u updates, %u rejected, %u NVS writes; soil dry %u%% target %.0f%%, overheat %.1f C, "
+         "light raw %u..%u\n", configUpdates.value, configRejected.value, simNvs().writes, config.soilDryPercent,
+         config.soilTargetPercent, config.overheatC, config.light.minRaw, config.light.maxRaw);
+  bool otaOk = true;
+  if (otaPath) {
+    // kiểm tra độc lập với firmware: slot khởi động chứa đúng ảnh có SHA-256 trong header delta
+    SimOta& slots = simOta();
+    OtaDeltaHeader h;
+    memcpy(&h, otaHost.delta.data(), sizeof(h));
+    uint8_t digest[SHA256_SIZE];
+    Sha256 sha;
+    sha.update(slots.slots[slots.boot].data.data(), slots.bootSize);
+    sha.finish(digest);
+    bool booted = slots.boot != slots.current && slots.bootSize == h.targetSize;
+    otaOk = booted && !memcmp(digest, h.targetSha, SHA256_SIZE) && slots.restarts;
+    printf("ota           %s: %zu B delta -> %u B image, %u chunks (%u resent), %u begins, %u statuses; %u B copied, "
+           "%u B new, %u erases, %u checkpoints, %s%s; boot slot %u %s, %u restarts\n",
+           otaHost.state.c_str(), otaHost.delta.size(), h.targetSize, otaHost.chunks, otaHost.resends, otaHost.begins,
+           otaHost.statuses, ota.copied, ota.literal, ota.erased, ota.checkpoints, otaHost.dropped ? "resumed after drop" : "no drop",
+           otaHost.flipped ? ", 1 byte corrupted" : "", slots.boot, otaOk ? "verified" : "NOT UPDATED", slots.restarts);
+  }
+  printf("leds          %u shows, %u changes\n", act.ledShows, act.ledChanges);
+  printf("buzzer        %u tone changes\n", act.toneChanges);
+#if GARDEN_HISTORY
+  SimFlash& flash = simFlash();
+  uint32_t minErase = UINT32_MAX, maxErase = 0;
+  for (uint32_t n : flash.erases) {
+    if (n < minErase) minErase = n;
+    if (n > maxErase) maxErase = n;
+  }
+  printf("history       %u samples, %u frames, %u B (%.2f B/sample), %u rotations, erases/sector %u..%u, %u program errors\n",
+         history.samples, history.frames, history.bytes, history.samples ? (double)history.bytes / history.samples : 0.0,
+         history.rotations, minErase, maxErase, flash.programErrors);
+#endif
+#if GARDEN_HTTP
+  if (serving)
+    printf("http          %u connections, %u requests, %u responses, %u errors, %u busy, %u timeouts, %u resets, %llu B sent\n",
+           http.connections, http.requests, http.responses, http.errors, http.rejected, http.timeouts, http.resets,
+           (unsigned long long)http.bytesSent);
+#endif
+  printf("oled          %u full + %u region flushes, %u bytes\n", oled.flushes, oled.regionFlushes, oled.bytesSent);
+  const EnergyMeter& e = simEnergy();
+  double totalUs = (double)simNowUs();
+  double avgMa = totalUs > 0 ? e.mAs / (totalUs / 1e6) : 0;
+  printf("energy        %.1f mAh, avg %.2f mA; awake %.2f%% (radio %.2f%%), light %.2f%%, deep %.2f%%\n",
+         e.mAh(), avgMa, 100 * e.awakeUs / totalUs, 100 * e.radioUs / totalUs,
+         100 * e.lightUs / totalUs, 100 * e.deepUs / totalUs);
+  printf("power         %u sleeps (%u threshold wakes), %u WiFi joins (%u cached), %.0f mAh battery: %.1f days\n",
+         e.sleeps, e.thresholdWakes, net.joins, net.cachedJoins, batteryMah,
+         avgMa > 0 ? batteryMah / avgMa / 24 : 0.0);
+  const ConnectStats& cs = connection.stats();
+  printf("connection    %u online, %u/%u MQTT attempts failed, time-to-online last %u ms, max %u ms\n",
+         cs.onlines, cs.failures, cs.attempts, cs.lastOnlineMs, cs.maxOnlineMs);
+  char diag[512];
+  metrics.format(diag, sizeof(diag), (uint32_t)(simNowUs() / 1000000));
+  printf("diagnostics   %s\n", diag);
+  const Scheduler* threads[] = { &netScheduler, &ioScheduler };
+  const char* names[] = { "net", "io" };
+  printf("     task         runs  missed overrun\n");
+  for (int k = 0; k < 2; k++) {
+    for (uint8_t i = 0; i < threads[k]->count(); i++) {
+      const Task& t = threads[k]->task(i);
+      printf("%-4s %-12s %7u %7u %7u\n", i ? "" : names[k], t.name, t.runs, t.missed, t.overruns);
+    }
+  }
+
+  if (nvsPath && !simNvs().save(nvsPath)) fprintf(stderr, "cannot write NVS %s\n", nvsPath);
+
+  act.record = nullptr;
+  uint32_t diffs = 0;
+  if (expectPath) {
+    fflush(record);
+    diffs = compareRecords(record, expectPath);
+    printf("record        %s: %s (%u lines differ)\n", expectPath, diffs ? "MISMATCH" : "match", diffs);
+  }
+  if (record && record != stdout) fclose(record);
+  return diffs || !otaOk ? 1 : 0;
+}
+#endif
@@ -0,0 +1,173 @@
+#ifndef ARDUINO
+// ThingSpeakBulk (lib/ThingSpeakBulk) chạy trên host qua socket POSIX, gửi tới
+// tools/thingspeak_standin.py (hoặc ThingSpeak thật): mỗi --every-ms xếp một bản ghi
+// 7 field như test/main.cpp, poll() liên tục, dừng khi mọi bản ghi đã được server nhận
+// hoặc hết --seconds. Mã thoát 0 khi đủ, 1 khi còn bản ghi chưa gửi hoặc bị ghi đè.
+//
+//   thingspeak_host [--host 127.0.0.1] [--port 8080] [--channel 1] [--key KEY]
+//                   [--records 40] [--every-ms 20] [--flush-ms 100] [--timeout-ms 2000]
+//                   [--seconds 30]
+//
+// tools/thingspeak_standin.py --check PROGRAM chạy chương trình này với từng chế độ của
+// máy chủ giả (độ trễ, lỗi 500, Connection: close, chunked, sai write_api_key).
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <ThingSpeakBulk.h>
+
+// Client kiểu WiFiClient: connect() chặn (như bắt tay TCP trên ESP32), đọc không chặn qua
+// buffer nhỏ; connected() còn true khi server đã đóng nhưng vẫn còn byte chưa đọc
+class SocketClient : public Client {
+public:
+  ~SocketClient() override { stop(); }
+
+  int connect(const char* host, uint16_t port) override {
+    stop();
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    addrinfo hints = {}, *list = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, service, &hints, &list) != 0) return 0;
+    for (addrinfo* a = list; a && fd < 0; a = a->ai_next) {
+      fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      if (fd < 0) continue;
+      if (::connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+        close(fd);
+        fd = -1;
+      }
+    }
+    freeaddrinfo(list);
+    if (fd < 0) return 0;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    peerClosed = false;
+    head = tail = 0;
+    return 1;
+  }
+
+  size_t write(const uint8_t* buf, size_t size) override {
+    size_t sent = 0;
+    while (fd >= 0 && sent < size) {
+      ssize_t n = send(fd, buf + sent, size - sent, MSG_NOSIGNAL);
+      if (n > 0) sent += n;
+      else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) usleep(1000);
+      else break;
+    }
+    return sent;
+  }
+
+  int available() override {
+    fill();
+    return tail - head;
+  }
+
+  int read() override {
+    if (!available()) return -1;
+    return buffer[head++];
+  }
+
+  void stop() override {
+    if (fd >= 0) close(fd);
+    fd = -1;
+    head = tail = 0;
+  }
+
+  uint8_t connected() override {
+    fill();
+    return fd >= 0 && (!peerClosed || head < tail);
+  }
+
+private:
+  void fill() {
+    if (fd < 0 || peerClosed || head < tail) return;
+    head = tail = 0;
+    ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+    if (n > 0) tail = n;
+    else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) peerClosed = true;
+  }
+
+  int fd = -1;
+  bool peerClosed = false;
+  uint8_t buffer[512];
+  int head = 0, tail = 0;
+};
+
+static uint32_t nowMs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000ull + ts.tv_nsec / 1000000);
+}
+
+int main(int argc, char** argv) {
+  const char* host = "127.0.0.1";
+  const char* key = "Q0C1U02B034TQZ1I";
+  unsigned port = 8080;
+  unsigned long channel = 1;
+  uint32_t records = 40, everyMs = 20, flushMs = 100, timeoutMs = 2000;
+  double seconds = 30;
+  bool badOption = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--host") && i + 1 < argc) host = argv[++i];
+    else if (!strcmp(argv[i], "--port") && i + 1 < argc) port = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--channel") && i + 1 < argc) channel = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--key") && i + 1 < argc) key = argv[++i];
+    else if (!strcmp(argv[i], "--records") && i + 1 < argc) records = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--every-ms") && i + 1 < argc) everyMs = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--flush-ms") && i + 1 < argc) flushMs = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--timeout-ms") && i + 1 < argc) timeoutMs = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atof(argv[++i]);
+    else badOption = true;
+  }
+  if (badOption || !port || port > 65535 || !records) {
+    fprintf(stderr, "usage: %s [--host H] [--port P] [--channel N] [--key KEY] [--records N] [--every-ms MS]\n"
+                    "       [--flush-ms MS] [--timeout-ms MS] [--seconds S]\n", argv[0]);
+    return 2;
+  }
+
+  SocketClient client;
+  ThingSpeakBulk ts(client, host, (uint16_t)port, channel, key);
+  ts.setFlushInterval(flushMs);
+  ts.setTimeout(timeoutMs);
+
+  uint32_t start = nowMs(), lastCommit = 0, committed = 0;
+  const TsStats& s = ts.stats();
+  while (s.sent < records && nowMs() - start < seconds * 1000) {
+    uint32_t now = nowMs();
+    if (committed < records && (committed == 0 || now - lastCommit >= everyMs)) {
+      // cùng 7 field như test/main.cpp: nhiệt độ, độ ẩm, ánh sáng, đất, bơm, đèn, heat index
+      float k = (float)committed;
+      ts.setField(1, 24.0f + k * 0.1f);
+      ts.setField(2, 60.0f - k * 0.2f);
+      ts.setField(3, (float)(committed % 100));
+      ts.setField(4, (float)(40 + committed % 20));
+      ts.setField(5, (float)(committed & 1));
+      ts.setField(6, (float)(committed / 2 & 1));
+      ts.setField(7, 25.0f + k * 0.1f);
+      ts.commit();
+      committed++;
+      lastCommit = now;
+    }
+    ts.poll();
+    usleep(1000);
+  }
+
+  bool ok = s.sent == records && ts.dropped() == 0;
+  printf("thingspeak    %s: %lu/%lu sent, %lu requests, %lu failures, %lu timeouts, %lu connects, "
+         "latency last %lu ms max %lu ms, %u pending, %lu dropped\n",
+         ok ? "ok" : "INCOMPLETE", (unsigned long)s.sent, (unsigned long)records, (unsigned long)s.requests,
+         (unsigned long)s.failures, (unsigned long)s.timeouts, (unsigned long)s.connects,
+         (unsigned long)s.lastLatencyMs, (unsigned long)s.maxLatencyMs, (unsigned)ts.pending(),
+         (unsigned long)ts.dropped());
+  return ok ? 0 : 1;
+}
+#endif
@@ -1,28 +1,30 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <PubSubClient.h>
-#include <ThingSpeak.h>
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include <Adafruit_NeoPixel.h>
 #include <ESP32Servo.h>
-#include "DHT.h"
-
-/* ===== PINS ===== */
-#define DHTPIN 4
-#define DHTTYPE DHT22
-#define LDR_PIN 34
-#define SOIL_PIN 35
-#define RING_PIN 25
-#define RING_PIX 16
-#define SERVO_PIN 26
-
-/* ===== Thresholds / timing ===== */
-const int   LIGHT_ON  = 40;
-const int   LIGHT_OFF = 50;
-const int   SOIL_ON   = 35;
-const int   SOIL_OFF  = 45;
+#include <Dht22.h>
+#include <Dispatcher.h>
+#include <Ssd1306Display.h>
+#include <StatusView.h>
+#include <AnalogStream.h>
+#include <Filters.h>
+#include <SpscQueue.h>
+#include <ThingSpeakBulk.h>
+#include <ChangeReporter.h>
+#include <AdcDmaSampler.h>
+#include <Backoff.h>
+#include <LedEngine.h>
+#include <Irrigation.h>
+#include "board.h"
+
+/* ===== Board: chân, hiệu chuẩn, bộ lọc, ngưỡng (include/board.h) ===== */
+typedef FarmRing Rig;
+
+/* ===== Timing ===== */
 const unsigned long PUMP_MIN_ON   = 5000;
 const unsigned long PUMP_COOLDOWN = 10000;
 
@@ -39,6 +41,16 @@ const char* TOPIC_HUM    = "farm/hum";
 const char* TOPIC_LIGHT  = "farm/light";
 const char* TOPIC_SOIL   = "farm/soil";
 
+/* Report-on-change (lib/ChangeReporter): số đo sang netTask mỗi SAMPLE_INTERVAL,
+ * topic retained chỉ gửi khi đổi đủ lớn / qua ngưỡng điều khiển / sau heartbeat */
+const unsigned long SAMPLE_INTERVAL = 2000;   // = chu kỳ tối thiểu của DHT22
+//                                 abs   rel   minIntervalMs heartbeatMs threshold
+const ReportPolicy TEMP_REPORT  = { 0.2f, 0.0f, 2000,         300000,     NAN };
+const ReportPolicy HUM_REPORT   = { 2.0f, 0.0f, 30000,        300000,     NAN };
+const ReportPolicy LIGHT_REPORT = { 3.0f, 0.1f, 30000,        300000,     (float)Rig::LIGHT_ON_PERCENT };
+const ReportPolicy SOIL_REPORT  = { 2.0f, 0.0f, 30000,        300000,     (float)Rig::SOIL_ON_PERCENT };
+ChangeReporter tempReport(TEMP_REPORT), humReport(HUM_REPORT), lightReport(LIGHT_REPORT), soilReport(SOIL_REPORT);
+
 const char* T_CMD_MODE   = "farm/cmd/mode";
 const char* T_CMD_LAMP   = "farm/cmd/lamp";
 const char* T_CMD_BRIGHT = "farm/cmd/lamp/bright";
@@ -54,32 +66,52 @@ const char* T_ST_PUMP    = "farm/status/pump";
 WiFiClient   net;
 PubSubClient mqtt(net);
 
+// Kết nối MQTT không chặn: thử lại sau 1, 2, 4 ... tối đa 60 s (jitter 50 %), đo time-to-online
+const BackoffPolicy MQTT_BACKOFF = { 1000, 60000, 50 };
+Backoff mqttBackoff(MQTT_BACKOFF);
+bool mqttOnline = false;
+unsigned long mqttRetryAt = 0, offlineSince = 0;
+uint32_t mqttAttempts = 0, mqttFailures = 0, lastOnlineMs = 0, maxOnlineMs = 0;
+
+// Thử cục bộ: tools/thingspeak_standin.py, TS_HOST "host.wokwi.internal", TS_PORT 8080
+#define TS_HOST "api.thingspeak.com"
+#define TS_PORT 80
 WiFiClient   tsClient;
 unsigned long myChannelNumber = 3064394;
 const char* myWriteAPIKey = "Q0C1U02B034TQZ1I";
+const uint32_t ts_flush_interval = 60000;   // gửi dồn ~4 bản ghi / request bulk
+ThingSpeakBulk thingSpeak(tsClient, TS_HOST, TS_PORT, myChannelNumber, myWriteAPIKey);
 unsigned long previousMillis = 0;
 const long ts_update_interval = 15000;
 
 /* ===== OLED ===== */
-#define SCREEN_WIDTH 128
-#define SCREEN_HEIGHT 64
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire);
+Adafruit_SSD1306 display(Rig::SCREEN_WIDTH, Rig::SCREEN_HEIGHT, &Wire);
+Ssd1306Display oled(display, Rig::OLED_ADDRESS);
+const StatusFormats OLED_FORMATS = { "T: %.1f C", "H: %.0f %%", "L: %d %%", "S: %d %%" };
+StatusView statusView(oled, OLED_FORMATS);   // chỉ vẽ lại/gửi trường thay đổi
 
 /* ===== NeoPixel + Servo ===== */
-Adafruit_NeoPixel ring(RING_PIX, RING_PIN, NEO_GRB + NEO_KHZ800);
+Adafruit_NeoPixel ring(Rig::RING_PIXELS, Rig::RING_PIN, NEO_GRB + NEO_KHZ800);
+// Màu/độ sáng chuyển mượt qua bảng gamma (lib/LedEngine), ring chỉ show() khi khung đổi
+const uint16_t LAMP_FRAME_MS = 20;     // 50 khung/s
+const uint32_t LAMP_FADE_MS  = 400;
+Rgb lampPixels[Rig::RING_PIXELS];
+LedEngine lamp(lampPixels, Rig::RING_PIXELS, LAMP_FRAME_MS);
 Servo pumpServo;
 
-/* ===== Filters/calib ===== */
-const int   LDR_MIN_RAW=0, LDR_MAX_RAW=3500;
-const float EMA_ALPHA=0.15f; const int MEDIAN_SAMPLES=7; const int RAW_DEADBAND=4;
-const bool  INVERT_LIGHT=true;
-const int   SOIL_WET_RAW=0, SOIL_DRY_RAW=4095;
-const float SOIL_EMA_ALPHA=0.15f; const int SOIL_MEDIAN_N=7; const int SOIL_DEADBAND=6;
-const bool  SOIL_INVERT=false;
+/* ===== ADC liên tục (DMA) ===== */
+// 20 kHz cho 2 kênh = 10 kHz/kênh, mỗi 500 mẫu -> 1 giá trị (trung bình bỏ min/max)
+AnalogDecimator analogIn(500);
+AdcDmaSampler adcDma(analogIn, 20000);
+const uint8_t ADC_PINS[] = { Rig::LDR_PIN, Rig::SOIL_PIN };
 
 /* ===== Globals ===== */
-DHT dht(DHTPIN, DHTTYPE);
+Dht22 dht(Rig::DHT_PIN);                     // đo nền, không chặn loop()
+const unsigned long DHT_MAX_AGE = 10000;
 float hum=0, temp=0, hic=0, lightPct=0, soilPct=0;
+Rig::LightFilter ldrFilter;
+Rig::SoilFilter  soilFilter;
+Hysteresis<float, Rig::LIGHT_ON_PERCENT, Rig::LIGHT_OFF_PERCENT> daylight;   // true = đủ sáng, tắt đèn
 
 bool autoMode = true;
 bool lampOn=false, pumpOn=false;
@@ -87,28 +119,54 @@ uint8_t lampBright = 120;               // 0..255
 uint32_t lampColor = 0xFFB43C;         // 0xRRGGBB (mặc định vàng ấm)
 unsigned long pumpTs=0;                // thời điểm gần nhất bật bơm
 unsigned long pumpManualUntil=0;       // nếu >0: đang tưới theo lệnh manual đến mốc thời gian này
-
-/* ---------- Icons rút gọn ---------- */
-const unsigned char icon_temp16[] PROGMEM = {0x06,0,0x06,0,0x06,0,0x06,0,0x06,0,0x06,0,0x06,0,0x06,0,0x0F,0,0x1F,0x80,0x3F,0xC0,0x3F,0xC0,0x3F,0xC0,0x1F,0x80,0x0F,0,0x06,0};
-const unsigned char icon_humid16[] PROGMEM={0x03,0,0x07,0x80,0x0F,0xC0,0x1F,0xE0,0x1F,0xE0,0x3F,0xF0,0x3F,0xF0,0x3F,0xF0,0x1F,0xE0,0x1F,0xE0,0x0F,0xC0,0x07,0x80,0x03,0,0x03,0,0x01,0,0,0};
-const unsigned char icon_light16[] PROGMEM={0x01,0,0x03,0x80,0x07,0xC0,0x0C,0x60,0x10,0x10,0x10,0x10,0x20,0x08,0x21,0x08,0x20,0x08,0x10,0x10,0x10,0x10,0x0C,0x60,0x07,0xC0,0x03,0x80,0x01,0,0,0};
-const unsigned char icon_soil16[]  PROGMEM={0,0,0x01,0,0x03,0x80,0x06,0xC0,0x03,0x80,0x01,0,0,0,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0,0,0,0,0,0,0,0,0,0,0,0};
+unsigned long pumpAutoUntil=0;         // nếu >0: xung tưới tự động kết thúc ở mốc này
+
+/* Bơm tự động (lib/Irrigation): tốc độ khô ước lượng theo nhiệt độ/độ ẩm không khí, mỗi lần
+ * một xung đủ dài để về SOIL_TARGET_PERCENT, chờ nước ngấm tới cảm biến rồi mới đánh giá lại */
+//                                   low      target       horizonMs soakMs   windowMs minPulse maxPulse gain/s dry/h
+const IrrigationPolicy IRRIGATION = { Rig::SOIL_ON_PERCENT, Rig::SOIL_TARGET_PERCENT, 1800000,  1800000, 1800000, 1000,    30000,   1.0f,  2.0f };
+IrrigationController irrigation(IRRIGATION);
+
+
+/* ===== Hai luồng =====
+ * netTask (core 0, cùng WiFi stack): MQTT, ThingSpeak. loop() (core 1): đo, điều
+ * khiển, OLED, NeoPixel, servo. Chỉ trao đổi qua các hàng đợi SPSC không khóa.
+ */
+struct Reading { float temp, hum, hic, light, soil; bool lamp, pump; bool log; uint32_t ms; };  // log: ghi ThingSpeak
+struct OutMsg  { char topic[32]; char payload[16]; };
+struct CmdMsg  { char topic[32]; uint8_t payload[32]; uint8_t length; };
+SpscQueue<Reading, 4> readings;   // loop() -> netTask, mỗi SAMPLE_INTERVAL
+SpscQueue<OutMsg, 16> outbox;     // loop() -> netTask, trạng thái (retained)
+SpscQueue<CmdMsg, 8>  inbox;      // netTask -> loop(), lệnh farm/cmd/#
+TaskHandle_t netTask = nullptr;
+volatile bool statusRequested = false;   // netTask vừa kết nối lại, loop() gửi lại toàn bộ trạng thái
+const uint32_t NET_STACK = 8192;
+const unsigned long METRICS_INTERVAL = 60000;
 
 /* ===== Utils ===== */
-template<int N> int medianRead(int pin){
-  int a[N]; for(int i=0;i<N;i++){ a[i]=analogRead(pin); delay(1); }
-  for(int i=0;i<N-1;i++) for(int j=i+1;j<N;j++) if(a[j]<a[i]){ int t=a[i]; a[i]=a[j]; a[j]=t; }
-  return a[N/2];
-}
-static inline float mapFloat(float x,float in_min,float in_max,float out_min,float out_max){
-  return (x-in_min)*(out_max-out_min)/(in_max-in_min)+out_min;
+// Giá trị decimate mới từ luồng DMA, mỗi giá trị trả về đúng một lần (không chờ);
+// analogRead() nếu DMA không chạy
+bool analogNext(int pin, uint32_t& seen, int& value){
+  if(!adcDma.running()){ value=analogRead(pin); return true; }
+  uint8_t ch=adc1Channel(pin);
+  if(analogIn.outputs(ch)==seen) return false;
+  seen=analogIn.outputs(ch);
+  uint16_t v=0; analogIn.latest(ch, v);
+  value=v;
+  return true;
 }
 
 /* ===== Actuators ===== */
+// Chỉ đặt màu/độ sáng đích; loop() gửi từng khung trong lúc chuyển
 void applyLamp(){
-  ring.setBrightness(lampBright);
-  if(lampOn){ ring.fill(lampColor); }
-  else      { ring.clear(); }
+  uint32_t now = millis();
+  lamp.setColor(rgbFromHex(lampColor), LAMP_FADE_MS, now);
+  lamp.setBrightness(lampOn ? lampBright : 0, LAMP_FADE_MS, now);
+}
+void renderLamp(uint32_t now){
+  if(!lamp.render(now)) return;
+  Rgb c = lamp.output();
+  ring.fill(ring.Color(c.r, c.g, c.b));
   ring.show();
 }
 void lampSet(bool on){ lampOn=on; applyLamp(); }
@@ -117,88 +175,164 @@ void pumpStart(){ pumpOn=true; pumpTs=millis(); pumpServo.write(90); }
 void pumpStop (){ pumpOn=false;              pumpServo.write(0);  }
 
 /* ===== Publish status ===== */
-void pub(const char* t, const String& s){ mqtt.publish(t, s.c_str(), true); }
+// Chỉ gọi từ loop(): xếp vào outbox, netTask gửi
+void pub(const char* t, const char* s){
+  OutMsg m;
+  strncpy(m.topic, t, sizeof(m.topic)-1);   m.topic[sizeof(m.topic)-1]=0;
+  strncpy(m.payload, s, sizeof(m.payload)-1); m.payload[sizeof(m.payload)-1]=0;
+  outbox.push(m);
+}
+void pubBright(){ char v[4]; snprintf(v,sizeof(v),"%u",(unsigned)lampBright); pub(T_ST_BRIGHT, v); }
+void pubColor(){ char hex[8]; snprintf(hex,sizeof(hex),"#%06X",(unsigned)lampColor); pub(T_ST_COLOR, hex); }
 void publishAllStatus(){
   pub(T_ST_MODE,   autoMode? "AUTO":"MANUAL");
   pub(T_ST_LAMP,   lampOn? "ON":"OFF");
-  pub(T_ST_BRIGHT, String(lampBright));
-  char hex[8]; sprintf(hex,"#%06X", (unsigned)lampColor); pub(T_ST_COLOR, String(hex));
+  pubBright();
+  pubColor();
   pub(T_ST_PUMP,   pumpOn? "ON":"OFF");
 }
 
-/* ===== Helpers ===== */
-uint32_t parseHexColor(String s){
-  s.trim(); s.toUpperCase();
-  if(s.startsWith("#")) s.remove(0,1);
-  if(s.length()!=6) return lampColor;
-  char *end=nullptr;
-  uint32_t v = strtoul(s.c_str(), &end, 16);
-  return v;
-}
-
 /* ===== MQTT callback ===== */
-void onMqtt(char* topic, byte* payload, unsigned int len){
-  String top = String(topic);
-  String msg; msg.reserve(len);
-  for(unsigned int i=0;i<len;i++) msg += (char)payload[i];
-  msg.trim();
-
-  if(top == T_CMD_MODE){
-    autoMode = (msg.equalsIgnoreCase("AUTO"));
-    pub(T_ST_MODE, autoMode? "AUTO":"MANUAL");
-    return;
-  }
-  if(top == T_CMD_LAMP){
-    if(msg.equalsIgnoreCase("ON"))  lampSet(true);
-    else                            lampSet(false);
-    pub(T_ST_LAMP, lampOn? "ON":"OFF");
-    return;
-  }
-  if(top == T_CMD_BRIGHT){
-    int v = constrain(msg.toInt(), 0, 255);
-    lampBright = (uint8_t)v;
-    applyLamp();
-    pub(T_ST_BRIGHT, String(lampBright));
-    return;
-  }
-  if(top == T_CMD_COLOR){
-    lampColor = parseHexColor(msg);
-    applyLamp();
-    char hex[8]; sprintf(hex,"#%06X", (unsigned)lampColor);
-    pub(T_ST_COLOR, String(hex));
-    return;
-  }
-  if(top == T_CMD_PUMP){
-    if(msg.startsWith("ON")){
-      // dạng "ON:10000"
-      int idx = msg.indexOf(':');
-      unsigned long dur = (idx>0)? msg.substring(idx+1).toInt() : 10000;
-      if(dur<2000) dur=2000; // an toàn
-      if((millis()-pumpTs) > PUMP_COOLDOWN){     // tôn trọng cooldown
-        pumpManualUntil = millis() + dur;
-        if(!pumpOn) pumpStart();
-        pub(T_ST_PUMP, "ON");
-      }
-    }else{ // OFF
-      pumpManualUntil = 0;
-      if(pumpOn && (millis()-pumpTs)>=PUMP_MIN_ON){
-        pumpStop();
-        pub(T_ST_PUMP, "OFF");
-      }
+// payload đọc tại chỗ (lib/Dispatcher), không tạo String
+void cmdMode(const uint8_t* p, size_t n){
+  n = payloadTrim(p, n);
+  autoMode = payloadIsNoCase(p, n, "AUTO");
+  pub(T_ST_MODE, autoMode? "AUTO":"MANUAL");
+}
+void cmdLamp(const uint8_t* p, size_t n){
+  n = payloadTrim(p, n);
+  lampSet(payloadIsNoCase(p, n, "ON"));
+  pub(T_ST_LAMP, lampOn? "ON":"OFF");
+}
+void cmdBright(const uint8_t* p, size_t n){
+  long v = 0; payloadInt(p, n, v);
+  lampBright = (uint8_t)constrain(v, 0L, 255L);
+  applyLamp();
+  pubBright();
+}
+void cmdColor(const uint8_t* p, size_t n){
+  payloadHexColor(p, n, lampColor);     // giữ màu cũ nếu sai định dạng
+  applyLamp();
+  pubColor();
+}
+void cmdPump(const uint8_t* p, size_t n){
+  n = payloadTrim(p, n);
+  if(payloadStartsWith(p, n, "ON")){
+    // dạng "ON:10000"
+    long dur = 10000;
+    const uint8_t* colon = (const uint8_t*)memchr(p, ':', n);
+    if(colon && !payloadInt(colon+1, n-(colon+1-p), dur)) dur = 0;
+    if(dur<2000) dur=2000; // an toàn
+    if((millis()-pumpTs) > PUMP_COOLDOWN){     // tôn trọng cooldown
+      pumpManualUntil = millis() + dur;
+      if(!pumpOn) pumpStart();
+      pub(T_ST_PUMP, "ON");
+    }
+  }else{ // OFF
+    pumpManualUntil = 0;
+    if(pumpOn && (millis()-pumpTs)>=PUMP_MIN_ON){
+      pumpStop();
+      pub(T_ST_PUMP, "OFF");
     }
-    return;
   }
 }
 
+const CommandRoute cmdRoutes[] = {
+  COMMAND_ROUTE(T_CMD_MODE,   cmdMode),
+  COMMAND_ROUTE(T_CMD_LAMP,   cmdLamp),
+  COMMAND_ROUTE(T_CMD_BRIGHT, cmdBright),
+  COMMAND_ROUTE(T_CMD_COLOR,  cmdColor),
+  COMMAND_ROUTE(T_CMD_PUMP,   cmdPump),
+};
+CommandDispatcher commands(cmdRoutes, sizeof(cmdRoutes)/sizeof(cmdRoutes[0]));
+
+// Chạy trên netTask: chép lệnh sang loop(), handler chỉ chạy ở một luồng
+void onMqtt(char* topic, byte* payload, unsigned int len){
+  CmdMsg c;
+  if(strlen(topic) >= sizeof(c.topic) || len > sizeof(c.payload)) return;
+  strcpy(c.topic, topic);
+  memcpy(c.payload, payload, len);
+  c.length = len;
+  inbox.push(c);
+}
+
 /* ===== MQTT connect ===== */
-void mqttEnsure(){
-  if(mqtt.connected()) return;
-  while(!mqtt.connected()){
-    mqtt.connect(MQTT_CLIENT);
-    if(!mqtt.connected()) delay(500);
+// Mỗi lần gọi thử tối đa một lần, không chờ; true khi đã kết nối
+bool mqttEnsure(){
+  if(mqtt.connected()) return true;
+  unsigned long now = millis();
+  if(mqttOnline){                       // vừa mất kết nối: đo lại, thử ngay
+    mqttOnline = false;
+    offlineSince = now;
+    mqttRetryAt = now;
+    mqttBackoff.reset();
+  }
+  if(WiFi.status()!=WL_CONNECTED || (long)(now - mqttRetryAt) < 0) return false;
+  mqttAttempts++;
+  if(!mqtt.connect(MQTT_CLIENT)){
+    mqttFailures++;
+    mqttRetryAt = now + mqttBackoff.next();
+    return false;
   }
   mqtt.subscribe("farm/cmd/#");
-  publishAllStatus();
+  mqttOnline = true;
+  mqttBackoff.reset();
+  lastOnlineMs = millis() - offlineSince;
+  if(lastOnlineMs > maxOnlineMs) maxOnlineMs = lastOnlineMs;
+  statusRequested = true;
+  tempReport.invalidate(); humReport.invalidate(); lightReport.invalidate(); soilReport.invalidate();
+  return true;
+}
+
+/* ===== Luồng mạng (core 0) ===== */
+// Mất MQTT vẫn xếp hàng ThingSpeak; các topic retained gửi lại đủ sau khi kết nối
+void uploadReading(const Reading& r, bool online){
+  char buf[16];
+  if(online && tempReport.update(r.temp, r.ms))   { dtostrf(r.temp,  0, 1, buf); mqtt.publish(TOPIC_TEMP,  buf, true); }
+  if(online && humReport.update(r.hum, r.ms))     { dtostrf(r.hum,   0, 0, buf); mqtt.publish(TOPIC_HUM,   buf, true); }
+  if(online && lightReport.update(r.light, r.ms)) { dtostrf(r.light, 0, 0, buf); mqtt.publish(TOPIC_LIGHT, buf, true); }
+  if(online && soilReport.update(r.soil, r.ms))   { dtostrf(r.soil,  0, 0, buf); mqtt.publish(TOPIC_SOIL,  buf, true); }
+  if(!r.log) return;
+  // chỉ xếp hàng, thingSpeak.poll() gửi dồn theo lịch
+  thingSpeak.setField(1, r.hum);
+  thingSpeak.setField(2, r.temp);
+  thingSpeak.setField(3, r.hic);
+  thingSpeak.setField(4, r.light);
+  thingSpeak.setField(5, r.soil);
+  thingSpeak.setField(6, r.lamp ? 1 : 0);
+  thingSpeak.setField(7, r.pump ? 1 : 0);
+  thingSpeak.commit();
+}
+
+void netLoop(void*){
+  for(;;){
+    bool online = mqttEnsure();
+    if(online) mqtt.loop();
+    OutMsg m;  while(online && outbox.pop(m)) mqtt.publish(m.topic, m.payload, true);
+    Reading r; while(readings.pop(r)) uploadReading(r, online);
+    thingSpeak.poll();
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+}
+
+void printMetrics(){
+  Serial.printf("stack free: net %u B, loop %u B\n",
+                (unsigned)uxTaskGetStackHighWaterMark(netTask), (unsigned)uxTaskGetStackHighWaterMark(NULL));
+  Serial.printf("queues: readings %u/%u (max %u, drop %u), outbox %u/%u (max %u, drop %u), inbox %u/%u (max %u, drop %u)\n",
+                (unsigned)readings.size(), (unsigned)readings.capacity(), (unsigned)readings.maxUsed(), (unsigned)readings.dropped(),
+                (unsigned)outbox.size(), (unsigned)outbox.capacity(), (unsigned)outbox.maxUsed(), (unsigned)outbox.dropped(),
+                (unsigned)inbox.size(), (unsigned)inbox.capacity(), (unsigned)inbox.maxUsed(), (unsigned)inbox.dropped());
+  const TsStats& ts = thingSpeak.stats();
+  Serial.printf("thingspeak: %u pending, %u sent in %u requests, %u failures, %u timeouts, %u connects, latency %u ms (max %u)\n",
+                (unsigned)thingSpeak.pending(), (unsigned)ts.sent, (unsigned)ts.requests, (unsigned)ts.failures,
+                (unsigned)ts.timeouts, (unsigned)ts.connects, (unsigned)ts.lastLatencyMs, (unsigned)ts.maxLatencyMs);
+  Serial.printf("reports sent/unchanged/limited: temp %u/%u/%u, hum %u/%u/%u, light %u/%u/%u, soil %u/%u/%u\n",
+                (unsigned)tempReport.reports, (unsigned)tempReport.suppressed, (unsigned)tempReport.limited,
+                (unsigned)humReport.reports, (unsigned)humReport.suppressed, (unsigned)humReport.limited,
+                (unsigned)lightReport.reports, (unsigned)lightReport.suppressed, (unsigned)lightReport.limited,
+                (unsigned)soilReport.reports, (unsigned)soilReport.suppressed, (unsigned)soilReport.limited);
+  Serial.printf("mqtt: %u/%u attempts failed, time-to-online last %u ms, max %u ms\n",
+                (unsigned)mqttFailures, (unsigned)mqttAttempts, (unsigned)lastOnlineMs, (unsigned)maxOnlineMs);
 }
 
 /* ===== Setup / Loop ===== */
@@ -206,63 +340,73 @@ void setup(){
   Serial.begin(115200);
   dht.begin();
   analogReadResolution(12);
-  analogSetPinAttenuation(LDR_PIN,  ADC_11db);
-  analogSetPinAttenuation(SOIL_PIN, ADC_11db);
+  analogSetPinAttenuation(Rig::LDR_PIN,  ADC_11db);
+  analogSetPinAttenuation(Rig::SOIL_PIN, ADC_11db);
+  if(!adcDma.begin(ADC_PINS, sizeof(ADC_PINS))) Serial.println(F("ADC DMA init failed"));
 
-  display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
-  display.clearDisplay(); display.setTextColor(WHITE); display.setTextSize(1);
+  oled.begin();
+  display.clearDisplay();
   display.setCursor(10,24); display.println(F("Garden (MQTT + Auto)")); display.display();
 
-  ring.begin(); ring.clear(); ring.setBrightness(lampBright); ring.show();
+  ring.begin(); ring.clear(); ring.show();
+  applyLamp();
   pumpServo.setPeriodHertz(50);
-  pumpServo.attach(SERVO_PIN, 500, 2400);
+  pumpServo.attach(Rig::SERVO_PIN, 500, 2400);
   pumpStop();
 
+  // không chờ WiFi: đo/điều khiển chạy ngay, netTask kết nối MQTT khi WiFi lên
   WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(true);
   WiFi.begin(WIFI_SSID, WIFI_PASS);
-  while(WiFi.status()!=WL_CONNECTED) delay(300);
+  offlineSince = millis();
+  mqttBackoff.seed(esp_random());
 
   mqtt.setServer(MQTT_HOST, MQTT_PORT);
   mqtt.setCallback(onMqtt);
 
-  ThingSpeak.begin(tsClient);
+  thingSpeak.setFlushInterval(ts_flush_interval);
+  xTaskCreatePinnedToCore(netLoop, "net", NET_STACK, nullptr, 1, &netTask, 0);
 }
 
 void loop(){
-  mqttEnsure();
-  mqtt.loop();
+  CmdMsg c;
+  while(inbox.pop(c)) commands.dispatch(c.topic, c.payload, c.length);
+  if(statusRequested){ statusRequested=false; publishAllStatus(); }
+
+  // ---- NeoPixel: nhịp khung cố định, trước các bước có thể return sớm ----
+  static uint32_t lastFrame=0;
+  if(millis() - lastFrame >= LAMP_FRAME_MS){ lastFrame = millis(); renderLamp(lastFrame); }
 
   // ---- LDR ----
-  static float emaRaw=-1; static int lastStable=-1;
-  int med = medianRead<MEDIAN_SAMPLES>(LDR_PIN);
-  if(emaRaw<0) emaRaw=med;
-  emaRaw = EMA_ALPHA*med + (1.0f-EMA_ALPHA)*emaRaw;
-  int raw = lroundf(emaRaw);
-  if(lastStable>=0 && abs(raw-lastStable)<=RAW_DEADBAND) raw=lastStable; else lastStable=raw;
-  float pct = mapFloat(raw, LDR_MIN_RAW, LDR_MAX_RAW, 0.0f, 100.0f);
-  lightPct = constrain(INVERT_LIGHT ? 100.0f - pct : pct, 0.0f, 100.0f);
+  static uint32_t ldrSeen=0; int ldrIn;
+  if(analogNext(Rig::LDR_PIN, ldrSeen, ldrIn)){
+    int raw = ldrFilter.update(ldrIn);
+    float pct = Rig::Light::level(raw);
+    lightPct = constrain(Rig::Light::INVERTED ? 100.0f - pct : pct, 0.0f, 100.0f);
+  }
 
   // ---- DHT ----
-  hum = dht.readHumidity();
-  temp = dht.readTemperature();
-  if(isnan(hum) || isnan(temp)) return;
-  hic = dht.computeHeatIndex(temp, hum, false);
+  // lấy kết quả gần nhất rồi kích lần đo kế tiếp (tự bỏ qua nếu chưa đủ 2 s)
+  bool dhtOk = dht.read(temp, hum, DHT_MAX_AGE);
+  dht.start();
+  if(!dhtOk) return;
+  hic = heatIndexC(temp, hum);
 
   // ---- Soil ----
-  int soilMed = medianRead<SOIL_MEDIAN_N>(SOIL_PIN);
-  static float soilEma = soilMed;
-  soilEma = SOIL_EMA_ALPHA*soilMed + (1.0f-SOIL_EMA_ALPHA)*soilEma;
-  int soilRaw = lroundf(soilEma);
-  static int soilLast=soilRaw;
-  if(abs(soilRaw-soilLast)<=SOIL_DEADBAND) soilRaw=soilLast; else soilLast=soilRaw;
-  float sp = (float)(soilRaw - SOIL_WET_RAW) * 100.0f / (float)(SOIL_DRY_RAW - SOIL_WET_RAW);
-  soilPct = constrain(SOIL_INVERT ? 100.0f - sp : sp, 0.0f, 100.0f);
+  static uint32_t soilSeen=0; int soilIn;
+  if(analogNext(Rig::SOIL_PIN, soilSeen, soilIn)){
+    int soilRaw = soilFilter.update(soilIn);
+    float sp = Rig::Soil::level(soilRaw);
+    soilPct = constrain(Rig::Soil::INVERTED ? 100.0f - sp : sp, 0.0f, 100.0f);
+  }
 
   // ---- Điều khiển ----
   unsigned long now = millis();
 
   // manual pump (được ưu tiên)
   if(pumpManualUntil>0){
+    pumpAutoUntil = 0;
+    irrigation.interrupt();
     if(!pumpOn) pumpStart();
     if(now >= pumpManualUntil && (now - pumpTs) >= PUMP_MIN_ON){
       pumpManualUntil = 0;
@@ -270,43 +414,40 @@ void loop(){
       pub(T_ST_PUMP, "OFF");
     }
   }else if(autoMode){
-    // Auto lamp
-    if(!lampOn && lightPct < LIGHT_ON)      { lampSet(true);  pub(T_ST_LAMP,"ON"); }
-    else if(lampOn && lightPct > LIGHT_OFF) { lampSet(false); pub(T_ST_LAMP,"OFF"); }
-    // Auto pump
-    if(!pumpOn && soilPct < SOIL_ON && (now - pumpTs) > PUMP_COOLDOWN){
-      pumpStart(); pub(T_ST_PUMP,"ON");
+    // Auto lamp: bật dưới LIGHT_ON_PERCENT, tắt trên LIGHT_OFF_PERCENT (đèn có thể vừa đổi qua MQTT)
+    daylight.set(!lampOn);
+    bool dark = !daylight.update(lightPct);
+    if(dark != lampOn){ lampSet(dark); pub(T_ST_LAMP, dark? "ON":"OFF"); }
+    // Auto pump: bộ điều khiển chạy theo nhịp lấy mẫu, xung tắt đúng hạn
+    static unsigned long lastIrrigation = 0;
+    if(now - lastIrrigation >= SAMPLE_INTERVAL){
+      lastIrrigation = now;
+      uint32_t pulse = irrigation.update(soilPct, temp, hum, now);
+      if(pulse && !pumpOn){ pumpAutoUntil = now + pulse; pumpStart(); pub(T_ST_PUMP,"ON"); }
     }
-    if(pumpOn && soilPct > SOIL_OFF && (now - pumpTs) > PUMP_MIN_ON){
+    if(pumpOn && pumpAutoUntil && (long)(now - pumpAutoUntil) >= 0){
+      pumpAutoUntil = 0;
       pumpStop();  pub(T_ST_PUMP,"OFF");
     }
+  }else{
+    if(pumpOn && pumpAutoUntil){ pumpAutoUntil = 0; pumpStop(); pub(T_ST_PUMP,"OFF"); }   // vừa tắt auto giữa xung
+    irrigation.interrupt();
   }
 
   // ---- OLED ----
-  display.clearDisplay(); display.setTextSize(1);
-  display.drawBitmap(0, 0,  icon_temp16, 16,16,WHITE); display.setCursor(20, 4);  display.print("T: ");  display.print(temp,1);  display.print(" C");
-  display.drawBitmap(0,16,  icon_humid16,16,16,WHITE); display.setCursor(20,20);  display.print("H: ");  display.print(hum,0);   display.print(" %");
-  display.drawBitmap(0,32,  icon_light16,16,16,WHITE); display.setCursor(20,36);  display.print("L: ");  display.print((int)lightPct); display.print(" %");
-  display.drawBitmap(0,48,  icon_soil16, 16,16,WHITE); display.setCursor(20,52);  display.print("S: ");  display.print((int)soilPct);  display.print(" %");
-  display.setCursor(92,36); display.print(lampOn ? "LAMP":"    ");
-  display.setCursor(92,52); display.print(pumpOn ? "PUMP":"    ");
-  display.display();
-
-  // ---- Publish sensor mỗi 15s ----
-  if(millis() - previousMillis >= ts_update_interval){
-    previousMillis = millis();
-    char buf[16];
-    dtostrf(temp,     0, 1, buf); mqtt.publish(TOPIC_TEMP,  buf, true);
-    dtostrf(hum,      0, 0, buf); mqtt.publish(TOPIC_HUM,   buf, true);
-    dtostrf(lightPct, 0, 0, buf); mqtt.publish(TOPIC_LIGHT, buf, true);
-    dtostrf(soilPct,  0, 0, buf); mqtt.publish(TOPIC_SOIL,  buf, true);
-    ThingSpeak.setField(1, hum);
-    ThingSpeak.setField(2, temp);
-    ThingSpeak.setField(3, hic);
-    ThingSpeak.setField(4, lightPct);
-    ThingSpeak.setField(5, soilPct);
-    ThingSpeak.setField(6, lampOn ? 1 : 0);
-    ThingSpeak.setField(7, pumpOn ? 1 : 0);
-    ThingSpeak.writeFields(myChannelNumber, myWriteAPIKey);
+  StatusFields fields = { temp, hum, (int)lightPct, (int)soilPct, WiFi.status()==WL_CONNECTED, lampOn, pumpOn };
+  statusView.render(fields);
+
+  // ---- Số đo sang netTask: MQTT theo thay đổi, ThingSpeak mỗi 15s ----
+  static unsigned long lastSample = 0;
+  if(millis() - lastSample >= SAMPLE_INTERVAL){
+    lastSample = millis();
+    bool log = lastSample - previousMillis >= ts_update_interval;
+    if(log) previousMillis = lastSample;
+    Reading r = { temp, hum, hic, lightPct, soilPct, lampOn, pumpOn, log, (uint32_t)lastSample };
+    readings.push(r);
   }
+
+  static unsigned long lastMetrics = 0;
+  if(millis() - lastMetrics >= METRICS_INTERVAL){ lastMetrics = millis(); printMetrics(); }
 }
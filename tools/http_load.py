@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+"""Thử tải máy chủ HTTP cục bộ của node (lib/HttpServer, cổng 80).
+
+N client chạy song song, mỗi client giữ một kết nối keep-alive và gửi lần lượt các
+request trong danh sách đường dẫn (xoay vòng). Response được kiểm tra: mã 200, giải
+chunked, JSON hợp lệ, CSV đủ cột. Kết nối bị đóng (503 khi hết slot, timeout) thì mở lại.
+In số request/s, độ trễ p50/p95/p99/max, byte nhận và số lỗi theo loại.
+
+  tools/http_load.py --clients 8 --seconds 30                # Wokwi: localhost:8180 -> ESP32:80
+  .pio/build/native/program --hours 1 --http 8180 --serve 60 & tools/http_load.py --seconds 30
+
+Mã thoát 1 nếu có response sai (khác 200/503 hoặc nội dung hỏng).
+"""
+import argparse
+import asyncio
+import json
+import sys
+import time
+
+DEFAULT_PATHS = ["/status", "/history/stats?minutes=60", "/history.json?minutes=10", "/history.csv?minutes=60"]
+
+
+class Stats:
+    def __init__(self):
+        self.latencies = []
+        self.bytes = 0
+        self.errors = {}
+        self.bad = 0
+        self.connects = 0
+
+    def error(self, kind):
+        self.errors[kind] = self.errors.get(kind, 0) + 1
+
+
+async def read_response(reader):
+    """Trả về (status, headers, body); body đã giải chunked."""
+    line = await reader.readline()
+    if not line:
+        raise ConnectionError("closed")
+    parts = line.decode("latin-1").split(" ", 2)
+    status = int(parts[1])
+    headers = {}
+    while True:
+        line = await reader.readline()
+        if line in (b"\r\n", b""):
+            break
+        key, _, value = line.decode("latin-1").partition(":")
+        headers[key.strip().lower()] = value.strip()
+    if headers.get("transfer-encoding", "").lower() == "chunked":
+        body = bytearray()
+        while True:
+            size = int((await reader.readline()).strip(), 16)
+            if size == 0:
+                await reader.readline()
+                break
+            body += await reader.readexactly(size)
+            await reader.readexactly(2)
+        body = bytes(body)
+    elif "content-length" in headers:
+        body = await reader.readexactly(int(headers["content-length"]))
+    else:
+        body = await reader.read()
+    return status, headers, body
+
+
+def check_body(path, headers, body):
+    kind = headers.get("content-type", "")
+    if kind.startswith("application/json"):
+        json.loads(body)
+    elif kind.startswith("text/csv"):
+        lines = body.decode().splitlines()
+        if not lines or lines[0] != "t_ms,temp,hum,light,soil":
+            raise ValueError("bad csv header")
+        for row in lines[1:]:
+            if row.count(",") != 4:
+                raise ValueError("bad csv row %r" % row)
+    else:
+        raise ValueError("unexpected content type %r for %s" % (kind, path))
+
+
+async def client(args, paths, stats, deadline, index):
+    i = index
+    writer = None
+    while time.monotonic() < deadline:
+        try:
+            if writer is None:
+                reader, writer = await asyncio.wait_for(asyncio.open_connection(args.host, args.port), args.timeout)
+                stats.connects += 1
+            path = paths[i % len(paths)]
+            i += 1
+            start = time.perf_counter()
+            writer.write(("GET %s HTTP/1.1\r\nHost: %s\r\n\r\n" % (path, args.host)).encode())
+            await writer.drain()
+            status, headers, body = await asyncio.wait_for(read_response(reader), args.timeout)
+            stats.bytes += len(body)
+            if status == 503:
+                stats.error("503 busy")
+                writer.close()
+                writer = None
+                await asyncio.sleep(0.05)
+                continue
+            if status != 200:
+                stats.bad += 1
+                stats.error("status %d" % status)
+            else:
+                try:
+                    check_body(path, headers, body)
+                    stats.latencies.append(time.perf_counter() - start)
+                except ValueError as e:
+                    stats.bad += 1
+                    stats.error("bad body: %s" % e)
+            if headers.get("connection", "").lower() == "close":
+                writer.close()
+                writer = None
+        except (ConnectionError, OSError, asyncio.IncompleteReadError, asyncio.TimeoutError) as e:
+            stats.error(type(e).__name__)
+            if writer is not None:
+                writer.close()
+            writer = None
+            await asyncio.sleep(0.05)
+    if writer is not None:
+        writer.close()
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    return values[min(len(values) - 1, int(len(values) * p))]
+
+
+async def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="localhost")
+    parser.add_argument("--port", type=int, default=8180)
+    parser.add_argument("--clients", type=int, default=8, help="số kết nối song song (node có 4 slot)")
+    parser.add_argument("--seconds", type=float, default=10)
+    parser.add_argument("--timeout", type=float, default=10)
+    parser.add_argument("--path", action="append", help="đường dẫn (lặp lại được), mặc định: các endpoint chính")
+    args = parser.parse_args()
+    paths = args.path or DEFAULT_PATHS
+
+    stats = Stats()
+    start = time.monotonic()
+    deadline = start + args.seconds
+    await asyncio.gather(*(client(args, paths, stats, deadline, i) for i in range(args.clients)))
+    elapsed = time.monotonic() - start
+
+    lat = sorted(stats.latencies)
+    ms = lambda s: s * 1000
+    print("requests      %d ok in %.1f s (%.1f req/s), %d connections, %.1f KB received"
+          % (len(lat), elapsed, len(lat) / elapsed, stats.connects, stats.bytes / 1024))
+    print("latency ms    p50 %.1f  p95 %.1f  p99 %.1f  max %.1f"
+          % (ms(percentile(lat, 0.5)), ms(percentile(lat, 0.95)), ms(percentile(lat, 0.99)), ms(lat[-1] if lat else 0)))
+    for kind, count in sorted(stats.errors.items()):
+        print("error         %-24s %d" % (kind, count))
+    return 1 if stats.bad or not lat else 0
+
+
+if __name__ == "__main__":
+    sys.exit(asyncio.run(main()))
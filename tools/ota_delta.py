@@ -0,0 +1,311 @@
+#!/usr/bin/env python3
+"""Delta firmware cho OTA qua MQTT (lib/Ota): tạo, áp dụng thử, gửi tới node, kiểm tra trên sim.
+
+Delta = header 80 byte (magic "GDLT", version, blockSize, baseSize, targetSize, SHA-256 base,
+SHA-256 target) rồi các lệnh COPY src len / DATA len bytes / END, số nguyên varint LEB128.
+Bộ tạo kiểu rsync: băm yếu (rolling) từng khối blockSize byte của base theo biên khối, trượt
+từng byte trên target; khớp thì so byte thật rồi kéo dài khớp về hai phía, phần còn lại là DATA.
+
+  tools/ota_delta.py make old/firmware.bin .pio/build/esp32doit-devkit-v1/firmware.bin -o update.delta
+  tools/ota_delta.py apply old/firmware.bin update.delta -o check.bin
+  tools/ota_delta.py send update.delta --node esp32-a1b2c3           # cần paho-mqtt
+  tools/ota_delta.py check --sim .pio/build/native/program old.bin new.bin
+
+send: stop-and-wait trên garden/<node>/ota, đoạn tối đa 512 byte (buffer MQTT của node), mất
+kết nối thì gửi lại begin và node báo offset cần tiếp (resume, kể cả sau khi node khởi động lại).
+check: tạo delta, áp dụng bằng Python, rồi chạy sim với --ota: bình thường, mất kết nối + mất
+RAM giữa chừng (--ota-drop) và một byte hỏng (--ota-flip, phải bị từ chối). Mã thoát 1 nếu sai.
+"""
+import argparse
+import hashlib
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+MAGIC = 0x544C4447  # "GDLT"
+VERSION = 1
+HEADER = struct.Struct("<IHHII32s32s")
+OP_END, OP_COPY, OP_DATA = 0, 1, 2
+CHUNK_MAX = 512
+MOD = 1 << 16
+
+
+def varint(n):
+    out = bytearray()
+    while True:
+        b = n & 0x7F
+        n >>= 7
+        if n:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return bytes(out)
+
+
+def read_varint(data, pos):
+    value = shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return value, pos
+        shift += 7
+        if shift > 28:
+            raise ValueError("varint too long at %d" % pos)
+
+
+def weak(block):
+    a = sum(block) % MOD
+    b = sum((len(block) - i) * x for i, x in enumerate(block)) % MOD
+    return a, b
+
+
+def make_delta(base, target, block):
+    """Danh sách lệnh ("copy", src, len) / ("data", bytes)."""
+    index = {}
+    for off in range(0, len(base) - block + 1, block):
+        a, b = weak(base[off:off + block])
+        index.setdefault(a | b << 16, []).append(off)
+
+    ops = []
+    literal_start = 0
+    i = 0
+    n = len(target)
+    if n >= block:
+        a, b = weak(target[:block])
+    while i + block <= n:
+        candidates = index.get(a | b << 16)
+        best_len = 0
+        if candidates:
+            window = target[i:i + block]
+            for src in candidates[:16]:
+                if base[src:src + block] != window:
+                    continue
+                length = block
+                while i + length < n and src + length < len(base):
+                    step = min(block, n - i - length, len(base) - src - length)
+                    if base[src + length:src + length + step] == target[i + length:i + length + step]:
+                        length += step
+                        continue
+                    while base[src + length] == target[i + length]:
+                        length += 1
+                    break
+                back = 0
+                while i - back > literal_start and src - back > 0 and base[src - back - 1] == target[i - back - 1]:
+                    back += 1
+                if length + back > best_len:
+                    best_len, best_src, best_back = length + back, src - back, back
+        if best_len:
+            start = i - best_back
+            if start > literal_start:
+                ops.append(("data", target[literal_start:start]))
+            ops.append(("copy", best_src, best_len))
+            i = start + best_len
+            literal_start = i
+            if i + block <= n:
+                a, b = weak(target[i:i + block])
+            continue
+        if i + block < n:
+            out, inc = target[i], target[i + block]
+            a = (a - out + inc) % MOD
+            b = (b - block * out + a) % MOD
+        i += 1
+    if literal_start < n:
+        ops.append(("data", target[literal_start:]))
+    return ops
+
+
+def encode(base, target, ops, block):
+    out = bytearray(HEADER.pack(MAGIC, VERSION, block, len(base), len(target),
+                                hashlib.sha256(base).digest(), hashlib.sha256(target).digest()))
+    for op in ops:
+        if op[0] == "copy":
+            out += bytes([OP_COPY]) + varint(op[1]) + varint(op[2])
+        else:
+            out += bytes([OP_DATA]) + varint(len(op[1])) + op[1]
+    out.append(OP_END)
+    return bytes(out)
+
+
+def parse_ops(delta):
+    """(header, [(op, offset của lệnh, offset payload DATA, src, len)])"""
+    header = HEADER.unpack_from(delta)
+    if header[0] != MAGIC or header[1] != VERSION:
+        raise ValueError("not a delta (magic/version)")
+    pos, ops = HEADER.size, []
+    while True:
+        at = pos
+        op = delta[pos]
+        pos += 1
+        if op == OP_END:
+            if pos != len(delta):
+                raise ValueError("bytes after END")
+            return header, ops
+        if op == OP_COPY:
+            src, pos = read_varint(delta, pos)
+            length, pos = read_varint(delta, pos)
+            ops.append((OP_COPY, at, None, src, length))
+        elif op == OP_DATA:
+            length, pos = read_varint(delta, pos)
+            ops.append((OP_DATA, at, pos, None, length))
+            pos += length
+        else:
+            raise ValueError("unknown op %d at %d" % (op, at))
+
+
+def apply_delta(base, delta):
+    header, ops = parse_ops(delta)
+    _, _, _, base_size, target_size, base_sha, target_sha = header
+    if hashlib.sha256(base[:base_size]).digest() != base_sha:
+        raise ValueError("base does not match delta")
+    out = bytearray()
+    for op, _, payload, src, length in ops:
+        out += base[src:src + length] if op == OP_COPY else delta[payload:payload + length]
+    if len(out) != target_size or hashlib.sha256(out).digest() != target_sha:
+        raise ValueError("result does not match target hash")
+    return bytes(out)
+
+
+def cmd_make(args):
+    base = open(args.base, "rb").read()
+    target = open(args.target, "rb").read()
+    start = time.monotonic()
+    ops = make_delta(base, target, args.block)
+    delta = encode(base, target, ops, args.block)
+    apply_delta(base, delta)  # tự kiểm tra trước khi ghi
+    with open(args.output, "wb") as f:
+        f.write(delta)
+    copied = sum(op[2] for op in ops if op[0] == "copy")
+    print("delta %s: %d B for %d B image (%.1f%%), %d copy / %d data ops, %d B reused, %.1f s"
+          % (args.output, len(delta), len(target), 100.0 * len(delta) / max(len(target), 1),
+             sum(op[0] == "copy" for op in ops), sum(op[0] == "data" for op in ops), copied,
+             time.monotonic() - start))
+    return 0
+
+
+def cmd_apply(args):
+    target = apply_delta(open(args.base, "rb").read(), open(args.delta, "rb").read())
+    with open(args.output, "wb") as f:
+        f.write(target)
+    print("%s: %d B, sha256 %s" % (args.output, len(target), hashlib.sha256(target).hexdigest()))
+    return 0
+
+
+def cmd_send(args):
+    try:
+        import paho.mqtt.client as mqtt
+    except ImportError:
+        print("send needs paho-mqtt (pip install paho-mqtt)", file=sys.stderr)
+        return 2
+    import queue
+
+    delta = open(args.delta, "rb").read()
+    header = HEADER.unpack_from(delta)
+    prefix = "%s/%s/" % (args.root, args.node)
+    begin = "size=%d sha256=%s" % (len(delta), header[6].hex())
+    statuses = queue.Queue()
+
+    client = mqtt.Client()
+    client.on_connect = lambda c, u, f, rc: c.subscribe(prefix + "ota")
+    client.on_message = lambda c, u, m: statuses.put(m.payload.decode(errors="replace"))
+    client.connect(args.host, args.port)
+    client.loop_start()
+    client.publish(prefix + "signal/ota/begin", begin)
+    start = time.monotonic()
+    while True:
+        try:
+            text = statuses.get(timeout=args.timeout)
+        except queue.Empty:
+            client.publish(prefix + "signal/ota/begin", begin)  # node hỏi lại vị trí
+            continue
+        fields = dict(kv.split("=", 1) for kv in text.split() if "=" in kv)
+        state = fields.get("state")
+        if state == "done":
+            print("done: %d B in %.1f s, node restarts into the new firmware" % (len(delta), time.monotonic() - start))
+            return 0
+        if state == "failed":
+            print("failed: %s" % fields.get("error"), file=sys.stderr)
+            return 1
+        if state == "idle":
+            client.publish(prefix + "signal/ota/begin", begin)
+            continue
+        if state not in ("header", "patch"):
+            continue  # base/verify: node đang băm, chờ status kế tiếp
+        offset = int(fields.get("next", 0))
+        if offset >= len(delta):
+            continue
+        chunk = delta[offset:offset + args.chunk]
+        client.publish(prefix + "signal/ota/chunk", struct.pack("<I", offset) + chunk)
+        print("\r%d/%d B" % (offset + len(chunk), len(delta)), end="", flush=True)
+
+
+def run_sim(sim, *extra):
+    r = subprocess.run([sim, "--hours", "0.1"] + list(extra), stdout=subprocess.PIPE, universal_newlines=True)
+    line = next((l for l in r.stdout.splitlines() if l.startswith("ota")), "ota           <no summary>")
+    return r.returncode, line
+
+
+def cmd_check(args):
+    base = open(args.base, "rb").read()
+    target = open(args.target, "rb").read()
+    delta = encode(base, target, make_delta(base, target, args.block), args.block)
+    ok = apply_delta(base, delta) == target
+    print("python apply  %s (%d B delta)" % ("ok" if ok else "MISMATCH", len(delta)))
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "update.delta")
+        with open(path, "wb") as f:
+            f.write(delta)
+        common = ["--ota", path, "--ota-base", args.base]
+        cases = [("clean", [], 0), ("drop", ["--ota-drop", str(len(delta) * 2 // 3)], 0)]
+        _, ops = parse_ops(delta)
+        data = [o for o in ops if o[0] == OP_DATA and o[4]]
+        if data:  # byte giữa DATA cuối: chỉ bắt được ở bước kiểm tra hash
+            cases.append(("flip", ["--ota-flip", str(data[-1][2] + data[-1][4] // 2)], 1))
+        for name, extra, want in cases:
+            rc, line = run_sim(args.sim, *(common + extra))
+            good = rc == want
+            ok &= good
+            print("sim %-9s %s  %s" % (name, "ok  " if good else "FAIL", line[14:]))
+    return 0 if ok else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command")
+    p = sub.add_parser("make", help="tạo delta từ firmware cũ và mới")
+    p.add_argument("base")
+    p.add_argument("target")
+    p.add_argument("-o", "--output", required=True)
+    p.add_argument("--block", type=int, default=64, help="khối so khớp (byte)")
+    p = sub.add_parser("apply", help="áp dụng delta (kiểm tra trên host)")
+    p.add_argument("base")
+    p.add_argument("delta")
+    p.add_argument("-o", "--output", required=True)
+    p = sub.add_parser("send", help="gửi delta tới một node qua MQTT")
+    p.add_argument("delta")
+    p.add_argument("--node", required=True, help="nodeId (clientID MQTT, mặc định esp32-<MAC>)")
+    p.add_argument("--host", default="broker.hivemq.com")
+    p.add_argument("--port", type=int, default=1883)
+    p.add_argument("--root", default="garden")
+    p.add_argument("--chunk", type=int, default=CHUNK_MAX)
+    p.add_argument("--timeout", type=float, default=5)
+    p = sub.add_parser("check", help="tạo + áp dụng delta trên sim (flash giả)")
+    p.add_argument("base")
+    p.add_argument("target")
+    p.add_argument("--sim", required=True, help="chương trình sim (env native)")
+    p.add_argument("--block", type=int, default=64)
+    args = parser.parse_args()
+    if args.command is None:
+        parser.print_help()
+        return 2
+    if getattr(args, "chunk", CHUNK_MAX) > CHUNK_MAX:
+        parser.error("--chunk above %d does not fit the node's MQTT buffer" % CHUNK_MAX)
+    return {"make": cmd_make, "apply": cmd_apply, "send": cmd_send, "check": cmd_check}[args.command](args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""Máy chủ giả ThingSpeak cho thử nghiệm cục bộ (ThingSpeakBulk trong test/main.cpp).
+
+Nhận POST /channels/<id>/bulk_update.json, kiểm tra write_api_key và định dạng
+updates[], trả 202 {"success":true} và giữ kết nối (HTTP/1.1 keep-alive).
+Có thể thêm độ trễ, tỉ lệ lỗi, đóng kết nối sau mỗi response hoặc trả chunked
+để thử các nhánh của bộ đọc response.
+
+  tools/thingspeak_standin.py --port 8080 --key Q0C1U02B034TQZ1I --latency 300 --fail 0.1
+
+Trên Wokwi, đặt TS_HOST = "host.wokwi.internal" và TS_PORT = 8080 trong test/main.cpp.
+
+--check PROGRAM chạy chương trình host của lib (src/native/thingspeak, env:thingspeak) với
+từng chế độ trên một cổng tạm: bình thường, trễ, lỗi 500, đóng kết nối, chunked phải gửi đủ;
+sai write_api_key phải không gửi được bản ghi nào.
+
+  pio run -e thingspeak && tools/thingspeak_standin.py --check .pio/build/thingspeak/program
+"""
+import argparse
+import json
+import random
+import re
+import subprocess
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+PATH = re.compile(r"^/channels/(\d+)/bulk_update\.json$")
+
+
+class Stats:
+    requests = 0
+    entries = 0
+    rejected = 0
+    connections = 0
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def setup(self):
+        super().setup()
+        Stats.connections += 1
+        self.served = 0
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def log(self, text):
+        if not self.server.opts.quiet:
+            print(text, flush=True)
+
+    def reply(self, code, payload):
+        data = json.dumps(payload).encode()
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        if self.server.opts.close:
+            self.send_header("Connection", "close")
+            self.close_connection = True
+        if self.server.opts.chunked:
+            self.send_header("Transfer-Encoding", "chunked")
+            self.end_headers()
+            half = len(data) // 2
+            for part in (data[:half], data[half:]):
+                self.wfile.write(b"%x\r\n%s\r\n" % (len(part), part))
+            self.wfile.write(b"0\r\n\r\n")
+        else:
+            self.send_header("Content-Length", str(len(data)))
+            self.end_headers()
+            self.wfile.write(data)
+
+    def do_POST(self):
+        opts = self.server.opts
+        self.served += 1
+        Stats.requests += 1
+        length = int(self.headers.get("Content-Length", 0))
+        raw = self.rfile.read(length)
+        if opts.latency:
+            time.sleep(opts.latency / 1000.0)
+
+        match = PATH.match(self.path)
+        try:
+            body = json.loads(raw)
+        except ValueError:
+            body = None
+        error = None
+        if not match:
+            error = (404, "unknown path")
+        elif not isinstance(body, dict) or not isinstance(body.get("updates"), list):
+            error = (400, "bad body")
+        elif opts.key and body.get("write_api_key") != opts.key:
+            error = (401, "bad write_api_key")
+        elif random.random() < opts.fail:
+            error = (500, "injected failure")
+        if error:
+            Stats.rejected += 1
+            self.log(f"#{Stats.requests} conn req {self.served}: {error[0]} {error[1]}")
+            self.reply(error[0], {"success": False, "error": error[1]})
+            return
+
+        updates = body["updates"]
+        Stats.entries += len(updates)
+        fields = sorted({k for u in updates for k in u if k.startswith("field")})
+        self.log(f"#{Stats.requests} channel {match.group(1)} conn req {self.served}: "
+                 f"{len(updates)} entries, {','.join(fields)} (total {Stats.entries}, "
+                 f"{Stats.connections} connections)")
+        self.reply(202, {"success": True})
+
+
+KEY = "Q0C1U02B034TQZ1I"
+
+# tên, tùy chọn máy chủ, tham số thêm cho chương trình, mã thoát mong đợi
+CASES = [
+    ("plain", {}, [], 0),
+    ("latency", {"latency": 300}, [], 0),
+    ("fail", {"fail": 0.3}, [], 0),
+    ("close", {"close": True}, [], 0),
+    ("chunked", {"chunked": True}, [], 0),
+    ("wrong key", {}, ["--key", "WRONG", "--seconds", "3"], 1),
+]
+
+
+def check(program):
+    random.seed(1)
+    failed = 0
+    for name, extra, args, expect in CASES:
+        opts = argparse.Namespace(port=0, key=KEY, latency=0, fail=0.0, close=False, chunked=False, quiet=True)
+        vars(opts).update(extra)
+        Stats.requests = Stats.entries = Stats.rejected = Stats.connections = 0
+        server = ThreadingHTTPServer(("127.0.0.1", 0), Handler)
+        server.opts = opts
+        thread = threading.Thread(target=server.serve_forever, daemon=True)
+        thread.start()
+        cmd = [program, "--port", str(server.server_address[1]), "--key", KEY] + args
+        run = subprocess.run(cmd, capture_output=True, text=True)
+        server.shutdown()
+        server.server_close()
+        good = run.returncode == expect and (expect != 0 or Stats.entries >= 40) and \
+            (expect == 0 or Stats.entries == 0)
+        failed += not good
+        summary = run.stdout.strip().removeprefix("thingspeak").strip() or run.stderr.strip()
+        print(f"{name:<10} {'ok' if good else 'FAIL'}  {summary}  "
+              f"[server: {Stats.requests} requests, {Stats.entries} entries, {Stats.rejected} rejected, "
+              f"{Stats.connections} connections]", flush=True)
+    return 1 if failed else 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--port", type=int, default=8080)
+    ap.add_argument("--key", default="", help="write_api_key bắt buộc (rỗng = không kiểm tra)")
+    ap.add_argument("--latency", type=int, default=0, help="ms chờ trước khi trả lời")
+    ap.add_argument("--fail", type=float, default=0.0, help="tỉ lệ trả 500 (0..1)")
+    ap.add_argument("--close", action="store_true", help="đóng kết nối sau mỗi response")
+    ap.add_argument("--chunked", action="store_true", help="trả body dạng chunked")
+    ap.add_argument("--check", metavar="PROGRAM", help="chạy chương trình host qua mọi chế độ rồi thoát")
+    opts = ap.parse_args()
+    opts.quiet = False
+    if opts.check:
+        sys.exit(check(opts.check))
+
+    server = ThreadingHTTPServer(("", opts.port), Handler)
+    server.opts = opts
+    print(f"ThingSpeak stand-in on :{opts.port}", flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print(f"{Stats.requests} requests, {Stats.entries} entries, {Stats.rejected} rejected, "
+          f"{Stats.connections} connections", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()